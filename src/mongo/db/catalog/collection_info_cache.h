@@ -28,11 +28,15 @@
 
 #pragma once
 
+#include <boost/optional.hpp>
+
 #include "mongo/db/collection_index_usage_tracker.h"
+#include "mongo/db/query/index_statistics.h"
 #include "mongo/db/query/plan_cache.h"
 #include "mongo/db/query/query_settings.h"
 #include "mongo/db/update_index_data.h"
 #include "mongo/stdx/functional.h"
+#include "mongo/util/time_support.h"
 
 namespace mongo {
 class Collection;
@@ -57,6 +61,19 @@ public:
 
         virtual CollectionIndexUsageMap getIndexUsageStats() const = 0;
 
+        virtual std::shared_ptr<const IndexStatistics> getIndexStatistics(
+            StringData indexName) const = 0;
+
+        virtual void setIndexStatistics(StringData indexName,
+                                        std::shared_ptr<const IndexStatistics> stats) = 0;
+
+        virtual boost::optional<long long> getLeadingFieldCardinality(StringData indexName,
+                                                                      Date_t notBefore) const = 0;
+
+        virtual void setLeadingFieldCardinality(StringData indexName,
+                                                long long cardinality,
+                                                Date_t now) = 0;
+
         virtual void init(OperationContext* opCtx) = 0;
 
         virtual void addedIndex(OperationContext* opCtx, const IndexDescriptor* desc) = 0;
@@ -121,6 +138,45 @@ public:
         return this->_impl().getIndexUsageStats();
     }
 
+    /**
+     * Returns the statistics last built for the index 'indexName' by the analyzeIndexes command,
+     * or nullptr if there are none. The statistics are discarded if the index is dropped.
+     */
+    inline std::shared_ptr<const IndexStatistics> getIndexStatistics(
+        const StringData indexName) const {
+        return this->_impl().getIndexStatistics(indexName);
+    }
+
+    /**
+     * Replaces the statistics for the index 'indexName', and clears the plan cache so that they
+     * are taken into account by subsequent queries.
+     */
+    inline void setIndexStatistics(const StringData indexName,
+                                   std::shared_ptr<const IndexStatistics> stats) {
+        return this->_impl().setIndexStatistics(indexName, std::move(stats));
+    }
+
+    /**
+     * Returns the leading field cardinality last counted for the index 'indexName', if it was
+     * counted at or after 'notBefore'. The count is -1 if the leading field had more distinct
+     * values than the counting was allowed to seek past.
+     */
+    inline boost::optional<long long> getLeadingFieldCardinality(const StringData indexName,
+                                                                 const Date_t notBefore) const {
+        return this->_impl().getLeadingFieldCardinality(indexName, notBefore);
+    }
+
+    /**
+     * Records the leading field cardinality counted for the index 'indexName' at 'now'. Unlike
+     * setIndexStatistics(), this leaves the plan cache alone, since the count is only an input to
+     * planning passes which happen anyway.
+     */
+    inline void setLeadingFieldCardinality(const StringData indexName,
+                                           const long long cardinality,
+                                           const Date_t now) {
+        return this->_impl().setLeadingFieldCardinality(indexName, cardinality, now);
+    }
+
     /**
      * Register a newly-created index with the cache.  Must be called whenever an index is
      * built on the associated collection.
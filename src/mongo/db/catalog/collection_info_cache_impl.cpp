@@ -235,6 +235,10 @@ void CollectionInfoCacheImpl::droppedIndex(OperationContext* opCtx, StringData i
 
     rebuildIndexData(opCtx);
     _indexUsageTracker.unregisterIndex(indexName);
+
+    stdx::lock_guard<stdx::mutex> lk(_indexStatisticsMutex);
+    _indexStatistics.erase(indexName);
+    _leadingFieldCardinalities.erase(indexName);
 }
 
 void CollectionInfoCacheImpl::rebuildIndexData(OperationContext* opCtx) {
@@ -248,4 +252,37 @@ void CollectionInfoCacheImpl::rebuildIndexData(OperationContext* opCtx) {
 CollectionIndexUsageMap CollectionInfoCacheImpl::getIndexUsageStats() const {
     return _indexUsageTracker.getUsageStats();
 }
+
+std::shared_ptr<const IndexStatistics> CollectionInfoCacheImpl::getIndexStatistics(
+    StringData indexName) const {
+    stdx::lock_guard<stdx::mutex> lk(_indexStatisticsMutex);
+    auto it = _indexStatistics.find(indexName);
+    return it == _indexStatistics.end() ? nullptr : it->second;
+}
+
+void CollectionInfoCacheImpl::setIndexStatistics(StringData indexName,
+                                                 std::shared_ptr<const IndexStatistics> stats) {
+    {
+        stdx::lock_guard<stdx::mutex> lk(_indexStatisticsMutex);
+        _indexStatistics[indexName] = std::move(stats);
+    }
+    clearQueryCache();
+}
+
+boost::optional<long long> CollectionInfoCacheImpl::getLeadingFieldCardinality(
+    StringData indexName, Date_t notBefore) const {
+    stdx::lock_guard<stdx::mutex> lk(_indexStatisticsMutex);
+    auto it = _leadingFieldCardinalities.find(indexName);
+    if (it == _leadingFieldCardinalities.end() || it->second.countedAt < notBefore) {
+        return boost::none;
+    }
+    return it->second.cardinality;
+}
+
+void CollectionInfoCacheImpl::setLeadingFieldCardinality(StringData indexName,
+                                                         long long cardinality,
+                                                         Date_t now) {
+    stdx::lock_guard<stdx::mutex> lk(_indexStatisticsMutex);
+    _leadingFieldCardinalities[indexName] = {cardinality, now};
+}
 }  // namespace mongo
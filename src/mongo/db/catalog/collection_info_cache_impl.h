@@ -34,6 +34,8 @@
 #include "mongo/db/query/plan_cache.h"
 #include "mongo/db/query/query_settings.h"
 #include "mongo/db/update_index_data.h"
+#include "mongo/stdx/mutex.h"
+#include "mongo/util/string_map.h"
 
 namespace mongo {
 
@@ -75,6 +77,15 @@ public:
      */
     CollectionIndexUsageMap getIndexUsageStats() const;
 
+    std::shared_ptr<const IndexStatistics> getIndexStatistics(StringData indexName) const;
+
+    void setIndexStatistics(StringData indexName, std::shared_ptr<const IndexStatistics> stats);
+
+    boost::optional<long long> getLeadingFieldCardinality(StringData indexName,
+                                                          Date_t notBefore) const;
+
+    void setLeadingFieldCardinality(StringData indexName, long long cardinality, Date_t now);
+
     /**
      * Builds internal cache state based on the current state of the Collection's IndexCatalog
      */
@@ -134,6 +145,19 @@ private:
     // Tracks index usage statistics for this collection.
     CollectionIndexUsageTracker _indexUsageTracker;
 
+    // Statistics built by the analyzeIndexes command, keyed by index name. They may be replaced
+    // while holding only an intent lock, so access is protected by '_indexStatisticsMutex'.
+    mutable stdx::mutex _indexStatisticsMutex;
+    StringMap<std::shared_ptr<const IndexStatistics>> _indexStatistics;
+
+    // Leading field cardinalities counted for skip scans, keyed by index name, along with when
+    // they were counted. They are recorded by queries, so are also protected by the mutex.
+    struct LeadingFieldCardinality {
+        long long cardinality;
+        Date_t countedAt;
+    };
+    StringMap<LeadingFieldCardinality> _leadingFieldCardinalities;
+
     bool _hasTTLIndex = false;
 };
 
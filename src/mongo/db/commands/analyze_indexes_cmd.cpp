@@ -0,0 +1,270 @@
+/**
+ *    Copyright (C) 2017 MongoDB Inc.
+ *
+ *    This program is free software: you can redistribute it and/or  modify
+ *    it under the terms of the GNU Affero General Public License, version 3,
+ *    as published by the Free Software Foundation.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU Affero General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Affero General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the GNU Affero General Public License in all respects for
+ *    all of the code used other than as permitted herein. If you modify file(s)
+ *    with this exception, you may extend this exception to your version of the
+ *    file(s), but you are not obligated to do so. If you do not wish to do so,
+ *    delete this exception statement from your version. If you delete this
+ *    exception statement from all source files in the program, then also delete
+ *    it in the license file.
+ */
+
+#include "mongo/platform/basic.h"
+
+#include <vector>
+
+#include "mongo/bson/simple_bsonobj_comparator.h"
+#include "mongo/db/auth/authorization_session.h"
+#include "mongo/db/catalog/collection.h"
+#include "mongo/db/catalog/index_catalog.h"
+#include "mongo/db/commands.h"
+#include "mongo/db/db_raii.h"
+#include "mongo/db/exec/multi_iterator.h"
+#include "mongo/db/exec/working_set_common.h"
+#include "mongo/db/index/index_access_method.h"
+#include "mongo/db/index/index_descriptor.h"
+#include "mongo/db/query/index_statistics.h"
+#include "mongo/db/query/internal_plans.h"
+#include "mongo/db/query/plan_executor.h"
+#include "mongo/platform/random.h"
+#include "mongo/util/mongoutils/str.h"
+
+namespace mongo {
+namespace {
+
+const long long kDefaultSampleSize = 10000;
+const long long kMaxSampleSize = 1000 * 1000;
+
+/**
+ * The leading values of the keys one sampled document generates, for each index being analyzed.
+ */
+using SampledKeys = std::vector<std::vector<BSONObj>>;
+
+/**
+ * Returns the leading values of the keys each of 'descs' generates for 'doc'. An index whose
+ * partial filter 'doc' does not match contributes no values.
+ */
+SampledKeys extractLeadingValues(Collection* collection,
+                                 const std::vector<const IndexDescriptor*>& descs,
+                                 const BSONObj& doc) {
+    SampledKeys sampled(descs.size());
+    for (size_t i = 0; i < descs.size(); ++i) {
+        const IndexCatalogEntry* entry = collection->getIndexCatalog()->getEntry(descs[i]);
+        const MatchExpression* filter = entry->getFilterExpression();
+        if (filter && !filter->matchesBSON(doc)) {
+            continue;
+        }
+
+        BSONObjSet keys = SimpleBSONObjComparator::kInstance.makeBSONObjSet();
+        entry->accessMethod()->getKeys(
+            doc, IndexAccessMethod::GetKeysMode::kRelaxConstraints, &keys, nullptr);
+        for (auto&& key : keys) {
+            sampled[i].push_back(key.firstElement().wrap(""));
+        }
+    }
+    return sampled;
+}
+
+/**
+ * Returns an executor which returns documents chosen at random from 'collection', or nullptr if the
+ * collection is no larger than the sample or the storage engine has no random cursors.
+ */
+std::unique_ptr<PlanExecutor, PlanExecutor::Deleter> makeRandomExecutor(OperationContext* opCtx,
+                                                                       Collection* collection,
+                                                                       long long sampleSize) {
+    if (static_cast<long long>(collection->numRecords(opCtx)) <= sampleSize) {
+        return nullptr;
+    }
+    auto randomCursor = collection->getRecordStore()->getRandomCursor(opCtx);
+    if (!randomCursor) {
+        return nullptr;
+    }
+
+    auto ws = stdx::make_unique<WorkingSet>();
+    auto stage = stdx::make_unique<MultiIteratorStage>(opCtx, ws.get(), collection);
+    stage->addIterator(std::move(randomCursor));
+    return uassertStatusOK(PlanExecutor::make(
+        opCtx, std::move(ws), std::move(stage), collection, PlanExecutor::YIELD_AUTO));
+}
+
+/**
+ * Samples up to 'sampleSize' documents at random from 'collection', returning the leading key
+ * values each generates for 'descs' rather than the documents themselves. Collections no larger
+ * than the sample, and storage engines without random cursors, are read in full and sampled with a
+ * reservoir. The scan yields, and fails if the collection or one of its indexes is dropped.
+ */
+std::vector<SampledKeys> sampleLeadingValues(OperationContext* opCtx,
+                                             Collection* collection,
+                                             const std::vector<const IndexDescriptor*>& descs,
+                                             long long sampleSize) {
+    auto exec = makeRandomExecutor(opCtx, collection, sampleSize);
+    const bool isRandom = static_cast<bool>(exec);
+    if (!isRandom) {
+        exec = InternalPlanner::collectionScan(
+            opCtx, collection->ns().ns(), collection, PlanExecutor::YIELD_AUTO);
+    }
+
+    std::vector<SampledKeys> samples;
+    PseudoRandom random(SecureRandom::create()->nextInt64());
+    long long seen = 0;
+    BSONObj obj;
+    PlanExecutor::ExecState state = PlanExecutor::IS_EOF;
+    while ((!isRandom || seen < sampleSize) &&
+           PlanExecutor::ADVANCED == (state = exec->getNext(&obj, nullptr))) {
+        if (seen < sampleSize) {
+            samples.push_back(extractLeadingValues(collection, descs, obj));
+        } else {
+            long long slot = random.nextInt64(seen + 1);
+            if (slot < sampleSize) {
+                samples[slot] = extractLeadingValues(collection, descs, obj);
+            }
+        }
+        ++seen;
+    }
+
+    if (PlanExecutor::DEAD == state || PlanExecutor::FAILURE == state) {
+        uassertStatusOK(WorkingSetCommon::getMemberObjectStatus(obj).withContext(
+            "Executor error while sampling documents for analyzeIndexes"));
+    }
+    return samples;
+}
+
+/**
+ * Builds statistics for the index at position 'indexPos' of the analyzed indexes from the leading
+ * key values sampled for it.
+ */
+IndexStatistics analyzeIndex(OperationContext* opCtx,
+                             Collection* collection,
+                             size_t indexPos,
+                             const std::vector<SampledKeys>& samples) {
+    std::vector<BSONObj> leadingValues;
+    for (auto&& sampled : samples) {
+        leadingValues.insert(
+            leadingValues.end(), sampled[indexPos].begin(), sampled[indexPos].end());
+    }
+
+    return IndexStatistics::build(
+        std::move(leadingValues), samples.size(), collection->numRecords(opCtx));
+}
+
+/**
+ * Samples a collection and builds statistics about the keys of its indexes, which the query
+ * planner uses to estimate the cost of candidate plans.
+ *
+ * {analyzeIndexes: <collection>, sampleSize: <number of documents>, index: <index name>}
+ *
+ * 'sampleSize' and 'index' are optional. Without 'index', every index is analyzed. The statistics
+ * are kept in memory until they are rebuilt, the index is dropped or the server restarts.
+ */
+class AnalyzeIndexesCmd : public BasicCommand {
+public:
+    AnalyzeIndexesCmd() : BasicCommand("analyzeIndexes") {}
+
+    bool supportsWriteConcern(const BSONObj& cmd) const override {
+        return false;
+    }
+
+    bool slaveOk() const override {
+        return true;
+    }
+
+    void help(std::stringstream& help) const override {
+        help << "Samples a collection to build the index statistics used by the query planner.\n"
+             << "{ analyzeIndexes: <collection>, sampleSize: <int>, index: <index name> }";
+    }
+
+    Status checkAuthForOperation(OperationContext* opCtx,
+                                 const std::string& dbname,
+                                 const BSONObj& cmdObj) override {
+        AuthorizationSession* authSession = AuthorizationSession::get(opCtx->getClient());
+        const NamespaceString nss(parseNsCollectionRequired(dbname, cmdObj));
+        if (!authSession->isAuthorizedForActionsOnNamespace(nss, ActionType::planCacheWrite)) {
+            return Status(ErrorCodes::Unauthorized, "Unauthorized");
+        }
+        return Status::OK();
+    }
+
+    bool run(OperationContext* opCtx,
+             const std::string& dbname,
+             const BSONObj& cmdObj,
+             BSONObjBuilder& result) override {
+        const NamespaceString nss(parseNsCollectionRequired(dbname, cmdObj));
+
+        long long sampleSize = kDefaultSampleSize;
+        if (BSONElement sampleSizeElt = cmdObj["sampleSize"]) {
+            if (!sampleSizeElt.isNumber() || sampleSizeElt.numberLong() < 1 ||
+                sampleSizeElt.numberLong() > kMaxSampleSize) {
+                return appendCommandStatus(
+                    result,
+                    Status(ErrorCodes::BadValue,
+                           str::stream() << "sampleSize must be between 1 and " << kMaxSampleSize));
+            }
+            sampleSize = sampleSizeElt.numberLong();
+        }
+
+        BSONElement indexElt = cmdObj["index"];
+        if (indexElt && indexElt.type() != String) {
+            return appendCommandStatus(
+                result, Status(ErrorCodes::TypeMismatch, "index must be an index name"));
+        }
+
+        AutoGetCollectionForReadCommand ctx(opCtx, nss);
+        Collection* collection = ctx.getCollection();
+        if (!collection) {
+            return appendCommandStatus(result,
+                                       Status(ErrorCodes::NamespaceNotFound,
+                                              str::stream() << "ns does not exist: " << nss.ns()));
+        }
+
+        std::vector<const IndexDescriptor*> descs;
+        IndexCatalog::IndexIterator ii =
+            collection->getIndexCatalog()->getIndexIterator(opCtx, false);
+        while (ii.more()) {
+            const IndexDescriptor* desc = ii.next();
+            if (!indexElt || desc->indexName() == indexElt.valueStringData()) {
+                descs.push_back(desc);
+            }
+        }
+        if (indexElt && descs.empty()) {
+            return appendCommandStatus(result,
+                                       Status(ErrorCodes::IndexNotFound,
+                                              str::stream() << "index not found: "
+                                                            << indexElt.valueStringData()));
+        }
+
+        const std::vector<SampledKeys> samples =
+            sampleLeadingValues(opCtx, collection, descs, sampleSize);
+
+        BSONArrayBuilder indexes(result.subarrayStart("indexes"));
+        for (size_t i = 0; i < descs.size(); ++i) {
+            const IndexDescriptor* desc = descs[i];
+            auto stats = std::make_shared<const IndexStatistics>(
+                analyzeIndex(opCtx, collection, i, samples));
+            indexes.append(BSON("name" << desc->indexName() << "statistics" << stats->toBSON()));
+            collection->infoCache()->setIndexStatistics(desc->indexName(), std::move(stats));
+        }
+        indexes.doneFast();
+
+        return true;
+    }
+} analyzeIndexesCmd;
+
+}  // namespace
+}  // namespace mongo
@@ -47,8 +47,10 @@
 #include "mongo/db/query/find.h"
 #include "mongo/db/query/find_common.h"
 #include "mongo/db/query/getmore_request.h"
+#include "mongo/db/query/plan_cache.h"
 #include "mongo/db/query/plan_executor.h"
 #include "mongo/db/query/plan_summary_stats.h"
+#include "mongo/db/query/query_stats_store.h"
 #include "mongo/db/repl/oplog.h"
 #include "mongo/db/repl/replication_coordinator_global.h"
 #include "mongo/db/service_context.h"
@@ -352,6 +354,15 @@ public:
         postExecutionStats.totalDocsExamined -= preExecutionStats.totalDocsExamined;
         curOp->debug().setPlanSummaryMetrics(postExecutionStats);
 
+        // Attribute the batch to the shape of the query the cursor runs, if it has one.
+        if (readLock && readLock->getCollection() && exec->getCanonicalQuery() &&
+            QueryStatsStore::isEnabled() &&
+            PlanCache::shouldCacheQuery(*exec->getCanonicalQuery())) {
+            curOp->debug().queryShape =
+                readLock->getCollection()->infoCache()->getPlanCache()->computeKey(
+                    *exec->getCanonicalQuery());
+        }
+
         // We do not report 'execStats' for aggregation or other globally managed cursors, both in
         // the original request and subsequent getMore. It would be useful to have this information
         // for an aggregation, but the source PlanExecutor could be destroyed before we know whether
@@ -446,6 +446,12 @@ Status PlanCacheListPlans::list(OperationContext* opCtx,
     // Append the time the entry was inserted into the plan cache.
     bob->append("timeOfCreation", entry->timeOfCreation);
 
+    // Append the selectivity bucket the plans were ranked under, if they were ranked for a
+    // particular one.
+    if (entry->selectivityBucket) {
+        bob->append("selectivityBucket", *entry->selectivityBucket);
+    }
+
     return Status::OK();
 }
 
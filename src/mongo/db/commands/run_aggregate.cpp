@@ -502,6 +502,9 @@ Status runAggregate(OperationContext* opCtx,
         // this process uses the correct collation if it does any string comparisons.
         pipeline->optimizePipeline();
 
+        // Run as much of the pipeline as possible on worker threads, if enabled.
+        PipelineD::addExchangeIfParallelizable(pipeline.get());
+
         // Transfer ownership of the Pipeline to the PipelineProxyStage.
         unownedPipeline = pipeline.get();
         auto ws = make_unique<WorkingSet>();
@@ -658,6 +658,21 @@ void LockManager::downgrade(LockRequest* request, LockMode newMode) {
     _onLockModeChanged(lock, true);
 }
 
+bool LockManager::hasWaiters(ResourceId resId) const {
+    LockBucket* bucket = _getBucket(resId);
+    stdx::lock_guard<SimpleMutex> scopedLock(bucket->mutex);
+
+    LockBucket::Map::const_iterator it = bucket->data.find(resId);
+    if (it == bucket->data.end()) {
+        return false;
+    }
+
+    // A conflicting request migrates any partitioned intent requests onto the LockHead before it
+    // is queued, so the partitions need not be checked.
+    const LockHead* lock = it->second;
+    return lock->conflictModes != 0 || lock->conversionsCount != 0;
+}
+
 void LockManager::cleanupUnusedLocks() {
     for (unsigned i = 0; i < _numLockBuckets; i++) {
         LockBucket* bucket = &_lockBuckets[i];
@@ -112,6 +112,13 @@ public:
      */
     void downgrade(LockRequest* request, LockMode newMode);
 
+    /**
+     * Returns true if some request for the specified resource is waiting, either on the conflict
+     * queue or for the conversion of an already granted request. Takes the resource's bucket
+     * mutex, but never blocks on the resource itself.
+     */
+    bool hasWaiters(ResourceId resId) const;
+
     /**
      * Iterates through all buckets and deletes all locks, which have no requests on them. This
      * call is kind of expensive and should only be used for reducing the memory footprint of
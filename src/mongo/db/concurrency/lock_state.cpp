@@ -545,6 +545,24 @@ ResourceId LockerImpl<IsForMMAPV1>::getWaitingResource() const {
     return ResourceId();
 }
 
+template <bool IsForMMAPV1>
+bool LockerImpl<IsForMMAPV1>::hasWaitersOnHeldLocks() const {
+    // Only the owning thread modifies _requests, so it may read them without taking _lock, which
+    // must not be held while waiting for the lock manager's bucket mutexes.
+    for (LockRequestsMap::ConstIterator it = _requests.begin(); !it.finished(); it.next()) {
+        // Mutexes are not released on yield, so waiters on them gain nothing from it.
+        if (it.key().getType() == RESOURCE_MUTEX || it->status != LockRequest::STATUS_GRANTED) {
+            continue;
+        }
+
+        if (globalLockManager.hasWaiters(it.key())) {
+            return true;
+        }
+    }
+
+    return false;
+}
+
 template <bool IsForMMAPV1>
 void LockerImpl<IsForMMAPV1>::getLockerInfo(LockerInfo* lockerInfo) const {
     invariant(lockerInfo);
@@ -254,6 +254,8 @@ public:
     virtual bool hasLockPending() const {
         return getWaitingResource().isValid();
     }
+
+    bool hasWaitersOnHeldLocks() const override;
 };
 
 typedef LockerImpl<false> DefaultLockerImpl;
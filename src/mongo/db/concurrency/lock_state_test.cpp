@@ -387,4 +387,40 @@ TEST(LockerImpl, GetLockerInfoShouldReportPendingLocks) {
     ASSERT(conflictingLocker.unlockGlobal());
 }
 
+TEST(LockerImpl, HasWaitersOnHeldLocksShouldReportConflictingRequests) {
+    const ResourceId dbId(RESOURCE_DATABASE, "TestDB"_sd);
+    const ResourceId collectionId(RESOURCE_COLLECTION, "TestDB.collection"_sd);
+
+    // Intent locks alone never make anyone wait.
+    DefaultLockerImpl reader;
+    ASSERT_EQ(LOCK_OK, reader.lockGlobal(MODE_IS));
+    ASSERT_EQ(LOCK_OK, reader.lock(dbId, MODE_IS));
+    ASSERT_EQ(LOCK_OK, reader.lock(collectionId, MODE_IS));
+
+    DefaultLockerImpl writer;
+    ASSERT_EQ(LOCK_OK, writer.lockGlobal(MODE_IX));
+    ASSERT_EQ(LOCK_OK, writer.lock(dbId, MODE_IX));
+    ASSERT_FALSE(reader.hasWaitersOnHeldLocks());
+    ASSERT_FALSE(writer.hasWaitersOnHeldLocks());
+
+    // An exclusive request for the collection waits on the reader, but the writer's own pending
+    // request does not count as a lock it holds.
+    ASSERT_EQ(LOCK_WAITING, writer.lockBegin(collectionId, MODE_X));
+    ASSERT_TRUE(reader.hasWaitersOnHeldLocks());
+    ASSERT_FALSE(writer.hasWaitersOnHeldLocks());
+
+    ASSERT(reader.unlock(collectionId));
+
+    const Milliseconds timeout = Milliseconds(0);
+    const bool checkDeadlock = false;
+    ASSERT_EQ(LOCK_OK, writer.lockComplete(collectionId, MODE_X, timeout, checkDeadlock));
+    ASSERT_FALSE(reader.hasWaitersOnHeldLocks());
+
+    ASSERT(writer.unlock(collectionId));
+    ASSERT(writer.unlock(dbId));
+    ASSERT(writer.unlockGlobal());
+    ASSERT(reader.unlock(dbId));
+    ASSERT(reader.unlockGlobal());
+}
+
 }  // namespace mongo
@@ -315,6 +315,12 @@ public:
      */
     virtual bool hasLockPending() const = 0;
 
+    /**
+     * Returns true if another locker is waiting on a resource this locker holds, which it would
+     * release by yielding. Used to decide whether yielding would let anyone else make progress.
+     */
+    virtual bool hasWaitersOnHeldLocks() const = 0;
+
     /**
      * If set to false, this opts out of conflicting with replication's use of the
      * ParallelBatchWriterMode lock. Code that opts-out must be ok with seeing an inconsistent view
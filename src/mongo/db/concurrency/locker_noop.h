@@ -164,6 +164,10 @@ public:
         invariant(false);
     }
 
+    bool hasWaitersOnHeldLocks() const override {
+        return false;
+    }
+
     bool isGlobalLockedRecursively() override {
         return false;
     }
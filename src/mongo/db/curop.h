@@ -120,6 +120,10 @@ public:
 
     BSONObj execStats;  // Owned here.
 
+    // The plan cache key of the first query this operation planned, if query statistics are
+    // enabled. Execution statistics are recorded against it when the operation completes.
+    std::string queryShape;
+
     // error handling
     Status exceptionInfo = Status::OK();
 
@@ -93,7 +93,9 @@
 #include "mongo/db/mongod_options.h"
 #include "mongo/db/op_observer_impl.h"
 #include "mongo/db/operation_context.h"
+#include "mongo/db/plan_cache_checkpoint.h"
 #include "mongo/db/query/internal_plans.h"
+#include "mongo/db/query/query_worker_pool.h"
 #include "mongo/db/repair_database.h"
 #include "mongo/db/repl/drop_pending_collection_reaper.h"
 #include "mongo/db/repl/oplog.h"
@@ -981,6 +983,8 @@ ExitCode _initAndListen(int listenPort) {
             startTTLBackgroundJob();
         }
 
+        startPlanCacheCheckpointJob();
+
         if (replSettings.usingReplSets() || (!replSettings.isMaster() && replSettings.isSlave()) ||
             !internalValidateFeaturesAsMaster) {
             serverGlobalParams.validateFeaturesAsMaster.store(false);
@@ -1303,6 +1307,10 @@ void shutdownTask() {
         runner->shutdown();
     }
 
+    // Wait for the tasks the queries scheduled on worker threads, which read from the storage
+    // engine, to finish.
+    QueryWorkerPool::get(serviceContext).shutdown();
+
     ReplicaSetMonitor::shutdown();
 
     if (auto sr = Grid::get(serviceContext)->shardRegistry()) {
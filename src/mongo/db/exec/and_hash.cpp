@@ -224,16 +224,17 @@ PlanStage::StageState AndHashStage::doWork(WorkingSetID* out) {
         return PlanStage::NEED_TIME;
     }
 
-    DataMap::iterator it = _dataMap.find(member->recordId);
-    if (_dataMap.end() == it) {
+    HashedMember* hashed =
+        mayBeHashed(member->recordId) ? _dataMap.find(member->recordId) : nullptr;
+    if (!hashed) {
         // Child's output wasn't in every previous child.  Throw it out.
         _ws->free(*out);
         return PlanStage::NEED_TIME;
     } else {
         // Child's output was in every previous child.  Merge any key data in
         // the child's output and free the child's just-outputted WSM.
-        WorkingSetID hashID = it->second;
-        _dataMap.erase(it);
+        WorkingSetID hashID = hashed->wsid;
+        _dataMap.erase(member->recordId);
 
         AndCommon::mergeFrom(_ws, hashID, *member);
         _ws->free(*out);
@@ -253,6 +254,20 @@ PlanStage::StageState AndHashStage::workChild(size_t childNo, WorkingSetID* out)
     }
 }
 
+bool AndHashStage::mayBeHashed(const RecordId& recordId) {
+    if (_bloomFilter && !_bloomFilter->mayContain(recordId)) {
+        ++_specificStats.bloomFilterRejects;
+        return false;
+    }
+    return true;
+}
+
+void AndHashStage::rebuildBloomFilter() {
+    _bloomFilter = make_unique<RecordIdBloomFilter>(_dataMap.size());
+    _dataMap.forEach(
+        [&](const RecordId& recordId, const HashedMember&) { _bloomFilter->add(recordId); });
+}
+
 PlanStage::StageState AndHashStage::readFirstChild(WorkingSetID* out) {
     verify(_currentChild == 0);
 
@@ -269,7 +284,7 @@ PlanStage::StageState AndHashStage::readFirstChild(WorkingSetID* out) {
             return PlanStage::NEED_TIME;
         }
 
-        if (!_dataMap.insert(std::make_pair(member->recordId, id)).second) {
+        if (!_dataMap.insert(member->recordId, HashedMember{id, 0}).second) {
             // Didn't insert because we already had this RecordId inside the map. This should only
             // happen if we're seeing a newer copy of the same doc in a more recent snapshot.
             // Throw out the newer copy of the doc.
@@ -295,6 +310,7 @@ PlanStage::StageState AndHashStage::readFirstChild(WorkingSetID* out) {
         }
 
         _specificStats.mapAfterChild.push_back(_dataMap.size());
+        rebuildBloomFilter();
 
         return PlanStage::NEED_TIME;
     } else if (PlanStage::FAILURE == childStatus || PlanStage::DEAD == childStatus) {
@@ -335,12 +351,14 @@ PlanStage::StageState AndHashStage::hashOtherChildren(WorkingSetID* out) {
         }
 
         verify(member->hasRecordId());
-        if (_dataMap.end() == _dataMap.find(member->recordId)) {
+        HashedMember* hashed =
+            mayBeHashed(member->recordId) ? _dataMap.find(member->recordId) : nullptr;
+        if (!hashed) {
             // Ignore.  It's not in any previous child.
         } else {
             // We have a hit.  Copy data into the WSM we already have.
-            _seenMap.insert(member->recordId);
-            WorkingSetID olderMemberID = _dataMap[member->recordId];
+            hashed->lastSeenChild = _currentChild;
+            WorkingSetID olderMemberID = hashed->wsid;
             WorkingSetMember* olderMember = _ws->get(olderMemberID);
             size_t memUsageBefore = olderMember->getMemUsage();
 
@@ -353,29 +371,25 @@ PlanStage::StageState AndHashStage::hashOtherChildren(WorkingSetID* out) {
         return PlanStage::NEED_TIME;
     } else if (PlanStage::IS_EOF == childStatus) {
         // Finished with a child.
+        const size_t finishedChild = _currentChild;
         ++_currentChild;
 
-        // Keep elements of _dataMap that are in _seenMap.
-        DataMap::iterator it = _dataMap.begin();
-        while (it != _dataMap.end()) {
-            if (_seenMap.end() == _seenMap.find(it->first)) {
-                DataMap::iterator toErase = it;
-                ++it;
-
-                // Update memory stats.
-                WorkingSetMember* member = _ws->get(toErase->second);
-                _memUsage -= member->getMemUsage();
-
-                _ws->free(toErase->second);
-                _dataMap.erase(toErase);
-            } else {
-                ++it;
+        // Keep elements of _dataMap that the finished child also produced.
+        _dataMap.eraseIf([&](const RecordId&, const HashedMember& hashed) {
+            if (hashed.lastSeenChild == finishedChild) {
+                return false;
             }
-        }
 
-        _specificStats.mapAfterChild.push_back(_dataMap.size());
+            // Update memory stats.
+            WorkingSetMember* member = _ws->get(hashed.wsid);
+            _memUsage -= member->getMemUsage();
 
-        _seenMap.clear();
+            _ws->free(hashed.wsid);
+            return true;
+        });
+
+        _specificStats.mapAfterChild.push_back(_dataMap.size());
+        rebuildBloomFilter();
 
         // _dataMap is now the intersection of the first _currentChild nodes.
 
@@ -439,9 +453,8 @@ void AndHashStage::doInvalidate(OperationContext* opCtx,
     // If it's a mutation the predicates implied by the AND-ing may no longer be true.
     //
     // So, we flag and try to pick it up later.
-    DataMap::iterator it = _dataMap.find(dl);
-    if (_dataMap.end() != it) {
-        WorkingSetID id = it->second;
+    if (HashedMember* hashed = _dataMap.find(dl)) {
+        WorkingSetID id = hashed->wsid;
         WorkingSetMember* member = _ws->get(id);
         verify(member->recordId == dl);
 
@@ -461,7 +474,7 @@ void AndHashStage::doInvalidate(OperationContext* opCtx,
         _ws->flagForReview(id);
 
         // And don't return it from this stage.
-        _dataMap.erase(it);
+        _dataMap.erase(dl);
     }
 }
 
@@ -470,6 +483,8 @@ unique_ptr<PlanStageStats> AndHashStage::getStats() {
 
     _specificStats.memLimit = _maxMemUsage;
     _specificStats.memUsage = _memUsage;
+    _specificStats.hashTableBytes = _dataMap.memUsageBytes();
+    _specificStats.bloomFilterBytes = _bloomFilter ? _bloomFilter->memUsageBytes() : 0;
 
     unique_ptr<PlanStageStats> ret = make_unique<PlanStageStats>(_commonStats, STAGE_AND_HASH);
     ret->specific = make_unique<AndHashStats>(_specificStats);
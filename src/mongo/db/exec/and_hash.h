@@ -31,11 +31,10 @@
 #include <vector>
 
 #include "mongo/db/exec/plan_stage.h"
+#include "mongo/db/exec/record_id_hash_table.h"
 #include "mongo/db/jsobj.h"
 #include "mongo/db/matcher/expression.h"
 #include "mongo/db/record_id.h"
-#include "mongo/platform/unordered_map.h"
-#include "mongo/platform/unordered_set.h"
 
 namespace mongo {
 
@@ -92,6 +91,17 @@ private:
     StageState hashOtherChildren(WorkingSetID* out);
     StageState workChild(size_t childNo, WorkingSetID* out);
 
+    /**
+     * Returns whether 'recordId' may be in _dataMap, counting those screened out by the bloom
+     * filter.
+     */
+    bool mayBeHashed(const RecordId& recordId);
+
+    /**
+     * Rebuilds _bloomFilter from the current contents of _dataMap.
+     */
+    void rebuildBloomFilter();
+
     // Not owned by us.
     const Collection* _collection;
 
@@ -103,15 +113,23 @@ private:
     // we place that result here.
     std::vector<WorkingSetID> _lookAheadResults;
 
+    struct HashedMember {
+        WorkingSetID wsid;
+
+        // The last child which produced this RecordId. Entries not seen by the child currently
+        // being hashed are dropped once that child is done.
+        size_t lastSeenChild;
+    };
+
     // _dataMap is filled out by the first child and probed by subsequent children.  This is the
     // hash table that we create by intersecting _children and probe with the last child.
-    typedef unordered_map<RecordId, WorkingSetID, RecordId::Hasher> DataMap;
+    typedef RecordIdHashTable<HashedMember> DataMap;
     DataMap _dataMap;
 
-    // Keeps track of what elements from _dataMap subsequent children have seen.
-    // Only used while _hashingChildren.
-    typedef unordered_set<RecordId, RecordId::Hasher> SeenMap;
-    SeenMap _seenMap;
+    // Built from the contents of _dataMap whenever a child is done, and consulted by the
+    // following children before probing _dataMap. Most non-matching RecordIds are rejected
+    // without touching the larger table.
+    std::unique_ptr<RecordIdBloomFilter> _bloomFilter;
 
     // True if we're still intersecting _children[0..._children.size()-1].
     bool _hashingChildren;
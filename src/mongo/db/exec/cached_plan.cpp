@@ -60,13 +60,15 @@ CachedPlanStage::CachedPlanStage(OperationContext* opCtx,
                                  CanonicalQuery* cq,
                                  const QueryPlannerParams& params,
                                  size_t decisionWorks,
+                                 boost::optional<int> selectivityBucket,
                                  PlanStage* root)
     : PlanStage(kStageType, opCtx),
       _collection(collection),
       _ws(ws),
       _canonicalQuery(cq),
       _plannerParams(params),
-      _decisionWorks(decisionWorks) {
+      _decisionWorks(decisionWorks),
+      _selectivityBucket(std::move(selectivityBucket)) {
     invariant(_collection);
     _children.emplace_back(root);
 }
@@ -96,10 +98,13 @@ Status CachedPlanStage::pickBestPlan(PlanYieldPolicy* yieldPolicy) {
         PlanStage::StageState state = child()->work(&id);
 
         if (PlanStage::ADVANCED == state) {
-            // Save result for later.
-            WorkingSetMember* member = _ws->get(id);
-            // Ensure that the BSONObj underlying the WorkingSetMember is owned in case we yield.
-            member->makeObjOwnedIfNeeded();
+            // Save result for later. A fast count plan advances without a WorkingSetMember.
+            if (WorkingSet::INVALID_ID != id) {
+                WorkingSetMember* member = _ws->get(id);
+                // Ensure that the BSONObj underlying the WorkingSetMember is owned in case we
+                // yield.
+                member->makeObjOwnedIfNeeded();
+            }
             _results.push_back(id);
 
             if (_results.size() >= numResults) {
@@ -222,10 +227,11 @@ Status CachedPlanStage::replan(PlanYieldPolicy* yieldPolicy, bool shouldCache) {
 
     if (1 == solutions.size()) {
         // If there's only one solution, it won't get cached. Make sure to evict the existing
-        // cache entry if requested by the caller.
+        // cache entry if requested by the caller. The plans cached for the shape's other
+        // selectivity buckets were not found wanting, so they stay.
         if (shouldCache) {
             PlanCache* cache = _collection->infoCache()->getPlanCache();
-            cache->remove(*_canonicalQuery).transitional_ignore();
+            cache->remove(*_canonicalQuery, _selectivityBucket).transitional_ignore();
         }
 
         PlanStage* newRoot;
@@ -297,10 +303,36 @@ PlanStage::StageState CachedPlanStage::doWork(WorkingSetID* out) {
     return child()->work(out);
 }
 
+PlanStage::StageState CachedPlanStage::doWorkBatch(WorkingSet* ws,
+                                                   size_t maxWorks,
+                                                   std::vector<WorkingSetID>* out,
+                                                   WorkingSetID* stateId) {
+    if (isEOF()) {
+        return PlanStage::IS_EOF;
+    }
+
+    // First exhaust any results buffered during the trial period.
+    if (!_results.empty()) {
+        while (!_results.empty() && maxWorks > 0) {
+            ++_commonStats.works;
+            out->push_back(_results.front());
+            _results.pop_front();
+            --maxWorks;
+        }
+        return PlanStage::ADVANCED;
+    }
+
+    ++_commonStats.works;
+    return child()->workBatch(ws, maxWorks, out, stateId);
+}
+
 void CachedPlanStage::doInvalidate(OperationContext* opCtx,
                                    const RecordId& dl,
                                    InvalidationType type) {
     for (auto it = _results.begin(); it != _results.end(); ++it) {
+        if (WorkingSet::INVALID_ID == *it) {
+            continue;
+        }
         WorkingSetMember* member = _ws->get(*it);
         if (member->hasRecordId() && member->recordId == dl) {
             WorkingSetCommon::fetchAndInvalidateRecordId(opCtx, member, _collection);
@@ -329,7 +361,7 @@ void CachedPlanStage::updatePlanCache() {
     feedback->score = PlanRanker::scoreTree(feedback->stats->children[0].get());
 
     PlanCache* cache = _collection->infoCache()->getPlanCache();
-    Status fbs = cache->feedback(*_canonicalQuery, feedback.release());
+    Status fbs = cache->feedback(*_canonicalQuery, _selectivityBucket, feedback.release());
     if (!fbs.isOK()) {
         LOG(5) << _canonicalQuery->ns() << ": Failed to update cache with feedback: " << redact(fbs)
                << " - "
@@ -28,6 +28,7 @@
 
 #pragma once
 
+#include <boost/optional.hpp>
 #include <list>
 #include <memory>
 
@@ -59,11 +60,16 @@ public:
                     CanonicalQuery* cq,
                     const QueryPlannerParams& params,
                     size_t decisionWorks,
+                    boost::optional<int> selectivityBucket,
                     PlanStage* root);
 
     bool isEOF() final;
 
     StageState doWork(WorkingSetID* out) final;
+    StageState doWorkBatch(WorkingSet* ws,
+                           size_t maxWorks,
+                           std::vector<WorkingSetID>* out,
+                           WorkingSetID* stateId) final;
 
     void doInvalidate(OperationContext* opCtx, const RecordId& dl, InvalidationType type) final;
 
@@ -71,6 +77,10 @@ public:
         return STAGE_CACHED_PLAN;
     }
 
+    bool supportsBatchedWork() const final {
+        return childrenSupportBatchedWork();
+    }
+
     std::unique_ptr<PlanStageStats> getStats() final;
 
     const SpecificStats* getSpecificStats() const final;
@@ -131,6 +141,10 @@ private:
     // cached.
     size_t _decisionWorks;
 
+    // The selectivity bucket of the cache entry the plan came from. Feedback and evictions apply
+    // to that entry alone, not to the plans cached for the shape's other buckets.
+    boost::optional<int> _selectivityBucket;
+
     // If we fall back to re-planning the query, and there is just one resulting query solution,
     // that solution is owned here.
     std::unique_ptr<QuerySolution> _replannedQs;
@@ -199,6 +199,92 @@ PlanStage::StageState CollectionScan::doWork(WorkingSetID* out) {
     return returnIfMatches(member, id, out);
 }
 
+PlanStage::StageState CollectionScan::doWorkBatch(WorkingSet* ws,
+                                                  size_t maxWorks,
+                                                  std::vector<WorkingSetID>* out,
+                                                  WorkingSetID* stateId) {
+    const size_t initialSize = out->size();
+    for (size_t i = 0; i < maxWorks; ++i) {
+        ++_commonStats.works;
+
+        // Establishing or re-establishing the cursor, seeking to the start position and tracking
+        // the oplog timestamp happen rarely enough that they are left to doWork().
+        if (!_cursor || _isDead || _commonStats.isEOF || _params.shouldTrackLatestOplogTimestamp ||
+            (_lastSeenId.isNull() && !_params.start.isNull())) {
+            WorkingSetID id = WorkingSet::INVALID_ID;
+            StageState state = doWork(&id);
+            if (PlanStage::ADVANCED == state) {
+                _workingSet->get(id)->makeObjOwnedIfNeeded();
+                out->push_back(id);
+            } else if (PlanStage::NEED_TIME == state) {
+                ++_commonStats.needTime;
+            } else {
+                *stateId = id;
+                return state;
+            }
+            continue;
+        }
+
+        if ((0 != _params.maxScan) && (_specificStats.docsTested >= _params.maxScan)) {
+            _commonStats.isEOF = true;
+            return PlanStage::IS_EOF;
+        }
+
+        boost::optional<Record> record;
+        try {
+            if (auto fetcher = _cursor->fetcherForNext()) {
+                WorkingSetMember* member = _workingSet->get(_wsidForFetch);
+                member->setFetcher(fetcher.release());
+                *stateId = _wsidForFetch;
+                return PlanStage::NEED_YIELD;
+            }
+
+            record = _cursor->next();
+        } catch (const WriteConflictException&) {
+            *stateId = WorkingSet::INVALID_ID;
+            return PlanStage::NEED_YIELD;
+        }
+
+        if (!record) {
+            if (_params.tailable && !_lastSeenId.isNull()) {
+                _cursor.reset();
+            } else {
+                _commonStats.isEOF = true;
+            }
+            return PlanStage::IS_EOF;
+        }
+
+        _lastSeenId = record->id;
+        ++_specificStats.docsTested;
+
+        // Apply the filter to the record's BSON directly, so that no WorkingSetMember is
+        // allocated for a document which will be discarded.
+        BSONObj obj = record->data.releaseToBson();
+        if (_filter && !_filter->matchesBSON(obj)) {
+            if (_endCondition && _endCondition->matchesBSON(obj)) {
+                _commonStats.isEOF = true;
+                return PlanStage::IS_EOF;
+            }
+            ++_commonStats.needTime;
+            continue;
+        }
+
+        if (_params.stopApplyingFilterAfterFirstMatch) {
+            _filter = nullptr;
+        }
+
+        WorkingSetID id = _workingSet->allocate();
+        WorkingSetMember* member = _workingSet->get(id);
+        member->recordId = record->id;
+        member->obj = {getOpCtx()->recoveryUnit()->getSnapshotId(), obj};
+        _workingSet->transitionToRecordIdAndObj(id);
+        member->makeObjOwnedIfNeeded();
+        out->push_back(id);
+    }
+
+    return batchExhaustedState(*out, initialSize);
+}
+
 Status CollectionScan::setLatestOplogEntryTimestamp(const Record& record) {
     auto tsElem = record.data.toBson()[repl::OpTime::kTimestampFieldName];
     if (tsElem.type() != BSONType::bsonTimestamp) {
@@ -56,8 +56,16 @@ public:
                    const MatchExpression* filter);
 
     StageState doWork(WorkingSetID* out) final;
+    StageState doWorkBatch(WorkingSet* ws,
+                           size_t maxWorks,
+                           std::vector<WorkingSetID>* out,
+                           WorkingSetID* stateId) final;
     bool isEOF() final;
 
+    bool supportsBatchedWork() const final {
+        return true;
+    }
+
     void doInvalidate(OperationContext* opCtx, const RecordId& dl, InvalidationType type) final;
     void doSaveState() final;
     void doRestoreState() final;
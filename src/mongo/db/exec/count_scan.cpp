@@ -71,7 +71,6 @@ const char* CountScan::kStageType = "COUNT_SCAN";
 
 CountScan::CountScan(OperationContext* opCtx, const CountScanParams& params, WorkingSet* workingSet)
     : PlanStage(kStageType, opCtx),
-      _workingSet(workingSet),
       _descriptor(params.descriptor),
       _iam(params.descriptor->getIndexCatalog()->getIndex(params.descriptor)),
       _shouldDedup(params.descriptor->isMultikey(opCtx)),
@@ -90,7 +89,8 @@ CountScan::CountScan(OperationContext* opCtx, const CountScanParams& params, Wor
     _specificStats.indexVersion = static_cast<int>(_params.descriptor->version());
 
     // endKey must be after startKey in index order since we only do forward scans.
-    dassert(_params.startKey.woCompare(_params.endKey,
+    dassert(_params.bounds.size() > 0 ||
+            _params.startKey.woCompare(_params.endKey,
                                        Ordering::make(params.descriptor->keyPattern()),
                                        /*compareFieldNames*/ false) <= 0);
 }
@@ -103,18 +103,32 @@ PlanStage::StageState CountScan::doWork(WorkingSetID* out) {
     boost::optional<IndexKeyEntry> entry;
     const bool needInit = !_cursor;
     try {
-        // We don't care about the keys.
-        const auto kWantLoc = SortedDataInterface::Cursor::kWantLoc;
+        // We only care about the keys if the bounds checker has to look at them.
+        const auto parts = _params.bounds.size() > 0 ? SortedDataInterface::Cursor::kKeyAndLoc
+                                                     : SortedDataInterface::Cursor::kWantLoc;
 
         if (needInit) {
             // First call to work().  Perform cursor init.
             _cursor = _iam->newCursor(getOpCtx());
-            _cursor->setEndPosition(_params.endKey, _params.endKeyInclusive);
-
-            entry = _cursor->seek(_params.startKey, _params.startKeyInclusive, kWantLoc);
+            ++_specificStats.seeks;
+
+            if (_params.bounds.size() > 0) {
+                _checker = stdx::make_unique<IndexBoundsChecker>(
+                    &_params.bounds, _descriptor->keyPattern(), 1);
+                if (_checker->getStartSeekPoint(&_seekPoint)) {
+                    entry = _cursor->seek(_seekPoint, parts);
+                }
+            } else {
+                _cursor->setEndPosition(_params.endKey, _params.endKeyInclusive);
+                entry = _cursor->seek(_params.startKey, _params.startKeyInclusive, parts);
+            }
+        } else if (_needSeek) {
+            ++_specificStats.seeks;
+            entry = _cursor->seek(_seekPoint, parts);
         } else {
-            entry = _cursor->next(kWantLoc);
+            entry = _cursor->next(parts);
         }
+        _needSeek = false;
     } catch (const WriteConflictException&) {
         if (needInit) {
             // Release our cursor and try again next time.
@@ -126,6 +140,21 @@ PlanStage::StageState CountScan::doWork(WorkingSetID* out) {
 
     ++_specificStats.keysExamined;
 
+    if (entry && _checker) {
+        switch (_checker->checkKey(entry->key, &_seekPoint)) {
+            case IndexBoundsChecker::VALID:
+                break;
+
+            case IndexBoundsChecker::DONE:
+                entry = boost::none;
+                break;
+
+            case IndexBoundsChecker::MUST_ADVANCE:
+                _needSeek = true;
+                return PlanStage::NEED_TIME;
+        }
+    }
+
     if (!entry) {
         _commonStats.isEOF = true;
         _cursor.reset();
@@ -137,9 +166,7 @@ PlanStage::StageState CountScan::doWork(WorkingSetID* out) {
         return PlanStage::NEED_TIME;
     }
 
-    WorkingSetID id = _workingSet->allocate();
-    _workingSet->transitionToRecordIdAndObj(id);
-    *out = id;
+    *out = WorkingSet::INVALID_ID;
     return PlanStage::ADVANCED;
 }
 
@@ -148,8 +175,15 @@ bool CountScan::isEOF() {
 }
 
 void CountScan::doSaveState() {
-    if (_cursor)
-        _cursor->save();
+    if (!_cursor)
+        return;
+
+    if (_needSeek) {
+        _cursor->saveUnpositioned();
+        return;
+    }
+
+    _cursor->save();
 }
 
 void CountScan::doRestoreState() {
@@ -192,10 +226,14 @@ unique_ptr<PlanStageStats> CountScan::getStats() {
     unique_ptr<CountScanStats> countStats = make_unique<CountScanStats>(_specificStats);
     countStats->keyPattern = _specificStats.keyPattern.getOwned();
 
-    countStats->startKey = replaceBSONFieldNames(_params.startKey, countStats->keyPattern);
-    countStats->startKeyInclusive = _params.startKeyInclusive;
-    countStats->endKey = replaceBSONFieldNames(_params.endKey, countStats->keyPattern);
-    countStats->endKeyInclusive = _params.endKeyInclusive;
+    if (_params.bounds.size() > 0) {
+        countStats->indexBounds = _params.bounds.toBSON();
+    } else {
+        countStats->startKey = replaceBSONFieldNames(_params.startKey, countStats->keyPattern);
+        countStats->startKeyInclusive = _params.startKeyInclusive;
+        countStats->endKey = replaceBSONFieldNames(_params.endKey, countStats->keyPattern);
+        countStats->endKeyInclusive = _params.endKeyInclusive;
+    }
 
     ret->specific = std::move(countStats);
 
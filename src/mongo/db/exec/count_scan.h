@@ -34,6 +34,7 @@
 #include "mongo/db/jsobj.h"
 #include "mongo/db/matcher/expression.h"
 #include "mongo/db/operation_context.h"
+#include "mongo/db/query/index_bounds.h"
 #include "mongo/db/record_id.h"
 #include "mongo/platform/unordered_set.h"
 
@@ -54,19 +55,24 @@ struct CountScanParams {
 
     BSONObj endKey;
     bool endKeyInclusive;
+
+    // If non-empty, the scan counts the keys within these bounds, which may have any number of
+    // intervals per field, and the start and end keys are ignored.
+    IndexBounds bounds;
 };
 
 /**
- * Used by the count command. Scans an index from a start key to an end key. Creates a
- * WorkingSetMember for each matching index key in RID_AND_OBJ state. It has a null record id and an
- * empty object with a null snapshot id rather than real data. Returning real data is unnecessary
- * since all we need is the count.
+ * Used by the count command. Scans an index from a start key to an end key, or over a set of
+ * multi-interval bounds, skipping from one interval to the next with an IndexBoundsChecker.
+ * Returns ADVANCED once for each matching index key, with WorkingSet::INVALID_ID rather than a
+ * WorkingSetMember. Returning data is unnecessary since all we need is the count.
  *
  * Only created through the getExecutorCount() path, as count is the only operation that doesn't
  * care about its data.
  */
 class CountScan final : public PlanStage {
 public:
+    // 'workingSet' is unused, since the scan never allocates working set members.
     CountScan(OperationContext* opCtx, const CountScanParams& params, WorkingSet* workingSet);
 
     StageState doWork(WorkingSetID* out) final;
@@ -88,15 +94,20 @@ public:
     static const char* kStageType;
 
 private:
-    // The WorkingSet we annotate with results.  Not owned by us.
-    WorkingSet* _workingSet;
-
     // Index access.  Both pointers below are owned by Collection -> IndexCatalog.
     const IndexDescriptor* _descriptor;
     const IndexAccessMethod* _iam;
 
     std::unique_ptr<SortedDataInterface::Cursor> _cursor;
 
+    // Only used for multi-interval bounds. Decides which keys are in the bounds, and where to seek
+    // to when a key is not.
+    std::unique_ptr<IndexBoundsChecker> _checker;
+    IndexSeekPoint _seekPoint;
+
+    // Set when the next call to work() should seek to _seekPoint rather than advance the cursor.
+    bool _needSeek = false;
+
     // Could our index have duplicates?  If so, we use _returned to dedup.
     bool _shouldDedup;
     unordered_set<RecordId, RecordId::Hasher> _returned;
@@ -30,11 +30,15 @@
 
 #include "mongo/db/exec/fetch.h"
 
+#include <algorithm>
+
 #include "mongo/db/catalog/collection.h"
 #include "mongo/db/concurrency/write_conflict_exception.h"
 #include "mongo/db/exec/filter.h"
+#include "mongo/db/exec/projection.h"
 #include "mongo/db/exec/scoped_timer.h"
 #include "mongo/db/exec/working_set_common.h"
+#include "mongo/db/query/query_knobs.h"
 #include "mongo/db/storage/record_fetcher.h"
 #include "mongo/stdx/memory.h"
 #include "mongo/util/fail_point_service.h"
@@ -53,13 +57,23 @@ FetchStage::FetchStage(OperationContext* opCtx,
                        WorkingSet* ws,
                        PlanStage* child,
                        const MatchExpression* filter,
-                       const Collection* collection)
+                       const Collection* collection,
+                       const BSONObj& simpleProjection)
     : PlanStage(kStageType, opCtx),
       _collection(collection),
       _ws(ws),
       _filter(filter),
-      _idRetrying(WorkingSet::INVALID_ID) {
+      _idRetrying(WorkingSet::INVALID_ID),
+      _batchEndStateId(WorkingSet::INVALID_ID),
+      _prefetchBatchSize(internalQueryExecFetchPrefetchBatchSize.load() > 1
+                             ? internalQueryExecFetchPrefetchBatchSize.load()
+                             : 0),
+      _simpleProjection(simpleProjection.getOwned()) {
     _children.emplace_back(child);
+
+    if (!_simpleProjection.isEmpty()) {
+        ProjectionStage::getSimpleInclusionFields(_simpleProjection, &_projectedFields);
+    }
 }
 
 FetchStage::~FetchStage() {}
@@ -71,6 +85,12 @@ bool FetchStage::isEOF() {
         return false;
     }
 
+    if (_batchPos < _batchIds.size() || PlanStage::NEED_TIME != _batchEndState) {
+        // There are results, or the reason our child stopped producing them, still buffered from
+        // a call to doWorkBatch().
+        return false;
+    }
+
     return child()->isEOF();
 }
 
@@ -79,58 +99,37 @@ PlanStage::StageState FetchStage::doWork(WorkingSetID* out) {
         return PlanStage::IS_EOF;
     }
 
-    // Either retry the last WSM we worked on or get a new one from our child.
+    // When prefetching, refill the buffer from our child rather than taking one result at a time.
+    if (_prefetchBatchSize && _idRetrying == WorkingSet::INVALID_ID &&
+        _batchPos >= _batchIds.size() && PlanStage::NEED_TIME == _batchEndState) {
+        StageState childState = bufferChildBatch(_prefetchBatchSize);
+        if (_batchIds.empty() && PlanStage::NEED_TIME == _batchEndState) {
+            return PlanStage::IS_EOF == childState ? PlanStage::IS_EOF : PlanStage::NEED_TIME;
+        }
+    }
+
+    // Either retry the last WSM we worked on, take one buffered by doWorkBatch() or by prefetching,
+    // or get a new one from our child.
     WorkingSetID id;
     StageState status;
-    if (_idRetrying == WorkingSet::INVALID_ID) {
-        status = child()->work(&id);
-    } else {
+    if (_idRetrying != WorkingSet::INVALID_ID) {
         status = ADVANCED;
         id = _idRetrying;
         _idRetrying = WorkingSet::INVALID_ID;
+    } else if (_batchPos < _batchIds.size()) {
+        status = ADVANCED;
+        id = _batchIds[_batchPos++];
+    } else if (PlanStage::NEED_TIME != _batchEndState) {
+        status = _batchEndState;
+        id = _batchEndStateId;
+        _batchEndState = PlanStage::NEED_TIME;
+        _batchEndStateId = WorkingSet::INVALID_ID;
+    } else {
+        status = child()->work(&id);
     }
 
     if (PlanStage::ADVANCED == status) {
-        WorkingSetMember* member = _ws->get(id);
-
-        // If there's an obj there, there is no fetching to perform.
-        if (member->hasObj()) {
-            ++_specificStats.alreadyHasObj;
-        } else {
-            // We need a valid RecordId to fetch from and this is the only state that has one.
-            verify(WorkingSetMember::RID_AND_IDX == member->getState());
-            verify(member->hasRecordId());
-
-            try {
-                if (!_cursor)
-                    _cursor = _collection->getCursor(getOpCtx());
-
-                if (auto fetcher = _cursor->fetcherForId(member->recordId)) {
-                    // There's something to fetch. Hand the fetcher off to the WSM, and pass up
-                    // a fetch request.
-                    _idRetrying = id;
-                    member->setFetcher(fetcher.release());
-                    *out = id;
-                    return NEED_YIELD;
-                }
-
-                // The doc is already in memory, so go ahead and grab it. Now we have a RecordId
-                // as well as an unowned object
-                if (!WorkingSetCommon::fetch(getOpCtx(), _ws, id, _cursor)) {
-                    _ws->free(id);
-                    return NEED_TIME;
-                }
-            } catch (const WriteConflictException&) {
-                // Ensure that the BSONObj underlying the WorkingSetMember is owned because it may
-                // be freed when we yield.
-                member->makeObjOwnedIfNeeded();
-                _idRetrying = id;
-                *out = WorkingSet::INVALID_ID;
-                return NEED_YIELD;
-            }
-        }
-
-        return returnIfMatches(member, id, out);
+        return fetchAndFilter(id, out);
     } else if (PlanStage::FAILURE == status || PlanStage::DEAD == status) {
         *out = id;
         // If a stage fails, it may create a status WSM to indicate why it
@@ -150,6 +149,153 @@ PlanStage::StageState FetchStage::doWork(WorkingSetID* out) {
     return status;
 }
 
+PlanStage::StageState FetchStage::doWorkBatch(WorkingSet* ws,
+                                              size_t maxWorks,
+                                              std::vector<WorkingSetID>* out,
+                                              WorkingSetID* stateId) {
+    const size_t initialSize = out->size();
+    for (size_t i = 0; i < maxWorks; ++i) {
+        ++_commonStats.works;
+
+        WorkingSetID id;
+        if (_idRetrying != WorkingSet::INVALID_ID) {
+            id = _idRetrying;
+            _idRetrying = WorkingSet::INVALID_ID;
+        } else if (_batchPos < _batchIds.size()) {
+            id = _batchIds[_batchPos++];
+        } else if (PlanStage::NEED_TIME != _batchEndState) {
+            // Every result our child produced before it stopped has been passed on, so we can
+            // now report why it stopped. doWork() knows how to do that.
+            return doWork(stateId);
+        } else {
+            StageState childState = bufferChildBatch(maxWorks - i);
+            if (PlanStage::IS_EOF == childState && _batchIds.empty()) {
+                return PlanStage::IS_EOF;
+            }
+
+            ++_commonStats.needTime;
+            continue;
+        }
+
+        StageState state = fetchAndFilter(id, stateId);
+        if (PlanStage::ADVANCED == state) {
+            makeResultOwned(_ws->get(id));
+            out->push_back(id);
+            *stateId = WorkingSet::INVALID_ID;
+        } else if (PlanStage::NEED_TIME == state) {
+            ++_commonStats.needTime;
+        } else {
+            invariant(PlanStage::NEED_YIELD == state);
+            return state;
+        }
+    }
+
+    return batchExhaustedState(*out, initialSize);
+}
+
+PlanStage::StageState FetchStage::bufferChildBatch(size_t maxWorks) {
+    _batchIds.clear();
+    _batchPos = 0;
+
+    WorkingSetID childStateId = WorkingSet::INVALID_ID;
+    StageState childState = child()->workBatch(_ws, maxWorks, &_batchIds, &childStateId);
+    if (PlanStage::NEED_YIELD == childState || PlanStage::FAILURE == childState ||
+        PlanStage::DEAD == childState) {
+        _batchEndState = childState;
+        _batchEndStateId = childStateId;
+    }
+
+    prefetchBuffered();
+    return childState;
+}
+
+void FetchStage::prefetchBuffered() {
+    if (!_prefetchBatchSize) {
+        return;
+    }
+
+    std::vector<RecordId> ids;
+    ids.reserve(_batchIds.size());
+    for (auto&& id : _batchIds) {
+        WorkingSetMember* member = _ws->get(id);
+        if (WorkingSetMember::RID_AND_IDX == member->getState()) {
+            ids.push_back(member->recordId);
+        }
+    }
+    if (ids.size() < 2) {
+        return;
+    }
+
+    std::sort(ids.begin(), ids.end());
+    ids.erase(std::unique(ids.begin(), ids.end()), ids.end());
+
+    try {
+        if (!_cursor)
+            _cursor = _collection->getCursor(getOpCtx());
+        _cursor->prefetch(ids);
+        _specificStats.recordsPrefetched += ids.size();
+    } catch (const WriteConflictException&) {
+        // The prefetch is only a hint. Each record is still fetched, and any write conflict
+        // handled, individually.
+    }
+}
+
+void FetchStage::makeResultOwned(WorkingSetMember* member) {
+    if (_projectedFields.empty() || !member->hasObj() || member->obj.value().isOwned()) {
+        member->makeObjOwnedIfNeeded();
+        return;
+    }
+
+    // The projection above us would drop every other field, so there is no need to copy them.
+    BSONObjBuilder bob;
+    ProjectionStage::transformSimpleInclusion(member->obj.value(), _projectedFields, bob);
+    member->obj.setValue(bob.obj());
+    ++_specificStats.docsPartiallyMaterialized;
+}
+
+PlanStage::StageState FetchStage::fetchAndFilter(WorkingSetID id, WorkingSetID* out) {
+    WorkingSetMember* member = _ws->get(id);
+
+    // If there's an obj there, there is no fetching to perform.
+    if (member->hasObj()) {
+        ++_specificStats.alreadyHasObj;
+    } else {
+        // We need a valid RecordId to fetch from and this is the only state that has one.
+        verify(WorkingSetMember::RID_AND_IDX == member->getState());
+        verify(member->hasRecordId());
+
+        try {
+            if (!_cursor)
+                _cursor = _collection->getCursor(getOpCtx());
+
+            if (auto fetcher = _cursor->fetcherForId(member->recordId)) {
+                // There's something to fetch. Hand the fetcher off to the WSM, and pass up
+                // a fetch request.
+                _idRetrying = id;
+                member->setFetcher(fetcher.release());
+                *out = id;
+                return NEED_YIELD;
+            }
+
+            // The doc is already in memory, so go ahead and grab it. Now we have a RecordId
+            // as well as an unowned object
+            if (!WorkingSetCommon::fetch(getOpCtx(), _ws, id, _cursor)) {
+                _ws->free(id);
+                return NEED_TIME;
+            }
+        } catch (const WriteConflictException&) {
+            // Ensure that the BSONObj underlying the WorkingSetMember is owned because it may
+            // be freed when we yield.
+            member->makeObjOwnedIfNeeded();
+            _idRetrying = id;
+            *out = WorkingSet::INVALID_ID;
+            return NEED_YIELD;
+        }
+    }
+
+    return returnIfMatches(member, id, out);
+}
+
 void FetchStage::doSaveState() {
     if (_cursor)
         _cursor->saveUnpositioned();
@@ -180,6 +326,14 @@ void FetchStage::doInvalidate(OperationContext* opCtx, const RecordId& dl, Inval
             WorkingSetCommon::fetchAndInvalidateRecordId(opCtx, member, _collection);
         }
     }
+
+    // The same goes for any results buffered by doWorkBatch() which we haven't fetched yet.
+    for (size_t i = _batchPos; i < _batchIds.size(); ++i) {
+        WorkingSetMember* member = _ws->get(_batchIds[i]);
+        if (member->hasRecordId() && (member->recordId == dl)) {
+            WorkingSetCommon::fetchAndInvalidateRecordId(opCtx, member, _collection);
+        }
+    }
 }
 
 PlanStage::StageState FetchStage::returnIfMatches(WorkingSetMember* member,
@@ -34,6 +34,7 @@
 #include "mongo/db/jsobj.h"
 #include "mongo/db/matcher/expression.h"
 #include "mongo/db/record_id.h"
+#include "mongo/util/string_map.h"
 
 namespace mongo {
 
@@ -45,6 +46,15 @@ class SeekableRecordCursor;
  * In WorkingSetMember terms, it transitions from RID_AND_IDX to RID_AND_OBJ by reading
  * the record at the provided RecordId.  Returns verbatim any data that already has an object.
  *
+ * If internalQueryExecFetchPrefetchBatchSize is at least 2, results are buffered from the child
+ * in batches and the storage engine is given the sorted RecordIds of each batch as a prefetch
+ * hint. Results are still returned in the order the child produced them.
+ *
+ * If the stage is given a simple inclusion projection which is applied directly above it, then
+ * whenever it must make a fetched document owned, it copies only the projected top-level fields
+ * out of the record rather than the whole document. The filter is always applied to the complete
+ * record first.
+ *
  * Preconditions: Valid RecordId.
  */
 class FetchStage : public PlanStage {
@@ -53,12 +63,17 @@ public:
                WorkingSet* ws,
                PlanStage* child,
                const MatchExpression* filter,
-               const Collection* collection);
+               const Collection* collection,
+               const BSONObj& simpleProjection = BSONObj());
 
     ~FetchStage();
 
     bool isEOF() final;
     StageState doWork(WorkingSetID* out) final;
+    StageState doWorkBatch(WorkingSet* ws,
+                           size_t maxWorks,
+                           std::vector<WorkingSetID>* out,
+                           WorkingSetID* stateId) final;
 
     void doSaveState() final;
     void doRestoreState() final;
@@ -70,6 +85,10 @@ public:
         return STAGE_FETCH;
     }
 
+    bool supportsBatchedWork() const final {
+        return childrenSupportBatchedWork();
+    }
+
     std::unique_ptr<PlanStageStats> getStats();
 
     const SpecificStats* getSpecificStats() const final;
@@ -77,12 +96,38 @@ public:
     static const char* kStageType;
 
 private:
+    /**
+     * Fetches the document for the member with id 'id' if it doesn't have one yet, then applies
+     * our filter to it. Returns ADVANCED, NEED_TIME or NEED_YIELD, with '*out' populated as for
+     * doWork().
+     */
+    StageState fetchAndFilter(WorkingSetID id, WorkingSetID* out);
+
     /**
      * If the member (with id memberID) passes our filter, set *out to memberID and return that
      * ADVANCED.  Otherwise, free memberID and return NEED_TIME.
      */
     StageState returnIfMatches(WorkingSetMember* member, WorkingSetID memberID, WorkingSetID* out);
 
+    /**
+     * Asks our child for up to 'maxWorks' units of work, buffering the results in '_batchIds' and
+     * the state which ended the batch, if any, in '_batchEndState'. Then hints to the storage
+     * engine that the buffered records are about to be fetched. Returns the child's final state.
+     */
+    StageState bufferChildBatch(size_t maxWorks);
+
+    /**
+     * Passes the sorted, distinct RecordIds of the buffered members which still need fetching to
+     * the cursor's prefetch(). Does nothing if prefetching is disabled.
+     */
+    void prefetchBuffered();
+
+    /**
+     * Makes the object of the member about to be returned owned. If we have a projection and the
+     * object is still a view of the record, only the projected fields are copied.
+     */
+    void makeResultOwned(WorkingSetMember* member);
+
     // Collection which is used by this stage. Used to resolve record ids retrieved by child
     // stages. The lifetime of the collection must supersede that of the stage.
     const Collection* _collection;
@@ -98,6 +143,25 @@ private:
     // If not Null, we use this rather than asking our child what to do next.
     WorkingSetID _idRetrying;
 
+    // Results obtained from our child by doWorkBatch() which we have yet to fetch. They are
+    // consumed from position '_batchPos' onwards.
+    std::vector<WorkingSetID> _batchIds;
+    size_t _batchPos = 0;
+
+    // If our child's last batch ended with NEED_YIELD, DEAD or FAILURE, that state and the id
+    // that came with it. They are passed on once '_batchIds' has been consumed. NEED_TIME means
+    // there is nothing to pass on.
+    StageState _batchEndState = PlanStage::NEED_TIME;
+    WorkingSetID _batchEndStateId;
+
+    // How many results to buffer from our child for prefetching. 0 if prefetching is disabled.
+    const size_t _prefetchBatchSize;
+
+    // The simple inclusion projection applied above us, if any, and the top-level fields it
+    // includes. '_projectedFields' points into '_simpleProjection'.
+    BSONObj _simpleProjection;
+    StringMap<bool> _projectedFields;
+
     // Stats
     FetchStats _specificStats;
 };
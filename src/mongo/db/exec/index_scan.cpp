@@ -237,6 +237,31 @@ PlanStage::StageState IndexScan::doWork(WorkingSetID* out) {
     return PlanStage::ADVANCED;
 }
 
+PlanStage::StageState IndexScan::doWorkBatch(WorkingSet* ws,
+                                             size_t maxWorks,
+                                             std::vector<WorkingSetID>* out,
+                                             WorkingSetID* stateId) {
+    // Index keys are always made owned before they are handed out, so results can be buffered
+    // without any extra copying.
+    const size_t initialSize = out->size();
+    for (size_t i = 0; i < maxWorks; ++i) {
+        ++_commonStats.works;
+
+        WorkingSetID id = WorkingSet::INVALID_ID;
+        StageState state = doWork(&id);
+        if (PlanStage::ADVANCED == state) {
+            out->push_back(id);
+        } else if (PlanStage::NEED_TIME == state) {
+            ++_commonStats.needTime;
+        } else {
+            *stateId = id;
+            return state;
+        }
+    }
+
+    return batchExhaustedState(*out, initialSize);
+}
+
 bool IndexScan::isEOF() {
     return _commonStats.isEOF;
 }
@@ -96,6 +96,10 @@ public:
               const MatchExpression* filter);
 
     StageState doWork(WorkingSetID* out) final;
+    StageState doWorkBatch(WorkingSet* ws,
+                           size_t maxWorks,
+                           std::vector<WorkingSetID>* out,
+                           WorkingSetID* stateId) final;
     bool isEOF() final;
     void doSaveState() final;
     void doRestoreState() final;
@@ -107,6 +111,10 @@ public:
         return STAGE_IXSCAN;
     }
 
+    bool supportsBatchedWork() const final {
+        return true;
+    }
+
     std::unique_ptr<PlanStageStats> getStats() final;
 
     const SpecificStats* getSpecificStats() const final;
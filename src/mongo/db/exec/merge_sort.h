@@ -33,6 +33,7 @@
 #include <vector>
 
 #include "mongo/db/exec/plan_stage.h"
+#include "mongo/db/exec/record_id_set.h"
 #include "mongo/db/exec/working_set.h"
 #include "mongo/db/jsobj.h"
 #include "mongo/db/record_id.h"
@@ -96,7 +97,7 @@ private:
     bool _dedup;
 
     // Which RecordIds have we seen?
-    unordered_set<RecordId, RecordId::Hasher> _seen;
+    RecordIdSet _seen;
 
     // In order to pick the next smallest value, we need each child work(...) until it produces
     // a result.  This is the queue of children that haven't given us a result yet.
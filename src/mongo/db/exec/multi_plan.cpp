@@ -39,14 +39,22 @@
 #include "mongo/db/catalog/collection.h"
 #include "mongo/db/catalog/database.h"
 #include "mongo/db/client.h"
+#include "mongo/db/concurrency/d_concurrency.h"
 #include "mongo/db/concurrency/write_conflict_exception.h"
+#include "mongo/db/exec/parallel_collection_scan.h"
 #include "mongo/db/exec/scoped_timer.h"
 #include "mongo/db/exec/working_set_common.h"
 #include "mongo/db/query/explain.h"
 #include "mongo/db/query/plan_cache.h"
 #include "mongo/db/query/plan_ranker.h"
+#include "mongo/db/query/query_knobs.h"
+#include "mongo/db/query/query_worker_pool.h"
+#include "mongo/db/service_context.h"
 #include "mongo/db/storage/record_fetcher.h"
+#include "mongo/platform/atomic_word.h"
+#include "mongo/stdx/condition_variable.h"
 #include "mongo/stdx/memory.h"
+#include "mongo/stdx/mutex.h"
 #include "mongo/util/log.h"
 #include "mongo/util/mongoutils/str.h"
 
@@ -61,6 +69,161 @@ using stdx::make_unique;
 // static
 const char* MultiPlanStage::kStageType = "MULTI_PLAN";
 
+namespace {
+
+// How long a worker waits for the locks it needs to work a candidate before skipping the round.
+const Milliseconds kWorkerLockTimeout{10};
+
+// How often the thread waiting for a round checks whether the operation has been interrupted.
+const Milliseconds kInterruptCheckPeriod{10};
+
+/**
+ * The intent shared locks a worker needs to read the candidates' collection on an
+ * OperationContext of its own. They are always compatible with the locks the calling thread holds
+ * for the round, but may queue behind a conflicting request which is itself waiting for the calling
+ * thread, so they are requested with a timeout rather than blocking.
+ */
+class WorkerLocks {
+    MONGO_DISALLOW_COPYING(WorkerLocks);
+
+public:
+    WorkerLocks(OperationContext* opCtx, const NamespaceString& nss)
+        : _locker(opCtx->lockState()),
+          _globalLock(opCtx, MODE_IS, durationCount<Milliseconds>(kWorkerLockTimeout)),
+          _dbId(RESOURCE_DATABASE, nss.db()),
+          _collectionId(RESOURCE_COLLECTION, nss.ns()) {
+        if (!_globalLock.isLocked()) {
+            return;
+        }
+        _dbLocked = LOCK_OK == _locker->lock(_dbId, MODE_IS, kWorkerLockTimeout);
+        _collectionLocked =
+            _dbLocked && LOCK_OK == _locker->lock(_collectionId, MODE_IS, kWorkerLockTimeout);
+    }
+
+    ~WorkerLocks() {
+        if (_collectionLocked) {
+            _locker->unlock(_collectionId);
+        }
+        if (_dbLocked) {
+            _locker->unlock(_dbId);
+        }
+    }
+
+    bool isLocked() const {
+        return _collectionLocked;
+    }
+
+private:
+    Locker* const _locker;
+    Lock::GlobalLock _globalLock;
+    const ResourceId _dbId;
+    const ResourceId _collectionId;
+    bool _dbLocked = false;
+    bool _collectionLocked = false;
+};
+
+/**
+ * The outcome of working one candidate on a worker thread for a round of its trial period.
+ */
+struct TrialRound {
+    // Set if the candidate hit EOF or returned enough results to end the trial period.
+    bool doneWorking = false;
+
+    // Set to FAILURE or DEAD, along with the id of the status member, if the candidate failed.
+    boost::optional<PlanStage::StageState> failedState;
+    WorkingSetID failedId = WorkingSet::INVALID_ID;
+
+    // Set if working the candidate threw. It is rethrown on the calling thread.
+    Status status = Status::OK();
+};
+
+/**
+ * Works 'candidate', which reads from the collection 'nss', up to 'numWorks' times on the
+ * calling pool thread, with an OperationContext, and so a snapshot, of its own. Stops early if
+ * 'stop' is set by the worker of another candidate, and sets it if this candidate ends the trial
+ * period. Fails the round once 'deadline' passes or 'interrupted' is set. If the worker can't take
+ * its locks promptly, the candidate isn't worked this round.
+ *
+ * The candidate's plan must be saved and detached from any OperationContext, and is left that way.
+ */
+void workCandidate(CandidatePlan* candidate,
+                   const NamespaceString& nss,
+                   size_t numWorks,
+                   size_t numResults,
+                   Date_t deadline,
+                   const AtomicWord<bool>* interrupted,
+                   AtomicBool* stop,
+                   TrialRound* round) {
+    auto opCtx = cc().makeOperationContext();
+
+    // The calling thread holds the parallel batch writer lock for the round on the worker's behalf.
+    opCtx->lockState()->setShouldConflictWithSecondaryBatchApplication(false);
+
+    // The worker's OperationContext inherits the operation's maxTimeMS, and is killed along with
+    // the operation, so that stages which check for interrupts on their own stop too.
+    opCtx->setDeadlineByDate(deadline);
+
+    WorkerLocks locks(opCtx.get(), nss);
+    if (!locks.isLocked()) {
+        return;
+    }
+
+    PlanStage* root = candidate->root;
+    root->reattachToOperationContext(opCtx.get());
+
+    try {
+        root->restoreState();
+
+        for (size_t ix = 0; ix < numWorks && !stop->load(); ++ix) {
+            if (interrupted->load()) {
+                opCtx->markKilled();
+            }
+            opCtx->checkForInterrupt();
+
+            WorkingSetID id = WorkingSet::INVALID_ID;
+            PlanStage::StageState state = root->work(&id);
+
+            if (PlanStage::ADVANCED == state) {
+                WorkingSetMember* member = candidate->ws->get(id);
+                member->makeObjOwnedIfNeeded();
+                candidate->results.push_back(id);
+
+                if (candidate->results.size() >= numResults) {
+                    round->doneWorking = true;
+                }
+            } else if (PlanStage::IS_EOF == state) {
+                round->doneWorking = true;
+            } else if (PlanStage::NEED_YIELD == state) {
+                // The next round runs on a fresh snapshot, which is all a yield would get us.
+                if (id != WorkingSet::INVALID_ID) {
+                    std::unique_ptr<RecordFetcher> fetcher(
+                        candidate->ws->get(id)->releaseFetcher());
+                }
+                break;
+            } else if (PlanStage::NEED_TIME != state) {
+                round->failedState = state;
+                round->failedId = id;
+                break;
+            }
+
+            if (round->doneWorking) {
+                stop->store(true);
+                break;
+            }
+        }
+    } catch (const WriteConflictException&) {
+        // Try again in the next round, on a fresh snapshot.
+    } catch (const DBException& ex) {
+        round->status = ex.toStatus();
+    }
+
+    root->saveState();
+    WorkingSetCommon::prepareForSnapshotChange(candidate->ws);
+    root->detachFromOperationContext();
+}
+
+}  // namespace
+
 MultiPlanStage::MultiPlanStage(OperationContext* opCtx,
                                const Collection* collection,
                                CanonicalQuery* cq,
@@ -80,6 +243,37 @@ MultiPlanStage::MultiPlanStage(OperationContext* opCtx,
 void MultiPlanStage::addPlan(QuerySolution* solution, PlanStage* root, WorkingSet* ws) {
     _candidates.push_back(CandidatePlan(solution, root, ws));
     _children.emplace_back(root);
+    _sharedWs = ws;
+}
+
+void MultiPlanStage::addPlan(QuerySolution* solution,
+                             PlanStage* root,
+                             WorkingSet* sharedWs,
+                             std::unique_ptr<WorkingSet> candidateWs) {
+    _candidates.push_back(CandidatePlan(solution, root, candidateWs.get()));
+    _children.emplace_back(root);
+    _sharedWs = sharedWs;
+    _candidateWorkingSets.push_back(std::move(candidateWs));
+}
+
+// static
+bool MultiPlanStage::canRunTrialsInParallel(OperationContext* opCtx, const CanonicalQuery& query) {
+    // Candidates worked on other threads read from snapshots of their own, so buffered RecordIds
+    // must not depend on invalidations to stay valid.
+    return internalQueryPlanEvaluationParallelTrials.load() &&
+        ParallelCollectionScan::canReadOnWorkers(opCtx) &&
+        ParallelCollectionScan::canEvaluateOnWorkers(query.root());
+}
+
+bool MultiPlanStage::trialsRunInParallel() const {
+    return _candidates.size() > 1 && _candidateWorkingSets.size() == _candidates.size();
+}
+
+WorkingSetID MultiPlanStage::toSharedWorkingSet(const CandidatePlan& candidate, WorkingSetID id) {
+    if (candidate.ws == _sharedWs || WorkingSet::INVALID_ID == id) {
+        return id;
+    }
+    return _sharedWs->moveFrom(candidate.ws, id);
 }
 
 bool MultiPlanStage::isEOF() {
@@ -108,7 +302,7 @@ PlanStage::StageState MultiPlanStage::doWork(WorkingSetID* out) {
 
     // Look for an already produced result that provides the data the caller wants.
     if (!bestPlan.results.empty()) {
-        *out = bestPlan.results.front();
+        *out = toSharedWorkingSet(bestPlan, bestPlan.results.front());
         bestPlan.results.pop_front();
         return PlanStage::ADVANCED;
     }
@@ -116,6 +310,9 @@ PlanStage::StageState MultiPlanStage::doWork(WorkingSetID* out) {
     // best plan had no (or has no more) cached results
 
     StageState state = bestPlan.root->work(out);
+    if (PlanStage::NEED_TIME != state && PlanStage::IS_EOF != state) {
+        *out = toSharedWorkingSet(bestPlan, *out);
+    }
 
     if (PlanStage::FAILURE == state && hasBackupPlan()) {
         LOG(5) << "Best plan errored out switching to backup";
@@ -132,7 +329,12 @@ PlanStage::StageState MultiPlanStage::doWork(WorkingSetID* out) {
         _bestPlanIdx = _backupPlanIdx;
         _backupPlanIdx = kNoSuchPlan;
 
-        return _candidates[_bestPlanIdx].root->work(out);
+        CandidatePlan& backupPlan = _candidates[_bestPlanIdx];
+        StageState backupState = backupPlan.root->work(out);
+        if (PlanStage::NEED_TIME != backupState && PlanStage::IS_EOF != backupState) {
+            *out = toSharedWorkingSet(backupPlan, *out);
+        }
+        return backupState;
     }
 
     if (hasBackupPlan() && PlanStage::ADVANCED == state) {
@@ -143,6 +345,36 @@ PlanStage::StageState MultiPlanStage::doWork(WorkingSetID* out) {
     return state;
 }
 
+PlanStage::StageState MultiPlanStage::doWorkBatch(WorkingSet* ws,
+                                                  size_t maxWorks,
+                                                  std::vector<WorkingSetID>* out,
+                                                  WorkingSetID* stateId) {
+    if (_failure || !bestPlanChosen() || hasBackupPlan() || trialsRunInParallel()) {
+        return PlanStage::doWorkBatch(ws, maxWorks, out, stateId);
+    }
+
+    CandidatePlan& bestPlan = _candidates[_bestPlanIdx];
+
+    // Look for already produced results that provide the data the caller wants.
+    if (!bestPlan.results.empty()) {
+        while (!bestPlan.results.empty() && maxWorks > 0) {
+            ++_commonStats.works;
+            out->push_back(bestPlan.results.front());
+            bestPlan.results.pop_front();
+            --maxWorks;
+        }
+        return PlanStage::ADVANCED;
+    }
+
+    ++_commonStats.works;
+    return bestPlan.root->workBatch(ws, maxWorks, out, stateId);
+}
+
+bool MultiPlanStage::supportsBatchedWork() const {
+    return bestPlanChosen() && !hasBackupPlan() && !trialsRunInParallel() &&
+        _candidates[_bestPlanIdx].root->supportsBatchedWork();
+}
+
 Status MultiPlanStage::tryYield(PlanYieldPolicy* yieldPolicy) {
     // These are the conditions which can cause us to yield:
     //   1) The yield policy's timer elapsed, or
@@ -154,8 +386,7 @@ Status MultiPlanStage::tryYield(PlanYieldPolicy* yieldPolicy) {
 
         if (!yieldStatus.isOK()) {
             _failure = true;
-            _statusMemberId =
-                WorkingSetCommon::allocateStatusMember(_candidates[0].ws, yieldStatus);
+            _statusMemberId = WorkingSetCommon::allocateStatusMember(_sharedWs, yieldStatus);
             return yieldStatus;
         }
     }
@@ -210,16 +441,32 @@ Status MultiPlanStage::pickBestPlan(PlanYieldPolicy* yieldPolicy) {
 
     // Work the plans, stopping when a plan hits EOF or returns some
     // fixed number of results.
-    for (size_t ix = 0; ix < numWorks; ++ix) {
-        bool moreToDo = workAllPlans(numResults, yieldPolicy);
-        if (!moreToDo) {
-            break;
+    if (trialsRunInParallel()) {
+        // Each round works every candidate as many times as we would between yields.
+        const size_t worksPerRound = std::max(1, internalQueryExecYieldIterations.load());
+        for (size_t ix = 0; ix < numWorks; ix += worksPerRound) {
+            if (!tryYield(yieldPolicy).isOK()) {
+                break;
+            }
+
+            bool moreToDo =
+                workAllPlansInParallel(std::min(worksPerRound, numWorks - ix), numResults);
+            if (!moreToDo) {
+                break;
+            }
+        }
+    } else {
+        for (size_t ix = 0; ix < numWorks; ++ix) {
+            bool moreToDo = workAllPlans(numResults, yieldPolicy);
+            if (!moreToDo) {
+                break;
+            }
         }
     }
 
     if (_failure) {
         invariant(WorkingSet::INVALID_ID != _statusMemberId);
-        WorkingSetMember* member = _candidates[0].ws->get(_statusMemberId);
+        WorkingSetMember* member = _sharedWs->get(_statusMemberId);
         return WorkingSetCommon::getMemberStatus(*member);
     }
 
@@ -408,6 +655,113 @@ bool MultiPlanStage::workAllPlans(size_t numResults, PlanYieldPolicy* yieldPolic
     return !doneWorking;
 }
 
+bool MultiPlanStage::workAllPlansInParallel(size_t numWorks, size_t numResults) {
+    std::vector<CandidatePlan*> toWork;
+    for (auto&& candidate : _candidates) {
+        if (!candidate.failed) {
+            toWork.push_back(&candidate);
+        }
+    }
+
+    // The candidates move to the workers' OperationContexts for the round, and back again
+    // afterwards, just as a plan moves between OperationContexts across getMores.
+    for (CandidatePlan* candidate : toWork) {
+        candidate->root->saveState();
+        candidate->root->detachFromOperationContext();
+    }
+
+    stdx::mutex mutex;
+    stdx::condition_variable done;
+    size_t remaining = toWork.size();
+    AtomicBool stop(false);
+    std::vector<TrialRound> rounds(toWork.size());
+
+    // Set if this operation is killed or times out while the workers run, so that they stop early.
+    AtomicWord<bool> interrupted{false};
+
+    const NamespaceString nss = _collection->ns();
+    const Date_t deadline = getOpCtx()->getDeadline();
+    for (size_t ix = 0; ix < toWork.size(); ++ix) {
+        auto task = [&, ix] {
+            workCandidate(toWork[ix],
+                          nss,
+                          numWorks,
+                          numResults,
+                          deadline,
+                          &interrupted,
+                          &stop,
+                          &rounds[ix]);
+
+            stdx::lock_guard<stdx::mutex> lk(mutex);
+            if (--remaining == 0) {
+                done.notify_one();
+            }
+        };
+
+        Status scheduled = QueryWorkerPool::get(getOpCtx()->getServiceContext()).schedule(task);
+        if (!scheduled.isOK()) {
+            // The pool is shutting down. Fail the query once the scheduled workers finish.
+            rounds[ix].status = scheduled;
+            stdx::lock_guard<stdx::mutex> lk(mutex);
+            --remaining;
+        }
+    }
+
+    {
+        // The candidates are detached until every worker finishes, so don't leave the round
+        // early, even if this operation is interrupted in the meantime.
+        stdx::unique_lock<stdx::mutex> lk(mutex);
+        while (!done.wait_for(
+            lk, kInterruptCheckPeriod.toSystemDuration(), [&] { return remaining == 0; })) {
+            if (!getOpCtx()->checkForInterruptNoAssert().isOK()) {
+                interrupted.store(true);
+            }
+        }
+    }
+
+    for (CandidatePlan* candidate : toWork) {
+        candidate->root->reattachToOperationContext(getOpCtx());
+        candidate->root->restoreState();
+    }
+    getOpCtx()->checkForInterrupt();
+
+    bool doneWorking = false;
+    for (size_t ix = 0; ix < toWork.size(); ++ix) {
+        CandidatePlan* candidate = toWork[ix];
+        const TrialRound& round = rounds[ix];
+        uassertStatusOK(round.status);
+
+        if (round.doneWorking) {
+            doneWorking = true;
+        }
+
+        if (round.failedState) {
+            candidate->failed = true;
+            ++_failureCount;
+
+            // Propagate most recent seen failure to parent.
+            if (PlanStage::FAILURE == *round.failedState) {
+                _statusMemberId = toSharedWorkingSet(*candidate, round.failedId);
+            }
+
+            if (_failureCount == _candidates.size()) {
+                _failure = true;
+                return false;
+            }
+        }
+    }
+
+    return !doneWorking;
+}
+
+void MultiPlanStage::doSaveState() {
+    // Our parent only prepares the WorkingSet it shares with us for a change of snapshot. The
+    // WorkingSets of candidates built on one of their own are prepared here.
+    for (auto&& ws : _candidateWorkingSets) {
+        WorkingSetCommon::prepareForSnapshotChange(ws.get());
+    }
+}
+
 namespace {
 
 void invalidateHelper(OperationContext* opCtx,
@@ -83,6 +83,12 @@ public:
     bool isEOF() final;
 
     StageState doWork(WorkingSetID* out) final;
+    StageState doWorkBatch(WorkingSet* ws,
+                           size_t maxWorks,
+                           std::vector<WorkingSetID>* out,
+                           WorkingSetID* stateId) final;
+
+    void doSaveState() final;
 
     void doInvalidate(OperationContext* opCtx, const RecordId& dl, InvalidationType type) final;
 
@@ -90,6 +96,12 @@ public:
         return STAGE_MULTI_PLAN;
     }
 
+    /**
+     * Batched work is only forwarded to the best plan once there is no backup plan left to fall
+     * back on, since switching plans part way through a batch is not supported.
+     */
+    bool supportsBatchedWork() const final;
+
     std::unique_ptr<PlanStageStats> getStats() final;
 
 
@@ -100,6 +112,25 @@ public:
      */
     void addPlan(QuerySolution* solution, PlanStage* root, WorkingSet* sharedWs);
 
+    /**
+     * Like addPlan(), but 'root' was built on 'candidateWs', a WorkingSet of its own, rather than
+     * on 'sharedWs'. If every candidate is added this way, their trial periods are run at the same
+     * time on worker threads. Results of the winning plan are moved into 'sharedWs' as they are
+     * returned.
+     *
+     * Takes ownership of QuerySolution, PlanStage and 'candidateWs'.
+     */
+    void addPlan(QuerySolution* solution,
+                 PlanStage* root,
+                 WorkingSet* sharedWs,
+                 std::unique_ptr<WorkingSet> candidateWs);
+
+    /**
+     * Returns true if the candidate plans for 'query' may have their trial periods run in
+     * parallel, in which case the caller should build each of them on a WorkingSet of its own.
+     */
+    static bool canRunTrialsInParallel(OperationContext* opCtx, const CanonicalQuery& query);
+
     /**
      * Runs all plans added by addPlan, ranks them, and picks a best.
      * All further calls to work(...) will return results from the best plan.
@@ -168,6 +199,27 @@ private:
      */
     bool workAllPlans(size_t numResults, PlanYieldPolicy* yieldPolicy);
 
+    /**
+     * Works each candidate which has not failed up to 'numWorks' times, all at once on worker
+     * threads, stopping every candidate as soon as one hits EOF or returns 'numResults' results.
+     * The calling thread waits for the workers, so they only run while it holds its locks.
+     *
+     * Returns true if we need to keep working the plans and false otherwise.
+     */
+    bool workAllPlansInParallel(size_t numWorks, size_t numResults);
+
+    /**
+     * Returns true if every candidate was built on a WorkingSet of its own, so that their trial
+     * periods may run in parallel.
+     */
+    bool trialsRunInParallel() const;
+
+    /**
+     * Moves the member 'id' of the WorkingSet 'candidate' was built on into the WorkingSet our
+     * parent reads from, returning its id there. A no-op if 'candidate' shares that WorkingSet.
+     */
+    WorkingSetID toSharedWorkingSet(const CandidatePlan& candidate, WorkingSetID id);
+
     /**
      * Checks whether we need to perform either a timing-based yield or a yield for a document
      * fetch. If so, then uses 'yieldPolicy' to actually perform the yield.
@@ -194,6 +246,12 @@ private:
     // one-to-one with _candidates.
     std::vector<CandidatePlan> _candidates;
 
+    // The WorkingSet our parent reads results from. Not owned here.
+    WorkingSet* _sharedWs = nullptr;
+
+    // The WorkingSets of candidates built on one of their own, rather than on '_sharedWs'.
+    std::vector<std::unique_ptr<WorkingSet>> _candidateWorkingSets;
+
     // index into _candidates, of the winner of the plan competition
     // uses -1 / kNoSuchPlan when best plan is not (yet) known
     int _bestPlanIdx;
@@ -0,0 +1,424 @@
+/**
+ *    Copyright (C) 2017 MongoDB Inc.
+ *
+ *    This program is free software: you can redistribute it and/or  modify
+ *    it under the terms of the GNU Affero General Public License, version 3,
+ *    as published by the Free Software Foundation.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU Affero General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Affero General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the GNU Affero General Public License in all respects for
+ *    all of the code used other than as permitted herein. If you modify file(s)
+ *    with this exception, you may extend this exception to your version of the
+ *    file(s), but you are not obligated to do so. If you do not wish to do so,
+ *    delete this exception statement from your version. If you delete this
+ *    exception statement from all source files in the program, then also delete
+ *    it in the license file.
+ */
+
+#define MONGO_LOG_DEFAULT_COMPONENT ::mongo::logger::LogComponent::kQuery
+
+#include "mongo/platform/basic.h"
+
+#include "mongo/db/exec/parallel_collection_scan.h"
+
+#include "mongo/db/catalog/collection.h"
+#include "mongo/db/catalog/database.h"
+#include "mongo/db/catalog/database_holder.h"
+#include "mongo/db/client.h"
+#include "mongo/db/concurrency/write_conflict_exception.h"
+#include "mongo/db/exec/scoped_timer.h"
+#include "mongo/db/exec/working_set.h"
+#include "mongo/db/exec/working_set_common.h"
+#include "mongo/db/matcher/expression.h"
+#include "mongo/db/operation_context.h"
+#include "mongo/db/query/query_knobs.h"
+#include "mongo/db/query/query_worker_pool.h"
+#include "mongo/db/service_context.h"
+#include "mongo/db/storage/record_store.h"
+#include "mongo/db/storage/storage_engine.h"
+#include "mongo/stdx/condition_variable.h"
+#include "mongo/stdx/memory.h"
+#include "mongo/stdx/mutex.h"
+#include "mongo/util/log.h"
+#include "mongo/util/mongoutils/str.h"
+
+namespace mongo {
+
+using std::unique_ptr;
+using stdx::make_unique;
+
+// static
+const char* ParallelCollectionScan::kStageType = "PARALLEL_COLLSCAN";
+
+// static
+bool ParallelCollectionScan::canEvaluateOnWorkers(const MatchExpression* expr) {
+    if (!expr) {
+        return true;
+    }
+
+    switch (expr->matchType()) {
+        case MatchExpression::WHERE:
+        case MatchExpression::EXPRESSION:
+        case MatchExpression::TEXT:
+        case MatchExpression::GEO_NEAR:
+            return false;
+        default:
+            break;
+    }
+
+    for (size_t i = 0; i < expr->numChildren(); ++i) {
+        if (!canEvaluateOnWorkers(expr->getChild(i))) {
+            return false;
+        }
+    }
+    return true;
+}
+
+// static
+bool ParallelCollectionScan::canReadOnWorkers(OperationContext* opCtx) {
+    // Each worker reads from its own snapshot while the calling thread holds the locks, which is
+    // only safe for storage engines with document-level concurrency control. A majority read
+    // concern would also have to be applied to every worker's snapshot.
+    return opCtx->getServiceContext()->getGlobalStorageEngine()->supportsDocLocking() &&
+        !opCtx->recoveryUnit()->isReadingFromMajorityCommittedSnapshot();
+}
+
+ParallelCollectionScan::ParallelCollectionScan(OperationContext* opCtx,
+                                               const ParallelCollectionScanParams& params,
+                                               WorkingSet* workingSet,
+                                               const MatchExpression* filter)
+    : PlanStage(kStageType, opCtx),
+      _workingSet(workingSet),
+      _filter(filter),
+      _params(params),
+      _nss(params.collection->ns()),
+      _uuid(params.collection->uuid()) {
+    invariant(_params.numRanges > 0);
+    invariant(_params.batchSize > 0);
+
+    if (!_params.projObj.isEmpty()) {
+        _projExec = make_unique<ProjectionExec>(
+            opCtx, _params.projObj, _params.fullExpression, _params.collator);
+    }
+
+    _specificStats.numRanges = _params.numRanges;
+    _specificStats.preserveOrder = _params.preserveOrder;
+    _specificStats.hasProjection = static_cast<bool>(_projExec);
+}
+
+ParallelCollectionScan::~ParallelCollectionScan() = default;
+
+// static
+bool ParallelCollectionScan::canRunInParallel(OperationContext* opCtx,
+                                              const Collection* collection,
+                                              const CollectionScanParams& params,
+                                              const MatchExpression* filter) {
+    if (internalQueryParallelCollectionScanWorkers.load() < 2) {
+        return false;
+    }
+
+    if (!collection || collection->isCapped() || !collection->getRecordStore() ||
+        !collection->getRecordStore()->supportsSeekAtOrAfter()) {
+        return false;
+    }
+
+    if (params.direction != CollectionScanParams::FORWARD || params.tailable ||
+        params.shouldTrackLatestOplogTimestamp || params.maxScan || params.maxTs ||
+        !params.start.isNull() || params.stopApplyingFilterAfterFirstMatch) {
+        return false;
+    }
+
+    if (!canReadOnWorkers(opCtx) || !canEvaluateOnWorkers(filter)) {
+        return false;
+    }
+
+    // Not worth starting workers for a collection which one batch covers.
+    const long long batchSize = internalQueryParallelCollectionScanBatchSize.load();
+    return collection->numRecords(opCtx) > batchSize;
+}
+
+bool ParallelCollectionScan::isEOF() {
+    if (!_initialized) {
+        return false;
+    }
+
+    for (auto&& range : _ranges) {
+        if (!range->exhausted || !range->results.empty()) {
+            return false;
+        }
+    }
+    return true;
+}
+
+PlanStage::StageState ParallelCollectionScan::doWork(WorkingSetID* out) {
+    if (!_initialized) {
+        initRanges();
+        _initialized = true;
+        return PlanStage::NEED_TIME;
+    }
+
+    if (isEOF()) {
+        return PlanStage::IS_EOF;
+    }
+
+    Range* range = nextReadyRange();
+    if (!range) {
+        runRound();
+
+        for (auto&& r : _ranges) {
+            if (!r->status.isOK()) {
+                *out = WorkingSetCommon::allocateStatusMember(_workingSet, r->status);
+                return PlanStage::FAILURE;
+            }
+        }
+
+        // Returning NEED_TIME gives the executor a chance to yield between rounds.
+        return PlanStage::NEED_TIME;
+    }
+
+    Result result = std::move(range->results.front());
+    range->results.pop_front();
+    range->resultBytes -= result.obj.objsize();
+
+    WorkingSetID id = _workingSet->allocate();
+    WorkingSetMember* member = _workingSet->get(id);
+    if (_projExec) {
+        member->obj = Snapshotted<BSONObj>(SnapshotId(), std::move(result.obj));
+        member->transitionToOwnedObj();
+    } else {
+        member->recordId = result.recordId;
+        member->obj = Snapshotted<BSONObj>(SnapshotId(), std::move(result.obj));
+        _workingSet->transitionToRecordIdAndObj(id);
+    }
+
+    *out = id;
+    return PlanStage::ADVANCED;
+}
+
+void ParallelCollectionScan::initRanges() {
+    // Find the bounds of the collection, then cut that span of RecordIds into equal pieces.
+    // RecordIds are not necessarily dense, so the ranges may hold different numbers of records.
+    const RecordStore* rs = _params.collection->getRecordStore();
+    auto first = rs->getCursor(getOpCtx(), true)->next();
+    auto last = rs->getCursor(getOpCtx(), false)->next();
+
+    size_t numRanges = _params.numRanges;
+    int64_t width = 0;
+    if (first && last && last->id.repr() > first->id.repr()) {
+        // Divide first so that the span can't overflow.
+        width = last->id.repr() / static_cast<int64_t>(numRanges) -
+            first->id.repr() / static_cast<int64_t>(numRanges) + 1;
+    } else {
+        numRanges = 1;
+    }
+
+    for (size_t i = 0; i < numRanges; ++i) {
+        auto range = make_unique<Range>();
+        if (i > 0) {
+            range->start = RecordId(first->id.repr() + width * static_cast<int64_t>(i));
+        }
+        if (i + 1 < numRanges) {
+            range->end = RecordId(first->id.repr() + width * static_cast<int64_t>(i + 1));
+        }
+        _ranges.push_back(std::move(range));
+    }
+    _specificStats.numRanges = _ranges.size();
+}
+
+ParallelCollectionScan::Range* ParallelCollectionScan::nextReadyRange() {
+    if (_params.preserveOrder) {
+        // Move past the ranges which are done.
+        while (_currentRange + 1 < _ranges.size() && _ranges[_currentRange]->exhausted &&
+               _ranges[_currentRange]->results.empty()) {
+            ++_currentRange;
+        }
+        Range* range = _ranges[_currentRange].get();
+        return range->results.empty() ? nullptr : range;
+    }
+
+    for (size_t i = 0; i < _ranges.size(); ++i) {
+        Range* range = _ranges[(_currentRange + i) % _ranges.size()].get();
+        if (!range->results.empty()) {
+            _currentRange = (_currentRange + i) % _ranges.size();
+            return range;
+        }
+    }
+    return nullptr;
+}
+
+void ParallelCollectionScan::runRound() {
+    std::vector<Range*> toFill;
+    for (auto&& range : _ranges) {
+        if (!range->exhausted && range->resultBytes < _params.maxBufferBytesPerRange) {
+            toFill.push_back(range.get());
+        }
+    }
+    invariant(!toFill.empty());
+    ++_specificStats.rounds;
+
+    stdx::mutex mutex;
+    stdx::condition_variable done;
+    size_t remaining = toFill.size();
+
+    for (Range* range : toFill) {
+        auto task = [this, range, &mutex, &done, &remaining] {
+            fillRange(range);
+
+            stdx::lock_guard<stdx::mutex> lk(mutex);
+            if (--remaining == 0) {
+                done.notify_one();
+            }
+        };
+
+        Status scheduled = QueryWorkerPool::get(getOpCtx()->getServiceContext()).schedule(task);
+        if (!scheduled.isOK()) {
+            // The pool is shutting down. Fail the scan once the scheduled workers finish.
+            range->status = scheduled;
+            stdx::lock_guard<stdx::mutex> lk(mutex);
+            --remaining;
+        }
+    }
+
+    stdx::unique_lock<stdx::mutex> lk(mutex);
+    done.wait(lk, [&] { return remaining == 0; });
+
+    for (Range* range : toFill) {
+        _specificStats.docsTested += range->docsTested;
+        _specificStats.writeConflicts += range->writeConflicts;
+        range->docsTested = 0;
+        range->writeConflicts = 0;
+    }
+}
+
+void ParallelCollectionScan::fillRange(Range* range) {
+    // Each round gets a fresh OperationContext, and so a fresh snapshot, on whichever pool thread
+    // runs it. The cursor is saved and detached at the end of every round, just as it would be for
+    // a yield.
+    auto opCtx = cc().makeOperationContext();
+    const RecordStore* rs = _params.collection->getRecordStore();
+
+    // Used to run the projection, which operates on WorkingSetMembers.
+    WorkingSet ws;
+
+    try {
+        boost::optional<Record> record;
+        if (!range->cursor) {
+            range->cursor = rs->getCursor(opCtx.get(), true);
+        } else {
+            range->cursor->reattachToOperationContext(opCtx.get());
+            if (!range->cursor->restore()) {
+                range->status = Status(ErrorCodes::CappedPositionLost,
+                                       "parallel collection scan lost its position");
+                range->cursor.reset();
+                return;
+            }
+        }
+
+        if (!range->positioned) {
+            record = range->start.isNull() ? range->cursor->next()
+                                           : range->cursor->seekAtOrAfter(range->start);
+            range->positioned = true;
+        } else {
+            record = range->cursor->next();
+        }
+
+        for (size_t examined = 0;; record = range->cursor->next()) {
+            if (!record || (!range->end.isNull() && record->id >= range->end)) {
+                range->exhausted = true;
+                range->cursor.reset();
+                return;
+            }
+
+            ++range->docsTested;
+            BSONObj obj = record->data.toBson();
+            if (!_filter || _filter->matchesBSON(obj)) {
+                if (_projExec) {
+                    WorkingSetID id = ws.allocate();
+                    WorkingSetMember* member = ws.get(id);
+                    member->recordId = record->id;
+                    member->obj = Snapshotted<BSONObj>(SnapshotId(), obj);
+                    ws.transitionToRecordIdAndObj(id);
+
+                    Status status = _projExec->transform(member);
+                    if (!status.isOK()) {
+                        range->status = status;
+                        range->cursor.reset();
+                        return;
+                    }
+                    obj = member->obj.value().getOwned();
+                    ws.free(id);
+                } else {
+                    obj = obj.getOwned();
+                }
+
+                range->resultBytes += obj.objsize();
+                range->results.push_back({record->id, std::move(obj)});
+            }
+
+            if (++examined >= _params.batchSize ||
+                range->resultBytes >= _params.maxBufferBytesPerRange) {
+                break;
+            }
+        }
+
+        range->cursor->save();
+        range->cursor->detachFromOperationContext();
+    } catch (const WriteConflictException&) {
+        // Nothing past the last record buffered has been consumed, so try again next round.
+        ++range->writeConflicts;
+        if (range->positioned && range->cursor) {
+            range->cursor->save();
+            range->cursor->detachFromOperationContext();
+        } else {
+            range->positioned = false;
+            range->cursor.reset();
+        }
+    } catch (const DBException& ex) {
+        range->status = ex.toStatus();
+        range->cursor.reset();
+    }
+}
+
+void ParallelCollectionScan::doRestoreState() {
+    // The workers only run while the calling thread holds its locks. If the collection went away
+    // during the yield, the next round would read from a dropped RecordStore. A drop doesn't reset
+    // '_params.collection', so look the collection up again, and make sure it is the same one.
+    Database* db = dbHolder().get(getOpCtx(), _nss.db());
+    Collection* collection = db ? db->getCollection(getOpCtx(), _nss) : nullptr;
+    uassert(ErrorCodes::QueryPlanKilled,
+            "collection dropped during parallel collection scan",
+            collection && collection == _params.collection && collection->uuid() == _uuid);
+}
+
+unique_ptr<PlanStageStats> ParallelCollectionScan::getStats() {
+    _commonStats.isEOF = isEOF();
+
+    // Add a BSON representation of the filter to the stats tree, if there is one.
+    if (NULL != _filter) {
+        BSONObjBuilder bob;
+        _filter->serialize(&bob);
+        _commonStats.filter = bob.obj();
+    }
+
+    unique_ptr<PlanStageStats> ret =
+        make_unique<PlanStageStats>(_commonStats, STAGE_PARALLEL_COLLSCAN);
+    ret->specific = make_unique<ParallelCollectionScanStats>(_specificStats);
+    return ret;
+}
+
+const SpecificStats* ParallelCollectionScan::getSpecificStats() const {
+    return &_specificStats;
+}
+
+}  // namespace mongo
@@ -0,0 +1,218 @@
+/**
+ *    Copyright (C) 2017 MongoDB Inc.
+ *
+ *    This program is free software: you can redistribute it and/or  modify
+ *    it under the terms of the GNU Affero General Public License, version 3,
+ *    as published by the Free Software Foundation.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU Affero General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Affero General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the GNU Affero General Public License in all respects for
+ *    all of the code used other than as permitted herein. If you modify file(s)
+ *    with this exception, you may extend this exception to your version of the
+ *    file(s), but you are not obligated to do so. If you do not wish to do so,
+ *    delete this exception statement from your version. If you delete this
+ *    exception statement from all source files in the program, then also delete
+ *    it in the license file.
+ */
+
+#pragma once
+
+#include <deque>
+#include <memory>
+#include <vector>
+
+#include "mongo/db/catalog/collection_options.h"
+#include "mongo/db/exec/collection_scan_common.h"
+#include "mongo/db/exec/plan_stage.h"
+#include "mongo/db/exec/projection_exec.h"
+#include "mongo/db/jsobj.h"
+#include "mongo/db/namespace_string.h"
+#include "mongo/db/record_id.h"
+
+namespace mongo {
+
+class CollatorInterface;
+class MatchExpression;
+class SeekableRecordCursor;
+class WorkingSet;
+
+struct ParallelCollectionScanParams {
+    // Not owned.
+    const Collection* collection = nullptr;
+
+    // How many RecordId ranges to split the collection into. Each range is scanned by at most one
+    // worker at a time.
+    size_t numRanges = 2;
+
+    // The number of documents a worker examines in one range before handing back its results.
+    size_t batchSize = 1000;
+
+    // The number of bytes of results which may be buffered for each range.
+    size_t maxBufferBytesPerRange = 4 * 1024 * 1024;
+
+    // If true, results are returned in RecordId order, as from a forward CollectionScan.
+    // Otherwise they are returned in whatever order the workers produce them.
+    bool preserveOrder = true;
+
+    // If non-empty, the workers apply this projection to each matching document. Only projections
+    // which ProjectionStage would run with ProjectionExec may be pushed down.
+    BSONObj projObj;
+
+    // The full query, for positional and $elemMatch projections. Not owned.
+    const MatchExpression* fullExpression = nullptr;
+
+    // Not owned. May be null.
+    const CollatorInterface* collator = nullptr;
+};
+
+/**
+ * Scans a collection using a pool of worker threads. The collection is split into contiguous
+ * RecordId ranges. On each call to work() with no buffered results, the ranges which have room
+ * are handed to the workers, which each examine up to 'batchSize' documents, apply the filter and
+ * projection, and buffer the results. The calling thread waits for every worker to finish before
+ * returning, so no worker runs while the plan yields, and each worker reads from its own
+ * snapshot, which it gives up between rounds as if it had yielded.
+ *
+ * Results are exchanged back to the calling thread either in RecordId order or in the order they
+ * were produced.
+ *
+ * Preconditions: The collection is not capped, and its RecordStore supports seekAtOrAfter().
+ */
+class ParallelCollectionScan final : public PlanStage {
+public:
+    ParallelCollectionScan(OperationContext* opCtx,
+                           const ParallelCollectionScanParams& params,
+                           WorkingSet* workingSet,
+                           const MatchExpression* filter);
+    ~ParallelCollectionScan();
+
+    /**
+     * Returns whether a collection scan over 'collection' with 'params' and 'filter' can be run
+     * by a ParallelCollectionScan instead.
+     */
+    static bool canRunInParallel(OperationContext* opCtx,
+                                 const Collection* collection,
+                                 const CollectionScanParams& params,
+                                 const MatchExpression* filter);
+
+    /**
+     * Returns false if 'expr' contains anything which can't be evaluated concurrently from several
+     * threads, such as JavaScript or aggregation expressions which share per-operation state.
+     */
+    static bool canEvaluateOnWorkers(const MatchExpression* expr);
+
+    /**
+     * Returns true if results read by worker threads, each from a snapshot of its own, may be
+     * returned to the operation 'opCtx' belongs to. The storage engine must have document-level
+     * concurrency control, and the operation must not read from the majority committed snapshot,
+     * which the workers' snapshots would not be.
+     */
+    static bool canReadOnWorkers(OperationContext* opCtx);
+
+    StageState doWork(WorkingSetID* out) final;
+    bool isEOF() final;
+
+    void doRestoreState() final;
+
+    StageType stageType() const final {
+        return STAGE_PARALLEL_COLLSCAN;
+    }
+
+    std::unique_ptr<PlanStageStats> getStats() final;
+
+    const SpecificStats* getSpecificStats() const final;
+
+    static const char* kStageType;
+
+private:
+    struct Result {
+        RecordId recordId;
+        BSONObj obj;
+    };
+
+    // The state of one RecordId range. Only the worker filling a range touches it while a round
+    // is running.
+    struct Range {
+        // The first RecordId in the range. Null means the start of the collection.
+        RecordId start;
+
+        // The first RecordId past the range. Null means the end of the collection.
+        RecordId end;
+
+        // Detached from any OperationContext between rounds.
+        std::unique_ptr<SeekableRecordCursor> cursor;
+
+        // Has the cursor been positioned at 'start' yet?
+        bool positioned = false;
+
+        bool exhausted = false;
+
+        std::deque<Result> results;
+        size_t resultBytes = 0;
+
+        // Counters for the round in progress, merged into the stage stats by the calling thread.
+        size_t docsTested = 0;
+        size_t writeConflicts = 0;
+
+        // Set if the worker failed.
+        Status status = Status::OK();
+    };
+
+    /**
+     * Splits the collection into ranges. Called on the first call to work().
+     */
+    void initRanges();
+
+    /**
+     * Hands every range which is not exhausted and has room for more results to a worker, and
+     * waits for all of them to finish.
+     */
+    void runRound();
+
+    /**
+     * Runs on a worker thread. Examines up to 'batchSize' documents in 'range'.
+     */
+    void fillRange(Range* range);
+
+    /**
+     * Returns the range the next result should come from, or nullptr if a round is needed.
+     */
+    Range* nextReadyRange();
+
+    // Not owned.
+    WorkingSet* _workingSet;
+
+    // Not owned.
+    const MatchExpression* _filter;
+
+    const ParallelCollectionScanParams _params;
+
+    // Identify '_params.collection', so that a drop during a yield can be detected on restore.
+    const NamespaceString _nss;
+    const OptionalCollectionUUID _uuid;
+
+    // Shared by the workers. Null if there is no projection.
+    std::unique_ptr<ProjectionExec> _projExec;
+
+    std::vector<std::unique_ptr<Range>> _ranges;
+    bool _initialized = false;
+
+    // With 'preserveOrder', results are returned from _ranges[_currentRange] until it is
+    // exhausted. Otherwise, this is where the round-robin search for results begins.
+    size_t _currentRange = 0;
+
+    ParallelCollectionScanStats _specificStats;
+};
+
+}  // namespace mongo
@@ -56,6 +56,60 @@ PlanStage::StageState PlanStage::work(WorkingSetID* out) {
     return workResult;
 }
 
+PlanStage::StageState PlanStage::workBatch(WorkingSet* ws,
+                                           size_t maxWorks,
+                                           std::vector<WorkingSetID>* out,
+                                           WorkingSetID* stateId) {
+    invariant(_opCtx);
+    invariant(maxWorks > 0);
+    ScopedTimer timer(getClock(), &_commonStats.executionTimeMillis);
+
+    const size_t initialSize = out->size();
+    *stateId = WorkingSet::INVALID_ID;
+    StageState batchResult = doWorkBatch(ws, maxWorks, out, stateId);
+
+    _commonStats.advanced += out->size() - initialSize;
+    if (StageState::NEED_YIELD == batchResult) {
+        ++_commonStats.needYield;
+    }
+
+    return batchResult;
+}
+
+PlanStage::StageState PlanStage::doWorkBatch(WorkingSet* ws,
+                                             size_t maxWorks,
+                                             std::vector<WorkingSetID>* out,
+                                             WorkingSetID* stateId) {
+    const size_t initialSize = out->size();
+    for (size_t i = 0; i < maxWorks; ++i) {
+        ++_commonStats.works;
+
+        WorkingSetID id = WorkingSet::INVALID_ID;
+        StageState state = doWork(&id);
+
+        if (StageState::ADVANCED == state) {
+            ws->get(id)->makeObjOwnedIfNeeded();
+            out->push_back(id);
+        } else if (StageState::NEED_TIME == state) {
+            ++_commonStats.needTime;
+        } else {
+            *stateId = id;
+            return state;
+        }
+    }
+
+    return batchExhaustedState(*out, initialSize);
+}
+
+bool PlanStage::childrenSupportBatchedWork() const {
+    for (auto&& child : _children) {
+        if (!child->supportsBatchedWork()) {
+            return false;
+        }
+    }
+    return true;
+}
+
 void PlanStage::saveState() {
     ++_commonStats.yields;
     for (auto&& child : _children) {
@@ -188,6 +188,37 @@ public:
      */
     StageState work(WorkingSetID* out);
 
+    /**
+     * Performs up to 'maxWorks' units of work, appending the id of every result produced to
+     * 'out'. 'ws' must be the WorkingSet shared by the stages of this plan. Each appended id is a
+     * result exactly as if work() had returned ADVANCED with it, and the caller must consume or
+     * free all of them before acting on the returned state.
+     *
+     * The returned state describes why the batch ended:
+     *   - ADVANCED or NEED_TIME: 'maxWorks' units of work were performed. ADVANCED is returned if
+     *     at least one result was appended, NEED_TIME otherwise. The caller may yield and ask for
+     *     another batch.
+     *   - IS_EOF, NEED_YIELD, DEAD or FAILURE: has the same meaning as when returned from work().
+     *     '*stateId' is populated as work() would populate its out parameter for that state.
+     *
+     * Objects of members in the RID_AND_OBJ state are made owned (see
+     * WorkingSetMember::makeObjOwnedIfNeeded()) before they are appended, since the storage
+     * cursor they came from has usually moved on by the time the caller looks at them.
+     */
+    StageState workBatch(WorkingSet* ws,
+                         size_t maxWorks,
+                         std::vector<WorkingSetID>* out,
+                         WorkingSetID* stateId);
+
+    /**
+     * Returns true if this stage and every stage below it implements doWorkBatch() natively,
+     * rather than relying on the default adapter over doWork(). PlanExecutor only drives a plan
+     * through workBatch() when this is true of its root.
+     */
+    virtual bool supportsBatchedWork() const {
+        return false;
+    }
+
     /**
      * Returns true if no more work can be done on the query / out of results.
      */
@@ -347,6 +378,35 @@ protected:
      */
     virtual StageState doWork(WorkingSetID* out) = 0;
 
+    /**
+     * Performs a batch of work. See comment at workBatch() above.
+     *
+     * Implementations are responsible for adding each unit of work they perform to
+     * '_commonStats.works', and each unit which produced no result to '_commonStats.needTime'.
+     * The number of results and NEED_YIELD requests are accounted for by workBatch().
+     *
+     * The default implementation adapts doWork() by calling it up to 'maxWorks' times.
+     */
+    virtual StageState doWorkBatch(WorkingSet* ws,
+                                   size_t maxWorks,
+                                   std::vector<WorkingSetID>* out,
+                                   WorkingSetID* stateId);
+
+    /**
+     * Returns true if every child of this stage supports batched work. Convenience method for
+     * implementations of supportsBatchedWork().
+     */
+    bool childrenSupportBatchedWork() const;
+
+    /**
+     * Returns the state a doWorkBatch() implementation should report when it has used up its
+     * budget of work, given the size 'out' had when the batch started.
+     */
+    static StageState batchExhaustedState(const std::vector<WorkingSetID>& out,
+                                          size_t initialSize) {
+        return out.size() > initialSize ? ADVANCED : NEED_TIME;
+    }
+
     /**
      * Saves any stage-specific state required to resume where it was if the underlying data
      * changes.
@@ -138,7 +138,14 @@ private:
 };
 
 struct AndHashStats : public SpecificStats {
-    AndHashStats() : flaggedButPassed(0), flaggedInProgress(0), memUsage(0), memLimit(0) {}
+    AndHashStats()
+        : flaggedButPassed(0),
+          flaggedInProgress(0),
+          memUsage(0),
+          memLimit(0),
+          hashTableBytes(0),
+          bloomFilterBytes(0),
+          bloomFilterRejects(0) {}
 
     SpecificStats* clone() const final {
         AndHashStats* specific = new AndHashStats(*this);
@@ -165,6 +172,14 @@ struct AndHashStats : public SpecificStats {
 
     // What's our memory limit?
     size_t memLimit;
+
+    // How many bytes are allocated for the RecordId hash table and the bloom filter? These are
+    // not counted in 'memUsage'.
+    size_t hashTableBytes;
+    size_t bloomFilterBytes;
+
+    // How many results from children after the first were rejected by the bloom filter?
+    size_t bloomFilterRejects;
 };
 
 struct AndSortedStats : public SpecificStats {
@@ -213,6 +228,31 @@ struct CollectionScanStats : public SpecificStats {
     boost::optional<Timestamp> maxTs;
 };
 
+struct ParallelCollectionScanStats : public SpecificStats {
+    SpecificStats* clone() const final {
+        ParallelCollectionScanStats* specific = new ParallelCollectionScanStats(*this);
+        return specific;
+    }
+
+    // How many documents did the workers check against our filter?
+    size_t docsTested = 0;
+
+    // How many RecordId ranges is the collection split into?
+    size_t numRanges = 0;
+
+    // How many times were the workers dispatched?
+    size_t rounds = 0;
+
+    // How many times did a worker hit a write conflict and have to retry in a later round?
+    size_t writeConflicts = 0;
+
+    // Are results returned in RecordId order?
+    bool preserveOrder = true;
+
+    // Is a projection applied by the workers?
+    bool hasProjection = false;
+};
+
 struct CountStats : public SpecificStats {
     CountStats() : nCounted(0), nSkipped(0), recordStoreCount(false) {}
 
@@ -238,7 +278,8 @@ struct CountScanStats : public SpecificStats {
           isPartial(false),
           isSparse(false),
           isUnique(false),
-          keysExamined(0) {}
+          keysExamined(0),
+          seeks(0) {}
 
     SpecificStats* clone() const final {
         CountScanStats* specific = new CountScanStats(*this);
@@ -247,6 +288,7 @@ struct CountScanStats : public SpecificStats {
         specific->collation = collation.getOwned();
         specific->startKey = startKey.getOwned();
         specific->endKey = endKey.getOwned();
+        specific->indexBounds = indexBounds.getOwned();
         return specific;
     }
 
@@ -265,6 +307,9 @@ struct CountScanStats : public SpecificStats {
     bool startKeyInclusive;
     bool endKeyInclusive;
 
+    // Set instead of the start and end keys when the scan has multi-interval bounds.
+    BSONObj indexBounds;
+
     int indexVersion;
 
     // Set to true if the index used for the count scan is multikey.
@@ -278,6 +323,9 @@ struct CountScanStats : public SpecificStats {
     bool isUnique;
 
     size_t keysExamined;
+
+    // Number of times the index cursor was repositioned, including the initial seek.
+    size_t seeks;
 };
 
 struct DeleteStats : public SpecificStats {
@@ -345,7 +393,12 @@ struct EnsureSortedStats : public SpecificStats {
 };
 
 struct FetchStats : public SpecificStats {
-    FetchStats() : alreadyHasObj(0), forcedFetches(0), docsExamined(0) {}
+    FetchStats()
+        : alreadyHasObj(0),
+          forcedFetches(0),
+          docsExamined(0),
+          recordsPrefetched(0),
+          docsPartiallyMaterialized(0) {}
 
     SpecificStats* clone() const final {
         FetchStats* specific = new FetchStats(*this);
@@ -360,6 +413,12 @@ struct FetchStats : public SpecificStats {
 
     // The total number of full documents touched by the fetch stage.
     size_t docsExamined;
+
+    // The number of records whose ids were passed to the storage engine as a prefetch hint.
+    size_t recordsPrefetched;
+
+    // The number of documents of which only the fields needed by the projection above were kept.
+    size_t docsPartiallyMaterialized;
 };
 
 struct GroupStats : public SpecificStats {
@@ -513,7 +572,7 @@ struct ProjectionStats : public SpecificStats {
 };
 
 struct SortStats : public SpecificStats {
-    SortStats() : forcedFetches(0), memUsage(0), memLimit(0) {}
+    SortStats() : forcedFetches(0), memUsage(0), memLimit(0), usedDisk(false), spills(0) {}
 
     SpecificStats* clone() const final {
         SortStats* specific = new SortStats(*this);
@@ -534,6 +593,12 @@ struct SortStats : public SpecificStats {
 
     // The pattern according to which we are sorting.
     BSONObj sortPattern;
+
+    // Did we write any sorted runs to disk?
+    bool usedDisk;
+
+    // How many sorted runs were written to disk?
+    size_t spills;
 };
 
 struct MergeSortStats : public SpecificStats {
@@ -227,6 +227,46 @@ PlanStage::StageState ProjectionStage::doWork(WorkingSetID* out) {
     return status;
 }
 
+PlanStage::StageState ProjectionStage::doWorkBatch(WorkingSet* ws,
+                                                   size_t maxWorks,
+                                                   std::vector<WorkingSetID>* out,
+                                                   WorkingSetID* stateId) {
+    // We do one unit of work per result of our child, so our child's batch is our batch.
+    const size_t initialSize = out->size();
+    StageState status = child()->workBatch(ws, maxWorks, out, stateId);
+    _commonStats.works += std::max<size_t>(1, out->size() - initialSize);
+
+    for (size_t i = initialSize; i < out->size(); ++i) {
+        WorkingSetMember* member = _ws->get((*out)[i]);
+        Status projStatus = transform(member);
+        if (!projStatus.isOK()) {
+            warning() << "Couldn't execute projection, status = " << redact(projStatus);
+
+            // Results from before the failure stand. Those from after it are never seen, as is
+            // the state which ended our child's batch.
+            for (size_t j = i; j < out->size(); ++j) {
+                _ws->free((*out)[j]);
+            }
+            out->resize(i);
+            *stateId = WorkingSetCommon::allocateStatusMember(_ws, projStatus);
+            return PlanStage::FAILURE;
+        }
+    }
+
+    if ((PlanStage::FAILURE == status || PlanStage::DEAD == status) &&
+        WorkingSet::INVALID_ID == *stateId) {
+        mongoutils::str::stream ss;
+        ss << "projection stage failed to read in results from child";
+        Status status(ErrorCodes::InternalError, ss);
+        *stateId = WorkingSetCommon::allocateStatusMember(_ws, status);
+    }
+
+    if (out->size() == initialSize && PlanStage::NEED_TIME == status) {
+        ++_commonStats.needTime;
+    }
+    return status;
+}
+
 unique_ptr<PlanStageStats> ProjectionStage::getStats() {
     _commonStats.isEOF = isEOF();
     unique_ptr<PlanStageStats> ret = make_unique<PlanStageStats>(_commonStats, STAGE_PROJECTION);
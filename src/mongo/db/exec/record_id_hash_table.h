@@ -0,0 +1,296 @@
+/**
+ *    Copyright (C) 2017 MongoDB Inc.
+ *
+ *    This program is free software: you can redistribute it and/or  modify
+ *    it under the terms of the GNU Affero General Public License, version 3,
+ *    as published by the Free Software Foundation.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU Affero General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Affero General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the GNU Affero General Public License in all respects for
+ *    all of the code used other than as permitted herein. If you modify file(s)
+ *    with this exception, you may extend this exception to your version of the
+ *    file(s), but you are not obligated to do so. If you do not wish to do so,
+ *    delete this exception statement from your version. If you delete this
+ *    exception statement from all source files in the program, then also delete
+ *    it in the license file.
+ */
+
+#pragma once
+
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+#include "mongo/base/disallow_copying.h"
+#include "mongo/db/record_id.h"
+#include "mongo/util/assert_util.h"
+
+namespace mongo {
+
+/**
+ * Mixes the bits of a RecordId so that the low bits are usable as a table index. RecordIds are
+ * often dense and sequential, which a plain identity hash would turn into long probe runs.
+ */
+inline uint64_t hashRecordIdForTable(const RecordId& id) {
+    uint64_t x = static_cast<uint64_t>(id.repr());
+    x = (x ^ (x >> 30)) * 0xbf58476d1ce4e5b9ULL;
+    x = (x ^ (x >> 27)) * 0x94d049bb133111ebULL;
+    return x ^ (x >> 31);
+}
+
+/**
+ * A map from RecordId to 'Value' which stores its entries inline in a single power-of-two sized
+ * array, using linear probing for collisions and backward-shift deletion. Unlike a node-based
+ * unordered_map there is no allocation per insert, and a lookup usually touches one cache line.
+ *
+ * The null RecordId marks an empty slot, so it may not be used as a key. Pointers returned by
+ * find() and insert() are invalidated by any subsequent insert or erase.
+ */
+template <typename Value>
+class RecordIdHashTable {
+    MONGO_DISALLOW_COPYING(RecordIdHashTable);
+
+public:
+    explicit RecordIdHashTable(size_t expectedSize = 0) {
+        reserve(expectedSize);
+    }
+
+    size_t size() const {
+        return _size;
+    }
+
+    bool empty() const {
+        return 0 == _size;
+    }
+
+    /**
+     * Makes room for at least 'n' entries without further rehashing.
+     */
+    void reserve(size_t n) {
+        size_t capacity = kMinCapacity;
+        while (capacity * kMaxLoadNumerator < n * kMaxLoadDenominator) {
+            capacity *= 2;
+        }
+        if (capacity > _slots.size()) {
+            rehash(capacity);
+        }
+    }
+
+    /**
+     * Returns a pointer to the value for 'id', or nullptr if it isn't present.
+     */
+    Value* find(const RecordId& id) {
+        if (_slots.empty()) {
+            return nullptr;
+        }
+        for (size_t i = homeSlot(id);; i = nextSlot(i)) {
+            Slot& slot = _slots[i];
+            if (slot.id.isNull()) {
+                return nullptr;
+            }
+            if (slot.id == id) {
+                return &slot.value;
+            }
+        }
+    }
+
+    bool contains(const RecordId& id) {
+        return find(id) != nullptr;
+    }
+
+    /**
+     * Inserts ('id', 'value') unless 'id' is already present. Returns a pointer to the value
+     * stored for 'id' and whether an insertion took place, like std::unordered_map::insert().
+     */
+    std::pair<Value*, bool> insert(const RecordId& id, const Value& value) {
+        invariant(!id.isNull());
+        if ((_size + 1) * kMaxLoadDenominator > _slots.size() * kMaxLoadNumerator) {
+            reserve(_size + 1);
+        }
+
+        size_t i = homeSlot(id);
+        for (; !_slots[i].id.isNull(); i = nextSlot(i)) {
+            if (_slots[i].id == id) {
+                return {&_slots[i].value, false};
+            }
+        }
+
+        _slots[i].id = id;
+        _slots[i].value = value;
+        ++_size;
+        return {&_slots[i].value, true};
+    }
+
+    /**
+     * Removes 'id' from the table. Returns whether it was present.
+     */
+    bool erase(const RecordId& id) {
+        if (_slots.empty()) {
+            return false;
+        }
+
+        size_t hole = homeSlot(id);
+        for (; _slots[hole].id != id; hole = nextSlot(hole)) {
+            if (_slots[hole].id.isNull()) {
+                return false;
+            }
+        }
+
+        // Shift back any later entries of the probe run which would no longer be reachable
+        // from their home slot once 'hole' is empty.
+        for (size_t i = nextSlot(hole); !_slots[i].id.isNull(); i = nextSlot(i)) {
+            const size_t home = homeSlot(_slots[i].id);
+            const bool reachable =
+                (hole <= i) ? (hole < home && home <= i) : (hole < home || home <= i);
+            if (!reachable) {
+                _slots[hole] = std::move(_slots[i]);
+                hole = i;
+            }
+        }
+
+        _slots[hole] = Slot();
+        --_size;
+        return true;
+    }
+
+    /**
+     * Calls 'fn(const RecordId&, Value&)' for each entry, in no particular order.
+     */
+    template <typename Fn>
+    void forEach(Fn fn) {
+        for (auto&& slot : _slots) {
+            if (!slot.id.isNull()) {
+                fn(slot.id, slot.value);
+            }
+        }
+    }
+
+    /**
+     * Removes every entry for which 'pred(const RecordId&, Value&)' returns true. The table is
+     * then resized to fit the remaining entries.
+     */
+    template <typename Pred>
+    void eraseIf(Pred pred) {
+        std::vector<Slot> kept;
+        for (auto&& slot : _slots) {
+            if (!slot.id.isNull() && !pred(slot.id, slot.value)) {
+                kept.push_back(std::move(slot));
+            }
+        }
+
+        clear();
+        reserve(kept.size());
+        for (auto&& slot : kept) {
+            insert(slot.id, slot.value);
+        }
+    }
+
+    void clear() {
+        std::vector<Slot>().swap(_slots);
+        _size = 0;
+    }
+
+    /**
+     * Returns the number of bytes allocated for the table.
+     */
+    size_t memUsageBytes() const {
+        return _slots.capacity() * sizeof(Slot);
+    }
+
+private:
+    struct Slot {
+        RecordId id;
+        Value value = Value();
+    };
+
+    // Grow once the table is more than 3/4 full.
+    static const size_t kMaxLoadNumerator = 3;
+    static const size_t kMaxLoadDenominator = 4;
+    static const size_t kMinCapacity = 16;
+
+    size_t homeSlot(const RecordId& id) const {
+        return hashRecordIdForTable(id) & (_slots.size() - 1);
+    }
+
+    size_t nextSlot(size_t i) const {
+        return (i + 1) & (_slots.size() - 1);
+    }
+
+    void rehash(size_t newCapacity) {
+        std::vector<Slot> old(newCapacity);
+        old.swap(_slots);
+        _size = 0;
+        for (auto&& slot : old) {
+            if (!slot.id.isNull()) {
+                insert(slot.id, slot.value);
+            }
+        }
+    }
+
+    std::vector<Slot> _slots;
+    size_t _size = 0;
+};
+
+/**
+ * A fixed-size bloom filter over RecordIds. mayContain() never returns a false negative, so it
+ * can screen out lookups in a larger table which are certain to miss.
+ */
+class RecordIdBloomFilter {
+public:
+    /**
+     * Sizes the filter at roughly ten bits per expected entry, for a false positive rate of about
+     * one percent with three probes.
+     */
+    explicit RecordIdBloomFilter(size_t expectedSize) {
+        size_t numBits = 64;
+        while (numBits < expectedSize * 10) {
+            numBits *= 2;
+        }
+        _bits.resize(numBits / 64);
+        _mask = numBits - 1;
+    }
+
+    void add(const RecordId& id) {
+        uint64_t hash = hashRecordIdForTable(id);
+        const uint64_t step = (hash >> 32) | 1;
+        for (int i = 0; i < kNumProbes; ++i, hash += step) {
+            const uint64_t bit = hash & _mask;
+            _bits[bit / 64] |= 1ULL << (bit % 64);
+        }
+    }
+
+    bool mayContain(const RecordId& id) const {
+        uint64_t hash = hashRecordIdForTable(id);
+        const uint64_t step = (hash >> 32) | 1;
+        for (int i = 0; i < kNumProbes; ++i, hash += step) {
+            const uint64_t bit = hash & _mask;
+            if (!(_bits[bit / 64] & (1ULL << (bit % 64)))) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    size_t memUsageBytes() const {
+        return _bits.capacity() * sizeof(uint64_t);
+    }
+
+private:
+    static const int kNumProbes = 3;
+
+    std::vector<uint64_t> _bits;
+    uint64_t _mask;
+};
+
+}  // namespace mongo
@@ -0,0 +1,145 @@
+/**
+ *    Copyright (C) 2017 MongoDB Inc.
+ *
+ *    This program is free software: you can redistribute it and/or  modify
+ *    it under the terms of the GNU Affero General Public License, version 3,
+ *    as published by the Free Software Foundation.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU Affero General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Affero General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the GNU Affero General Public License in all respects for
+ *    all of the code used other than as permitted herein. If you modify file(s)
+ *    with this exception, you may extend this exception to your version of the
+ *    file(s), but you are not obligated to do so. If you do not wish to do so,
+ *    delete this exception statement from your version. If you delete this
+ *    exception statement from all source files in the program, then also delete
+ *    it in the license file.
+ */
+
+/**
+ * This file contains tests for mongo/db/exec/record_id_hash_table.h
+ */
+
+#include "mongo/platform/basic.h"
+
+#include "mongo/db/exec/record_id_hash_table.h"
+
+#include <set>
+
+#include "mongo/platform/random.h"
+#include "mongo/unittest/unittest.h"
+
+namespace mongo {
+namespace {
+
+TEST(RecordIdHashTableTest, InsertFindErase) {
+    RecordIdHashTable<int> table;
+    ASSERT_TRUE(table.empty());
+    ASSERT_FALSE(table.find(RecordId(1)));
+
+    for (int i = 1; i <= 1000; ++i) {
+        auto result = table.insert(RecordId(i), i * 2);
+        ASSERT_TRUE(result.second);
+        ASSERT_EQ(i * 2, *result.first);
+    }
+    ASSERT_EQ(1000U, table.size());
+
+    // Inserting an existing key leaves the original value in place.
+    auto result = table.insert(RecordId(7), -1);
+    ASSERT_FALSE(result.second);
+    ASSERT_EQ(14, *result.first);
+
+    for (int i = 1; i <= 1000; ++i) {
+        int* value = table.find(RecordId(i));
+        ASSERT(value);
+        ASSERT_EQ(i * 2, *value);
+    }
+    ASSERT_FALSE(table.find(RecordId(1001)));
+
+    // Erase the odd keys. The even ones must remain reachable after backward shifting.
+    for (int i = 1; i <= 1000; i += 2) {
+        ASSERT_TRUE(table.erase(RecordId(i)));
+    }
+    ASSERT_FALSE(table.erase(RecordId(1)));
+    ASSERT_EQ(500U, table.size());
+    for (int i = 1; i <= 1000; ++i) {
+        ASSERT_EQ(i % 2 == 0, table.contains(RecordId(i)));
+    }
+}
+
+TEST(RecordIdHashTableTest, MatchesStdSetUnderRandomOperations) {
+    PseudoRandom rand(1234);
+    RecordIdHashTable<int64_t> table;
+    std::set<int64_t> expected;
+
+    for (int i = 0; i < 20000; ++i) {
+        // A small key space forces plenty of collisions, re-inserts and erases.
+        const int64_t key = 1 + rand.nextInt32(512);
+        if (rand.nextInt32(3) == 0) {
+            ASSERT_EQ(expected.erase(key) == 1, table.erase(RecordId(key)));
+        } else {
+            ASSERT_EQ(expected.insert(key).second, table.insert(RecordId(key), key).second);
+        }
+        ASSERT_EQ(expected.size(), table.size());
+    }
+
+    for (int64_t key = 1; key <= 512; ++key) {
+        int64_t* value = table.find(RecordId(key));
+        ASSERT_EQ(expected.count(key) == 1, value != nullptr);
+        if (value) {
+            ASSERT_EQ(key, *value);
+        }
+    }
+}
+
+TEST(RecordIdHashTableTest, EraseIfShrinksTable) {
+    RecordIdHashTable<int> table(10000);
+    for (int i = 1; i <= 10000; ++i) {
+        table.insert(RecordId(i), i);
+    }
+    const size_t bytesBefore = table.memUsageBytes();
+
+    table.eraseIf([](const RecordId& id, int& value) { return value % 100 != 0; });
+
+    ASSERT_EQ(100U, table.size());
+    ASSERT_LT(table.memUsageBytes(), bytesBefore);
+    size_t visited = 0;
+    table.forEach([&](const RecordId& id, int& value) {
+        ASSERT_EQ(id.repr(), value);
+        ASSERT_EQ(0, value % 100);
+        ++visited;
+    });
+    ASSERT_EQ(100U, visited);
+}
+
+TEST(RecordIdBloomFilterTest, NoFalseNegatives) {
+    RecordIdBloomFilter filter(1000);
+    for (int i = 0; i < 1000; ++i) {
+        filter.add(RecordId(i * 3 + 1));
+    }
+    for (int i = 0; i < 1000; ++i) {
+        ASSERT_TRUE(filter.mayContain(RecordId(i * 3 + 1)));
+    }
+
+    // The false positive rate should be in the neighbourhood of one percent.
+    size_t falsePositives = 0;
+    for (int i = 0; i < 1000; ++i) {
+        if (filter.mayContain(RecordId(i * 3 + 2))) {
+            ++falsePositives;
+        }
+    }
+    ASSERT_LT(falsePositives, 50U);
+}
+
+}  // namespace
+}  // namespace mongo
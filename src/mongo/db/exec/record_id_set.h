@@ -0,0 +1,225 @@
+/**
+ *    Copyright (C) 2017 MongoDB Inc.
+ *
+ *    This program is free software: you can redistribute it and/or  modify
+ *    it under the terms of the GNU Affero General Public License, version 3,
+ *    as published by the Free Software Foundation.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU Affero General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Affero General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the GNU Affero General Public License in all respects for
+ *    all of the code used other than as permitted herein. If you modify file(s)
+ *    with this exception, you may extend this exception to your version of the
+ *    file(s), but you are not obligated to do so. If you do not wish to do so,
+ *    delete this exception statement from your version. If you delete this
+ *    exception statement from all source files in the program, then also delete
+ *    it in the license file.
+ */
+
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+#include <vector>
+
+#include "mongo/base/disallow_copying.h"
+#include "mongo/db/record_id.h"
+#include "mongo/platform/bits.h"
+#include "mongo/stdx/unordered_map.h"
+
+namespace mongo {
+
+/**
+ * A set of RecordIds stored in the manner of a roaring bitmap. RecordIds are grouped into chunks
+ * by all but their low 16 bits. A chunk holding few RecordIds keeps their low bits in a sorted
+ * array; once that array would grow past kMaxArrayEntries, the chunk switches to a 65536 bit
+ * bitmap. The dense, sequential RecordIds which most storage engines assign therefore cost about
+ * one bit each, where a node-based hash set costs dozens of bytes per RecordId.
+ */
+class RecordIdSet {
+    MONGO_DISALLOW_COPYING(RecordIdSet);
+
+public:
+    RecordIdSet() = default;
+
+    size_t size() const {
+        return _size;
+    }
+
+    bool empty() const {
+        return 0 == _size;
+    }
+
+    bool contains(const RecordId& id) const {
+        auto it = _chunks.find(chunkKey(id));
+        return it != _chunks.end() && it->second.contains(chunkOffset(id));
+    }
+
+    /**
+     * Adds 'id' to the set. Returns false if it was already present.
+     */
+    bool insert(const RecordId& id) {
+        if (!_chunks[chunkKey(id)].insert(chunkOffset(id))) {
+            return false;
+        }
+        ++_size;
+        return true;
+    }
+
+    /**
+     * Removes 'id' from the set. Returns whether it was present.
+     */
+    bool erase(const RecordId& id) {
+        auto it = _chunks.find(chunkKey(id));
+        if (it == _chunks.end() || !it->second.erase(chunkOffset(id))) {
+            return false;
+        }
+        if (0 == it->second.size) {
+            _chunks.erase(it);
+        }
+        --_size;
+        return true;
+    }
+
+    void clear() {
+        _chunks.clear();
+        _size = 0;
+    }
+
+    /**
+     * Returns an estimate of the number of bytes allocated for the set.
+     */
+    size_t memUsageBytes() const {
+        size_t bytes = 0;
+        for (auto&& chunk : _chunks) {
+            bytes += sizeof(chunk) + sizeof(void*) + chunk.second.memUsageBytes();
+        }
+        return bytes;
+    }
+
+private:
+    static const uint64_t kChunkBits = 16;
+    static const size_t kBitmapWords = (size_t(1) << kChunkBits) / 64;
+
+    // Above this many entries, a bitmap is smaller than an array of 16-bit offsets.
+    static const size_t kMaxArrayEntries = kBitmapWords * sizeof(uint64_t) / sizeof(uint16_t);
+
+    struct Chunk {
+        bool isBitmap() const {
+            return !bitmap.empty();
+        }
+
+        bool contains(uint16_t offset) const {
+            if (isBitmap()) {
+                return bitmap[offset / 64] & (uint64_t(1) << (offset % 64));
+            }
+            return std::binary_search(offsets.begin(), offsets.end(), offset);
+        }
+
+        bool insert(uint16_t offset) {
+            if (isBitmap()) {
+                uint64_t& word = bitmap[offset / 64];
+                const uint64_t bit = uint64_t(1) << (offset % 64);
+                if (word & bit) {
+                    return false;
+                }
+                word |= bit;
+                ++size;
+                return true;
+            }
+
+            auto it = std::lower_bound(offsets.begin(), offsets.end(), offset);
+            if (it != offsets.end() && *it == offset) {
+                return false;
+            }
+            if (offsets.size() < kMaxArrayEntries) {
+                offsets.insert(it, offset);
+                ++size;
+                return true;
+            }
+
+            toBitmap();
+            return insert(offset);
+        }
+
+        bool erase(uint16_t offset) {
+            if (!isBitmap()) {
+                auto it = std::lower_bound(offsets.begin(), offsets.end(), offset);
+                if (it == offsets.end() || *it != offset) {
+                    return false;
+                }
+                offsets.erase(it);
+                --size;
+                return true;
+            }
+
+            uint64_t& word = bitmap[offset / 64];
+            const uint64_t bit = uint64_t(1) << (offset % 64);
+            if (!(word & bit)) {
+                return false;
+            }
+            word &= ~bit;
+            --size;
+
+            // Go back to an array only well below the limit, so that a chunk near it doesn't
+            // flip back and forth.
+            if (size <= kMaxArrayEntries / 2) {
+                toArray();
+            }
+            return true;
+        }
+
+        void toBitmap() {
+            bitmap.assign(kBitmapWords, 0);
+            for (uint16_t offset : offsets) {
+                bitmap[offset / 64] |= uint64_t(1) << (offset % 64);
+            }
+            std::vector<uint16_t>().swap(offsets);
+        }
+
+        void toArray() {
+            offsets.reserve(size);
+            for (size_t i = 0; i < kBitmapWords; ++i) {
+                for (uint64_t word = bitmap[i]; word; word &= word - 1) {
+                    offsets.push_back(i * 64 + countTrailingZeros64(word));
+                }
+            }
+            std::vector<uint64_t>().swap(bitmap);
+        }
+
+        size_t memUsageBytes() const {
+            return offsets.capacity() * sizeof(uint16_t) + bitmap.capacity() * sizeof(uint64_t);
+        }
+
+        // The low bits of the chunk's RecordIds, in order, while it has few enough of them.
+        std::vector<uint16_t> offsets;
+
+        // One bit per possible RecordId in the chunk, once there are too many for 'offsets'.
+        std::vector<uint64_t> bitmap;
+
+        size_t size = 0;
+    };
+
+    static uint64_t chunkKey(const RecordId& id) {
+        return static_cast<uint64_t>(id.repr()) >> kChunkBits;
+    }
+
+    static uint16_t chunkOffset(const RecordId& id) {
+        return static_cast<uint16_t>(static_cast<uint64_t>(id.repr()));
+    }
+
+    stdx::unordered_map<uint64_t, Chunk> _chunks;
+    size_t _size = 0;
+};
+
+}  // namespace mongo
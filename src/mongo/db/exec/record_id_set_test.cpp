@@ -0,0 +1,134 @@
+/**
+ *    Copyright (C) 2017 MongoDB Inc.
+ *
+ *    This program is free software: you can redistribute it and/or  modify
+ *    it under the terms of the GNU Affero General Public License, version 3,
+ *    as published by the Free Software Foundation.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU Affero General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Affero General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the GNU Affero General Public License in all respects for
+ *    all of the code used other than as permitted herein. If you modify file(s)
+ *    with this exception, you may extend this exception to your version of the
+ *    file(s), but you are not obligated to do so. If you do not wish to do so,
+ *    delete this exception statement from your version. If you delete this
+ *    exception statement from all source files in the program, then also delete
+ *    it in the license file.
+ */
+
+/**
+ * This file contains tests for mongo/db/exec/record_id_set.h
+ */
+
+#include "mongo/platform/basic.h"
+
+#include "mongo/db/exec/record_id_set.h"
+
+#include <set>
+
+#include "mongo/platform/random.h"
+#include "mongo/unittest/unittest.h"
+
+namespace mongo {
+namespace {
+
+TEST(RecordIdSetTest, InsertContainsErase) {
+    RecordIdSet set;
+    ASSERT_TRUE(set.empty());
+    ASSERT_FALSE(set.contains(RecordId(1)));
+
+    for (int i = 1; i <= 1000; ++i) {
+        ASSERT_TRUE(set.insert(RecordId(i)));
+    }
+    ASSERT_FALSE(set.insert(RecordId(7)));
+    ASSERT_EQ(1000U, set.size());
+
+    for (int i = 1; i <= 1000; i += 2) {
+        ASSERT_TRUE(set.erase(RecordId(i)));
+    }
+    ASSERT_FALSE(set.erase(RecordId(1)));
+    ASSERT_EQ(500U, set.size());
+    for (int i = 1; i <= 1001; ++i) {
+        ASSERT_EQ(i % 2 == 0 && i <= 1000, set.contains(RecordId(i)));
+    }
+
+    set.clear();
+    ASSERT_TRUE(set.empty());
+    ASSERT_FALSE(set.contains(RecordId(2)));
+}
+
+TEST(RecordIdSetTest, DenseRecordIdsCostAboutOneBitEach) {
+    RecordIdSet set;
+    const int64_t n = 1000000;
+    for (int64_t i = 1; i <= n; ++i) {
+        ASSERT_TRUE(set.insert(RecordId(i)));
+    }
+    ASSERT_EQ(size_t(n), set.size());
+    ASSERT_LT(set.memUsageBytes(), size_t(n) / 4);
+
+    for (int64_t i = 1; i <= n; ++i) {
+        ASSERT_TRUE(set.contains(RecordId(i)));
+    }
+    ASSERT_FALSE(set.contains(RecordId(n + 1)));
+}
+
+TEST(RecordIdSetTest, ChunksSwitchBetweenArraysAndBitmaps) {
+    RecordIdSet set;
+
+    // Fill one chunk well past the point where it becomes a bitmap, then empty it again so that
+    // it goes back to an array.
+    for (int64_t i = 0; i < 10000; ++i) {
+        ASSERT_TRUE(set.insert(RecordId((1 << 16) + i)));
+    }
+    const size_t bitmapBytes = set.memUsageBytes();
+    for (int64_t i = 0; i < 9000; ++i) {
+        ASSERT_TRUE(set.erase(RecordId((1 << 16) + i)));
+    }
+    ASSERT_EQ(1000U, set.size());
+    ASSERT_LT(set.memUsageBytes(), bitmapBytes);
+    for (int64_t i = 0; i < 10000; ++i) {
+        ASSERT_EQ(i >= 9000, set.contains(RecordId((1 << 16) + i)));
+    }
+}
+
+TEST(RecordIdSetTest, MatchesStdSetUnderRandomOperations) {
+    PseudoRandom rand(1234);
+    RecordIdSet set;
+    std::set<int64_t> expected;
+
+    for (int i = 0; i < 200000; ++i) {
+        // Keys span a handful of chunks, some sparse and some dense, as well as negative and
+        // very large RecordIds.
+        int64_t key = rand.nextInt32(4) * (int64_t(1) << 16) + rand.nextInt32(8192);
+        if (rand.nextInt32(10) == 0) {
+            key = rand.nextInt64();
+        }
+
+        if (rand.nextInt32(3) == 0) {
+            ASSERT_EQ(expected.erase(key) == 1, set.erase(RecordId(key)));
+        } else {
+            ASSERT_EQ(expected.insert(key).second, set.insert(RecordId(key)));
+        }
+        ASSERT_EQ(expected.size(), set.size());
+    }
+
+    for (int64_t key : expected) {
+        ASSERT_TRUE(set.contains(RecordId(key)));
+    }
+    for (int64_t key = 0; key < 4 * (int64_t(1) << 16); ++key) {
+        ASSERT_EQ(expected.count(key) == 1, set.contains(RecordId(key)));
+    }
+}
+
+}  // namespace
+}  // namespace mongo
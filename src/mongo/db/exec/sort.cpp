@@ -67,6 +67,35 @@ bool SortStage::WorkingSetComparator::operator()(const SortableDataItem& lhs,
     return lhs.recordId < rhs.recordId;
 }
 
+namespace {
+
+// Field names for the documents written to spilled runs.
+const char kSpillObjField[] = "o";
+const char kSpillRecordIdField[] = "r";
+const char kSpillTextScoreField[] = "ts";
+const char kSpillGeoDistanceField[] = "gd";
+const char kSpillGeoNearPointField[] = "gp";
+const char kSpillIndexKeyField[] = "ik";
+
+RecordId spilledRecordId(const BSONObj& spilled) {
+    BSONElement elt = spilled[kSpillRecordIdField];
+    return elt.eoo() ? RecordId() : RecordId(elt.numberLong());
+}
+
+}  // namespace
+
+SortStage::SpillComparator::SpillComparator(BSONObj p) : pattern(p) {}
+
+int SortStage::SpillComparator::operator()(const SpillIterator::Data& lhs,
+                                           const SpillIterator::Data& rhs) const {
+    // False means ignore field names.
+    int result = lhs.first.woCompare(rhs.first, pattern, false);
+    if (0 != result) {
+        return result;
+    }
+    return spilledRecordId(lhs.second).compare(spilledRecordId(rhs.second));
+}
+
 SortStage::SortStage(OperationContext* opCtx,
                      const SortStageParams& params,
                      WorkingSet* ws,
@@ -78,18 +107,13 @@ SortStage::SortStage(OperationContext* opCtx,
       _limit(params.limit),
       _sorted(false),
       _resultIterator(_data.end()),
-      _memUsage(0) {
+      _memUsage(0),
+      _allowDiskUse(params.allowDiskUse),
+      _tempDir(params.tempDir) {
     _children.emplace_back(child);
 
     BSONObj sortComparator = FindCommon::transformSortSpec(_pattern);
     _sortKeyComparator = stdx::make_unique<WorkingSetComparator>(sortComparator);
-
-    // If limit > 1, we need to initialize _dataSet here to maintain ordered set of data items while
-    // fetching from the child stage.
-    if (_limit > 1) {
-        const WorkingSetComparator& cmp = *_sortKeyComparator;
-        _dataSet.reset(new SortableDataItemSet(cmp));
-    }
 }
 
 SortStage::~SortStage() {}
@@ -97,7 +121,8 @@ SortStage::~SortStage() {}
 bool SortStage::isEOF() {
     // We're done when our child has no more results, we've sorted the child's results, and
     // we've returned all sorted results.
-    return child()->isEOF() && _sorted && (_data.end() == _resultIterator);
+    return child()->isEOF() && _sorted && (_data.end() == _resultIterator) &&
+        (!_mergeIterator || !_mergeIterator->more());
 }
 
 PlanStage::StageState SortStage::doWork(WorkingSetID* out) {
@@ -126,8 +151,9 @@ PlanStage::StageState SortStage::doWork(WorkingSetID* out) {
             // the WorkingSet as quickly as possible to handle it.
             WorkingSetMember* member = _ws->get(id);
 
-            // Planner must put a fetch before we get here.
-            verify(member->hasObj());
+            // Planner must put a fetch before we get here, unless the sort keys come from the
+            // index, in which case the fetch happens once the sort is done.
+            verify(member->hasObj() || member->getState() == WorkingSetMember::RID_AND_IDX);
 
             // We might be sorting something that was invalidated at some point.
             if (member->hasRecordId()) {
@@ -150,11 +176,25 @@ PlanStage::StageState SortStage::doWork(WorkingSetID* out) {
 
             addToBuffer(item);
 
+            if (_allowDiskUse && _memUsage > maxBytes) {
+                spill();
+            }
+
             return PlanStage::NEED_TIME;
         } else if (PlanStage::IS_EOF == code) {
             // TODO: We don't need the lock for this.  We could ask for a yield and do this work
             // unlocked.  Also, this is performing a lot of work for one call to work(...)
-            sortBuffer();
+            if (!_spilledRuns.empty()) {
+                // Whatever is still buffered becomes the last run, and the runs are merged on
+                // the way out.
+                spill();
+                const SortOptions opts = SortOptions().Limit(_limit).TempDir(_tempDir);
+                _mergeIterator.reset(SpillIterator::merge(
+                    _spilledRuns, opts, SpillComparator(_sortKeyComparator->pattern)));
+                _spilledRuns.clear();
+            } else {
+                sortBuffer();
+            }
             _resultIterator = _data.begin();
             _sorted = true;
             return PlanStage::NEED_TIME;
@@ -178,6 +218,11 @@ PlanStage::StageState SortStage::doWork(WorkingSetID* out) {
     }
 
     // Returning results.
+    if (_mergeIterator) {
+        *out = allocateFromSpill(_mergeIterator->next());
+        return PlanStage::ADVANCED;
+    }
+
     verify(_resultIterator != _data.end());
     verify(_sorted);
     *out = _resultIterator->wsid;
@@ -222,6 +267,7 @@ unique_ptr<PlanStageStats> SortStage::getStats() {
     const size_t maxBytes = static_cast<size_t>(internalQueryExecMaxBlockingSortBytes.load());
     _specificStats.memLimit = maxBytes;
     _specificStats.memUsage = _memUsage;
+    _specificStats.usedDisk = _specificStats.spills > 0;
     _specificStats.limit = _limit;
     _specificStats.sortPattern = _pattern.getOwned();
 
@@ -250,10 +296,11 @@ const SpecificStats* SortStage::getSpecificStats() const {
  *                     Updates memory usage if item was replaced.
  *     sortBuffer() - Does nothing.
  * limit > 1:
- *     addToBuffer() - Does not update vector. Adds item to set.
- *                     If size of set exceeds limit, remove item from set
- *                     with lowest key. Updates memory usage accordingly.
- *     sortBuffer() - Copies items from set to vectors.
+ *     addToBuffer() - Keeps vector as a max-heap of at most limit items.
+ *                     Once the heap is full, a new item replaces the heap's
+ *                     top if it sorts before it, and is freed otherwise.
+ *                     Updates memory usage accordingly.
+ *     sortBuffer() - Sorts the heap in place.
  */
 void SortStage::addToBuffer(const SortableDataItem& item) {
     // Holds ID of working set member to be freed at end of this function.
@@ -282,33 +329,28 @@ void SortStage::addToBuffer(const SortableDataItem& item) {
             _memUsage = member->getMemUsage();
         }
     } else {
-        // Update data item set instead of vector
+        const WorkingSetComparator& cmp = *_sortKeyComparator;
+
         // Limit not reached - insert and return
-        vector<SortableDataItem>::size_type limit(_limit);
-        if (_dataSet->size() < limit) {
+        if (_data.size() < _limit) {
             member->makeObjOwnedIfNeeded();
-            _dataSet->insert(item);
+            _data.push_back(item);
+            std::push_heap(_data.begin(), _data.end(), cmp);
             _memUsage += member->getMemUsage();
             return;
         }
-        // Limit will be exceeded - compare with item with lowest key
-        // If new item does not have a lower key value than last item,
-        // do nothing.
+
+        // Limit will be exceeded - compare with the item which sorts last, at the top of the
+        // heap. If the new item does not sort before it, do nothing.
         wsidToFree = item.wsid;
-        SortableDataItemSet::const_iterator lastItemIt = --(_dataSet->end());
-        const SortableDataItem& lastItem = *lastItemIt;
-        const WorkingSetComparator& cmp = *_sortKeyComparator;
-        if (cmp(item, lastItem)) {
-            _memUsage -= _ws->get(lastItem.wsid)->getMemUsage();
+        if (cmp(item, _data.front())) {
+            wsidToFree = _data.front().wsid;
+            _memUsage -= _ws->get(wsidToFree)->getMemUsage();
             _memUsage += member->getMemUsage();
-            wsidToFree = lastItem.wsid;
-            // According to std::set iterator validity rules,
-            // it does not matter which of erase()/insert() happens first.
-            // Here, we choose to erase first to release potential resources
-            // used by the last item and to keep the scope of the iterator to a minimum.
-            _dataSet->erase(lastItemIt);
             member->makeObjOwnedIfNeeded();
-            _dataSet->insert(item);
+            std::pop_heap(_data.begin(), _data.end(), cmp);
+            _data.back() = item;
+            std::push_heap(_data.begin(), _data.end(), cmp);
         }
     }
 
@@ -331,13 +373,89 @@ void SortStage::sortBuffer() {
         // Buffer contains either 0 or 1 item so it is already in a sorted state.
         return;
     } else {
-        // Set already contains items in sorted order, so we simply copy the items
-        // from the set to the vector.
-        // Release the memory for the set after the copy.
-        vector<SortableDataItem> newData(_dataSet->begin(), _dataSet->end());
-        _data.swap(newData);
-        _dataSet.reset();
+        const WorkingSetComparator& cmp = *_sortKeyComparator;
+        std::sort_heap(_data.begin(), _data.end(), cmp);
     }
 }
 
+void SortStage::spill() {
+    invariant(_allowDiskUse);
+    sortBuffer();
+
+    SortedFileWriter<BSONObj, BSONObj> writer(SortOptions().TempDir(_tempDir));
+    for (auto&& item : _data) {
+        WorkingSetMember* member = _ws->get(item.wsid);
+        // The planner never defers the fetch past a sort which may spill.
+        invariant(member->hasObj());
+
+        BSONObjBuilder bob;
+        bob.append(kSpillObjField, member->obj.value());
+        if (!item.recordId.isNull()) {
+            // Kept only to break ties between equal sort keys when merging.
+            bob.append(kSpillRecordIdField, static_cast<long long>(item.recordId.repr()));
+        }
+        if (member->hasComputed(WSM_COMPUTED_TEXT_SCORE)) {
+            auto score = static_cast<const TextScoreComputedData*>(
+                member->getComputed(WSM_COMPUTED_TEXT_SCORE));
+            bob.append(kSpillTextScoreField, score->getScore());
+        }
+        if (member->hasComputed(WSM_COMPUTED_GEO_DISTANCE)) {
+            auto dist = static_cast<const GeoDistanceComputedData*>(
+                member->getComputed(WSM_COMPUTED_GEO_DISTANCE));
+            bob.append(kSpillGeoDistanceField, dist->getDist());
+        }
+        if (member->hasComputed(WSM_GEO_NEAR_POINT)) {
+            auto point = static_cast<const GeoNearPointComputedData*>(
+                member->getComputed(WSM_GEO_NEAR_POINT));
+            bob.append(kSpillGeoNearPointField, point->getPoint());
+        }
+        if (member->hasComputed(WSM_INDEX_KEY)) {
+            auto key =
+                static_cast<const IndexKeyComputedData*>(member->getComputed(WSM_INDEX_KEY));
+            bob.append(kSpillIndexKeyField, key->getKey());
+        }
+        writer.addAlreadySorted(item.sortKey, bob.obj());
+
+        // The spilled copy is now authoritative, so this member no longer needs invalidations.
+        if (member->hasRecordId()) {
+            _wsidByRecordId.erase(member->recordId);
+        }
+        _ws->free(item.wsid);
+    }
+
+    _spilledRuns.emplace_back(writer.done());
+    ++_specificStats.spills;
+
+    _data.clear();
+    _resultIterator = _data.end();
+    _memUsage = 0;
+}
+
+WorkingSetID SortStage::allocateFromSpill(const SpillIterator::Data& data) {
+    const BSONObj& spilled = data.second;
+
+    WorkingSetID id = _ws->allocate();
+    WorkingSetMember* member = _ws->get(id);
+    member->obj = Snapshotted<BSONObj>(SnapshotId(), spilled[kSpillObjField].Obj().getOwned());
+    member->transitionToOwnedObj();
+
+    member->addComputed(new SortKeyComputedData(data.first));
+    if (BSONElement score = spilled[kSpillTextScoreField]) {
+        member->addComputed(new TextScoreComputedData(score.numberDouble()));
+    }
+    if (BSONElement dist = spilled[kSpillGeoDistanceField]) {
+        member->addComputed(new GeoDistanceComputedData(dist.numberDouble()));
+    }
+    if (BSONElement point = spilled[kSpillGeoNearPointField]) {
+        member->addComputed(new GeoNearPointComputedData(point.Obj()));
+    }
+    if (BSONElement key = spilled[kSpillIndexKeyField]) {
+        member->addComputed(new IndexKeyComputedData(key.Obj()));
+    }
+    return id;
+}
+
 }  // namespace mongo
+
+#include "mongo/db/sorter/sorter.cpp"
+// Explicit instantiation unneeded since we aren't exposing Sorter outside of this file.
@@ -28,7 +28,7 @@
 
 #pragma once
 
-#include <set>
+#include <string>
 #include <vector>
 
 #include "mongo/db/exec/plan_stage.h"
@@ -37,6 +37,7 @@
 #include "mongo/db/jsobj.h"
 #include "mongo/db/query/index_bounds.h"
 #include "mongo/db/record_id.h"
+#include "mongo/db/sorter/sorter.h"
 #include "mongo/platform/unordered_map.h"
 
 namespace mongo {
@@ -46,7 +47,7 @@ class BtreeKeyGenerator;
 // Parameters that must be provided to a SortStage
 class SortStageParams {
 public:
-    SortStageParams() : collection(NULL), limit(0) {}
+    SortStageParams() : collection(NULL), limit(0), allowDiskUse(false) {}
 
     // Used for resolving RecordIds to BSON
     const Collection* collection;
@@ -56,11 +57,26 @@ public:
 
     // Equal to 0 for no limit.
     size_t limit;
+
+    // If true, buffered data is written to sorted runs under 'tempDir' once it exceeds the
+    // in-memory sort limit, rather than failing the query.
+    bool allowDiskUse;
+
+    // Directory for spilled runs. Must be set if 'allowDiskUse' is true.
+    std::string tempDir;
 };
 
 /**
  * Sorts the input received from the child according to the sort pattern provided.
  *
+ * If 'allowDiskUse' is set, buffered results are sorted and written to disk whenever they exceed
+ * the in-memory limit, and the spilled runs are merged once the child is exhausted. Results read
+ * back from disk are returned as owned objects without a RecordId.
+ *
+ * With a limit of K, only the best K results seen so far are kept, in a bounded heap, and every
+ * other result is freed as soon as it is known not to make the cut. If the child supplies index
+ * keys rather than documents, only those keys are buffered, and the caller fetches the K winners.
+ *
  * Preconditions:
  *   -- For each field in 'pattern', all inputs in the child must handle a getFieldDotted for that
  *   field.
@@ -124,7 +140,7 @@ private:
         RecordId recordId;
     };
 
-    // Comparison object for data buffers (vector and set). Items are compared on (sortKey, loc).
+    // Comparison object for the data buffer. Items are compared on (sortKey, loc).
     // This is also how the items are ordered in the indices. Keys are compared using
     // BSONObj::woCompare() with RecordId as a tie-breaker.
     //
@@ -139,19 +155,41 @@ private:
     };
 
     /**
-     * Inserts one item into data buffer (vector or set).
-     * If limit is exceeded, remove item with lowest key.
+     * Inserts one item into the data buffer.
+     * If limit is exceeded, remove the item which sorts last.
      */
     void addToBuffer(const SortableDataItem& item);
 
     /**
      * Sorts data buffer.
      * Assumes no more items will be added to buffer.
-     * If data is stored in set, copy set
-     * contents to vector and clear set.
      */
     void sortBuffer();
 
+    // Sorted runs spilled to disk. The key is the sort key and the value holds the document
+    // along with its RecordId and any computed data which must survive the round trip.
+    typedef SortIteratorInterface<BSONObj, BSONObj> SpillIterator;
+
+    // Comparison object for merging spilled runs. Orders the same way as WorkingSetComparator.
+    struct SpillComparator {
+        explicit SpillComparator(BSONObj p);
+
+        int operator()(const SpillIterator::Data& lhs, const SpillIterator::Data& rhs) const;
+
+        BSONObj pattern;
+    };
+
+    /**
+     * Sorts the data buffer and writes it to a new run on disk, freeing the buffered working set
+     * members and resetting the memory usage.
+     */
+    void spill();
+
+    /**
+     * Allocates an owned working set member holding a document read back from a spilled run.
+     */
+    WorkingSetID allocateFromSpill(const SpillIterator::Data& data);
+
     // Comparator for data buffer
     // Initialization follows sort key generator
     std::unique_ptr<WorkingSetComparator> _sortKeyComparator;
@@ -160,12 +198,9 @@ private:
     // _data will contain sorted data when all data is gathered
     // and sorted.
     // When _limit is greater than 1 and not all data has been gathered from child stage,
-    // _dataSet is used instead to maintain an ordered set of the incomplete data set.
-    // When the data set is complete, we copy the items from _dataSet to _data which will
-    // be used to provide the results of this stage through _resultIterator.
+    // _data is a max-heap under _sortKeyComparator of at most _limit items, so that the item
+    // which sorts last is always at the front, ready to be evicted.
     std::vector<SortableDataItem> _data;
-    typedef std::set<SortableDataItem, WorkingSetComparator> SortableDataItemSet;
-    std::unique_ptr<SortableDataItemSet> _dataSet;
 
     // Iterates through _data post-sort returning it.
     std::vector<SortableDataItem>::iterator _resultIterator;
@@ -178,6 +213,20 @@ private:
 
     // The usage in bytes of all buffered data that we're sorting.
     size_t _memUsage;
+
+    //
+    // External sort
+    //
+
+    const bool _allowDiskUse;
+    const std::string _tempDir;
+
+    // Runs written by spill() which have not yet been merged.
+    std::vector<std::shared_ptr<SpillIterator>> _spilledRuns;
+
+    // Set once the child is exhausted if anything was spilled. Returns results in sorted order
+    // in place of _resultIterator.
+    std::unique_ptr<SpillIterator> _mergeIterator;
 };
 
 }  // namespace mongo
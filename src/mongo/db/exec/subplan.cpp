@@ -545,6 +545,19 @@ PlanStage::StageState SubplanStage::doWork(WorkingSetID* out) {
     return child()->work(out);
 }
 
+PlanStage::StageState SubplanStage::doWorkBatch(WorkingSet* ws,
+                                                size_t maxWorks,
+                                                std::vector<WorkingSetID>* out,
+                                                WorkingSetID* stateId) {
+    if (isEOF()) {
+        return PlanStage::IS_EOF;
+    }
+
+    invariant(child());
+    ++_commonStats.works;
+    return child()->workBatch(ws, maxWorks, out, stateId);
+}
+
 unique_ptr<PlanStageStats> SubplanStage::getStats() {
     _commonStats.isEOF = isEOF();
     unique_ptr<PlanStageStats> ret = make_unique<PlanStageStats>(_commonStats, STAGE_SUBPLAN);
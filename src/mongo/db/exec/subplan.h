@@ -79,11 +79,19 @@ public:
 
     bool isEOF() final;
     StageState doWork(WorkingSetID* out) final;
+    StageState doWorkBatch(WorkingSet* ws,
+                           size_t maxWorks,
+                           std::vector<WorkingSetID>* out,
+                           WorkingSetID* stateId) final;
 
     StageType stageType() const final {
         return STAGE_SUBPLAN;
     }
 
+    bool supportsBatchedWork() const final {
+        return childrenSupportBatchedWork();
+    }
+
     std::unique_ptr<PlanStageStats> getStats();
 
     const SpecificStats* getSpecificStats() const final;
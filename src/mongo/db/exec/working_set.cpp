@@ -28,6 +28,8 @@
 
 #include "mongo/db/exec/working_set.h"
 
+#include <cstring>
+
 #include "mongo/db/bson/dotted_path_support.h"
 #include "mongo/db/index/index_descriptor.h"
 #include "mongo/db/service_context.h"
@@ -39,6 +41,14 @@ using std::string;
 
 namespace dps = ::mongo::dotted_path_support;
 
+namespace {
+
+// Buffers larger than this are freed rather than recycled, to bound the memory held by free
+// members.
+const size_t kMaxRecycledBufferBytes = 64 * 1024;
+
+}  // namespace
+
 WorkingSet::MemberHolder::MemberHolder() : member(NULL) {}
 WorkingSet::MemberHolder::~MemberHolder() {}
 
@@ -132,6 +142,34 @@ std::vector<WorkingSetID> WorkingSet::getAndClearYieldSensitiveIds() {
     return out;
 }
 
+void WorkingSet::freeRecycledBuffers() {
+    for (auto&& holder : _data) {
+        holder.member->_recycledBuffer = SharedBuffer();
+    }
+}
+
+WorkingSetID WorkingSet::moveFrom(WorkingSet* other, WorkingSetID otherId) {
+    MemberHolder& otherHolder = other->_data[otherId];
+    verify(otherId < other->_data.size());         // ID has been allocated.
+    verify(otherHolder.nextFreeOrSelf == otherId);  // ID currently in use.
+
+    // Swap in the empty member we just allocated, which 'other' then frees in place of the moved
+    // one.
+    WorkingSetID id = allocate();
+    std::swap(_data[id].member, otherHolder.member);
+    if (other->isFlagged(otherId)) {
+        _flagged.insert(id);
+    }
+    other->free(otherId);
+
+    WorkingSetMember* member = _data[id].member;
+    if (member->getState() == WorkingSetMember::RID_AND_IDX ||
+        member->getState() == WorkingSetMember::RID_AND_OBJ) {
+        _yieldSensitiveIds.push_back(id);
+    }
+    return id;
+}
+
 //
 // WorkingSetMember
 //
@@ -146,6 +184,19 @@ void WorkingSetMember::clear() {
     }
 
     keyData.clear();
+
+    // Hold on to the buffer of an owned object if we are its only owner and the object starts at
+    // the beginning of the buffer, so that it can be overwritten by the next copy.
+    const BSONObj& oldObj = obj.value();
+    if (oldObj.isOwned() && !oldObj.sharedBuffer().isShared() &&
+        oldObj.sharedBuffer().get() == oldObj.objdata()) {
+        SharedBuffer buffer = obj.value().releaseSharedBuffer().constCast();
+        if (buffer.capacity() <= kMaxRecycledBufferBytes &&
+            buffer.capacity() > _recycledBuffer.capacity()) {
+            _recycledBuffer = std::move(buffer);
+        }
+    }
+
     obj.reset();
     _state = WorkingSetMember::INVALID;
 }
@@ -174,7 +225,13 @@ bool WorkingSetMember::hasOwnedObj() const {
 
 void WorkingSetMember::makeObjOwnedIfNeeded() {
     if (supportsDocLocking() && _state == RID_AND_OBJ && !obj.value().isOwned()) {
-        obj.setValue(obj.value().getOwned());
+        const size_t size = obj.value().objsize();
+        if (_recycledBuffer.capacity() >= size) {
+            memcpy(_recycledBuffer.get(), obj.value().objdata(), size);
+            obj.setValue(BSONObj(std::move(_recycledBuffer)));
+        } else {
+            obj.setValue(obj.value().getOwned());
+        }
     }
 }
 
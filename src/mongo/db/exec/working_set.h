@@ -36,6 +36,7 @@
 #include "mongo/db/storage/snapshot.h"
 #include "mongo/platform/unordered_set.h"
 #include "mongo/stdx/unordered_set.h"
+#include "mongo/util/shared_buffer.h"
 
 namespace mongo {
 
@@ -139,6 +140,22 @@ public:
      */
     std::vector<WorkingSetID> getAndClearYieldSensitiveIds();
 
+    /**
+     * Releases the buffers which free members keep around for their next owned object. Members
+     * which are in use keep their objects.
+     *
+     * PlanExecutor calls this when it is detached between batches, so that an idle cursor does
+     * not pin the memory of its previous batch.
+     */
+    void freeRecycledBuffers();
+
+    /**
+     * Moves the in-use member 'otherId' of 'other' into a newly allocated member of this
+     * WorkingSet, freeing it in 'other', and returns its new id. The member itself changes hands
+     * rather than being copied, so pointers to it from before the move remain valid.
+     */
+    WorkingSetID moveFrom(WorkingSet* other, WorkingSetID otherId);
+
 private:
     struct MemberHolder {
         MemberHolder();
@@ -295,6 +312,9 @@ public:
      * is in a different state or if 'obj' is already owned.
      *
      * It is also a no-op if the active storage engine doesn't support document-level concurrency.
+     *
+     * The copy is made into the buffer recycled from an object this member previously owned, if
+     * it is large enough.
      */
     void makeObjOwnedIfNeeded();
 
@@ -339,6 +359,10 @@ private:
     std::unique_ptr<WorkingSetComputedData> _computed[WSM_COMPUTED_NUM_TYPES];
 
     std::unique_ptr<RecordFetcher> _fetcher;
+
+    // The buffer of an owned object this member held before it was last cleared, if no one else
+    // referred to it. Reused by makeObjOwnedIfNeeded() to avoid an allocation per document.
+    SharedBuffer _recycledBuffer;
 };
 
 }  // namespace mongo
@@ -31,6 +31,7 @@
  */
 
 
+#include "mongo/db/concurrency/lock_manager_test_help.h"
 #include "mongo/db/exec/working_set.h"
 #include "mongo/db/jsobj.h"
 #include "mongo/db/json.h"
@@ -154,4 +155,95 @@ TEST_F(WorkingSetFixture, getDottedFieldFromIndex) {
     ASSERT_FALSE(member->getFieldDotted("y", &elt));
 }
 
+TEST_F(WorkingSetFixture, makeObjOwnedReusesBufferOfFreedMember) {
+    ForceSupportsDocLocking docLocking(true);
+
+    BSONObj first = BSON("a" << 1 << "b" << "some string");
+    member->obj = Snapshotted<BSONObj>(SnapshotId(), BSONObj(first.objdata()));
+    ws->transitionToRecordIdAndObj(id);
+    member->makeObjOwnedIfNeeded();
+    ASSERT_TRUE(member->obj.value().isOwned());
+    const char* ownedData = member->obj.value().objdata();
+    ws->free(id);
+
+    // The free list hands back the same member, which copies into the buffer it kept.
+    BSONObj second = BSON("c" << 2);
+    id = ws->allocate();
+    member = ws->get(id);
+    member->obj = Snapshotted<BSONObj>(SnapshotId(), BSONObj(second.objdata()));
+    ws->transitionToRecordIdAndObj(id);
+    member->makeObjOwnedIfNeeded();
+    ASSERT_TRUE(member->obj.value().isOwned());
+    ASSERT_EQUALS(ownedData, member->obj.value().objdata());
+    ASSERT_BSONOBJ_EQ(second, member->obj.value());
+}
+
+TEST_F(WorkingSetFixture, makeObjOwnedDoesNotReuseBufferStillReferenced) {
+    ForceSupportsDocLocking docLocking(true);
+
+    BSONObj first = BSON("a" << 1);
+    member->obj = Snapshotted<BSONObj>(SnapshotId(), BSONObj(first.objdata()));
+    ws->transitionToRecordIdAndObj(id);
+    member->makeObjOwnedIfNeeded();
+    BSONObj stillReferenced = member->obj.value();
+    ws->free(id);
+
+    BSONObj second = BSON("b" << 2);
+    id = ws->allocate();
+    member = ws->get(id);
+    member->obj = Snapshotted<BSONObj>(SnapshotId(), BSONObj(second.objdata()));
+    ws->transitionToRecordIdAndObj(id);
+    member->makeObjOwnedIfNeeded();
+    ASSERT_NOT_EQUALS(stillReferenced.objdata(), member->obj.value().objdata());
+    ASSERT_BSONOBJ_EQ(first, stillReferenced);
+    ASSERT_BSONOBJ_EQ(second, member->obj.value());
+}
+
+TEST_F(WorkingSetFixture, freeRecycledBuffersDropsKeptBuffers) {
+    ForceSupportsDocLocking docLocking(true);
+
+    BSONObj first = BSON("a" << 1 << "b" << "some string");
+    member->obj = Snapshotted<BSONObj>(SnapshotId(), BSONObj(first.objdata()));
+    ws->transitionToRecordIdAndObj(id);
+    member->makeObjOwnedIfNeeded();
+    ws->free(id);
+    ws->freeRecycledBuffers();
+
+    // With nothing to reuse, the copy must come from a fresh allocation and still be correct.
+    BSONObj second = BSON("c" << 2);
+    id = ws->allocate();
+    member = ws->get(id);
+    member->obj = Snapshotted<BSONObj>(SnapshotId(), BSONObj(second.objdata()));
+    ws->transitionToRecordIdAndObj(id);
+    member->makeObjOwnedIfNeeded();
+    ASSERT_TRUE(member->obj.value().isOwned());
+    ASSERT_BSONOBJ_EQ(second, member->obj.value());
+}
+
+TEST_F(WorkingSetFixture, moveFromTransfersMemberBetweenWorkingSets) {
+    BSONObj obj = BSON("a" << 1);
+    member->obj = Snapshotted<BSONObj>(SnapshotId(), obj);
+    member->recordId = RecordId(42);
+    ws->transitionToRecordIdAndObj(id);
+    ws->getAndClearYieldSensitiveIds();
+
+    WorkingSet other;
+    WorkingSetID movedId = other.moveFrom(ws.get(), id);
+    ASSERT_TRUE(ws->isFree(id));
+    ASSERT_EQUALS(member, other.get(movedId));
+    ASSERT_EQUALS(WorkingSetMember::RID_AND_OBJ, member->getState());
+    ASSERT_EQUALS(RecordId(42), member->recordId);
+    ASSERT_BSONOBJ_EQ(obj, member->obj.value());
+
+    // The member is yield sensitive in the WorkingSet it was moved to.
+    std::vector<WorkingSetID> yieldSensitiveIds = other.getAndClearYieldSensitiveIds();
+    ASSERT_EQUALS(1U, yieldSensitiveIds.size());
+    ASSERT_EQUALS(movedId, yieldSensitiveIds[0]);
+
+    // The freed id is handed out again with an empty member.
+    WorkingSetID reusedId = ws->allocate();
+    ASSERT_EQUALS(id, reusedId);
+    ASSERT_EQUALS(WorkingSetMember::INVALID, ws->get(reusedId)->getState());
+}
+
 }  // namespace
@@ -478,6 +478,8 @@ void InMatchExpression::_doSetCollator(const CollatorInterface* collator) {
 }
 
 Status InMatchExpression::setEqualities(std::vector<BSONElement> equalities) {
+    _hasNull = false;
+    _hasEmptyArray = false;
     for (auto&& equality : equalities) {
         if (equality.type() == BSONType::RegEx) {
             return Status(ErrorCodes::BadValue, "InMatchExpression equality cannot be a regex");
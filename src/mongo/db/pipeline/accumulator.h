@@ -60,6 +60,15 @@ public:
         processInternal(input, merging);
     }
 
+    /**
+     * Processes the 'count' inputs at 'inputs' in order, with the same result as calling process()
+     * on each of them. $group uses this to hand a group's accumulators the inputs from a whole
+     * batch of documents at once.
+     */
+    void processBatch(const Value* inputs, size_t count, bool merging) {
+        processBatchInternal(inputs, count, merging);
+    }
+
     /** Marks the end of the evaluate() phase and return accumulated result.
      *  toBeMerged should be true when the outputs will be merged by process().
      */
@@ -77,6 +86,14 @@ public:
     virtual void reset() = 0;
 
 
+    /**
+     * Returns true if this accumulator overrides processBatchInternal() to process a run of
+     * inputs faster than one at a time, which makes it worth $group's while to batch its inputs.
+     */
+    virtual bool hasFastBatchProcessing() const {
+        return false;
+    }
+
     virtual bool isAssociative() const {
         return false;
     }
@@ -89,6 +106,16 @@ protected:
     /// Update subclass's internal state based on input
     virtual void processInternal(const Value& input, bool merging) = 0;
 
+    /**
+     * Accumulators which can process a run of numbers faster than one at a time override this. The
+     * default processes each input in turn.
+     */
+    virtual void processBatchInternal(const Value* inputs, size_t count, bool merging) {
+        for (size_t i = 0; i < count; ++i) {
+            processInternal(inputs[i], merging);
+        }
+    }
+
     const boost::intrusive_ptr<ExpressionContext>& getExpressionContext() const {
         return _expCtx;
     }
@@ -166,10 +193,15 @@ public:
     explicit AccumulatorSum(const boost::intrusive_ptr<ExpressionContext>& expCtx);
 
     void processInternal(const Value& input, bool merging) final;
+    void processBatchInternal(const Value* inputs, size_t count, bool merging) final;
     Value getValue(bool toBeMerged) final;
     const char* getOpName() const final;
     void reset() final;
 
+    bool hasFastBatchProcessing() const final {
+        return true;
+    }
+
     static boost::intrusive_ptr<Accumulator> create(
         const boost::intrusive_ptr<ExpressionContext>& expCtx);
 
@@ -198,10 +230,15 @@ public:
     AccumulatorMinMax(const boost::intrusive_ptr<ExpressionContext>& expCtx, Sense sense);
 
     void processInternal(const Value& input, bool merging) final;
+    void processBatchInternal(const Value* inputs, size_t count, bool merging) final;
     Value getValue(bool toBeMerged) final;
     const char* getOpName() const final;
     void reset() final;
 
+    bool hasFastBatchProcessing() const final {
+        return true;
+    }
+
     bool isAssociative() const final {
         return true;
     }
@@ -254,10 +291,15 @@ public:
     explicit AccumulatorAvg(const boost::intrusive_ptr<ExpressionContext>& expCtx);
 
     void processInternal(const Value& input, bool merging) final;
+    void processBatchInternal(const Value* inputs, size_t count, bool merging) final;
     Value getValue(bool toBeMerged) final;
     const char* getOpName() const final;
     void reset() final;
 
+    bool hasFastBatchProcessing() const final {
+        return true;
+    }
+
     static boost::intrusive_ptr<Accumulator> create(
         const boost::intrusive_ptr<ExpressionContext>& expCtx);
 
@@ -280,10 +322,15 @@ public:
     AccumulatorStdDev(const boost::intrusive_ptr<ExpressionContext>& expCtx, bool isSamp);
 
     void processInternal(const Value& input, bool merging) final;
+    void processBatchInternal(const Value* inputs, size_t count, bool merging) final;
     Value getValue(bool toBeMerged) final;
     const char* getOpName() const final;
     void reset() final;
 
+    bool hasFastBatchProcessing() const final {
+        return true;
+    }
+
 private:
     const bool _isSamp;
     long long _count;
@@ -34,6 +34,7 @@
 #include "mongo/db/pipeline/document.h"
 #include "mongo/db/pipeline/expression.h"
 #include "mongo/db/pipeline/expression_context.h"
+#include "mongo/db/pipeline/numeric_run_reader.h"
 #include "mongo/db/pipeline/value.h"
 #include "mongo/platform/decimal128.h"
 
@@ -92,6 +93,36 @@ void AccumulatorAvg::processInternal(const Value& input, bool merging) {
     _count++;
 }
 
+void AccumulatorAvg::processBatchInternal(const Value* inputs, size_t count, bool merging) {
+    if (merging) {
+        Accumulator::processBatchInternal(inputs, count, merging);
+        return;
+    }
+
+    NumericRunReader runs(inputs, count);
+    while (runs.next()) {
+        switch (runs.type()) {
+            case NumberDouble:
+                _nonDecimalTotal.addDoubles(runs.doubles(), runs.size());
+                _count += runs.size();
+                break;
+            case NumberLong:
+                _nonDecimalTotal.addLongs(runs.longs(), runs.size());
+                _count += runs.size();
+                break;
+            case NumberInt:
+                // Ints are summed as doubles, as in processInternal().
+                for (size_t i = 0; i < runs.size(); ++i) {
+                    _nonDecimalTotal.addDouble(static_cast<double>(runs.longs()[i]));
+                }
+                _count += runs.size();
+                break;
+            default:
+                processInternal(runs.other(), merging);
+        }
+    }
+}
+
 intrusive_ptr<Accumulator> AccumulatorAvg::create(
     const boost::intrusive_ptr<ExpressionContext>& expCtx) {
     return new AccumulatorAvg(expCtx);
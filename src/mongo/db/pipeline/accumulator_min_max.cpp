@@ -30,8 +30,12 @@
 
 #include "mongo/db/pipeline/accumulator.h"
 
+#include <algorithm>
+
+#include "mongo/base/compare_numbers.h"
 #include "mongo/db/pipeline/accumulation_statement.h"
 #include "mongo/db/pipeline/expression.h"
+#include "mongo/db/pipeline/numeric_run_reader.h"
 #include "mongo/db/pipeline/value.h"
 
 namespace mongo {
@@ -61,6 +65,50 @@ void AccumulatorMinMax::processInternal(const Value& input, bool merging) {
     }
 }
 
+void AccumulatorMinMax::processBatchInternal(const Value* inputs, size_t count, bool merging) {
+    // Only the best of each run of numbers needs comparing against '_val'. Numbers are compared
+    // the same way under any collation, and the first of several equal numbers is kept, as it
+    // would be if they were processed one at a time.
+    NumericRunReader runs(inputs, count);
+    while (runs.next()) {
+        switch (runs.type()) {
+            case NumberDouble: {
+                // Doubles which compare equal may still differ, as 0 and -0 do, and NaN sorts
+                // before every other number, so use the same comparison as Value.
+                const double* values = runs.doubles();
+                double best = values[0];
+                for (size_t i = 1; i < runs.size(); ++i) {
+                    if (compareDoubles(best, values[i]) * _sense > 0) {
+                        best = values[i];
+                    }
+                }
+                processInternal(Value(best), merging);
+                break;
+            }
+            case NumberInt:
+            case NumberLong: {
+                const long long* values = runs.longs();
+                long long best = values[0];
+                if (_sense == MIN) {
+                    for (size_t i = 1; i < runs.size(); ++i) {
+                        best = std::min(best, values[i]);
+                    }
+                } else {
+                    for (size_t i = 1; i < runs.size(); ++i) {
+                        best = std::max(best, values[i]);
+                    }
+                }
+                processInternal(runs.type() == NumberInt ? Value(static_cast<int>(best))
+                                                         : Value(best),
+                                merging);
+                break;
+            }
+            default:
+                processInternal(runs.other(), merging);
+        }
+    }
+}
+
 Value AccumulatorMinMax::getValue(bool toBeMerged) {
     if (_val.missing()) {
         return Value(BSONNULL);
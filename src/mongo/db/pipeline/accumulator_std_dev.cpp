@@ -34,6 +34,7 @@
 #include "mongo/db/pipeline/document.h"
 #include "mongo/db/pipeline/expression.h"
 #include "mongo/db/pipeline/expression_context.h"
+#include "mongo/db/pipeline/numeric_run_reader.h"
 #include "mongo/db/pipeline/value.h"
 
 namespace mongo {
@@ -44,6 +45,32 @@ REGISTER_ACCUMULATOR(stdDevSamp, AccumulatorStdDevSamp::create);
 REGISTER_EXPRESSION(stdDevPop, ExpressionFromAccumulator<AccumulatorStdDevPop>::parse);
 REGISTER_EXPRESSION(stdDevSamp, ExpressionFromAccumulator<AccumulatorStdDevSamp>::parse);
 
+namespace {
+/**
+ * Adds the 'size' numbers at 'values' to the running 'count', 'mean' and 'm2' of a standard
+ * deviation, in order. The running values are kept in locals for the length of the loop.
+ */
+template <typename T>
+void addToVariance(const T* values, size_t size, long long* count, double* mean, double* m2) {
+    long long newCount = *count;
+    double newMean = *mean;
+    double newM2 = *m2;
+    for (size_t i = 0; i < size; ++i) {
+        const double val = static_cast<double>(values[i]);
+
+        // This is an implementation of the following algorithm:
+        // http://en.wikipedia.org/wiki/Algorithms_for_calculating_variance#Online_algorithm
+        newCount += 1;
+        const double delta = val - newMean;
+        newMean += delta / newCount;
+        newM2 += delta * (val - newMean);
+    }
+    *count = newCount;
+    *mean = newMean;
+    *m2 = newM2;
+}
+}  // namespace
+
 const char* AccumulatorStdDev::getOpName() const {
     return (_isSamp ? "$stdDevSamp" : "$stdDevPop");
 }
@@ -55,13 +82,7 @@ void AccumulatorStdDev::processInternal(const Value& input, bool merging) {
             return;
 
         const double val = input.getDouble();
-
-        // This is an implementation of the following algorithm:
-        // http://en.wikipedia.org/wiki/Algorithms_for_calculating_variance#Online_algorithm
-        _count += 1;
-        const double delta = val - _mean;
-        _mean += delta / _count;
-        _m2 += delta * (val - _mean);
+        addToVariance(&val, 1, &_count, &_mean, &_m2);
     } else {
         // This is what getValue(true) produced below.
         verify(input.getType() == Object);
@@ -83,6 +104,28 @@ void AccumulatorStdDev::processInternal(const Value& input, bool merging) {
     }
 }
 
+void AccumulatorStdDev::processBatchInternal(const Value* inputs, size_t count, bool merging) {
+    if (merging) {
+        Accumulator::processBatchInternal(inputs, count, merging);
+        return;
+    }
+
+    NumericRunReader runs(inputs, count);
+    while (runs.next()) {
+        switch (runs.type()) {
+            case NumberDouble:
+                addToVariance(runs.doubles(), runs.size(), &_count, &_mean, &_m2);
+                break;
+            case NumberInt:
+            case NumberLong:
+                addToVariance(runs.longs(), runs.size(), &_count, &_mean, &_m2);
+                break;
+            default:
+                processInternal(runs.other(), merging);
+        }
+    }
+}
+
 Value AccumulatorStdDev::getValue(bool toBeMerged) {
     if (!toBeMerged) {
         const long long adjustedCount = (_isSamp ? _count - 1 : _count);
@@ -35,6 +35,7 @@
 
 #include "mongo/db/pipeline/accumulation_statement.h"
 #include "mongo/db/pipeline/expression.h"
+#include "mongo/db/pipeline/numeric_run_reader.h"
 #include "mongo/db/pipeline/value.h"
 #include "mongo/util/summation.h"
 
@@ -84,6 +85,25 @@ void AccumulatorSum::processInternal(const Value& input, bool merging) {
     }
 }
 
+void AccumulatorSum::processBatchInternal(const Value* inputs, size_t count, bool merging) {
+    NumericRunReader runs(inputs, count);
+    while (runs.next()) {
+        switch (runs.type()) {
+            case NumberDouble:
+                totalType = Value::getWidestNumeric(totalType, NumberDouble);
+                nonDecimalTotal.addDoubles(runs.doubles(), runs.size());
+                break;
+            case NumberInt:
+            case NumberLong:
+                totalType = Value::getWidestNumeric(totalType, runs.type());
+                nonDecimalTotal.addLongs(runs.longs(), runs.size());
+                break;
+            default:
+                processInternal(runs.other(), merging);
+        }
+    }
+}
+
 intrusive_ptr<Accumulator> AccumulatorSum::create(
     const boost::intrusive_ptr<ExpressionContext>& expCtx) {
     return new AccumulatorSum(expCtx);
@@ -66,6 +66,15 @@ static void assertExpectedResults(
                 ASSERT_EQUALS(op.second.getType(), result.getType());
             }
 
+            // Asserts that result equals expected result when the input is processed as a batch.
+            {
+                boost::intrusive_ptr<Accumulator> accum(factory(expCtx));
+                accum->processBatch(op.first.data(), op.first.size(), false);
+                Value result = accum->getValue(false);
+                ASSERT_VALUE_EQ(op.second, result);
+                ASSERT_EQUALS(op.second.getType(), result.getType());
+            }
+
             // Asserts that result equals expected result when all input is on one shard.
             {
                 boost::intrusive_ptr<Accumulator> accum(factory(expCtx));
@@ -354,6 +363,50 @@ TEST(AccumulatorMergeObjects, MergingZeroObjectsShouldReturnEmptyDocument) {
     assertExpectedResults("$mergeObjects", expCtx, {{{}, {Value(Document({}))}}});
 }
 
+TEST(Accumulators, BatchShouldMatchProcessingOneInputAtATime) {
+    intrusive_ptr<ExpressionContext> expCtx(new ExpressionContextForTest());
+
+    // Runs of each numeric type, some longer than a single run can hold, separated by values of
+    // other types. The doubles include values of very different magnitudes, zeros of both signs
+    // and NaN, where the order in which they are processed could otherwise show.
+    std::vector<Value> inputs;
+    for (int i = 0; i < 600; ++i) {
+        inputs.push_back(Value(i % 7 == 0 ? 1e16 : 0.1 * i));
+    }
+    inputs.push_back(Value(-0.0));
+    inputs.push_back(Value(0.0));
+    inputs.push_back(Value("string"_sd));
+    for (int i = 0; i < 300; ++i) {
+        inputs.push_back(Value(i * 1000003));
+    }
+    inputs.push_back(Value(numeric_limits<double>::quiet_NaN()));
+    inputs.push_back(Value(BSONNULL));
+    for (long long i = 0; i < 300; ++i) {
+        inputs.push_back(Value(numeric_limits<long long>::max() / 1000 - i * 7));
+    }
+    inputs.push_back(Value(Decimal128("2.5")));
+    inputs.push_back(Value(42));
+    inputs.push_back(Value(42.0));
+
+    for (auto&& name : {"$sum", "$avg", "$min", "$max", "$stdDevPop", "$stdDevSamp"}) {
+        auto factory = AccumulationStatement::getFactory(name);
+        boost::intrusive_ptr<Accumulator> oneAtATime(factory(expCtx));
+        for (auto&& val : inputs) {
+            oneAtATime->process(val, false);
+        }
+        boost::intrusive_ptr<Accumulator> batched(factory(expCtx));
+        batched->processBatch(inputs.data(), inputs.size(), false);
+
+        // Compare the BSON, so that differences in type or in the last bit of a double show.
+        for (bool toBeMerged : {false, true}) {
+            BSONObj expected = BSON("" << oneAtATime->getValue(toBeMerged));
+            BSONObj result = BSON("" << batched->getValue(toBeMerged));
+            ASSERT_TRUE(result.binaryEqual(expected)) << name << ": expected " << expected
+                                                      << " but got " << result;
+        }
+    }
+}
+
 TEST(AccumulatorMergeObjects, MergingWithSingleObjectShouldLeaveUnchanged) {
     intrusive_ptr<ExpressionContext> expCtx(new ExpressionContextForTest());
 
@@ -0,0 +1,399 @@
+/**
+ *    Copyright (C) 2017 MongoDB Inc.
+ *
+ *    This program is free software: you can redistribute it and/or  modify
+ *    it under the terms of the GNU Affero General Public License, version 3,
+ *    as published by the Free Software Foundation.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU Affero General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Affero General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the GNU Affero General Public License in all respects for
+ *    all of the code used other than as permitted herein. If you modify file(s)
+ *    with this exception, you may extend this exception to your version of the
+ *    file(s), but you are not obligated to do so. If you do not wish to do so,
+ *    delete this exception statement from your version. If you delete this
+ *    exception statement from all source files in the program, then also delete
+ *    it in the license file.
+ */
+
+#include "mongo/platform/basic.h"
+
+#include "mongo/db/pipeline/document_source_exchange.h"
+
+#include <algorithm>
+#include <iterator>
+
+#include "mongo/db/client.h"
+#include "mongo/db/matcher/expression.h"
+#include "mongo/db/operation_context.h"
+#include "mongo/db/pipeline/document_source_group.h"
+#include "mongo/db/pipeline/document_source_match.h"
+#include "mongo/db/pipeline/document_source_single_document_transformation.h"
+#include "mongo/db/pipeline/document_source_unwind.h"
+#include "mongo/db/pipeline/expression_context.h"
+#include "mongo/db/pipeline/value.h"
+#include "mongo/db/query/query_worker_pool.h"
+#include "mongo/db/service_context.h"
+#include "mongo/stdx/condition_variable.h"
+#include "mongo/stdx/mutex.h"
+#include "mongo/util/assert_util.h"
+#include "mongo/util/scopeguard.h"
+
+namespace mongo {
+
+using boost::intrusive_ptr;
+using std::vector;
+
+constexpr StringData DocumentSourceExchange::kStageName;
+
+/**
+ * The first stage of each worker's pipeline. It returns the documents dealt to the worker for the
+ * current round, and then pauses until the next round, or returns EOF once the exchange's input
+ * has run out.
+ */
+class DocumentSourceExchange::Input final : public DocumentSource {
+public:
+    Input(const intrusive_ptr<ExpressionContext>& expCtx) : DocumentSource(expCtx) {}
+
+    GetNextResult getNext() final {
+        pExpCtx->checkForInterrupt();
+
+        if (!documents.empty()) {
+            Document next = std::move(documents.front());
+            documents.pop_front();
+            return std::move(next);
+        }
+        return inputExhausted ? GetNextResult::makeEOF() : GetNextResult::makePauseExecution();
+    }
+
+    StageConstraints constraints(Pipeline::SplitState pipeState) const final {
+        StageConstraints constraints(StreamType::kStreaming,
+                                     PositionRequirement::kFirst,
+                                     HostTypeRequirement::kNone,
+                                     DiskUseRequirement::kNoDiskUse,
+                                     FacetRequirement::kNotAllowed);
+        constraints.requiresInputDocSource = false;
+        return constraints;
+    }
+
+    Value serialize(boost::optional<ExplainOptions::Verbosity> explain) const final {
+        // This stage is added to the front of each worker's pipeline, but is not part of the
+        // prefix being run.
+        return Value();
+    }
+
+    std::deque<Document> documents;
+    bool inputExhausted = false;
+
+protected:
+    void doDispose() final {
+        documents.clear();
+    }
+};
+
+namespace {
+
+// How often the thread waiting for a round checks whether the operation has been interrupted.
+const Milliseconds kInterruptCheckPeriod{10};
+
+/**
+ * Returns false if 'expr' contains anything which can't be evaluated on a worker thread, such as
+ * JavaScript.
+ */
+bool canMatchOnWorkers(const MatchExpression* expr) {
+    switch (expr->matchType()) {
+        case MatchExpression::WHERE:
+        case MatchExpression::TEXT:
+        case MatchExpression::GEO_NEAR:
+            return false;
+        default:
+            break;
+    }
+
+    for (size_t i = 0; i < expr->numChildren(); ++i) {
+        if (!canMatchOnWorkers(expr->getChild(i))) {
+            return false;
+        }
+    }
+    return true;
+}
+
+/**
+ * Returns true if the merging $group gets the same result from the partial results of an
+ * accumulator, whatever order the workers' inputs arrive in.
+ */
+bool isOrderInsensitiveAccumulator(StringData opName) {
+    return opName == "$sum" || opName == "$avg" || opName == "$min" || opName == "$max" ||
+        opName == "$addToSet" || opName == "$stdDevPop" || opName == "$stdDevSamp";
+}
+
+}  // namespace
+
+DocumentSourceExchange::DocumentSourceExchange(const intrusive_ptr<ExpressionContext>& expCtx,
+                                               const vector<BSONObj>& workerPipeline,
+                                               size_t numWorkers,
+                                               size_t batchSize)
+    : DocumentSource(expCtx),
+      _workerPipeline(workerPipeline),
+      _batchSize(batchSize),
+      _workers(numWorkers) {
+    invariant(numWorkers > 0);
+    invariant(_batchSize > 0);
+
+    for (auto&& worker : _workers) {
+        // Each worker parses a copy of the prefix with an ExpressionContext of its own, since
+        // neither the stages nor their expressions' variables may be shared between threads. The
+        // copy produces partial results for the stages after the exchange to merge, just as it
+        // would on a shard.
+        auto workerExpCtx = pExpCtx->copyWith(pExpCtx->ns);
+        workerExpCtx->needsMerge = true;
+
+        worker.pipeline = uassertStatusOK(Pipeline::parse(_workerPipeline, workerExpCtx));
+        worker.pipeline->optimizePipeline();
+
+        // The workers' $group stages hold their groups at the same time, so between them they may
+        // use no more memory than a single $group would.
+        for (auto&& source : worker.pipeline->getSources()) {
+            if (auto group = dynamic_cast<DocumentSourceGroup*>(source.get())) {
+                group->setMaxMemoryUsageBytes(
+                    std::max<size_t>(1, group->getMaxMemoryUsageBytes() / numWorkers));
+            }
+        }
+        worker.input = new Input(workerExpCtx);
+        worker.pipeline->addInitialSource(worker.input);
+
+        // Each round attaches the pipeline to an OperationContext of the worker thread's own.
+        worker.pipeline->detachFromOperationContext();
+    }
+}
+
+DocumentSourceExchange::~DocumentSourceExchange() = default;
+
+intrusive_ptr<DocumentSourceExchange> DocumentSourceExchange::create(
+    const intrusive_ptr<ExpressionContext>& expCtx,
+    const vector<BSONObj>& workerPipeline,
+    size_t numWorkers,
+    size_t batchSize) {
+    return new DocumentSourceExchange(expCtx, workerPipeline, numWorkers, batchSize);
+}
+
+bool DocumentSourceExchange::canRunOnWorkers(const DocumentSource& stage) {
+    if (dynamic_cast<const DocumentSourceSingleDocumentTransformation*>(&stage) ||
+        dynamic_cast<const DocumentSourceUnwind*>(&stage)) {
+        return true;
+    }
+
+    if (auto match = dynamic_cast<const DocumentSourceMatch*>(&stage)) {
+        return !match->isTextQuery() && canMatchOnWorkers(match->getMatchExpression());
+    }
+
+    if (dynamic_cast<const DocumentSourceGroup*>(&stage)) {
+        // The specification is {$group: {_id: <expression>, <field>: {<accumulator>: <input>}}}.
+        vector<Value> serialized;
+        stage.serializeToArray(serialized);
+        const Document spec = serialized.front().getDocument()[stage.getSourceName()].getDocument();
+        for (auto it = spec.fieldIterator(); it.more();) {
+            auto field = it.next();
+            if (field.first == "_id") {
+                continue;
+            }
+            if (!isOrderInsensitiveAccumulator(
+                    field.second.getDocument().fieldIterator().next().first)) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    return false;
+}
+
+DocumentSource::GetNextResult DocumentSourceExchange::getNext() {
+    pExpCtx->checkForInterrupt();
+
+    while (_outputs.empty()) {
+        if (_inputPaused) {
+            _inputPaused = false;
+            return GetNextResult::makePauseExecution();
+        }
+
+        const bool allExhausted =
+            std::all_of(_workers.begin(), _workers.end(), [](const Worker& worker) {
+                return worker.exhausted;
+            });
+        if (allExhausted) {
+            return GetNextResult::makeEOF();
+        }
+
+        runRound();
+    }
+
+    Document next = std::move(_outputs.front());
+    _outputs.pop_front();
+    return std::move(next);
+}
+
+void DocumentSourceExchange::runRound() {
+    pExpCtx->opCtx->checkForInterrupt();
+
+    vector<Document> batch;
+    while (!_inputExhausted && batch.size() < _batchSize * _workers.size()) {
+        auto next = pSource->getNext();
+        if (next.isEOF()) {
+            _inputExhausted = true;
+        } else if (next.isPaused()) {
+            _inputPaused = true;
+            break;
+        } else {
+            batch.push_back(next.releaseDocument());
+        }
+    }
+
+    // Deal each worker a contiguous run of the batch, so that appending the workers' outputs in
+    // turn keeps them in the order of their inputs. Workers with nothing to do sit out the round,
+    // unless the input has just run out and they have yet to return EOF.
+    const size_t perWorker = (batch.size() + _workers.size() - 1) / _workers.size();
+    vector<Worker*> toRun;
+    for (size_t i = 0; i < _workers.size(); ++i) {
+        Worker& worker = _workers[i];
+        const size_t begin = std::min(i * perWorker, batch.size());
+        const size_t end = std::min(begin + perWorker, batch.size());
+        for (size_t j = begin; j < end; ++j) {
+            worker.input->documents.push_back(std::move(batch[j]));
+        }
+        worker.input->inputExhausted = _inputExhausted;
+
+        if (!worker.exhausted && (begin < end || _inputExhausted)) {
+            toRun.push_back(&worker);
+        }
+    }
+
+    stdx::mutex mutex;
+    stdx::condition_variable done;
+    size_t remaining = toRun.size();
+
+    // Set if this operation is killed or times out while the workers run, so that they stop early.
+    AtomicWord<bool> interrupted{false};
+
+    const Date_t deadline = pExpCtx->opCtx->getDeadline();
+    for (Worker* worker : toRun) {
+        auto task = [worker, deadline, &interrupted, &mutex, &done, &remaining] {
+            // The round's state lives on the waiting thread's stack, so it must hear from every
+            // task, however the task ends.
+            ON_BLOCK_EXIT([&] {
+                stdx::lock_guard<stdx::mutex> lk(mutex);
+                if (--remaining == 0) {
+                    done.notify_one();
+                }
+            });
+
+            runWorker(worker, deadline, &interrupted);
+        };
+
+        Status scheduled = QueryWorkerPool::get(pExpCtx->opCtx->getServiceContext()).schedule(task);
+        if (!scheduled.isOK()) {
+            // The pool is shutting down. Fail the exchange once the scheduled workers finish.
+            worker->status = scheduled;
+            stdx::lock_guard<stdx::mutex> lk(mutex);
+            --remaining;
+        }
+    }
+
+    {
+        // The workers can't throw into this thread, so don't leave the round until all of them
+        // have finished, even if this operation is interrupted in the meantime.
+        stdx::unique_lock<stdx::mutex> lk(mutex);
+        while (!done.wait_for(
+            lk, kInterruptCheckPeriod.toSystemDuration(), [&] { return remaining == 0; })) {
+            if (!pExpCtx->opCtx->checkForInterruptNoAssert().isOK()) {
+                interrupted.store(true);
+            }
+        }
+    }
+    pExpCtx->opCtx->checkForInterrupt();
+
+    for (Worker* worker : toRun) {
+        uassertStatusOK(worker->status);
+    }
+    for (auto&& worker : _workers) {
+        std::move(worker.outputs.begin(), worker.outputs.end(), std::back_inserter(_outputs));
+        worker.outputs.clear();
+    }
+}
+
+void DocumentSourceExchange::runWorker(Worker* worker,
+                                       Date_t deadline,
+                                       const AtomicWord<bool>* interrupted) {
+    try {
+        // The worker's OperationContext inherits the operation's maxTimeMS, and is killed along
+        // with the operation, so that stages which check for interrupts on their own stop too.
+        auto opCtx = cc().makeOperationContext();
+        opCtx->setDeadlineByDate(deadline);
+        worker->pipeline->reattachToOperationContext(opCtx.get());
+        ON_BLOCK_EXIT([worker] { worker->pipeline->detachFromOperationContext(); });
+
+        const auto& lastStage = worker->pipeline->getSources().back();
+        while (true) {
+            if (interrupted->load()) {
+                opCtx->markKilled();
+            }
+            opCtx->checkForInterrupt();
+
+            auto next = lastStage->getNext();
+            if (next.isPaused()) {
+                break;
+            }
+            if (next.isEOF()) {
+                worker->exhausted = true;
+                break;
+            }
+            worker->outputs.push_back(next.releaseDocument());
+        }
+    } catch (...) {
+        worker->status = exceptionToStatus();
+    }
+}
+
+DocumentSource::StageConstraints DocumentSourceExchange::constraints(
+    Pipeline::SplitState pipeState) const {
+    const auto& sources = _workers.front().pipeline->getSources();
+    const bool mayUseDisk = std::any_of(sources.begin(), sources.end(), [](const auto& source) {
+        return source->constraints().diskRequirement == DiskUseRequirement::kWritesTmpData;
+    });
+
+    return {StreamType::kStreaming,
+            PositionRequirement::kNone,
+            HostTypeRequirement::kAnyShard,
+            mayUseDisk ? DiskUseRequirement::kWritesTmpData : DiskUseRequirement::kNoDiskUse,
+            FacetRequirement::kNotAllowed};
+}
+
+Value DocumentSourceExchange::serialize(boost::optional<ExplainOptions::Verbosity> explain) const {
+    const auto& pipeline = _workers.front().pipeline;
+    return Value(Document{{kStageName,
+                           Document{{"workers", static_cast<long long>(_workers.size())},
+                                    {"batchSize", static_cast<long long>(_batchSize)},
+                                    {"pipeline",
+                                     explain ? pipeline->writeExplainOps(*explain)
+                                             : pipeline->serialize()}}}});
+}
+
+void DocumentSourceExchange::doDispose() {
+    for (auto&& worker : _workers) {
+        worker.pipeline.get_deleter().dismissDisposal();
+        worker.pipeline->dispose(pExpCtx->opCtx);
+    }
+    _outputs.clear();
+}
+
+}  // namespace mongo
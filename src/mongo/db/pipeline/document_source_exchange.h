@@ -0,0 +1,148 @@
+/**
+ *    Copyright (C) 2017 MongoDB Inc.
+ *
+ *    This program is free software: you can redistribute it and/or  modify
+ *    it under the terms of the GNU Affero General Public License, version 3,
+ *    as published by the Free Software Foundation.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU Affero General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Affero General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the GNU Affero General Public License in all respects for
+ *    all of the code used other than as permitted herein. If you modify file(s)
+ *    with this exception, you may extend this exception to your version of the
+ *    file(s), but you are not obligated to do so. If you do not wish to do so,
+ *    delete this exception statement from your version. If you delete this
+ *    exception statement from all source files in the program, then also delete
+ *    it in the license file.
+ */
+
+#pragma once
+
+#include <boost/intrusive_ptr.hpp>
+#include <boost/optional.hpp>
+#include <deque>
+#include <memory>
+#include <vector>
+
+#include "mongo/base/status.h"
+#include "mongo/bson/bsonobj.h"
+#include "mongo/db/pipeline/document.h"
+#include "mongo/db/pipeline/document_source.h"
+#include "mongo/db/pipeline/pipeline.h"
+#include "mongo/platform/atomic_word.h"
+#include "mongo/util/time_support.h"
+
+namespace mongo {
+
+class ExpressionContext;
+
+/**
+ * Runs a prefix of a pipeline on several worker threads at once. The exchange reads a batch of
+ * documents from the stage before it, deals each worker a contiguous run of the batch, and waits
+ * while the workers push their runs through copies of the prefix of their own. The workers' outputs
+ * are then returned in the order of their inputs, so a prefix of $match, $project, $addFields and
+ * $unwind stages produces the same stream of documents as it would on a single thread.
+ *
+ * A prefix which ends in a $group is run as the shards' part of the pipeline would be: each worker
+ * outputs its partial groups once the input runs out, to be combined by the merging $group which
+ * follows the exchange. The prefix and the stages after the exchange come from splitting the
+ * pipeline with Pipeline::splitForSharded().
+ */
+class DocumentSourceExchange final : public DocumentSource {
+public:
+    static constexpr StringData kStageName = "$_internalExchange"_sd;
+
+    /**
+     * Creates an exchange which runs 'workerPipeline' on 'numWorkers' threads, each of which is
+     * given up to 'batchSize' documents at a time.
+     */
+    static boost::intrusive_ptr<DocumentSourceExchange> create(
+        const boost::intrusive_ptr<ExpressionContext>& expCtx,
+        const std::vector<BSONObj>& workerPipeline,
+        size_t numWorkers,
+        size_t batchSize);
+
+    /**
+     * Returns true if 'stage' can be part of the prefix run by the workers. It must process each
+     * document on its own, or be a $group whose accumulators don't depend on the order of their
+     * inputs, and must not share per-operation state such as a JavaScript scope.
+     */
+    static bool canRunOnWorkers(const DocumentSource& stage);
+
+    ~DocumentSourceExchange();
+
+    GetNextResult getNext() final;
+
+    const char* getSourceName() const final {
+        return kStageName.rawData();
+    }
+
+    StageConstraints constraints(Pipeline::SplitState pipeState) const final;
+
+    Value serialize(boost::optional<ExplainOptions::Verbosity> explain = boost::none) const final;
+
+protected:
+    void doDispose() final;
+
+private:
+    class Input;
+
+    struct Worker {
+        std::unique_ptr<Pipeline, Pipeline::Deleter> pipeline;
+
+        // The first stage of 'pipeline', from which it reads the documents dealt to this worker.
+        boost::intrusive_ptr<Input> input;
+
+        // The documents output by 'pipeline' during the current round.
+        std::vector<Document> outputs;
+
+        // Set once 'pipeline' has returned EOF.
+        bool exhausted = false;
+
+        Status status = Status::OK();
+    };
+
+    DocumentSourceExchange(const boost::intrusive_ptr<ExpressionContext>& expCtx,
+                           const std::vector<BSONObj>& workerPipeline,
+                           size_t numWorkers,
+                           size_t batchSize);
+
+    /**
+     * Reads the next batch of input, runs each worker with a share of it, and queues their outputs
+     * in '_outputs'.
+     */
+    void runRound();
+
+    /**
+     * Pulls from 'worker's pipeline on the calling thread, which must be a worker pool thread,
+     * until the pipeline pauses for more input or is exhausted. Stops with an error once
+     * 'deadline' passes or 'interrupted' is set.
+     */
+    static void runWorker(Worker* worker, Date_t deadline, const AtomicWord<bool>* interrupted);
+
+    const std::vector<BSONObj> _workerPipeline;
+    const size_t _batchSize;
+
+    std::vector<Worker> _workers;
+
+    // The workers' outputs from the last round, in the order of their inputs.
+    std::deque<Document> _outputs;
+
+    // Set once the stage before the exchange has returned EOF.
+    bool _inputExhausted = false;
+
+    // Set if the stage before the exchange paused while a round was being read.
+    bool _inputPaused = false;
+};
+
+}  // namespace mongo
@@ -0,0 +1,201 @@
+/**
+ *    Copyright (C) 2017 MongoDB Inc.
+ *
+ *    This program is free software: you can redistribute it and/or  modify
+ *    it under the terms of the GNU Affero General Public License, version 3,
+ *    as published by the Free Software Foundation.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU Affero General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Affero General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the GNU Affero General Public License in all respects for
+ *    all of the code used other than as permitted herein. If you modify file(s)
+ *    with this exception, you may extend this exception to your version of the
+ *    file(s), but you are not obligated to do so. If you do not wish to do so,
+ *    delete this exception statement from your version. If you delete this
+ *    exception statement from all source files in the program, then also delete
+ *    it in the license file.
+ */
+
+#include "mongo/platform/basic.h"
+
+#include "mongo/db/pipeline/document_source_exchange.h"
+
+#include <deque>
+#include <map>
+#include <vector>
+
+#include "mongo/bson/json.h"
+#include "mongo/db/pipeline/aggregation_context_fixture.h"
+#include "mongo/db/pipeline/document.h"
+#include "mongo/db/pipeline/document_source_mock.h"
+#include "mongo/db/pipeline/document_value_test_util.h"
+#include "mongo/unittest/unittest.h"
+
+namespace mongo {
+namespace {
+
+using std::deque;
+using std::vector;
+
+// This provides access to getExpCtx(), but we'll use a different name for this test suite.
+using DocumentSourceExchangeTest = AggregationContextFixture;
+
+vector<BSONObj> makePipeline(const std::initializer_list<const char*>& stages) {
+    vector<BSONObj> pipeline;
+    for (auto&& stage : stages) {
+        pipeline.push_back(fromjson(stage));
+    }
+    return pipeline;
+}
+
+TEST_F(DocumentSourceExchangeTest, ShouldReturnWorkerResultsInInputOrder) {
+    auto ctx = getExpCtx();
+
+    deque<DocumentSource::GetNextResult> inputs;
+    vector<Document> expected;
+    for (int i = 0; i < 50; ++i) {
+        const int a = (i % 7 == 3) ? -i : i;
+        inputs.emplace_back(Document{{"a", a}});
+        if (a >= 0) {
+            expected.push_back(Document{{"a", a}, {"b", a * 2}});
+        }
+    }
+    auto mock = DocumentSourceMock::create(inputs);
+
+    auto exchange = DocumentSourceExchange::create(
+        ctx,
+        makePipeline({"{$match: {a: {$gte: 0}}}", "{$addFields: {b: {$multiply: ['$a', 2]}}}"}),
+        3,
+        4);
+    exchange->setSource(mock.get());
+
+    for (auto&& doc : expected) {
+        auto next = exchange->getNext();
+        ASSERT_TRUE(next.isAdvanced());
+        ASSERT_DOCUMENT_EQ(next.releaseDocument(), doc);
+    }
+    ASSERT_TRUE(exchange->getNext().isEOF());
+    ASSERT_TRUE(exchange->getNext().isEOF());
+    exchange->dispose();
+}
+
+TEST_F(DocumentSourceExchangeTest, ShouldUnwindInInputOrder) {
+    auto ctx = getExpCtx();
+    auto mock = DocumentSourceMock::create({"{_id: 0, a: [1, 2, 3]}",
+                                            "{_id: 1, a: []}",
+                                            "{_id: 2, a: [4]}",
+                                            "{_id: 3, a: [5, 6]}",
+                                            "{_id: 4, a: [7, 8, 9, 10]}"});
+
+    auto exchange = DocumentSourceExchange::create(ctx, makePipeline({"{$unwind: '$a'}"}), 2, 1);
+    exchange->setSource(mock.get());
+
+    for (int i = 1; i <= 10; ++i) {
+        auto next = exchange->getNext();
+        ASSERT_TRUE(next.isAdvanced());
+        ASSERT_VALUE_EQ(next.releaseDocument()["a"], Value(i));
+    }
+    ASSERT_TRUE(exchange->getNext().isEOF());
+    exchange->dispose();
+}
+
+TEST_F(DocumentSourceExchangeTest, ShouldOutputPartialGroupsWhichMergeToTheSameResult) {
+    auto ctx = getExpCtx();
+
+    deque<DocumentSource::GetNextResult> inputs;
+    std::map<int, int> expectedTotals;
+    for (int i = 0; i < 100; ++i) {
+        inputs.emplace_back(Document{{"k", i % 5}, {"a", i}});
+        expectedTotals[i % 5] += i;
+    }
+    auto mock = DocumentSourceMock::create(inputs);
+
+    auto exchange = DocumentSourceExchange::create(
+        ctx, makePipeline({"{$group: {_id: '$k', total: {$sum: '$a'}}}"}), 4, 3);
+    exchange->setSource(mock.get());
+
+    // Each worker outputs a partial group for every key it saw. Summing them should give the same
+    // totals as grouping on a single thread.
+    std::map<int, int> totals;
+    size_t numPartialGroups = 0;
+    for (auto next = exchange->getNext(); next.isAdvanced(); next = exchange->getNext()) {
+        auto doc = next.releaseDocument();
+        totals[doc["_id"].getInt()] += doc["total"].getInt();
+        ++numPartialGroups;
+    }
+    ASSERT_GT(numPartialGroups, expectedTotals.size());
+    ASSERT_TRUE(totals == expectedTotals);
+    exchange->dispose();
+}
+
+TEST_F(DocumentSourceExchangeTest, ShouldPropagatePausesAfterPrecedingResults) {
+    auto ctx = getExpCtx();
+    auto mock = DocumentSourceMock::create({Document{{"a", 1}},
+                                            Document{{"a", 2}},
+                                            DocumentSource::GetNextResult::makePauseExecution(),
+                                            Document{{"a", 3}}});
+
+    auto exchange = DocumentSourceExchange::create(
+        ctx, makePipeline({"{$project: {_id: 0, a: 1}}"}), 2, 10);
+    exchange->setSource(mock.get());
+
+    auto next = exchange->getNext();
+    ASSERT_TRUE(next.isAdvanced());
+    ASSERT_DOCUMENT_EQ(next.releaseDocument(), (Document{{"a", 1}}));
+    next = exchange->getNext();
+    ASSERT_TRUE(next.isAdvanced());
+    ASSERT_DOCUMENT_EQ(next.releaseDocument(), (Document{{"a", 2}}));
+    ASSERT_TRUE(exchange->getNext().isPaused());
+    next = exchange->getNext();
+    ASSERT_TRUE(next.isAdvanced());
+    ASSERT_DOCUMENT_EQ(next.releaseDocument(), (Document{{"a", 3}}));
+    ASSERT_TRUE(exchange->getNext().isEOF());
+    exchange->dispose();
+}
+
+TEST_F(DocumentSourceExchangeTest, ShouldThrowErrorsFromWorkers) {
+    auto ctx = getExpCtx();
+    auto mock = DocumentSourceMock::create({"{a: 1}", "{a: 2}", "{a: 0}", "{a: 4}"});
+
+    auto exchange = DocumentSourceExchange::create(
+        ctx, makePipeline({"{$addFields: {b: {$divide: [1, '$a']}}}"}), 2, 2);
+    exchange->setSource(mock.get());
+
+    ASSERT_THROWS_CODE(exchange->getNext(), AssertionException, 16608);
+    exchange->dispose();
+}
+
+TEST_F(DocumentSourceExchangeTest, ShouldOnlyRunOrderInsensitiveStagesOnWorkers) {
+    auto ctx = getExpCtx();
+    auto canRunOnWorkers = [&](const char* spec) {
+        auto stages = DocumentSource::parse(ctx, fromjson(spec));
+        ASSERT_EQ(stages.size(), 1U);
+        return DocumentSourceExchange::canRunOnWorkers(*stages.front());
+    };
+
+    ASSERT_TRUE(canRunOnWorkers("{$match: {a: {$gt: 1}, $expr: {$lt: ['$a', '$b']}}}"));
+    ASSERT_TRUE(canRunOnWorkers("{$project: {a: 1, b: {$add: ['$a', 1]}}}"));
+    ASSERT_TRUE(canRunOnWorkers("{$addFields: {b: '$a'}}"));
+    ASSERT_TRUE(canRunOnWorkers("{$unwind: '$a'}"));
+    ASSERT_TRUE(canRunOnWorkers(
+        "{$group: {_id: '$k', s: {$sum: '$a'}, m: {$max: '$a'}, v: {$stdDevPop: '$a'}}}"));
+
+    ASSERT_FALSE(canRunOnWorkers("{$group: {_id: '$k', f: {$first: '$a'}}}"));
+    ASSERT_FALSE(canRunOnWorkers("{$group: {_id: '$k', s: {$sum: '$a'}, p: {$push: '$a'}}}"));
+    ASSERT_FALSE(canRunOnWorkers("{$sort: {a: 1}}"));
+    ASSERT_FALSE(canRunOnWorkers("{$limit: 10}"));
+    ASSERT_FALSE(canRunOnWorkers("{$skip: 10}"));
+}
+
+}  // namespace
+}  // namespace mongo
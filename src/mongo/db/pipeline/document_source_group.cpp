@@ -28,6 +28,9 @@
 
 #include "mongo/platform/basic.h"
 
+#include <algorithm>
+#include <numeric>
+
 #include "mongo/db/jsobj.h"
 #include "mongo/db/pipeline/accumulation_statement.h"
 #include "mongo/db/pipeline/accumulator.h"
@@ -38,7 +41,9 @@
 #include "mongo/db/pipeline/lite_parsed_document_source.h"
 #include "mongo/db/pipeline/value.h"
 #include "mongo/db/pipeline/value_comparator.h"
+#include "mongo/db/query/query_knobs.h"
 #include "mongo/stdx/memory.h"
+#include "mongo/stdx/unordered_map.h"
 
 namespace mongo {
 
@@ -72,6 +77,8 @@ DocumentSource::GetNextResult DocumentSourceGroup::getNext() {
 
     if (_spilled) {
         return getNextSpilled();
+    } else if (_partitioned) {
+        return getNextPartitioned();
     } else if (_streaming) {
         return getNextStreaming();
     } else {
@@ -85,22 +92,10 @@ DocumentSource::GetNextResult DocumentSourceGroup::getNextSpilled() {
         return GetNextResult::makeEOF();
 
     _currentId = _firstPartOfNextGroup.first;
-    const size_t numAccumulators = _accumulatedFields.size();
     while (pExpCtx->getValueComparator().evaluate(_currentId == _firstPartOfNextGroup.first)) {
         // Inside of this loop, _firstPartOfNextGroup is the current data being processed.
         // At loop exit, it is the first value to be processed in the next group.
-        switch (numAccumulators) {  // mirrors switch in spill()
-            case 1:                 // Single accumulators serialize as a single Value.
-                _currentAccumulators[0]->process(_firstPartOfNextGroup.second, true);
-            case 0:  // No accumulators so no Values.
-                break;
-            default: {  // Multiple accumulators serialize as an array of Values.
-                const vector<Value>& accumulatorStates = _firstPartOfNextGroup.second.getArray();
-                for (size_t i = 0; i < numAccumulators; i++) {
-                    _currentAccumulators[i]->process(accumulatorStates[i], true);
-                }
-            }
-        }
+        mergeSpilledState(_firstPartOfNextGroup.second, &_currentAccumulators);
 
         if (!_sorterIterator->more()) {
             dispose();
@@ -126,6 +121,22 @@ DocumentSource::GetNextResult DocumentSourceGroup::getNextStandard() {
     return std::move(out);
 }
 
+DocumentSource::GetNextResult DocumentSourceGroup::getNextPartitioned() {
+    // Spilled to hash partitions, which we aggregate one at a time.
+    if (groupsIterator == _groups->end()) {
+        if (!loadNextPartition()) {
+            dispose();
+            return GetNextResult::makeEOF();
+        }
+        groupsIterator = _groups->begin();
+    }
+
+    Document out = makeDocument(groupsIterator->first, groupsIterator->second, pExpCtx->needsMerge);
+    ++groupsIterator;
+
+    return std::move(out);
+}
+
 DocumentSource::GetNextResult DocumentSourceGroup::getNextStreaming() {
     // Streaming optimization is active.
     if (!_firstDocOfNextGroup) {
@@ -168,6 +179,8 @@ void DocumentSourceGroup::doDispose() {
     // Free our resources.
     _groups = pExpCtx->getValueComparator().makeUnorderedValueMap<Accumulators>();
     _sorterIterator.reset();
+    _partitionWriters.clear();
+    _partitions.clear();
 
     // Make us look done.
     groupsIterator = _groups->end();
@@ -478,16 +491,35 @@ DocumentSource::GetNextResult DocumentSourceGroup::initialize() {
     }
 
 
+    // Accumulator inputs may be gathered from a batch of documents before being processed, which
+    // only pays off if some accumulator can process a run of inputs faster than one at a time.
+    const int batchSizeKnob = internalDocumentSourceGroupBatchSize.load();
+    const bool anyFastBatchProcessing =
+        std::any_of(_accumulatedFields.begin(),
+                    _accumulatedFields.end(),
+                    [this](const AccumulationStatement& accumulatedField) {
+                        return accumulatedField.makeAccumulator(pExpCtx)->hasFastBatchProcessing();
+                    });
+    const size_t batchSize = batchSizeKnob > 1 && anyFastBatchProcessing ? batchSizeKnob : 1;
+    _batchInputs.resize(numAccumulators);
+
     // Barring any pausing, this loop exhausts 'pSource' and populates '_groups'.
     GetNextResult input = pSource->getNext();
     for (; input.isAdvanced(); input = pSource->getNext()) {
         if (_memoryUsageBytes > _maxMemoryUsageBytes) {
+            // The batch refers to groups which are about to be spilled.
+            processBatch();
             uassert(16945,
                     "Exceeded memory limit for $group, but didn't allow external sort."
                     " Pass allowDiskUse:true to opt in.",
                     _allowDiskUse);
-            _sortedFiles.push_back(spill());
-            _memoryUsageBytes = 0;
+            if (!_partitionWriters.empty() ||
+                (_sortedFiles.empty() && internalDocumentSourceGroupHashPartitions.load() > 1)) {
+                spillToPartitions(0);
+            } else {
+                _sortedFiles.push_back(spill());
+                _memoryUsageBytes = 0;
+            }
         }
 
         // We release the result document here so that it does not outlive the end of this loop
@@ -510,7 +542,24 @@ DocumentSource::GetNextResult DocumentSourceGroup::initialize() {
             for (auto&& accumulatedField : _accumulatedFields) {
                 group.push_back(accumulatedField.makeAccumulator(pExpCtx));
             }
-        } else {
+        }
+
+        if (batchSize > 1) {
+            if (inserted) {
+                // processBatch() replaces the memory usage of every group in the batch.
+                for (auto&& groupObj : group) {
+                    _memoryUsageBytes += groupObj->memUsageForSorter();
+                }
+            }
+            addToBatch(&group, rootDocument);
+            _batchHasDuplicate = _batchHasDuplicate || !inserted;
+            if (_batchGroups.size() >= batchSize || _memoryUsageBytes > _maxMemoryUsageBytes) {
+                processBatch();
+            }
+            continue;
+        }
+
+        if (!inserted) {
             for (auto&& groupObj : group) {
                 // subtract old mem usage. New usage added back after processing.
                 _memoryUsageBytes -= groupObj->memUsageForSorter();
@@ -539,6 +588,10 @@ DocumentSource::GetNextResult DocumentSourceGroup::initialize() {
         }
     }
 
+    // Whether we are pausing or have reached the end of the input, the batch must be processed
+    // before the groups are next looked at.
+    processBatch();
+
     switch (input.getStatus()) {
         case DocumentSource::GetNextResult::ReturnStatus::kAdvanced: {
             MONGO_UNREACHABLE;  // We consumed all advances above.
@@ -548,7 +601,14 @@ DocumentSource::GetNextResult DocumentSourceGroup::initialize() {
         }
         case DocumentSource::GetNextResult::ReturnStatus::kEOF: {
             // Do any final steps necessary to prepare to output results.
-            if (!_sortedFiles.empty()) {
+            if (!_partitionWriters.empty()) {
+                _partitioned = true;
+                spillToPartitions(0);
+                finishPartitions();
+
+                // The partitions will be loaded into the groups map one at a time.
+                groupsIterator = _groups->end();
+            } else if (!_sortedFiles.empty()) {
                 _spilled = true;
                 if (!_groups->empty()) {
                     _sortedFiles.push_back(spill());
@@ -582,6 +642,89 @@ DocumentSource::GetNextResult DocumentSourceGroup::initialize() {
     MONGO_UNREACHABLE;
 }
 
+void DocumentSourceGroup::addToBatch(Accumulators* group, const Document& rootDocument) {
+    _batchGroups.push_back(group);
+    for (size_t i = 0; i < _accumulatedFields.size(); i++) {
+        Value input = _accumulatedFields[i].expression->evaluate(rootDocument);
+
+        // The queued inputs count towards the memory limit until the accumulators take them over.
+        const size_t inputBytes = input.getApproximateSize();
+        _batchInputsBytes += inputBytes;
+        _memoryUsageBytes += inputBytes;
+        _batchInputs[i].push_back(std::move(input));
+    }
+}
+
+void DocumentSourceGroup::processBatch() {
+    const size_t numDocs = _batchGroups.size();
+    if (numDocs == 0) {
+        return;
+    }
+
+    // Order the documents of the batch by group, keeping each group's documents in the order they
+    // arrived in, so that the inputs for a group form a single run within each column.
+    stdx::unordered_map<Accumulators*, size_t> groupIndexes;
+    vector<Accumulators*> groups;
+    vector<size_t> docGroupIndexes(numDocs);
+    for (size_t doc = 0; doc < numDocs; ++doc) {
+        auto insertion = groupIndexes.emplace(_batchGroups[doc], groups.size());
+        if (insertion.second) {
+            groups.push_back(_batchGroups[doc]);
+        }
+        docGroupIndexes[doc] = insertion.first->second;
+    }
+
+    vector<size_t> groupStarts(groups.size() + 1, 0);
+    for (auto groupIndex : docGroupIndexes) {
+        ++groupStarts[groupIndex + 1];
+    }
+    std::partial_sum(groupStarts.begin(), groupStarts.end(), groupStarts.begin());
+
+    vector<size_t> docsInGroupOrder(numDocs);
+    vector<size_t> nextPositions(groupStarts.begin(), groupStarts.end() - 1);
+    for (size_t doc = 0; doc < numDocs; ++doc) {
+        docsInGroupOrder[nextPositions[docGroupIndexes[doc]]++] = doc;
+    }
+
+    for (auto group : groups) {
+        for (auto&& groupObj : *group) {
+            _memoryUsageBytes -= groupObj->memUsageForSorter();
+        }
+    }
+    _memoryUsageBytes -= _batchInputsBytes;
+    _batchInputsBytes = 0;
+
+    vector<Value> column(numDocs);
+    for (size_t i = 0; i < _accumulatedFields.size(); i++) {
+        for (size_t pos = 0; pos < numDocs; ++pos) {
+            column[pos] = std::move(_batchInputs[i][docsInGroupOrder[pos]]);
+        }
+        _batchInputs[i].clear();
+
+        for (size_t groupIndex = 0; groupIndex < groups.size(); ++groupIndex) {
+            const size_t start = groupStarts[groupIndex];
+            (*groups[groupIndex])[i]->processBatch(
+                column.data() + start, groupStarts[groupIndex + 1] - start, _doingMerge);
+        }
+    }
+
+    for (auto group : groups) {
+        for (auto&& groupObj : *group) {
+            _memoryUsageBytes += groupObj->memUsageForSorter();
+        }
+    }
+    _batchGroups.clear();
+
+    if (kDebugBuild && !storageGlobalParams.readOnly) {
+        // As in the unbatched case, spill after finding a duplicate id, to stress merge logic.
+        if (_batchHasDuplicate && !pExpCtx->inMongos && !_allowDiskUse &&
+            _sortedFiles.size() < 20) {
+            _sortedFiles.push_back(spill());
+        }
+    }
+    _batchHasDuplicate = false;
+}
+
 shared_ptr<Sorter<Value, Value>::Iterator> DocumentSourceGroup::spill() {
     vector<const GroupsMap::value_type*> ptrs;  // using pointers to speed sorting
     ptrs.reserve(_groups->size());
@@ -622,6 +765,147 @@ shared_ptr<Sorter<Value, Value>::Iterator> DocumentSourceGroup::spill() {
     return shared_ptr<Sorter<Value, Value>::Iterator>(writer.done());
 }
 
+namespace {
+
+/**
+ * Mixes the hash of a group's _id with 'level', so that the partitions of each level split the
+ * _id values of their parent on different bits of the hash.
+ */
+size_t partitionOf(size_t idHash, unsigned level, size_t numPartitions) {
+    uint64_t hash = static_cast<uint64_t>(idHash) + (level + 1) * 0x9E3779B97F4A7C15ULL;
+    hash = (hash ^ (hash >> 30)) * 0xBF58476D1CE4E5B9ULL;
+    hash = (hash ^ (hash >> 27)) * 0x94D049BB133111EBULL;
+    hash ^= hash >> 31;
+    return hash % numPartitions;
+}
+
+}  // namespace
+
+void DocumentSourceGroup::spillToPartitions(unsigned level) {
+    if (_partitionWriters.empty()) {
+        const auto numPartitions = internalDocumentSourceGroupHashPartitions.load();
+        invariant(numPartitions > 1);
+        _partitionWriters.resize(numPartitions);
+        _partitionWritersLevel = level;
+    }
+    invariant(_partitionWritersLevel == level);
+
+    const auto& comparator = pExpCtx->getValueComparator();
+    for (auto&& group : *_groups) {
+        auto& writer = _partitionWriters[partitionOf(
+            comparator.hash(group.first), level, _partitionWriters.size())];
+        // A writer which gets no groups would leave an empty file, which can't be read back, so
+        // each one is only opened once a group hashes to its partition.
+        if (!writer) {
+            writer = stdx::make_unique<SortedFileWriter<Value, Value>>(
+                SortOptions().TempDir(pExpCtx->tempDir));
+        }
+        writer->addAlreadySorted(group.first, getSpilledState(group.second));
+    }
+
+    _groups->clear();
+    _memoryUsageBytes = 0;
+}
+
+void DocumentSourceGroup::finishPartitions() {
+    // The files are not sorted, but a SortedFileWriter reads them back in the order written.
+    for (auto&& writer : _partitionWriters) {
+        if (!writer) {
+            continue;
+        }
+        _partitions.push_front(SpilledPartition{
+            shared_ptr<Sorter<Value, Value>::Iterator>(writer->done()), _partitionWritersLevel});
+    }
+    _partitionWriters.clear();
+}
+
+bool DocumentSourceGroup::loadNextPartition() {
+    const size_t numAccumulators = _accumulatedFields.size();
+
+    while (!_partitions.empty()) {
+        auto partition = std::move(_partitions.front());
+        _partitions.pop_front();
+
+        _groups->clear();
+        _memoryUsageBytes = 0;
+
+        while (partition.iterator->more()) {
+            if (_memoryUsageBytes > _maxMemoryUsageBytes &&
+                partition.level + 1 < kMaxPartitionLevels) {
+                spillToPartitions(partition.level + 1);
+            }
+
+            auto spilledGroup = partition.iterator->next();
+
+            const size_t oldSize = _groups->size();
+            Accumulators& group = (*_groups)[spilledGroup.first];
+            if (_groups->size() != oldSize) {
+                _memoryUsageBytes += spilledGroup.first.getApproximateSize();
+                group.reserve(numAccumulators);
+                for (auto&& accumulatedField : _accumulatedFields) {
+                    group.push_back(accumulatedField.makeAccumulator(pExpCtx));
+                }
+            } else {
+                for (auto&& groupObj : group) {
+                    _memoryUsageBytes -= groupObj->memUsageForSorter();
+                }
+            }
+
+            mergeSpilledState(spilledGroup.second, &group);
+            for (auto&& groupObj : group) {
+                _memoryUsageBytes += groupObj->memUsageForSorter();
+            }
+        }
+
+        if (!_partitionWriters.empty()) {
+            // The partition did not fit in memory, so it has been split into smaller ones.
+            spillToPartitions(partition.level + 1);
+            finishPartitions();
+            continue;
+        }
+
+        if (!_groups->empty()) {
+            return true;
+        }
+    }
+
+    return false;
+}
+
+Value DocumentSourceGroup::getSpilledState(const Accumulators& accums) const {
+    switch (accums.size()) {  // mirrors switch in spill()
+        case 0:               // No accumulators so no Values.
+            return Value();
+        case 1:  // Single accumulators serialize as a single Value.
+            return accums[0]->getValue(/*toBeMerged=*/true);
+        default: {  // Multiple accumulators serialize as an array of Values.
+            vector<Value> accumulatorStates;
+            accumulatorStates.reserve(accums.size());
+            for (auto&& accum : accums) {
+                accumulatorStates.push_back(accum->getValue(/*toBeMerged=*/true));
+            }
+            return Value(std::move(accumulatorStates));
+        }
+    }
+}
+
+void DocumentSourceGroup::mergeSpilledState(const Value& spilledState,
+                                            Accumulators* accums) const {
+    const size_t numAccumulators = _accumulatedFields.size();
+    switch (numAccumulators) {  // mirrors switch in spill()
+        case 1:                 // Single accumulators serialize as a single Value.
+            (*accums)[0]->process(spilledState, true);
+        case 0:  // No accumulators so no Values.
+            break;
+        default: {  // Multiple accumulators serialize as an array of Values.
+            const vector<Value>& accumulatorStates = spilledState.getArray();
+            for (size_t i = 0; i < numAccumulators; i++) {
+                (*accums)[i]->process(accumulatorStates[i], true);
+            }
+        }
+    }
+}
+
 boost::optional<BSONObj> DocumentSourceGroup::findRelevantInputSort() const {
     if (true) {
         // Until streaming $group correctly handles nullish values, the streaming behavior is
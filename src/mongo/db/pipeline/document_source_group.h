@@ -28,6 +28,7 @@
 
 #pragma once
 
+#include <deque>
 #include <memory>
 #include <utility>
 
@@ -45,6 +46,10 @@ public:
 
     static const size_t kDefaultMaxMemoryUsageBytes = 100 * 1024 * 1024;
 
+    // How many times may a spilled partition which does not fit in memory be split again? The
+    // partitions of the last level are aggregated in memory whatever their size.
+    static const unsigned kMaxPartitionLevels = 4;
+
     // Virtuals from DocumentSource.
     boost::intrusive_ptr<DocumentSource> optimize() final;
     GetDepsReturn getDependencies(DepsTracker* deps) const final;
@@ -94,6 +99,22 @@ public:
         _doingMerge = doingMerge;
     }
 
+    /**
+     * Returns how much memory the groups may use before they are spilled to disk, or the stage
+     * fails if it can't use the disk.
+     */
+    size_t getMaxMemoryUsageBytes() const {
+        return _maxMemoryUsageBytes;
+    }
+
+    /**
+     * Changes the limit returned by getMaxMemoryUsageBytes(). Must be called before the first call
+     * to getNext().
+     */
+    void setMaxMemoryUsageBytes(size_t maxMemoryUsageBytes) {
+        _maxMemoryUsageBytes = maxMemoryUsageBytes;
+    }
+
     bool isStreaming() const {
         return _streaming;
     }
@@ -117,6 +138,7 @@ private:
     GetNextResult getNextStreaming();
     GetNextResult getNextSpilled();
     GetNextResult getNextStandard();
+    GetNextResult getNextPartitioned();
 
     /**
      * Attempt to identify an input sort order that allows us to turn into a streaming $group. If we
@@ -136,6 +158,18 @@ private:
      */
     GetNextResult initialize();
 
+    /**
+     * Evaluates the accumulator inputs for 'rootDocument', and queues them to be processed by the
+     * accumulators of 'group' along with the rest of the current batch.
+     */
+    void addToBatch(Accumulators* group, const Document& rootDocument);
+
+    /**
+     * Processes the inputs queued by addToBatch(). Each accumulator is handed all of the inputs for
+     * its group at once, in the order of the documents they came from.
+     */
+    void processBatch();
+
     /**
      * Spill groups map to disk and returns an iterator to the file. Note: Since a sorted $group
      * does not exhaust the previous stage before returning, and thus does not maintain as large a
@@ -143,6 +177,37 @@ private:
      */
     std::shared_ptr<Sorter<Value, Value>::Iterator> spill();
 
+    /**
+     * The alternative to spill(), used once memory runs out when we have been configured with more
+     * than one hash partition. Appends the partial state of every group to the file of the
+     * partition at 'level' its _id hashes to, then clears the groups map. Between calls, the
+     * groups map serves as a cache in which the most frequent _id values are pre-aggregated, so
+     * they reach the files far fewer times than there are input documents for them.
+     */
+    void spillToPartitions(unsigned level);
+
+    /**
+     * Finishes writing the files opened by spillToPartitions(), queueing them to be aggregated.
+     */
+    void finishPartitions();
+
+    /**
+     * Aggregates the next queued partition into the groups map. A partition which does not fit in
+     * memory is split into partitions of the next level, which are queued in its place. Returns
+     * false if no partitions remain.
+     */
+    bool loadNextPartition();
+
+    /**
+     * Returns the partial state of 'accums', as written to disk when spilling.
+     */
+    Value getSpilledState(const Accumulators& accums) const;
+
+    /**
+     * Merges 'spilledState', as returned by getSpilledState(), into 'accums'.
+     */
+    void mergeSpilledState(const Value& spilledState, Accumulators* accums) const;
+
     Document makeDocument(const Value& id, const Accumulators& accums, bool mergeableOutput);
 
     /**
@@ -182,8 +247,31 @@ private:
     // Only used when '_spilled' is false.
     GroupsMap::iterator groupsIterator;
 
+    // The group of each document in the current batch, and the inputs for its accumulators, one
+    // column per accumulator. Only used when the internalDocumentSourceGroupBatchSize knob is
+    // greater than one and some accumulator has fast batch processing. The approximate size of the
+    // queued inputs is included in '_memoryUsageBytes'.
+    std::vector<Accumulators*> _batchGroups;
+    std::vector<std::vector<Value>> _batchInputs;
+    size_t _batchInputsBytes = 0;
+    bool _batchHasDuplicate = false;
+
     // Only used when '_spilled' is true.
     std::unique_ptr<Sorter<Value, Value>::Iterator> _sorterIterator;
+
+    // Used in place of '_sortedFiles' once memory runs out if the
+    // internalDocumentSourceGroupHashPartitions knob is greater than one. Groups are then written
+    // to files by the hash of their _id, rather than in sorted runs, so that each partition can be
+    // aggregated independently of the others without a merge.
+    struct SpilledPartition {
+        std::shared_ptr<Sorter<Value, Value>::Iterator> iterator;
+        unsigned level;
+    };
+    // One entry per partition of '_partitionWritersLevel', null until a group is spilled to it.
+    std::vector<std::unique_ptr<SortedFileWriter<Value, Value>>> _partitionWriters;
+    unsigned _partitionWritersLevel = 0;
+    std::deque<SpilledPartition> _partitions;
+    bool _partitioned = false;
     const bool _allowDiskUse;
 
     std::pair<Value, Value> _firstPartOfNextGroup;
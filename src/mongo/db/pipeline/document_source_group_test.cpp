@@ -47,12 +47,14 @@
 #include "mongo/db/pipeline/expression.h"
 #include "mongo/db/pipeline/expression_context_for_test.h"
 #include "mongo/db/pipeline/value_comparator.h"
+#include "mongo/db/query/query_knobs.h"
 #include "mongo/db/query/query_test_service_context.h"
 #include "mongo/dbtests/dbtests.h"
 #include "mongo/stdx/memory.h"
 #include "mongo/stdx/unordered_set.h"
 #include "mongo/unittest/temp_dir.h"
 #include "mongo/unittest/unittest.h"
+#include "mongo/util/scopeguard.h"
 
 namespace mongo {
 
@@ -189,6 +191,202 @@ TEST_F(DocumentSourceGroupTest, ShouldCorrectlyTrackMemoryUsageBetweenPauses) {
     ASSERT_THROWS_CODE(group->getNext(), AssertionException, 16945);
 }
 
+/**
+ * Groups 'numDocs' documents by their _id modulo 'numGroups', counting each group, with a memory
+ * limit low enough that the $group must spill. Checks every group has the right count.
+ */
+void assertSpilledGroupCounts(const intrusive_ptr<ExpressionContextForTest>& expCtx,
+                              int numDocs,
+                              int numGroups) {
+    TempDir tempDir("DocumentSourceGroupTest");
+    expCtx->tempDir = tempDir.path();
+    expCtx->allowDiskUse = true;
+    const size_t maxMemoryUsageBytes = 1000;
+
+    VariablesParseState vps = expCtx->variablesParseState;
+    AccumulationStatement countStatement{"count",
+                                         ExpressionConstant::create(expCtx, Value(1)),
+                                         AccumulationStatement::getFactory("$sum")};
+    auto groupByExpression = ExpressionFieldPath::parse(expCtx, "$key", vps);
+    auto group = DocumentSourceGroup::create(
+        expCtx, groupByExpression, {countStatement}, maxMemoryUsageBytes);
+
+    deque<DocumentSource::GetNextResult> inputs;
+    for (int i = 0; i < numDocs; i++) {
+        inputs.emplace_back(Document{{"_id", i}, {"key", i % numGroups}});
+    }
+    auto mock = DocumentSourceMock::create(inputs);
+    group->setSource(mock.get());
+
+    map<int, int> counts;
+    for (auto result = group->getNext(); result.isAdvanced(); result = group->getNext()) {
+        auto doc = result.releaseDocument();
+        ASSERT_EQ(counts.count(doc["_id"].coerceToInt()), 0U);
+        counts[doc["_id"].coerceToInt()] = doc["count"].coerceToInt();
+    }
+    ASSERT_TRUE(group->getNext().isEOF());
+
+    ASSERT_EQ(counts.size(), static_cast<size_t>(numGroups));
+    for (auto&& count : counts) {
+        ASSERT_EQ(count.second, numDocs / numGroups);
+    }
+}
+
+TEST_F(DocumentSourceGroupTest, ShouldAggregateEachHashPartitionWhenSpilled) {
+    assertSpilledGroupCounts(getExpCtx(), 1000, 50);
+}
+
+TEST_F(DocumentSourceGroupTest, ShouldSplitHashPartitionsWhichDoNotFitInMemory) {
+    // With only two partitions, each holds far more groups than fit in memory.
+    const auto oldNumPartitions = internalDocumentSourceGroupHashPartitions.load();
+    ON_BLOCK_EXIT([oldNumPartitions] {
+        internalDocumentSourceGroupHashPartitions.store(oldNumPartitions);
+    });
+    internalDocumentSourceGroupHashPartitions.store(2);
+
+    assertSpilledGroupCounts(getExpCtx(), 2000, 200);
+}
+
+TEST_F(DocumentSourceGroupTest, ShouldSkipEmptyHashPartitionsWhenSpilled) {
+    // Fewer groups than partitions leaves most partitions empty at every level, and each group is
+    // too large to fit in memory, so its partition is split again until the last level.
+    const auto oldNumPartitions = internalDocumentSourceGroupHashPartitions.load();
+    ON_BLOCK_EXIT([oldNumPartitions] {
+        internalDocumentSourceGroupHashPartitions.store(oldNumPartitions);
+    });
+    internalDocumentSourceGroupHashPartitions.store(16);
+
+    auto expCtx = getExpCtx();
+    TempDir tempDir("DocumentSourceGroupTest");
+    expCtx->tempDir = tempDir.path();
+    expCtx->allowDiskUse = true;
+    const size_t maxMemoryUsageBytes = 1000;
+    const int numGroups = 3;
+    const int numDocs = 30;
+
+    VariablesParseState vps = expCtx->variablesParseState;
+    AccumulationStatement pushStatement{"spaceHog",
+                                        ExpressionFieldPath::parse(expCtx, "$largeStr", vps),
+                                        AccumulationStatement::getFactory("$push")};
+    auto groupByExpression = ExpressionFieldPath::parse(expCtx, "$key", vps);
+    auto group = DocumentSourceGroup::create(
+        expCtx, groupByExpression, {pushStatement}, maxMemoryUsageBytes);
+
+    string largeStr(maxMemoryUsageBytes / 5, 'x');
+    deque<DocumentSource::GetNextResult> inputs;
+    for (int i = 0; i < numDocs; i++) {
+        inputs.emplace_back(Document{{"key", i % numGroups}, {"largeStr", largeStr}});
+    }
+    auto mock = DocumentSourceMock::create(inputs);
+    group->setSource(mock.get());
+
+    map<int, size_t> counts;
+    for (auto result = group->getNext(); result.isAdvanced(); result = group->getNext()) {
+        auto doc = result.releaseDocument();
+        ASSERT_EQ(counts.count(doc["_id"].coerceToInt()), 0U);
+        counts[doc["_id"].coerceToInt()] = doc["spaceHog"].getArrayLength();
+    }
+    ASSERT_TRUE(group->getNext().isEOF());
+
+    ASSERT_EQ(counts.size(), static_cast<size_t>(numGroups));
+    for (auto&& count : counts) {
+        ASSERT_EQ(count.second, static_cast<size_t>(numDocs / numGroups));
+    }
+}
+
+TEST_F(DocumentSourceGroupTest, ShouldMergeSortedRunsWhenHashPartitioningIsDisabled) {
+    const auto oldNumPartitions = internalDocumentSourceGroupHashPartitions.load();
+    ON_BLOCK_EXIT([oldNumPartitions] {
+        internalDocumentSourceGroupHashPartitions.store(oldNumPartitions);
+    });
+    internalDocumentSourceGroupHashPartitions.store(0);
+
+    assertSpilledGroupCounts(getExpCtx(), 1000, 50);
+}
+
+TEST_F(DocumentSourceGroupTest, ShouldProcessBatchedInputsInDocumentOrder) {
+    const auto oldBatchSize = internalDocumentSourceGroupBatchSize.load();
+    ON_BLOCK_EXIT([oldBatchSize] { internalDocumentSourceGroupBatchSize.store(oldBatchSize); });
+    internalDocumentSourceGroupBatchSize.store(4);
+
+    auto expCtx = getExpCtx();
+    VariablesParseState vps = expCtx->variablesParseState;
+    AccumulationStatement pushStatement{"ids",
+                                        ExpressionFieldPath::parse(expCtx, "$_id", vps),
+                                        AccumulationStatement::getFactory("$push")};
+    AccumulationStatement sumStatement{"total",
+                                       ExpressionFieldPath::parse(expCtx, "$_id", vps),
+                                       AccumulationStatement::getFactory("$sum")};
+    auto groupByExpression = ExpressionFieldPath::parse(expCtx, "$key", vps);
+    auto group =
+        DocumentSourceGroup::create(expCtx, groupByExpression, {pushStatement, sumStatement});
+
+    // A pause partway through a batch must not lose the documents already in it.
+    deque<DocumentSource::GetNextResult> inputs;
+    for (int i = 0; i < 10; i++) {
+        if (i == 6) {
+            inputs.push_back(DocumentSource::GetNextResult::makePauseExecution());
+        }
+        inputs.emplace_back(Document{{"_id", i}, {"key", i % 3}});
+    }
+    auto mock = DocumentSourceMock::create(inputs);
+    group->setSource(mock.get());
+
+    ASSERT_TRUE(group->getNext().isPaused());
+    map<int, Document> results;
+    for (auto result = group->getNext(); result.isAdvanced(); result = group->getNext()) {
+        auto doc = result.releaseDocument();
+        results[doc["_id"].coerceToInt()] = doc;
+    }
+
+    ASSERT_EQ(results.size(), 3U);
+    ASSERT_DOCUMENT_EQ(results[0],
+                       (Document{{"_id", 0},
+                                 {"ids", vector<Value>{Value(0), Value(3), Value(6), Value(9)}},
+                                 {"total", 18}}));
+    ASSERT_DOCUMENT_EQ(results[1],
+                       (Document{{"_id", 1},
+                                 {"ids", vector<Value>{Value(1), Value(4), Value(7)}},
+                                 {"total", 12}}));
+    ASSERT_DOCUMENT_EQ(results[2],
+                       (Document{{"_id", 2},
+                                 {"ids", vector<Value>{Value(2), Value(5), Value(8)}},
+                                 {"total", 15}}));
+}
+
+TEST_F(DocumentSourceGroupTest, ShouldCountBatchedInputsTowardsMemoryLimit) {
+    const auto oldBatchSize = internalDocumentSourceGroupBatchSize.load();
+    ON_BLOCK_EXIT([oldBatchSize] { internalDocumentSourceGroupBatchSize.store(oldBatchSize); });
+    internalDocumentSourceGroupBatchSize.store(100);
+
+    auto expCtx = getExpCtx();
+    const size_t maxMemoryUsageBytes = 1000;
+    expCtx->inMongos = true;  // Disallow external sort.
+
+    VariablesParseState vps = expCtx->variablesParseState;
+    AccumulationStatement pushStatement{"spaceHog",
+                                        ExpressionFieldPath::parse(expCtx, "$largeStr", vps),
+                                        AccumulationStatement::getFactory("$push")};
+    AccumulationStatement sumStatement{"total",
+                                       ExpressionFieldPath::parse(expCtx, "$_id", vps),
+                                       AccumulationStatement::getFactory("$sum")};
+    auto groupByExpression = ExpressionFieldPath::parse(expCtx, "$key", vps);
+    auto group = DocumentSourceGroup::create(
+        expCtx, groupByExpression, {pushStatement, sumStatement}, maxMemoryUsageBytes);
+
+    // The whole input fits in one batch, so only the queued inputs can exceed the limit before
+    // the input runs out.
+    string largeStr(maxMemoryUsageBytes / 2, 'x');
+    deque<DocumentSource::GetNextResult> inputs;
+    for (int i = 0; i < 5; i++) {
+        inputs.emplace_back(Document{{"_id", i}, {"key", 0}, {"largeStr", largeStr}});
+    }
+    auto mock = DocumentSourceMock::create(inputs);
+    group->setSource(mock.get());
+
+    ASSERT_THROWS_CODE(group->getNext(), AssertionException, 16945);
+}
+
 BSONObj toBson(const intrusive_ptr<DocumentSource>& source) {
     vector<Value> arr;
     source->serializeToArray(arr);
@@ -33,6 +33,7 @@
 #include "mongo/base/init.h"
 #include "mongo/db/jsobj.h"
 #include "mongo/db/matcher/expression_algo.h"
+#include "mongo/db/matcher/expression_parser.h"
 #include "mongo/db/pipeline/document.h"
 #include "mongo/db/pipeline/document_path_support.h"
 #include "mongo/db/pipeline/expression.h"
@@ -201,6 +202,101 @@ BSONObj buildEqualityOrQuery(const std::string& fieldName, const BSONArray& valu
     return orBuilder.obj();
 }
 
+/**
+ * Returns the values at 'localFieldPath' in 'input' which a $lookup joins on. If the path
+ * references a field with an array in it, we may need to join on multiple values, so each element
+ * is included. Missing values are treated as null.
+ */
+std::vector<Value> getLocalValues(const Document& input, const FieldPath& localFieldPath) {
+    std::vector<Value> localValues;
+    document_path_support::visitAllValuesAtPath(
+        input, localFieldPath, [&](const Value& nextValue) { localValues.push_back(nextValue); });
+
+    if (localValues.empty()) {
+        localValues.emplace_back(BSONNULL);
+    }
+    return localValues;
+}
+
+/**
+ * Builds the $match stage which queries the foreign collection for documents whose
+ * 'foreignFieldName' equals any of 'localValues'.
+ */
+BSONObj makeMatchStageFromLocalValues(const std::vector<Value>& localValues,
+                                      const std::string& foreignFieldName,
+                                      const BSONObj& additionalFilter) {
+    BSONArrayBuilder arrBuilder;
+    bool containsRegex = false;
+    for (auto&& localValue : localValues) {
+        arrBuilder << localValue;
+        if (!containsRegex && localValue.getType() == BSONType::RegEx) {
+            containsRegex = true;
+        }
+    }
+
+    const auto localFieldListSize = arrBuilder.arrSize();
+    const auto localFieldList = arrBuilder.arr();
+
+    // We construct a query of one of the following forms, depending on the contents of
+    // 'localFieldList'.
+    //
+    //   {$and: [{<foreignFieldName>: {$eq: <localFieldList[0]>}}, <additionalFilter>]}
+    //     if 'localFieldList' contains a single element.
+    //
+    //   {$and: [{<foreignFieldName>: {$in: [<value>, <value>, ...]}}, <additionalFilter>]}
+    //     if 'localFieldList' contains more than one element but doesn't contain any that are
+    //     regular expressions.
+    //
+    //   {$and: [{$or: [{<foreignFieldName>: {$eq: <value>}},
+    //                  {<foreignFieldName>: {$eq: <value>}}, ...]},
+    //           <additionalFilter>]}
+    //     if 'localFieldList' contains more than one element and it contains at least one element
+    //     that is a regular expression.
+
+    // We wrap the query in a $match so that it can be parsed into a DocumentSourceMatch when
+    // constructing a pipeline to execute.
+    BSONObjBuilder match;
+    BSONObjBuilder query(match.subobjStart("$match"));
+
+    BSONArrayBuilder andObj(query.subarrayStart("$and"));
+    BSONObjBuilder joiningObj(andObj.subobjStart());
+
+    if (localFieldListSize > 1) {
+        // A $lookup on an array value corresponds to finding documents in the foreign collection
+        // that have a value of any of the elements in the array value, rather than finding
+        // documents that have a value equal to the entire array value. These semantics are
+        // automatically provided to us by using the $in query operator.
+        if (containsRegex) {
+            // A regular expression inside the $in query operator will perform pattern matching on
+            // any string values. Since we want regular expressions to only match other RegEx types,
+            // we write the query as a $or of equality comparisons instead.
+            BSONObj orQuery = buildEqualityOrQuery(foreignFieldName, localFieldList);
+            joiningObj.appendElements(orQuery);
+        } else {
+            // { <foreignFieldName> : { "$in" : <localFieldList> } }
+            BSONObjBuilder subObj(joiningObj.subobjStart(foreignFieldName));
+            subObj << "$in" << localFieldList;
+            subObj.doneFast();
+        }
+    } else {
+        // { <foreignFieldName> : { "$eq" : <localFieldList[0]> } }
+        BSONObjBuilder subObj(joiningObj.subobjStart(foreignFieldName));
+        subObj << "$eq" << localFieldList[0];
+        subObj.doneFast();
+    }
+
+    joiningObj.doneFast();
+
+    BSONObjBuilder additionalFilterObj(andObj.subobjStart());
+    additionalFilterObj.appendElements(additionalFilter);
+    additionalFilterObj.doneFast();
+
+    andObj.doneFast();
+
+    query.doneFast();
+    return match.obj();
+}
+
 }  // namespace
 
 DocumentSource::GetNextResult DocumentSourceLookUp::getNext() {
@@ -210,7 +306,7 @@ DocumentSource::GetNextResult DocumentSourceLookUp::getNext() {
         return unwindResult();
     }
 
-    auto nextInput = pSource->getNext();
+    auto nextInput = getNextInput();
     if (!nextInput.isAdvanced()) {
         return nextInput;
     }
@@ -221,27 +317,36 @@ DocumentSource::GetNextResult DocumentSourceLookUp::getNext() {
     // '_unwindSrc' would be non-null, and we would not have made it here.
     invariant(!_matchSrc);
 
-    if (!wasConstructedWithPipelineSyntax()) {
-        auto matchStage =
-            makeMatchStageFromInput(inputDoc, *_localField, _foreignField->fullPath(), BSONObj());
-        // We've already allocated space for the trailing $match stage in '_resolvedPipeline'.
-        _resolvedPipeline.back() = matchStage;
-    }
-
-    auto pipeline = buildPipeline(inputDoc);
-
     std::vector<Value> results;
     int objsize = 0;
 
-    while (auto result = pipeline->getNext()) {
-        objsize += result->getApproximateSize();
+    auto addResult = [&](Document&& result) {
+        objsize += result.getApproximateSize();
         uassert(4568,
                 str::stream() << "Total size of documents in " << _fromNs.coll()
                               << " matching pipeline "
                               << getUserPipelineDefinition()
                               << " exceeds maximum document size",
                 objsize <= BSONObjMaxInternalSize);
-        results.emplace_back(std::move(*result));
+        results.emplace_back(std::move(result));
+    };
+
+    if (isHashJoining()) {
+        for (auto&& result : probeHashTable(inputDoc)) {
+            addResult(std::move(result));
+        }
+    } else {
+        if (!wasConstructedWithPipelineSyntax()) {
+            auto matchStage = makeMatchStageFromInput(
+                inputDoc, *_localField, _foreignField->fullPath(), BSONObj());
+            // We've already allocated space for the trailing $match stage in '_resolvedPipeline'.
+            _resolvedPipeline.back() = matchStage;
+        }
+
+        auto pipeline = buildPipeline(inputDoc);
+        while (auto result = pipeline->getNext()) {
+            addResult(std::move(*result));
+        }
     }
 
     MutableDocument output(std::move(inputDoc));
@@ -249,6 +354,153 @@ DocumentSource::GetNextResult DocumentSourceLookUp::getNext() {
     return output.freeze();
 }
 
+DocumentSource::GetNextResult DocumentSourceLookUp::getNextInput() {
+    if (!_joinStrategy) {
+        const auto maxHashTableBytes = internalDocumentSourceLookupHashJoinMaxBytes.load();
+        if (!wasConstructedWithPipelineSyntax() && maxHashTableBytes > 0 &&
+            LookupHashTable::canHashPath(*_foreignField)) {
+            _hashTable.emplace(_fromExpCtx->getValueComparator(),
+                               *_foreignField,
+                               static_cast<size_t>(maxHashTableBytes));
+            _joinStrategy = JoinStrategy::kBatchedHashJoin;
+        } else {
+            _joinStrategy = JoinStrategy::kPerDocument;
+        }
+    }
+
+    if (_joinStrategy == JoinStrategy::kBatchedHashJoin && _inputBatch.empty() && !_pendingInput) {
+        loadInputBatch();
+    }
+
+    if (!_inputBatch.empty()) {
+        auto inputDoc = std::move(_inputBatch.front());
+        _inputBatch.pop_front();
+        return std::move(inputDoc);
+    }
+
+    if (_pendingInput) {
+        auto pendingInput = std::move(*_pendingInput);
+        _pendingInput = boost::none;
+        return pendingInput;
+    }
+
+    return pSource->getNext();
+}
+
+void DocumentSourceLookUp::loadInputBatch() {
+    invariant(_inputBatch.empty());
+
+    // Bound the size of the query for the batch's matches, which holds every local value.
+    const size_t kMaxBatchLocalValuesBytes = BSONObjMaxUserSize / 4;
+    const size_t batchSize = std::max(1, internalDocumentSourceLookupHashJoinBatchSize.load());
+
+    std::vector<Value> batchLocalValues;
+    auto distinctLocalValues = _fromExpCtx->getValueComparator().makeUnorderedValueSet();
+    size_t batchLocalValuesBytes = 0;
+
+    while (_inputBatch.size() < batchSize && batchLocalValuesBytes < kMaxBatchLocalValuesBytes) {
+        auto nextInput = pSource->getNext();
+        if (!nextInput.isAdvanced()) {
+            _pendingInput = std::move(nextInput);
+            break;
+        }
+
+        _inputBatch.push_back(nextInput.releaseDocument());
+        for (auto&& localValue : getLocalValues(_inputBatch.back(), *_localField)) {
+            if (distinctLocalValues.insert(localValue).second) {
+                batchLocalValuesBytes += localValue.getApproximateSize();
+                batchLocalValues.push_back(std::move(localValue));
+            }
+        }
+    }
+
+    if (_inputBatch.empty()) {
+        return;
+    }
+
+    const auto filter = _additionalFilter.value_or(BSONObj());
+
+    // Once our source has produced a full batch, there is probably more input to come, which may
+    // make reading the whole foreign collection cheaper than a query for each batch.
+    if (!_triedWholeCollectionHashJoin && !_pendingInput) {
+        _triedWholeCollectionHashJoin = true;
+        if (foreignCollectionMayFitInHashTable() && buildHashTable(BSON("$match" << filter))) {
+            _joinStrategy = JoinStrategy::kHashJoin;
+            return;
+        }
+    }
+
+    if (!buildHashTable(
+            makeMatchStageFromLocalValues(batchLocalValues, _foreignField->fullPath(), filter))) {
+        // The local documents already in '_inputBatch' will be served by a query each.
+        _hashTable = boost::none;
+        _joinStrategy = JoinStrategy::kPerDocument;
+    }
+}
+
+bool DocumentSourceLookUp::foreignCollectionMayFitInHashTable() const {
+    BSONObjBuilder stats;
+    if (!_mongoProcessInterface->appendStorageStats(_resolvedNs, BSONObj(), &stats).isOK()) {
+        return false;
+    }
+    const auto size = stats.done()["size"];
+    return size.isNumber() &&
+        size.safeNumberLong() <= internalDocumentSourceLookupHashJoinMaxBytes.load();
+}
+
+bool DocumentSourceLookUp::buildHashTable(BSONObj matchStage) {
+    invariant(_hashTable);
+    _hashTable->clear();
+
+    // We've already allocated space for the trailing $match stage in '_resolvedPipeline'.
+    _resolvedPipeline.back() = std::move(matchStage);
+
+    auto pipeline = buildPipeline(Document());
+    while (auto result = pipeline->getNext()) {
+        if (!_hashTable->add(*result)) {
+            _hashTable->clear();
+            return false;
+        }
+    }
+    return true;
+}
+
+std::vector<Document> DocumentSourceLookUp::probeHashTable(const Document& inputDoc) {
+    invariant(_hashTable);
+
+    // The table holds only documents which pass '_additionalFilter', so we need only check that
+    // the candidates match the join predicate.
+    const auto localValues = getLocalValues(inputDoc, *_localField);
+    BSONArrayBuilder localValuesBuilder;
+    for (auto&& localValue : localValues) {
+        localValuesBuilder << localValue;
+    }
+    const BSONObj localValuesArray = localValuesBuilder.arr();
+
+    std::vector<BSONElement> equalities;
+    for (auto&& localValue : localValuesArray) {
+        if (localValue.type() == BSONType::RegEx || localValue.type() == BSONType::Undefined) {
+            // $in would match a regular expression as a pattern rather than as a value, and can't
+            // hold undefined, so check these candidates with the query we would otherwise run.
+            auto matchStage =
+                makeMatchStageFromLocalValues(localValues, _foreignField->fullPath(), BSONObj());
+            auto joinPredicate = uassertStatusOK(
+                MatchExpressionParser::parse(matchStage.firstElement().Obj(), _fromExpCtx));
+            return _hashTable->probe(localValues, *joinPredicate);
+        }
+        equalities.push_back(localValue);
+    }
+
+    if (!_joinPredicate) {
+        _joinPredicate = stdx::make_unique<InMatchExpression>();
+        uassertStatusOK(_joinPredicate->init(_foreignField->fullPath()));
+        _joinPredicate->setCollator(_fromExpCtx->getCollator());
+    }
+    uassertStatusOK(_joinPredicate->setEqualities(std::move(equalities)));
+
+    return _hashTable->probe(localValues, *_joinPredicate);
+}
+
 std::unique_ptr<Pipeline, Pipeline::Deleter> DocumentSourceLookUp::buildPipeline(
     const Document& inputDoc) {
     // Copy all 'let' variables into the foreign pipeline's expression context.
@@ -436,90 +688,18 @@ void DocumentSourceLookUp::doDispose() {
         _pipeline->dispose(pExpCtx->opCtx);
         _pipeline.reset();
     }
+
+    _hashTable = boost::none;
+    _hashJoinMatches.clear();
+    _inputBatch.clear();
 }
 
 BSONObj DocumentSourceLookUp::makeMatchStageFromInput(const Document& input,
                                                       const FieldPath& localFieldPath,
                                                       const std::string& foreignFieldName,
                                                       const BSONObj& additionalFilter) {
-    // Add the 'localFieldPath' of 'input' into 'localFieldList'. If 'localFieldPath' references a
-    // field with an array in its path, we may need to join on multiple values, so we add each
-    // element to 'localFieldList'.
-    BSONArrayBuilder arrBuilder;
-    bool containsRegex = false;
-    document_path_support::visitAllValuesAtPath(input, localFieldPath, [&](const Value& nextValue) {
-        arrBuilder << nextValue;
-        if (!containsRegex && nextValue.getType() == BSONType::RegEx) {
-            containsRegex = true;
-        }
-    });
-
-    if (arrBuilder.arrSize() == 0) {
-        // Missing values are treated as null.
-        arrBuilder << BSONNULL;
-    }
-
-    const auto localFieldListSize = arrBuilder.arrSize();
-    const auto localFieldList = arrBuilder.arr();
-
-    // We construct a query of one of the following forms, depending on the contents of
-    // 'localFieldList'.
-    //
-    //   {$and: [{<foreignFieldName>: {$eq: <localFieldList[0]>}}, <additionalFilter>]}
-    //     if 'localFieldList' contains a single element.
-    //
-    //   {$and: [{<foreignFieldName>: {$in: [<value>, <value>, ...]}}, <additionalFilter>]}
-    //     if 'localFieldList' contains more than one element but doesn't contain any that are
-    //     regular expressions.
-    //
-    //   {$and: [{$or: [{<foreignFieldName>: {$eq: <value>}},
-    //                  {<foreignFieldName>: {$eq: <value>}}, ...]},
-    //           <additionalFilter>]}
-    //     if 'localFieldList' contains more than one element and it contains at least one element
-    //     that is a regular expression.
-
-    // We wrap the query in a $match so that it can be parsed into a DocumentSourceMatch when
-    // constructing a pipeline to execute.
-    BSONObjBuilder match;
-    BSONObjBuilder query(match.subobjStart("$match"));
-
-    BSONArrayBuilder andObj(query.subarrayStart("$and"));
-    BSONObjBuilder joiningObj(andObj.subobjStart());
-
-    if (localFieldListSize > 1) {
-        // A $lookup on an array value corresponds to finding documents in the foreign collection
-        // that have a value of any of the elements in the array value, rather than finding
-        // documents that have a value equal to the entire array value. These semantics are
-        // automatically provided to us by using the $in query operator.
-        if (containsRegex) {
-            // A regular expression inside the $in query operator will perform pattern matching on
-            // any string values. Since we want regular expressions to only match other RegEx types,
-            // we write the query as a $or of equality comparisons instead.
-            BSONObj orQuery = buildEqualityOrQuery(foreignFieldName, localFieldList);
-            joiningObj.appendElements(orQuery);
-        } else {
-            // { <foreignFieldName> : { "$in" : <localFieldList> } }
-            BSONObjBuilder subObj(joiningObj.subobjStart(foreignFieldName));
-            subObj << "$in" << localFieldList;
-            subObj.doneFast();
-        }
-    } else {
-        // { <foreignFieldName> : { "$eq" : <localFieldList[0]> } }
-        BSONObjBuilder subObj(joiningObj.subobjStart(foreignFieldName));
-        subObj << "$eq" << localFieldList[0];
-        subObj.doneFast();
-    }
-
-    joiningObj.doneFast();
-
-    BSONObjBuilder additionalFilterObj(andObj.subobjStart());
-    additionalFilterObj.appendElements(additionalFilter);
-    additionalFilterObj.doneFast();
-
-    andObj.doneFast();
-
-    query.doneFast();
-    return match.obj();
+    return makeMatchStageFromLocalValues(
+        getLocalValues(input, localFieldPath), foreignFieldName, additionalFilter);
 }
 
 DocumentSource::GetNextResult DocumentSourceLookUp::unwindResult() {
@@ -528,35 +708,43 @@ DocumentSource::GetNextResult DocumentSourceLookUp::unwindResult() {
     // Loop until we get a document that has at least one match.
     // Note we may return early from this loop if our source stage is exhausted or if the unwind
     // source was asked to return empty arrays and we get a document without a match.
-    while (!_pipeline || !_nextValue) {
-        auto nextInput = pSource->getNext();
+    while (!_nextValue) {
+        auto nextInput = getNextInput();
         if (!nextInput.isAdvanced()) {
             return nextInput;
         }
 
         _input = nextInput.releaseDocument();
 
-        if (!wasConstructedWithPipelineSyntax()) {
-            BSONObj filter = _additionalFilter.value_or(BSONObj());
-            auto matchStage =
-                makeMatchStageFromInput(*_input, *_localField, _foreignField->fullPath(), filter);
-            // We've already allocated space for the trailing $match stage in '_resolvedPipeline'.
-            _resolvedPipeline.back() = matchStage;
-        }
-
         if (_pipeline) {
             _pipeline->dispose(pExpCtx->opCtx);
+            _pipeline.reset();
         }
 
-        _pipeline = buildPipeline(*_input);
+        if (isHashJoining()) {
+            auto matches = probeHashTable(*_input);
+            _hashJoinMatches.assign(std::make_move_iterator(matches.begin()),
+                                    std::make_move_iterator(matches.end()));
+        } else {
+            if (!wasConstructedWithPipelineSyntax()) {
+                BSONObj filter = _additionalFilter.value_or(BSONObj());
+                auto matchStage = makeMatchStageFromInput(
+                    *_input, *_localField, _foreignField->fullPath(), filter);
+                // We've already allocated space for the trailing $match stage in
+                // '_resolvedPipeline'.
+                _resolvedPipeline.back() = matchStage;
+            }
+
+            _pipeline = buildPipeline(*_input);
 
-        // The $lookup stage takes responsibility for disposing of its Pipeline, since it will
-        // potentially be used by multiple OperationContexts, and the $lookup stage is part of an
-        // outer Pipeline that will propagate dispose() calls before being destroyed.
-        _pipeline.get_deleter().dismissDisposal();
+            // The $lookup stage takes responsibility for disposing of its Pipeline, since it will
+            // potentially be used by multiple OperationContexts, and the $lookup stage is part of
+            // an outer Pipeline that will propagate dispose() calls before being destroyed.
+            _pipeline.get_deleter().dismissDisposal();
+        }
 
         _cursorIndex = 0;
-        _nextValue = _pipeline->getNext();
+        _nextValue = getNextUnwindMatch();
 
         if (_unwindSrc->preserveNullAndEmptyArrays() && !_nextValue) {
             // There were no results for this cursor, but the $unwind was asked to preserve empty
@@ -574,7 +762,7 @@ DocumentSource::GetNextResult DocumentSourceLookUp::unwindResult() {
 
     invariant(bool(_input) && bool(_nextValue));
     auto currentValue = *_nextValue;
-    _nextValue = _pipeline->getNext();
+    _nextValue = getNextUnwindMatch();
 
     // Move input document into output if this is the last or only result, otherwise perform a copy.
     MutableDocument output(_nextValue ? *_input : std::move(*_input));
@@ -588,6 +776,20 @@ DocumentSource::GetNextResult DocumentSourceLookUp::unwindResult() {
     return output.freeze();
 }
 
+boost::optional<Document> DocumentSourceLookUp::getNextUnwindMatch() {
+    if (_pipeline) {
+        return _pipeline->getNext();
+    }
+
+    if (_hashJoinMatches.empty()) {
+        return boost::none;
+    }
+
+    auto match = std::move(_hashJoinMatches.front());
+    _hashJoinMatches.pop_front();
+    return match;
+}
+
 void DocumentSourceLookUp::copyVariablesToExpCtx(const Variables& vars,
                                                  const VariablesParseState& vps,
                                                  ExpressionContext* expCtx) {
@@ -29,13 +29,16 @@
 #pragma once
 
 #include <boost/optional.hpp>
+#include <deque>
 
+#include "mongo/db/matcher/expression_leaf.h"
 #include "mongo/db/pipeline/document_source.h"
 #include "mongo/db/pipeline/document_source_match.h"
 #include "mongo/db/pipeline/document_source_sequential_document_cache.h"
 #include "mongo/db/pipeline/document_source_unwind.h"
 #include "mongo/db/pipeline/expression.h"
 #include "mongo/db/pipeline/lite_parsed_pipeline.h"
+#include "mongo/db/pipeline/lookup_hash_table.h"
 #include "mongo/db/pipeline/lookup_set_cache.h"
 #include "mongo/db/pipeline/value_comparator.h"
 
@@ -198,6 +201,21 @@ protected:
                                                      Pipeline::SourceContainer* container) final;
 
 private:
+    /**
+     * The ways of finding the foreign documents which match each local document.
+     */
+    enum class JoinStrategy {
+        // Runs the foreign pipeline once for each local document.
+        kPerDocument,
+
+        // Runs the foreign pipeline once for each batch of local documents, collecting the matches
+        // of the whole batch into '_hashTable'.
+        kBatchedHashJoin,
+
+        // Runs the foreign pipeline once, collecting every foreign document into '_hashTable'.
+        kHashJoin,
+    };
+
     struct LetVariable {
         LetVariable(std::string name, boost::intrusive_ptr<Expression> expression, Variables::Id id)
             : name(std::move(name)), expression(std::move(expression)), id(id) {}
@@ -244,6 +262,48 @@ private:
 
     GetNextResult unwindResult();
 
+    bool isHashJoining() const {
+        return _joinStrategy == JoinStrategy::kBatchedHashJoin ||
+            _joinStrategy == JoinStrategy::kHashJoin;
+    }
+
+    /**
+     * Returns the next local document. If we are hash joining once this returns, the document's
+     * matches are in '_hashTable'.
+     */
+    GetNextResult getNextInput();
+
+    /**
+     * Reads the next batch of local documents into '_inputBatch', and fills '_hashTable' with their
+     * matches. Falls back to the per-document strategy if the matches do not fit. The first time
+     * it reads a full batch, tries to fill the table with the whole foreign collection instead.
+     */
+    void loadInputBatch();
+
+    /**
+     * Returns whether the foreign collection's data is no larger than '_hashTable' may hold.
+     * Reading a larger collection in full could not succeed, and would cost far more than the
+     * queries for batches of local documents it is meant to save.
+     */
+    bool foreignCollectionMayFitInHashTable() const;
+
+    /**
+     * Replaces the contents of '_hashTable' with the results of the foreign pipeline ending in
+     * 'matchStage'. Returns false, leaving the table empty, if they do not all fit.
+     */
+    bool buildHashTable(BSONObj matchStage);
+
+    /**
+     * Returns the matches of 'inputDoc' from '_hashTable'.
+     */
+    std::vector<Document> probeHashTable(const Document& inputDoc);
+
+    /**
+     * Returns the next match of '_input' when unwinding, from either '_pipeline' or
+     * '_hashJoinMatches'.
+     */
+    boost::optional<Document> getNextUnwindMatch();
+
     /**
      * Copies 'vars' and 'vps' to the Variables and VariablesParseState objects in 'expCtx'. These
      * copies provide access to 'let' defined variables in sub-pipeline execution.
@@ -330,8 +390,26 @@ private:
     // not null.
     long long _cursorIndex = 0;
     std::unique_ptr<Pipeline, Pipeline::Deleter> _pipeline;
+    std::deque<Document> _hashJoinMatches;
     boost::optional<Document> _input;
     boost::optional<Document> _nextValue;
+
+    // Chosen on the first call to getNext(). Only localField/foreignField syntax may hash join.
+    boost::optional<JoinStrategy> _joinStrategy;
+    bool _triedWholeCollectionHashJoin = false;
+
+    // Holds foreign documents hashed by their values at '_foreignField' while hash joining.
+    boost::optional<LookupHashTable> _hashTable;
+
+    // Confirms the candidate matches of each local document probing '_hashTable'. Built on the
+    // first probe, and given the local values of each probing document in turn.
+    std::unique_ptr<InMatchExpression> _joinPredicate;
+
+    // Local documents read ahead as a batch, whose matches are in '_hashTable' unless we have since
+    // fallen back to the per-document strategy. A result other than a document which our source
+    // returned while we filled the batch is held in '_pendingInput' until the batch is drained.
+    std::deque<Document> _inputBatch;
+    boost::optional<GetNextResult> _pendingInput;
 };
 
 }  // namespace mongo
@@ -35,18 +35,22 @@
 #include "mongo/bson/bsonmisc.h"
 #include "mongo/bson/bsonobj.h"
 #include "mongo/bson/bsonobjbuilder.h"
+#include "mongo/db/matcher/expression_parser.h"
 #include "mongo/db/pipeline/aggregation_context_fixture.h"
 #include "mongo/db/pipeline/document.h"
 #include "mongo/db/pipeline/document_source_lookup.h"
 #include "mongo/db/pipeline/document_source_mock.h"
 #include "mongo/db/pipeline/document_value_test_util.h"
 #include "mongo/db/pipeline/field_path.h"
+#include "mongo/db/pipeline/lookup_hash_table.h"
 #include "mongo/db/pipeline/stub_mongo_process_interface.h"
 #include "mongo/db/pipeline/value.h"
+#include "mongo/db/query/collation/collator_interface_mock.h"
 #include "mongo/db/query/query_knobs.h"
 #include "mongo/db/repl/replication_coordinator_mock.h"
 #include "mongo/db/repl/storage_interface_mock.h"
 #include "mongo/db/server_options.h"
+#include "mongo/util/scopeguard.h"
 
 namespace mongo {
 namespace {
@@ -551,12 +555,36 @@ public:
         }
 
         pipeline->addInitialSource(DocumentSourceMock::create(_mockResults));
+        ++_numCursorSourcesAttached;
         return Status::OK();
     }
 
+    Status appendStorageStats(const NamespaceString& nss,
+                              const BSONObj& param,
+                              BSONObjBuilder* builder) const final {
+        builder->appendNumber("size", _dataSize);
+        return Status::OK();
+    }
+
+    /**
+     * Returns how many times the foreign collection has been queried.
+     */
+    int numCursorSourcesAttached() const {
+        return _numCursorSourcesAttached;
+    }
+
+    /**
+     * Sets the data size reported for the foreign collection.
+     */
+    void setDataSize(long long dataSize) {
+        _dataSize = dataSize;
+    }
+
 private:
     deque<DocumentSource::GetNextResult> _mockResults;
     bool _removeLeadingQueryStages = false;
+    int _numCursorSourcesAttached = 0;
+    long long _dataSize = 0;
 };
 
 TEST_F(DocumentSourceLookUpTest, ShouldPropagatePauses) {
@@ -1129,5 +1157,275 @@ TEST_F(DocumentSourceLookUpTest, ShouldNotCacheIfCorrelatedStageIsAbsorbedIntoPl
     ASSERT_VALUE_EQ(Value(subPipeline->writeExplainOps(kExplain)), Value(BSONArray(expectedPipe)));
 }
 
+TEST_F(DocumentSourceLookUpTest, ShouldHashJoinWholeForeignCollectionOnceInputFillsABatch) {
+    const auto oldBatchSize = internalDocumentSourceLookupHashJoinBatchSize.load();
+    ON_BLOCK_EXIT(
+        [oldBatchSize] { internalDocumentSourceLookupHashJoinBatchSize.store(oldBatchSize); });
+    internalDocumentSourceLookupHashJoinBatchSize.store(2);
+
+    auto expCtx = getExpCtx();
+    NamespaceString fromNs("test", "foreign");
+    expCtx->setResolvedNamespace(fromNs, {fromNs, std::vector<BSONObj>{}});
+
+    auto lookupSpec =
+        fromjson("{$lookup: {from: 'foreign', localField: 'k', foreignField: 'f', as: 'as'}}");
+    auto parsed = DocumentSourceLookUp::createFromBson(lookupSpec.firstElement(), expCtx);
+    auto lookup = static_cast<DocumentSourceLookUp*>(parsed.get());
+
+    auto mockLocalSource = DocumentSourceMock::create({Document{fromjson("{_id: 0, k: 1}")},
+                                                       Document{fromjson("{_id: 1, k: [2, 3]}")},
+                                                       Document{fromjson("{_id: 2}")},
+                                                       Document{fromjson("{_id: 3, k: 4}")}});
+    lookup->setSource(mockLocalSource.get());
+
+    deque<DocumentSource::GetNextResult> mockForeignContents{
+        Document{fromjson("{_id: 10, f: 1}")},
+        Document{fromjson("{_id: 11, f: [3, 5]}")},
+        Document{fromjson("{_id: 12}")},
+        Document{fromjson("{_id: 13, f: null}")},
+        Document{fromjson("{_id: 14, f: 2}")}};
+    auto mongoProcessInterface =
+        std::make_shared<MockMongoProcessInterface>(std::move(mockForeignContents));
+    lookup->injectMongoProcessInterface(mongoProcessInterface);
+
+    auto next = lookup->getNext();
+    ASSERT_TRUE(next.isAdvanced());
+    ASSERT_DOCUMENT_EQ(next.releaseDocument(),
+                       Document(fromjson("{_id: 0, k: 1, as: [{_id: 10, f: 1}]}")));
+
+    next = lookup->getNext();
+    ASSERT_TRUE(next.isAdvanced());
+    ASSERT_DOCUMENT_EQ(
+        next.releaseDocument(),
+        Document(fromjson("{_id: 1, k: [2, 3], as: [{_id: 11, f: [3, 5]}, {_id: 14, f: 2}]}")));
+
+    // A missing local field matches foreign documents where the field is missing or null.
+    next = lookup->getNext();
+    ASSERT_TRUE(next.isAdvanced());
+    ASSERT_DOCUMENT_EQ(next.releaseDocument(),
+                       Document(fromjson("{_id: 2, as: [{_id: 12}, {_id: 13, f: null}]}")));
+
+    next = lookup->getNext();
+    ASSERT_TRUE(next.isAdvanced());
+    ASSERT_DOCUMENT_EQ(next.releaseDocument(), Document(fromjson("{_id: 3, k: 4, as: []}")));
+
+    ASSERT_TRUE(lookup->getNext().isEOF());
+
+    // The whole foreign collection fit in the hash table, so it was read just once.
+    ASSERT_EQ(mongoProcessInterface->numCursorSourcesAttached(), 1);
+    lookup->dispose();
+}
+
+TEST_F(DocumentSourceLookUpTest, ShouldNotReadWholeForeignCollectionLargerThanHashTable) {
+    const auto oldBatchSize = internalDocumentSourceLookupHashJoinBatchSize.load();
+    ON_BLOCK_EXIT(
+        [oldBatchSize] { internalDocumentSourceLookupHashJoinBatchSize.store(oldBatchSize); });
+    internalDocumentSourceLookupHashJoinBatchSize.store(2);
+
+    auto expCtx = getExpCtx();
+    NamespaceString fromNs("test", "foreign");
+    expCtx->setResolvedNamespace(fromNs, {fromNs, std::vector<BSONObj>{}});
+
+    auto lookupSpec =
+        fromjson("{$lookup: {from: 'foreign', localField: 'k', foreignField: 'f', as: 'as'}}");
+    auto parsed = DocumentSourceLookUp::createFromBson(lookupSpec.firstElement(), expCtx);
+    auto lookup = static_cast<DocumentSourceLookUp*>(parsed.get());
+
+    auto mockLocalSource = DocumentSourceMock::create({Document{fromjson("{_id: 0, k: 1}")},
+                                                       Document{fromjson("{_id: 1, k: 2}")},
+                                                       Document{fromjson("{_id: 2, k: 3}")},
+                                                       Document{fromjson("{_id: 3, k: 4}")}});
+    lookup->setSource(mockLocalSource.get());
+
+    deque<DocumentSource::GetNextResult> mockForeignContents{Document{fromjson("{_id: 10, f: 1}")},
+                                                             Document{fromjson("{_id: 11, f: 3}")}};
+    auto mongoProcessInterface =
+        std::make_shared<MockMongoProcessInterface>(std::move(mockForeignContents));
+    mongoProcessInterface->setDataSize(internalDocumentSourceLookupHashJoinMaxBytes.load() + 1LL);
+    lookup->injectMongoProcessInterface(mongoProcessInterface);
+
+    for (int i = 0; i < 4; ++i) {
+        ASSERT_TRUE(lookup->getNext().isAdvanced());
+    }
+    ASSERT_TRUE(lookup->getNext().isEOF());
+
+    // The foreign collection was too large to read in full, so each batch had a query of its own.
+    ASSERT_EQ(mongoProcessInterface->numCursorSourcesAttached(), 2);
+    lookup->dispose();
+}
+
+TEST_F(DocumentSourceLookUpTest, ShouldFindMatchesForABatchOfLocalDocumentsWithOneQuery) {
+    auto expCtx = getExpCtx();
+    NamespaceString fromNs("test", "foreign");
+    expCtx->setResolvedNamespace(fromNs, {fromNs, std::vector<BSONObj>{}});
+
+    auto lookupSpec =
+        fromjson("{$lookup: {from: 'foreign', localField: 'k', foreignField: 'f', as: 'as'}}");
+    auto parsed = DocumentSourceLookUp::createFromBson(lookupSpec.firstElement(), expCtx);
+    auto lookup = static_cast<DocumentSourceLookUp*>(parsed.get());
+
+    // There is less than a batch of input, so we only query for the foreign documents it matches.
+    auto mockLocalSource = DocumentSourceMock::create(
+        {Document{fromjson("{_id: 0, k: 1}")}, Document{fromjson("{_id: 1, k: 2}")}});
+    lookup->setSource(mockLocalSource.get());
+
+    deque<DocumentSource::GetNextResult> mockForeignContents{
+        Document{fromjson("{_id: 10, f: 1}")},
+        Document{fromjson("{_id: 11, f: [1, 2]}")},
+        Document{fromjson("{_id: 12, f: 3}")}};
+    auto mongoProcessInterface =
+        std::make_shared<MockMongoProcessInterface>(std::move(mockForeignContents));
+    lookup->injectMongoProcessInterface(mongoProcessInterface);
+
+    auto next = lookup->getNext();
+    ASSERT_TRUE(next.isAdvanced());
+    ASSERT_DOCUMENT_EQ(
+        next.releaseDocument(),
+        Document(fromjson("{_id: 0, k: 1, as: [{_id: 10, f: 1}, {_id: 11, f: [1, 2]}]}")));
+
+    next = lookup->getNext();
+    ASSERT_TRUE(next.isAdvanced());
+    ASSERT_DOCUMENT_EQ(next.releaseDocument(),
+                       Document(fromjson("{_id: 1, k: 2, as: [{_id: 11, f: [1, 2]}]}")));
+
+    ASSERT_TRUE(lookup->getNext().isEOF());
+    ASSERT_EQ(mongoProcessInterface->numCursorSourcesAttached(), 1);
+    lookup->dispose();
+}
+
+TEST_F(DocumentSourceLookUpTest, ShouldQueryPerDocumentIfMatchesDoNotFitInHashTable) {
+    const auto oldMaxBytes = internalDocumentSourceLookupHashJoinMaxBytes.load();
+    ON_BLOCK_EXIT(
+        [oldMaxBytes] { internalDocumentSourceLookupHashJoinMaxBytes.store(oldMaxBytes); });
+    internalDocumentSourceLookupHashJoinMaxBytes.store(1);
+
+    auto expCtx = getExpCtx();
+    NamespaceString fromNs("test", "foreign");
+    expCtx->setResolvedNamespace(fromNs, {fromNs, std::vector<BSONObj>{}});
+
+    auto lookupSpec =
+        fromjson("{$lookup: {from: 'foreign', localField: 'k', foreignField: 'f', as: 'as'}}");
+    auto parsed = DocumentSourceLookUp::createFromBson(lookupSpec.firstElement(), expCtx);
+    auto lookup = static_cast<DocumentSourceLookUp*>(parsed.get());
+
+    auto mockLocalSource = DocumentSourceMock::create(
+        {Document{fromjson("{_id: 0, k: 1}")}, Document{fromjson("{_id: 1, k: 2}")}});
+    lookup->setSource(mockLocalSource.get());
+
+    deque<DocumentSource::GetNextResult> mockForeignContents{Document{fromjson("{_id: 10, f: 1}")},
+                                                             Document{fromjson("{_id: 11, f: 2}")}};
+    auto mongoProcessInterface =
+        std::make_shared<MockMongoProcessInterface>(std::move(mockForeignContents));
+    lookup->injectMongoProcessInterface(mongoProcessInterface);
+
+    auto next = lookup->getNext();
+    ASSERT_TRUE(next.isAdvanced());
+    ASSERT_DOCUMENT_EQ(next.releaseDocument(),
+                       Document(fromjson("{_id: 0, k: 1, as: [{_id: 10, f: 1}]}")));
+
+    next = lookup->getNext();
+    ASSERT_TRUE(next.isAdvanced());
+    ASSERT_DOCUMENT_EQ(next.releaseDocument(),
+                       Document(fromjson("{_id: 1, k: 2, as: [{_id: 11, f: 2}]}")));
+
+    ASSERT_TRUE(lookup->getNext().isEOF());
+
+    // One query for the batch, which was abandoned, and then one for each local document.
+    ASSERT_EQ(mongoProcessInterface->numCursorSourcesAttached(), 3);
+    lookup->dispose();
+}
+
+TEST_F(DocumentSourceLookUpTest, ShouldHashJoinWhileUnwinding) {
+    auto expCtx = getExpCtx();
+    NamespaceString fromNs("test", "foreign");
+    expCtx->setResolvedNamespace(fromNs, {fromNs, std::vector<BSONObj>{}});
+
+    auto lookupSpec =
+        fromjson("{$lookup: {from: 'foreign', localField: 'k', foreignField: 'f', as: 'as'}}");
+    auto parsed = DocumentSourceLookUp::createFromBson(lookupSpec.firstElement(), expCtx);
+    auto lookup = static_cast<DocumentSourceLookUp*>(parsed.get());
+
+    const bool preserveNullAndEmptyArrays = false;
+    const boost::optional<std::string> includeArrayIndex = std::string("i");
+    lookup->setUnwindStage(
+        DocumentSourceUnwind::create(expCtx, "as", preserveNullAndEmptyArrays, includeArrayIndex));
+
+    auto mockLocalSource = DocumentSourceMock::create(
+        {Document{fromjson("{_id: 0, k: 1}")}, Document{fromjson("{_id: 1, k: 2}")}});
+    lookup->setSource(mockLocalSource.get());
+
+    deque<DocumentSource::GetNextResult> mockForeignContents{Document{fromjson("{_id: 10, f: 1}")},
+                                                             Document{fromjson("{_id: 11, f: 1}")},
+                                                             Document{fromjson("{_id: 12, f: 3}")}};
+    auto mongoProcessInterface =
+        std::make_shared<MockMongoProcessInterface>(std::move(mockForeignContents));
+    lookup->injectMongoProcessInterface(mongoProcessInterface);
+
+    auto next = lookup->getNext();
+    ASSERT_TRUE(next.isAdvanced());
+    ASSERT_DOCUMENT_EQ(next.releaseDocument(),
+                       Document(fromjson("{_id: 0, k: 1, as: {_id: 10, f: 1}, i: 0}")));
+
+    next = lookup->getNext();
+    ASSERT_TRUE(next.isAdvanced());
+    ASSERT_DOCUMENT_EQ(next.releaseDocument(),
+                       Document(fromjson("{_id: 0, k: 1, as: {_id: 11, f: 1}, i: 1}")));
+
+    // {_id: 1} has no matches, so the $unwind drops it.
+    ASSERT_TRUE(lookup->getNext().isEOF());
+    ASSERT_EQ(mongoProcessInterface->numCursorSourcesAttached(), 1);
+    lookup->dispose();
+}
+
+TEST_F(DocumentSourceLookUpTest, HashTableProbeRespectsCollation) {
+    CollatorInterfaceMock collator(CollatorInterfaceMock::MockType::kToLowerString);
+    auto expCtx = getExpCtx();
+    expCtx->setCollator(&collator);
+
+    LookupHashTable table(expCtx->getValueComparator(), FieldPath("f"), 1024 * 1024);
+    ASSERT_TRUE(table.add(Document(fromjson("{_id: 0, f: 'abc'}"))));
+    ASSERT_TRUE(table.add(Document(fromjson("{_id: 1, f: 'xyz'}"))));
+    ASSERT_TRUE(table.add(Document(fromjson("{_id: 2, f: ['ABC', 'def']}"))));
+
+    auto predicateObj = fromjson("{f: {$eq: 'Abc'}}");
+    auto joinPredicate = uassertStatusOK(MatchExpressionParser::parse(predicateObj, expCtx));
+    auto matches = table.probe({Value("Abc"_sd)}, *joinPredicate);
+
+    ASSERT_EQ(matches.size(), 2U);
+    ASSERT_DOCUMENT_EQ(matches[0], Document(fromjson("{_id: 0, f: 'abc'}")));
+    ASSERT_DOCUMENT_EQ(matches[1], Document(fromjson("{_id: 2, f: ['ABC', 'def']}")));
+}
+
+TEST_F(DocumentSourceLookUpTest, HashTableProbeMatchesNumbersOfDifferentTypes) {
+    auto expCtx = getExpCtx();
+    LookupHashTable table(expCtx->getValueComparator(), FieldPath("a.f"), 1024 * 1024);
+    ASSERT_TRUE(table.add(Document(fromjson("{_id: 0, a: {f: 1}}"))));
+    ASSERT_TRUE(table.add(Document(fromjson("{_id: 1, a: [{f: 2.0}, {f: NumberLong(1)}]}"))));
+    ASSERT_TRUE(table.add(Document(fromjson("{_id: 2, a: {f: NumberDecimal('1.5')}}"))));
+
+    auto predicateObj = fromjson("{'a.f': {$eq: 1.0}}");
+    auto joinPredicate = uassertStatusOK(MatchExpressionParser::parse(predicateObj, expCtx));
+    auto matches = table.probe({Value(1.0)}, *joinPredicate);
+
+    ASSERT_EQ(matches.size(), 2U);
+    ASSERT_VALUE_EQ(matches[0]["_id"], Value(0));
+    ASSERT_VALUE_EQ(matches[1]["_id"], Value(1));
+}
+
+TEST_F(DocumentSourceLookUpTest, HashTableRefusesDocumentsPastItsMaximumSize) {
+    auto expCtx = getExpCtx();
+    const auto doc = Document(fromjson("{_id: 0, f: 1}"));
+    LookupHashTable table(expCtx->getValueComparator(), FieldPath("f"), doc.toBson().objsize());
+    ASSERT_FALSE(table.add(doc));
+    ASSERT_EQ(table.count(), 0U);
+}
+
+TEST(LookupHashTableTest, CannotHashPathsWithNumericComponents) {
+    ASSERT_TRUE(LookupHashTable::canHashPath(FieldPath("a.b")));
+    ASSERT_TRUE(LookupHashTable::canHashPath(FieldPath("0.b")));
+    ASSERT_FALSE(LookupHashTable::canHashPath(FieldPath("a.0")));
+    ASSERT_FALSE(LookupHashTable::canHashPath(FieldPath("a.0.b")));
+}
+
 }  // namespace
 }  // namespace mongo
@@ -240,6 +240,13 @@ const char* ExpressionAbs::getOpName() const {
 /* ------------------------- ExpressionAdd ----------------------------- */
 
 Value ExpressionAdd::evaluate(const Document& root) const {
+    return evaluateOperands(vpOperand.size(),
+                            [&](size_t i) { return vpOperand[i]->evaluate(root); });
+}
+
+// static
+Value ExpressionAdd::evaluateOperands(size_t numOperands,
+                                      const stdx::function<Value(size_t)>& getOperand) {
     // We'll try to return the narrowest possible result value while avoiding overflow, loss
     // of precision due to intermediate rounding or implicit use of decimal types. To do that,
     // compute a compensated sum for non-decimal values and a separate decimal sum for decimal
@@ -249,9 +256,8 @@ Value ExpressionAdd::evaluate(const Document& root) const {
     BSONType totalType = NumberInt;
     bool haveDate = false;
 
-    const size_t n = vpOperand.size();
-    for (size_t i = 0; i < n; ++i) {
-        Value val = vpOperand[i]->evaluate(root);
+    for (size_t i = 0; i < numOperands; ++i) {
+        Value val = getOperand(i);
 
         switch (val.getType()) {
             case NumberDecimal:
@@ -793,7 +799,10 @@ static const CmpLookup cmpLookup[7] = {
 Value ExpressionCompare::evaluate(const Document& root) const {
     Value pLeft(vpOperand[0]->evaluate(root));
     Value pRight(vpOperand[1]->evaluate(root));
+    return evaluateOperands(pLeft, pRight);
+}
 
+Value ExpressionCompare::evaluateOperands(const Value& pLeft, const Value& pRight) const {
     int cmp = getExpressionContext()->getValueComparator().compare(pLeft, pRight);
 
     // Make cmp one of 1, 0, or -1.
@@ -1647,7 +1656,11 @@ void ExpressionDateToString::_doAddDependencies(DepsTracker* deps) const {
 Value ExpressionDivide::evaluate(const Document& root) const {
     Value lhs = vpOperand[0]->evaluate(root);
     Value rhs = vpOperand[1]->evaluate(root);
+    return evaluateOperands(lhs, rhs);
+}
 
+// static
+Value ExpressionDivide::evaluateOperands(const Value& lhs, const Value& rhs) {
     auto assertNonZero = [](bool nonZero) { uassert(16608, "can't $divide by zero", nonZero); };
 
     if (lhs.numeric() && rhs.numeric()) {
@@ -2408,6 +2421,13 @@ const char* ExpressionMod::getOpName() const {
 /* ------------------------- ExpressionMultiply ----------------------------- */
 
 Value ExpressionMultiply::evaluate(const Document& root) const {
+    return evaluateOperands(vpOperand.size(),
+                            [&](size_t i) { return vpOperand[i]->evaluate(root); });
+}
+
+// static
+Value ExpressionMultiply::evaluateOperands(size_t numOperands,
+                                           const stdx::function<Value(size_t)>& getOperand) {
     /*
       We'll try to return the narrowest possible result value.  To do that
       without creating intermediate Values, do the arithmetic for double
@@ -2420,9 +2440,8 @@ Value ExpressionMultiply::evaluate(const Document& root) const {
 
     BSONType productType = NumberInt;
 
-    const size_t n = vpOperand.size();
-    for (size_t i = 0; i < n; ++i) {
-        Value val = vpOperand[i]->evaluate(root);
+    for (size_t i = 0; i < numOperands; ++i) {
+        Value val = getOperand(i);
 
         if (val.numeric()) {
             BSONType oldProductType = productType;
@@ -4023,7 +4042,11 @@ const char* ExpressionStrLenCP::getOpName() const {
 Value ExpressionSubtract::evaluate(const Document& root) const {
     Value lhs = vpOperand[0]->evaluate(root);
     Value rhs = vpOperand[1]->evaluate(root);
+    return evaluateOperands(lhs, rhs);
+}
 
+// static
+Value ExpressionSubtract::evaluateOperands(const Value& lhs, const Value& rhs) {
     BSONType diffType = Value::getWidestNumeric(rhs.getType(), lhs.getType());
 
     if (diffType == NumberDecimal) {
@@ -651,6 +651,14 @@ public:
     Value evaluate(const Document& root) const final;
     const char* getOpName() const final;
 
+    /**
+     * Computes the result from the operands' values rather than from the operand expressions.
+     * 'getOperand' is called for each of the 'numOperands' operands in turn, and no further once
+     * the result is known to be null or an error, just as evaluate() evaluates its operands.
+     */
+    static Value evaluateOperands(size_t numOperands,
+                                  const stdx::function<Value(size_t)>& getOperand);
+
     bool isAssociative() const final {
         return true;
     }
@@ -791,6 +799,12 @@ public:
     Value evaluate(const Document& root) const final;
     const char* getOpName() const final;
 
+    /**
+     * Computes the result from the values of the two operands rather than from the operand
+     * expressions.
+     */
+    Value evaluateOperands(const Value& lhs, const Value& rhs) const;
+
     CmpOp getOp() const {
         return cmpOp;
     }
@@ -1027,6 +1041,12 @@ public:
 
     Value evaluate(const Document& root) const final;
     const char* getOpName() const final;
+
+    /**
+     * Computes the result from the values of the two operands rather than from the operand
+     * expressions.
+     */
+    static Value evaluateOperands(const Value& lhs, const Value& rhs);
 };
 
 
@@ -1372,6 +1392,14 @@ public:
     Value evaluate(const Document& root) const final;
     const char* getOpName() const final;
 
+    /**
+     * Computes the result from the operands' values rather than from the operand expressions.
+     * 'getOperand' is called for each of the 'numOperands' operands in turn, and no further once
+     * the result is known to be null or an error, just as evaluate() evaluates its operands.
+     */
+    static Value evaluateOperands(size_t numOperands,
+                                  const stdx::function<Value(size_t)>& getOperand);
+
     bool isAssociative() const final {
         return true;
     }
@@ -1722,6 +1750,12 @@ public:
 
     Value evaluate(const Document& root) const final;
     const char* getOpName() const final;
+
+    /**
+     * Computes the result from the values of the two operands rather than from the operand
+     * expressions.
+     */
+    static Value evaluateOperands(const Value& lhs, const Value& rhs);
 };
 
 
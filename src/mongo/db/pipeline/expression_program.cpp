@@ -0,0 +1,475 @@
+/**
+ *    Copyright (C) 2017 MongoDB Inc.
+ *
+ *    This program is free software: you can redistribute it and/or  modify
+ *    it under the terms of the GNU Affero General Public License, version 3,
+ *    as published by the Free Software Foundation.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU Affero General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Affero General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the GNU Affero General Public License in all respects for
+ *    all of the code used other than as permitted herein. If you modify file(s)
+ *    with this exception, you may extend this exception to your version of the
+ *    file(s), but you are not obligated to do so. If you do not wish to do so,
+ *    delete this exception statement from your version. If you delete this
+ *    exception statement from all source files in the program, then also delete
+ *    it in the license file.
+ */
+
+#include "mongo/platform/basic.h"
+
+#include "mongo/db/pipeline/expression_program.h"
+
+#include "mongo/base/compare_numbers.h"
+#include "mongo/bson/bsonobjbuilder.h"
+#include "mongo/platform/overflow_arithmetic.h"
+#include "mongo/util/summation.h"
+
+namespace mongo {
+
+using boost::intrusive_ptr;
+
+void ExpressionProgram::Register::setValue(Value newValue) {
+    switch (newValue.getType()) {
+        case NumberInt:
+            tag = Tag::kInt;
+            intValue = newValue.getInt();
+            break;
+        case NumberLong:
+            tag = Tag::kLong;
+            longValue = newValue.getLong();
+            break;
+        case NumberDouble:
+            tag = Tag::kDouble;
+            doubleValue = newValue.getDouble();
+            break;
+        case Bool:
+            tag = Tag::kBool;
+            boolValue = newValue.getBool();
+            break;
+        default:
+            tag = Tag::kValue;
+            value = std::move(newValue);
+    }
+}
+
+void ExpressionProgram::Register::setIntOrLong(long long newValue) {
+    // Mirrors Value::createIntOrLong().
+    int newIntValue = newValue;
+    if (newIntValue != newValue) {
+        setLong(newValue);
+        return;
+    }
+    tag = Tag::kInt;
+    intValue = newIntValue;
+}
+
+void ExpressionProgram::Register::setLong(long long newValue) {
+    tag = Tag::kLong;
+    longValue = newValue;
+}
+
+void ExpressionProgram::Register::setDouble(double newValue) {
+    tag = Tag::kDouble;
+    doubleValue = newValue;
+}
+
+void ExpressionProgram::Register::setBool(bool newValue) {
+    tag = Tag::kBool;
+    boolValue = newValue;
+}
+
+long long ExpressionProgram::Register::coerceToLong() const {
+    switch (tag) {
+        case Tag::kInt:
+            return static_cast<long long>(intValue);
+        case Tag::kLong:
+            return longValue;
+        case Tag::kDouble:
+            return static_cast<long long>(doubleValue);
+        default:
+            MONGO_UNREACHABLE;
+    }
+}
+
+double ExpressionProgram::Register::coerceToDouble() const {
+    switch (tag) {
+        case Tag::kInt:
+            return static_cast<double>(intValue);
+        case Tag::kLong:
+            return static_cast<double>(longValue);
+        case Tag::kDouble:
+            return doubleValue;
+        default:
+            MONGO_UNREACHABLE;
+    }
+}
+
+Value ExpressionProgram::Register::box() const {
+    switch (tag) {
+        case Tag::kInt:
+            return Value(intValue);
+        case Tag::kLong:
+            return Value(longValue);
+        case Tag::kDouble:
+            return Value(doubleValue);
+        case Tag::kBool:
+            return Value(boolValue);
+        case Tag::kValue:
+            return value;
+    }
+    MONGO_UNREACHABLE;
+}
+
+size_t ExpressionProgram::addOutput(const intrusive_ptr<Expression>& expression) {
+    return compile(expression);
+}
+
+size_t ExpressionProgram::compile(const intrusive_ptr<Expression>& expression) {
+    // Two subexpressions with the same serialization compute the same value for the same root.
+    // Serializing to BSON, rather than comparing Values, keeps constants of different numeric types
+    // apart.
+    BSONObjBuilder keyBuilder;
+    expression->serialize(false).addToBsonObj(&keyBuilder, "");
+    BSONObj keyObj = keyBuilder.done();
+    std::string key(keyObj.objdata(), keyObj.objsize());
+
+    auto existing = _registersBySubexpression.find(key);
+    if (existing != _registersBySubexpression.end()) {
+        ++_instructions[existing->second].numUses;
+        return existing->second;
+    }
+
+    Instruction instruction;
+    instruction.expression = expression;
+    instruction.numUses = 1;
+
+    const ExpressionNary* nary = nullptr;
+    if (dynamic_cast<ExpressionConstant*>(expression.get())) {
+        instruction.op = Op::kConstant;
+    } else if ((nary = dynamic_cast<ExpressionAdd*>(expression.get()))) {
+        instruction.op = Op::kAdd;
+    } else if ((nary = dynamic_cast<ExpressionSubtract*>(expression.get()))) {
+        instruction.op = Op::kSubtract;
+    } else if ((nary = dynamic_cast<ExpressionMultiply*>(expression.get()))) {
+        instruction.op = Op::kMultiply;
+    } else if ((nary = dynamic_cast<ExpressionDivide*>(expression.get()))) {
+        instruction.op = Op::kDivide;
+    } else if (auto compare = dynamic_cast<ExpressionCompare*>(expression.get())) {
+        nary = compare;
+        instruction.op = Op::kCompare;
+        instruction.cmpOp = compare->getOp();
+    } else if ((nary = dynamic_cast<ExpressionCond*>(expression.get()))) {
+        instruction.op = Op::kCond;
+    } else {
+        instruction.op = Op::kEvaluate;
+    }
+
+    if (nary) {
+        for (auto&& operand : nary->getOperandList()) {
+            instruction.operands.push_back(compile(operand));
+        }
+    }
+
+    const size_t reg = _instructions.size();
+    _instructions.push_back(std::move(instruction));
+    _registers.emplace_back();
+    _registersBySubexpression.emplace(std::move(key), reg);
+
+    if (_instructions[reg].op == Op::kConstant) {
+        _registers[reg].setValue(
+            static_cast<ExpressionConstant*>(_instructions[reg].expression.get())->getValue());
+        _registers[reg].generation = kAlwaysValid;
+    }
+    return reg;
+}
+
+bool ExpressionProgram::isWorthRunning() const {
+    for (auto&& instruction : _instructions) {
+        if ((instruction.op != Op::kConstant && instruction.op != Op::kEvaluate) ||
+            (instruction.op == Op::kEvaluate && instruction.numUses > 1)) {
+            return true;
+        }
+    }
+    return false;
+}
+
+Value ExpressionProgram::evaluate(size_t reg, const Document& root) const {
+    return run(reg, root).box();
+}
+
+const ExpressionProgram::Register& ExpressionProgram::run(size_t reg, const Document& root) const {
+    Register& out = _registers[reg];
+    if (out.generation == _generation || out.generation == kAlwaysValid) {
+        return out;
+    }
+
+    const Instruction& instruction = _instructions[reg];
+    bool done = false;
+    switch (instruction.op) {
+        case Op::kConstant:
+        case Op::kEvaluate:
+            break;
+        case Op::kAdd:
+            done = executeAdd(instruction, &out, root);
+            break;
+        case Op::kSubtract:
+            done = executeSubtract(instruction, &out, root);
+            break;
+        case Op::kMultiply:
+            done = executeMultiply(instruction, &out, root);
+            break;
+        case Op::kDivide:
+            done = executeDivide(instruction, &out, root);
+            break;
+        case Op::kCompare:
+            done = executeCompare(instruction, &out, root);
+            break;
+        case Op::kCond: {
+            const Register& condition = run(instruction.operands[0], root);
+            bool isTrue = false;
+            switch (condition.tag) {
+                case Register::Tag::kInt:
+                    isTrue = condition.intValue;
+                    break;
+                case Register::Tag::kLong:
+                    isTrue = condition.longValue;
+                    break;
+                case Register::Tag::kDouble:
+                    isTrue = condition.doubleValue;
+                    break;
+                case Register::Tag::kBool:
+                    isTrue = condition.boolValue;
+                    break;
+                case Register::Tag::kValue:
+                    isTrue = condition.value.coerceToBool();
+                    break;
+            }
+            out = run(instruction.operands[isTrue ? 1 : 2], root);
+            done = true;
+            break;
+        }
+    }
+
+    if (!done) {
+        // Either the expression is not one we compile, or an operand was of a type the instruction
+        // does not handle. The Expression computes the value, or throws, exactly as it otherwise
+        // would have.
+        out.setValue(fallBack(instruction, root));
+    }
+    out.generation = _generation;
+    return out;
+}
+
+Value ExpressionProgram::fallBack(const Instruction& instruction, const Document& root) const {
+    // The operands the instruction computed before giving up are still in their registers, so
+    // rather than evaluating the whole subtree again, pass their values to the Expression. It asks
+    // for any operands the instruction did not reach in the order it would have evaluated them.
+    auto getOperand = [&](size_t i) { return run(instruction.operands[i], root).box(); };
+    switch (instruction.op) {
+        case Op::kAdd:
+            return ExpressionAdd::evaluateOperands(instruction.operands.size(), getOperand);
+        case Op::kMultiply:
+            return ExpressionMultiply::evaluateOperands(instruction.operands.size(), getOperand);
+        case Op::kSubtract:
+        case Op::kDivide:
+        case Op::kCompare: {
+            // Binary instructions compute both operands before checking either.
+            const Value lhs = getOperand(0);
+            const Value rhs = getOperand(1);
+            if (instruction.op == Op::kSubtract) {
+                return ExpressionSubtract::evaluateOperands(lhs, rhs);
+            } else if (instruction.op == Op::kDivide) {
+                return ExpressionDivide::evaluateOperands(lhs, rhs);
+            }
+            return static_cast<const ExpressionCompare*>(instruction.expression.get())
+                ->evaluateOperands(lhs, rhs);
+        }
+        case Op::kConstant:
+        case Op::kEvaluate:
+        case Op::kCond:
+            break;
+    }
+    return instruction.expression->evaluate(root);
+}
+
+bool ExpressionProgram::executeAdd(const Instruction& instruction,
+                                   Register* out,
+                                   const Document& root) const {
+    // Mirrors ExpressionAdd::evaluate() for ints, longs and doubles.
+    DoubleDoubleSummation total;
+    BSONType totalType = NumberInt;
+    for (auto operand : instruction.operands) {
+        const Register& val = run(operand, root);
+        switch (val.tag) {
+            case Register::Tag::kDouble:
+                total.addDouble(val.doubleValue);
+                totalType = NumberDouble;
+                break;
+            case Register::Tag::kLong:
+                total.addLong(val.longValue);
+                if (totalType == NumberInt)
+                    totalType = NumberLong;
+                break;
+            case Register::Tag::kInt:
+                total.addDouble(val.intValue);
+                break;
+            default:
+                // Dates, decimals and nulls are handled by the expression, as are the errors for
+                // any other type. We must not evaluate the remaining operands first.
+                return false;
+        }
+    }
+
+    switch (totalType) {
+        case NumberLong:
+            if (total.fitsLong()) {
+                out->setLong(total.getLong());
+                return true;
+            }
+        // Fallthrough.
+        case NumberInt:
+            if (total.fitsLong()) {
+                out->setIntOrLong(total.getLong());
+                return true;
+            }
+        // Fallthrough.
+        default:
+            out->setDouble(total.getDouble());
+            return true;
+    }
+}
+
+bool ExpressionProgram::executeSubtract(const Instruction& instruction,
+                                        Register* out,
+                                        const Document& root) const {
+    // Mirrors ExpressionSubtract::evaluate() for ints, longs and doubles.
+    const Register& lhs = run(instruction.operands[0], root);
+    const Register& rhs = run(instruction.operands[1], root);
+    if (!lhs.isNumeric() || !rhs.isNumeric()) {
+        return false;
+    }
+
+    if (lhs.tag == Register::Tag::kDouble || rhs.tag == Register::Tag::kDouble) {
+        out->setDouble(lhs.coerceToDouble() - rhs.coerceToDouble());
+    } else if (lhs.tag == Register::Tag::kLong || rhs.tag == Register::Tag::kLong) {
+        out->setLong(lhs.coerceToLong() - rhs.coerceToLong());
+    } else {
+        out->setIntOrLong(lhs.coerceToLong() - rhs.coerceToLong());
+    }
+    return true;
+}
+
+bool ExpressionProgram::executeMultiply(const Instruction& instruction,
+                                        Register* out,
+                                        const Document& root) const {
+    // Mirrors ExpressionMultiply::evaluate() for ints, longs and doubles.
+    double doubleProduct = 1;
+    long long longProduct = 1;
+    BSONType productType = NumberInt;
+    for (auto operand : instruction.operands) {
+        const Register& val = run(operand, root);
+        if (!val.isNumeric()) {
+            return false;
+        }
+
+        if (val.tag == Register::Tag::kDouble) {
+            productType = NumberDouble;
+        } else if (val.tag == Register::Tag::kLong && productType == NumberInt) {
+            productType = NumberLong;
+        }
+        doubleProduct *= val.coerceToDouble();
+        if (mongoSignedMultiplyOverflow64(longProduct, val.coerceToLong(), &longProduct)) {
+            productType = NumberDouble;
+        }
+    }
+
+    if (productType == NumberDouble) {
+        out->setDouble(doubleProduct);
+    } else if (productType == NumberLong) {
+        out->setLong(longProduct);
+    } else {
+        out->setIntOrLong(longProduct);
+    }
+    return true;
+}
+
+bool ExpressionProgram::executeDivide(const Instruction& instruction,
+                                      Register* out,
+                                      const Document& root) const {
+    // Mirrors ExpressionDivide::evaluate() for ints, longs and doubles. Division by zero is left
+    // to the expression to report.
+    const Register& lhs = run(instruction.operands[0], root);
+    const Register& rhs = run(instruction.operands[1], root);
+    if (!lhs.isNumeric() || !rhs.isNumeric()) {
+        return false;
+    }
+
+    const double denom = rhs.coerceToDouble();
+    if (denom == 0.0) {
+        return false;
+    }
+    out->setDouble(lhs.coerceToDouble() / denom);
+    return true;
+}
+
+bool ExpressionProgram::executeCompare(const Instruction& instruction,
+                                       Register* out,
+                                       const Document& root) const {
+    // Mirrors Value::compare() for two numbers or two booleans, which no collation affects.
+    const Register& lhs = run(instruction.operands[0], root);
+    const Register& rhs = run(instruction.operands[1], root);
+
+    int cmp;
+    if (lhs.tag == Register::Tag::kBool && rhs.tag == Register::Tag::kBool) {
+        cmp = lhs.boolValue - rhs.boolValue;
+    } else if (!lhs.isNumeric() || !rhs.isNumeric()) {
+        return false;
+    } else if (lhs.tag == Register::Tag::kDouble && rhs.tag == Register::Tag::kDouble) {
+        cmp = compareDoubles(lhs.doubleValue, rhs.doubleValue);
+    } else if (lhs.tag == Register::Tag::kDouble) {
+        cmp = compareDoubleToLong(lhs.doubleValue, rhs.coerceToLong());
+    } else if (rhs.tag == Register::Tag::kDouble) {
+        cmp = compareLongToDouble(lhs.coerceToLong(), rhs.doubleValue);
+    } else {
+        cmp = compareLongs(lhs.coerceToLong(), rhs.coerceToLong());
+    }
+    cmp = cmp < 0 ? -1 : (cmp > 0 ? 1 : 0);
+
+    switch (instruction.cmpOp) {
+        case ExpressionCompare::EQ:
+            out->setBool(cmp == 0);
+            break;
+        case ExpressionCompare::NE:
+            out->setBool(cmp != 0);
+            break;
+        case ExpressionCompare::GT:
+            out->setBool(cmp > 0);
+            break;
+        case ExpressionCompare::GTE:
+            out->setBool(cmp >= 0);
+            break;
+        case ExpressionCompare::LT:
+            out->setBool(cmp < 0);
+            break;
+        case ExpressionCompare::LTE:
+            out->setBool(cmp <= 0);
+            break;
+        case ExpressionCompare::CMP:
+            out->setIntOrLong(cmp);
+            break;
+    }
+    return true;
+}
+
+}  // namespace mongo
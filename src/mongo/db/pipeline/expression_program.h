@@ -0,0 +1,170 @@
+/**
+ *    Copyright (C) 2017 MongoDB Inc.
+ *
+ *    This program is free software: you can redistribute it and/or  modify
+ *    it under the terms of the GNU Affero General Public License, version 3,
+ *    as published by the Free Software Foundation.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU Affero General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Affero General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the GNU Affero General Public License in all respects for
+ *    all of the code used other than as permitted herein. If you modify file(s)
+ *    with this exception, you may extend this exception to your version of the
+ *    file(s), but you are not obligated to do so. If you do not wish to do so,
+ *    delete this exception statement from your version. If you delete this
+ *    exception statement from all source files in the program, then also delete
+ *    it in the license file.
+ */
+
+#pragma once
+
+#include <boost/intrusive_ptr.hpp>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "mongo/base/disallow_copying.h"
+#include "mongo/db/pipeline/document.h"
+#include "mongo/db/pipeline/expression.h"
+#include "mongo/db/pipeline/value.h"
+#include "mongo/stdx/unordered_map.h"
+
+namespace mongo {
+
+/**
+ * A flat program computing the values of a set of optimized Expression trees which are all
+ * evaluated against the same root document, such as the computed fields of a $project or
+ * $addFields. Each distinct subexpression becomes a single instruction writing to a register of its
+ * own, so subexpressions which appear more than once, in one tree or across several, are computed
+ * once per document.
+ *
+ * Registers hold numbers and booleans unboxed. Arithmetic, comparisons and $cond run directly on
+ * them when every operand is an int, long or double (or any value, for the condition of a $cond),
+ * producing exactly the value the Expression would have. For any other operand, the instruction
+ * falls back to the Expression's own logic, given the values of the operands it has computed,
+ * which makes both its results and its errors identical to those of the tree. Any other kind of
+ * expression is evaluated as a whole by a single instruction.
+ *
+ * Registers are computed on demand, the first time a value depends on them for a document, so that
+ * the branch $cond does not take and the operands after an $add or $multiply gives up are not
+ * evaluated, just as with the tree.
+ */
+class ExpressionProgram {
+    MONGO_DISALLOW_COPYING(ExpressionProgram);
+
+public:
+    ExpressionProgram() = default;
+
+    /**
+     * Compiles 'expression', which should already be optimized, into the program. Returns the
+     * register which will hold its value, to pass to evaluate().
+     */
+    size_t addOutput(const boost::intrusive_ptr<Expression>& expression);
+
+    /**
+     * Forgets the registers computed for the previous root document. Must be called before
+     * evaluating any outputs against a new one.
+     */
+    void startDocument() const {
+        ++_generation;
+    }
+
+    /**
+     * Returns the value of the output in register 'reg' for the document 'root'.
+     */
+    Value evaluate(size_t reg, const Document& root) const;
+
+    /**
+     * Returns whether the program does anything the Expression trees would not, that is, whether it
+     * has arithmetic, comparison or $cond instructions or computes any subexpression only once for
+     * several uses.
+     */
+    bool isWorthRunning() const;
+
+    size_t numInstructions() const {
+        return _instructions.size();
+    }
+
+private:
+    enum class Op { kConstant, kEvaluate, kAdd, kSubtract, kMultiply, kDivide, kCompare, kCond };
+
+    struct Instruction {
+        Op op;
+        boost::intrusive_ptr<Expression> expression;
+        std::vector<size_t> operands;
+        ExpressionCompare::CmpOp cmpOp = ExpressionCompare::EQ;
+        size_t numUses = 0;
+    };
+
+    struct Register {
+        enum class Tag { kValue, kInt, kLong, kDouble, kBool };
+
+        void setValue(Value newValue);
+        void setIntOrLong(long long newValue);
+        void setLong(long long newValue);
+        void setDouble(double newValue);
+        void setBool(bool newValue);
+
+        bool isNumeric() const {
+            return tag == Tag::kInt || tag == Tag::kLong || tag == Tag::kDouble;
+        }
+        long long coerceToLong() const;
+        double coerceToDouble() const;
+        Value box() const;
+
+        Tag tag = Tag::kValue;
+        union {
+            int intValue;
+            long long longValue;
+            double doubleValue;
+            bool boolValue;
+        };
+        Value value;
+
+        // The document generation this register was computed for. Constant registers never need
+        // to be recomputed.
+        uint64_t generation = 0;
+    };
+
+    static constexpr uint64_t kAlwaysValid = UINT64_MAX;
+
+    size_t compile(const boost::intrusive_ptr<Expression>& expression);
+
+    /**
+     * Returns register 'reg', computing it for 'root' if it has not been already.
+     */
+    const Register& run(size_t reg, const Document& root) const;
+
+    /**
+     * Computes the value of 'instruction' with its Expression, for when the instruction can't.
+     */
+    Value fallBack(const Instruction& instruction, const Document& root) const;
+
+    // Each execute*() returns false, leaving 'out' unset, if an operand is not one it can handle.
+    bool executeAdd(const Instruction& instruction, Register* out, const Document& root) const;
+    bool executeSubtract(const Instruction& instruction, Register* out, const Document& root) const;
+    bool executeMultiply(const Instruction& instruction, Register* out, const Document& root) const;
+    bool executeDivide(const Instruction& instruction, Register* out, const Document& root) const;
+    bool executeCompare(const Instruction& instruction, Register* out, const Document& root) const;
+
+    std::vector<Instruction> _instructions;
+
+    // Maps the serialized form of each compiled subexpression to its register.
+    stdx::unordered_map<std::string, size_t> _registersBySubexpression;
+
+    // One register per instruction, reused from one document to the next.
+    mutable std::vector<Register> _registers;
+    mutable uint64_t _generation = 1;
+};
+
+}  // namespace mongo
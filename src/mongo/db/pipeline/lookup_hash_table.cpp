@@ -0,0 +1,147 @@
+/**
+ *    Copyright (C) 2017 MongoDB Inc.
+ *
+ *    This program is free software: you can redistribute it and/or  modify
+ *    it under the terms of the GNU Affero General Public License, version 3,
+ *    as published by the Free Software Foundation.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU Affero General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Affero General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the GNU Affero General Public License in all respects for
+ *    all of the code used other than as permitted herein. If you modify file(s)
+ *    with this exception, you may extend this exception to your version of the
+ *    file(s), but you are not obligated to do so. If you do not wish to do so,
+ *    delete this exception statement from your version. If you delete this
+ *    exception statement from all source files in the program, then also delete
+ *    it in the license file.
+ */
+
+#include "mongo/platform/basic.h"
+
+#include "mongo/db/pipeline/lookup_hash_table.h"
+
+#include <algorithm>
+#include <cctype>
+#include <numeric>
+
+#include "mongo/db/matcher/expression.h"
+#include "mongo/db/pipeline/document_path_support.h"
+
+namespace mongo {
+
+namespace {
+
+// An estimate of the memory taken by each entry in a bucket of the hash table, beyond the size of
+// the value itself.
+const size_t kBucketEntryOverheadBytes = sizeof(Value) + sizeof(size_t);
+
+/**
+ * Returns whether documents matching {<foreignField>: {$eq: 'localValue'}} may hold no value equal
+ * to 'localValue' at 'foreignField'.
+ */
+bool matchesWithoutEqualValue(const Value& localValue) {
+    return localValue.nullish() || localValue.isArray();
+}
+
+}  // namespace
+
+bool LookupHashTable::canHashPath(const FieldPath& foreignField) {
+    // The first component is always treated as a field name, even if it is numeric.
+    for (size_t i = 1; i < foreignField.getPathLength(); ++i) {
+        const auto component = foreignField.getFieldName(i);
+        if (std::all_of(component.begin(), component.end(), [](char c) {
+                return std::isdigit(static_cast<unsigned char>(c));
+            })) {
+            return false;
+        }
+    }
+    return true;
+}
+
+LookupHashTable::LookupHashTable(const ValueComparator& comparator,
+                                 FieldPath foreignField,
+                                 size_t maxSizeBytes)
+    : _foreignField(std::move(foreignField)),
+      _maxSizeBytes(maxSizeBytes),
+      _positionsByValue(comparator.makeUnorderedValueMap<std::vector<size_t>>()) {}
+
+bool LookupHashTable::add(const Document& doc) {
+    auto obj = doc.toBson();
+
+    std::vector<Value> foreignValues;
+    size_t sizeBytes = obj.objsize();
+    document_path_support::visitAllValuesAtPath(
+        doc, _foreignField, [&](const Value& foreignValue) {
+            foreignValues.push_back(foreignValue);
+            sizeBytes += foreignValue.getApproximateSize() + kBucketEntryOverheadBytes;
+        });
+
+    if (_sizeBytes + sizeBytes > _maxSizeBytes) {
+        return false;
+    }
+
+    const size_t position = _documents.size();
+    _documents.push_back(std::move(obj));
+    _sizeBytes += sizeBytes;
+
+    for (auto&& foreignValue : foreignValues) {
+        auto& positions = _positionsByValue[foreignValue];
+        // An array holding the same value twice puts the document in its bucket only once.
+        if (positions.empty() || positions.back() != position) {
+            positions.push_back(position);
+        }
+    }
+    return true;
+}
+
+std::vector<Document> LookupHashTable::probe(const std::vector<Value>& localValues,
+                                             const MatchExpression& joinPredicate) const {
+    std::vector<size_t> candidates;
+    const bool probeAll = std::any_of(localValues.begin(), localValues.end(), [](const Value& v) {
+        return matchesWithoutEqualValue(v);
+    });
+
+    if (probeAll) {
+        candidates.resize(_documents.size());
+        std::iota(candidates.begin(), candidates.end(), 0);
+    } else {
+        for (auto&& localValue : localValues) {
+            auto it = _positionsByValue.find(localValue);
+            if (it != _positionsByValue.end()) {
+                candidates.insert(candidates.end(), it->second.begin(), it->second.end());
+            }
+        }
+
+        // A document may be in the buckets of several local values.
+        if (localValues.size() > 1) {
+            std::sort(candidates.begin(), candidates.end());
+            candidates.erase(std::unique(candidates.begin(), candidates.end()), candidates.end());
+        }
+    }
+
+    std::vector<Document> matches;
+    for (auto position : candidates) {
+        if (joinPredicate.matchesBSON(_documents[position])) {
+            matches.emplace_back(_documents[position]);
+        }
+    }
+    return matches;
+}
+
+void LookupHashTable::clear() {
+    _documents.clear();
+    _positionsByValue.clear();
+    _sizeBytes = 0;
+}
+
+}  // namespace mongo
@@ -0,0 +1,109 @@
+/**
+ *    Copyright (C) 2017 MongoDB Inc.
+ *
+ *    This program is free software: you can redistribute it and/or  modify
+ *    it under the terms of the GNU Affero General Public License, version 3,
+ *    as published by the Free Software Foundation.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU Affero General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Affero General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the GNU Affero General Public License in all respects for
+ *    all of the code used other than as permitted herein. If you modify file(s)
+ *    with this exception, you may extend this exception to your version of the
+ *    file(s), but you are not obligated to do so. If you do not wish to do so,
+ *    delete this exception statement from your version. If you delete this
+ *    exception statement from all source files in the program, then also delete
+ *    it in the license file.
+ */
+
+#pragma once
+
+#include <vector>
+
+#include "mongo/bson/bsonobj.h"
+#include "mongo/db/pipeline/document.h"
+#include "mongo/db/pipeline/field_path.h"
+#include "mongo/db/pipeline/value.h"
+#include "mongo/db/pipeline/value_comparator.h"
+
+namespace mongo {
+
+class MatchExpression;
+
+/**
+ * Holds documents from the foreign collection of a $lookup, hashed by the values they have at the
+ * 'foreignField' path, so that the matches for a local document can be found without running a
+ * query for it. The table is built up to a maximum size, past which it refuses more documents.
+ *
+ * Hashing only narrows down the candidates for a local document: a probe confirms each one against
+ * the same equality predicate the per-document query would have used, so the matches are exactly
+ * those the query would have returned. Local values which can match documents without an equal
+ * value at 'foreignField' (null, which also matches missing fields, and arrays, which also match
+ * arrays nested within arrays) make the probe consider every document in the table.
+ */
+class LookupHashTable {
+    MONGO_DISALLOW_COPYING(LookupHashTable);
+
+public:
+    /**
+     * Returns whether documents can be hashed by their values at 'foreignField'. Paths with a
+     * numeric component cannot, since a query on "a.0" also matches objects in the array "a" which
+     * have a field named "0".
+     */
+    static bool canHashPath(const FieldPath& foreignField);
+
+    /**
+     * 'comparator' determines which values hash together, and must outlive this table. It should
+     * carry the collation of the foreign pipeline.
+     */
+    LookupHashTable(const ValueComparator& comparator, FieldPath foreignField, size_t maxSizeBytes);
+
+    /**
+     * Adds 'doc' to the table. Returns false without adding it if doing so would take the table
+     * past its maximum size.
+     */
+    bool add(const Document& doc);
+
+    /**
+     * Returns the documents in the table which 'joinPredicate' matches, in the order they were
+     * added. 'localValues' are the values the predicate joins on, as extracted from the local
+     * document's 'localField'.
+     */
+    std::vector<Document> probe(const std::vector<Value>& localValues,
+                                const MatchExpression& joinPredicate) const;
+
+    /**
+     * Removes every document from the table.
+     */
+    void clear();
+
+    size_t count() const {
+        return _documents.size();
+    }
+
+    size_t sizeBytes() const {
+        return _sizeBytes;
+    }
+
+private:
+    const FieldPath _foreignField;
+    const size_t _maxSizeBytes;
+    size_t _sizeBytes = 0;
+
+    // The documents in the order they were added, and the positions in '_documents' of those
+    // holding each value at '_foreignField'.
+    std::vector<BSONObj> _documents;
+    ValueUnorderedMap<std::vector<size_t>> _positionsByValue;
+};
+
+}  // namespace mongo
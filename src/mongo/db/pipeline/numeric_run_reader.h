@@ -0,0 +1,129 @@
+/**
+ *    Copyright (C) 2017 MongoDB Inc.
+ *
+ *    This program is free software: you can redistribute it and/or  modify
+ *    it under the terms of the GNU Affero General Public License, version 3,
+ *    as published by the Free Software Foundation.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU Affero General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Affero General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the GNU Affero General Public License in all respects for
+ *    all of the code used other than as permitted herein. If you modify file(s)
+ *    with this exception, you may extend this exception to your version of the
+ *    file(s), but you are not obligated to do so. If you do not wish to do so,
+ *    delete this exception statement from your version. If you delete this
+ *    exception statement from all source files in the program, then also delete
+ *    it in the license file.
+ */
+
+#pragma once
+
+#include <array>
+#include <cstddef>
+
+#include "mongo/bson/bsontypes.h"
+#include "mongo/db/pipeline/value.h"
+
+namespace mongo {
+
+/**
+ * Splits a sequence of accumulator inputs into runs of consecutive numbers of a single type,
+ * unboxed into a dense array, so that an accumulator can process each run with a tight loop rather
+ * than one Value at a time. Inputs other than ints, longs and doubles are returned one at a time.
+ */
+class NumericRunReader {
+public:
+    static constexpr size_t kMaxRunLength = 256;
+
+    NumericRunReader(const Value* inputs, size_t count) : _next(inputs), _end(inputs + count) {}
+
+    /**
+     * Advances to the next run, returning false once the inputs are exhausted.
+     */
+    bool next() {
+        if (_next == _end) {
+            return false;
+        }
+
+        _type = _next->getType();
+        _size = 0;
+        switch (_type) {
+            case NumberDouble:
+                for (; _next != _end && _size < kMaxRunLength && _next->getType() == NumberDouble;
+                     ++_next) {
+                    _doubles[_size++] = _next->getDouble();
+                }
+                break;
+            case NumberInt:
+                for (; _next != _end && _size < kMaxRunLength && _next->getType() == NumberInt;
+                     ++_next) {
+                    _longs[_size++] = _next->getInt();
+                }
+                break;
+            case NumberLong:
+                for (; _next != _end && _size < kMaxRunLength && _next->getType() == NumberLong;
+                     ++_next) {
+                    _longs[_size++] = _next->getLong();
+                }
+                break;
+            default:
+                _other = _next++;
+                _size = 1;
+        }
+        return true;
+    }
+
+    /**
+     * The type of every input in the current run.
+     */
+    BSONType type() const {
+        return _type;
+    }
+
+    size_t size() const {
+        return _size;
+    }
+
+    /**
+     * The values of a run of NumberDouble inputs.
+     */
+    const double* doubles() const {
+        return _doubles.data();
+    }
+
+    /**
+     * The values of a run of NumberInt or NumberLong inputs.
+     */
+    const long long* longs() const {
+        return _longs.data();
+    }
+
+    /**
+     * The input, when the current run is of a single input of any other type.
+     */
+    const Value& other() const {
+        return *_other;
+    }
+
+private:
+    const Value* _next;
+    const Value* const _end;
+
+    BSONType _type = EOO;
+    size_t _size = 0;
+    std::array<double, kMaxRunLength> _doubles;
+    std::array<long long, kMaxRunLength> _longs;
+    const Value* _other = nullptr;
+};
+
+}  // namespace mongo
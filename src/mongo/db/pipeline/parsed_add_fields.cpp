@@ -83,6 +83,9 @@ void ParsedAddFields::parse(const BSONObj& spec) {
 Document ParsedAddFields::applyProjection(const Document& inputDoc) const {
     // The output doc is the same as the input doc, with the added fields.
     MutableDocument output(inputDoc);
+    if (_program) {
+        _program->startDocument();
+    }
     _root->addComputedFields(&output, inputDoc);
 
     // Pass through the metadata.
@@ -82,6 +82,7 @@ public:
      */
     void optimize() final {
         _root->optimize();
+        _program = _root->compileComputedFields();
     }
 
     DocumentSource::GetDepsReturn addDependencies(DepsTracker* deps) const final {
@@ -135,6 +136,9 @@ private:
 
     // The InclusionNode tree does most of the execution work once constructed.
     std::unique_ptr<InclusionNode> _root;
+
+    // The program evaluating the computed fields of '_root', once they have been compiled.
+    std::unique_ptr<ExpressionProgram> _program;
 };
 }  // namespace parsed_aggregation_projection
 }  // namespace mongo
@@ -32,6 +32,8 @@
 
 #include <algorithm>
 
+#include "mongo/db/query/query_knobs.h"
+
 namespace mongo {
 
 namespace parsed_aggregation_projection {
@@ -54,6 +56,30 @@ void InclusionNode::optimize() {
     }
 }
 
+std::unique_ptr<ExpressionProgram> InclusionNode::compileComputedFields() {
+    auto program = stdx::make_unique<ExpressionProgram>();
+    compileComputedFields(internalQueryCompileProjectionExpressions.load() ? program.get()
+                                                                             : nullptr);
+    if (!_program || !program->isWorthRunning()) {
+        compileComputedFields(nullptr);
+        return nullptr;
+    }
+    return program;
+}
+
+void InclusionNode::compileComputedFields(ExpressionProgram* program) {
+    _program = program;
+    _programOutputs.clear();
+    if (program) {
+        for (auto&& expressionIt : _expressions) {
+            _programOutputs[expressionIt.first] = program->addOutput(expressionIt.second);
+        }
+    }
+    for (auto&& childPair : _children) {
+        childPair.second->compileComputedFields(program);
+    }
+}
+
 void InclusionNode::serialize(MutableDocument* output,
                               boost::optional<ExplainOptions::Verbosity> explain) const {
     // Always put "_id" first if it was included (implicitly or explicitly).
@@ -148,6 +174,12 @@ void InclusionNode::addComputedFields(MutableDocument* outputDoc, const Document
             outputDoc->setField(field,
                                 childIt->second->addComputedFields(outputDoc->peek()[field], root));
         } else {
+            if (_program) {
+                auto outputIt = _programOutputs.find(field);
+                invariant(outputIt != _programOutputs.end());
+                outputDoc->setField(field, _program->evaluate(outputIt->second, root));
+                continue;
+            }
             auto expressionIt = _expressions.find(field);
             invariant(expressionIt != _expressions.end());
             outputDoc->setField(field, expressionIt->second->evaluate(root));
@@ -342,6 +374,9 @@ Document ParsedInclusionProjection::applyProjection(const Document& inputDoc) co
     // transformations have been applied.
     MutableDocument output;
     _root->applyInclusions(inputDoc, &output);
+    if (_program) {
+        _program->startDocument();
+    }
     _root->addComputedFields(&output, inputDoc);
 
     // Always pass through the metadata.
@@ -32,6 +32,7 @@
 
 #include "mongo/db/pipeline/expression.h"
 #include "mongo/db/pipeline/expression_context.h"
+#include "mongo/db/pipeline/expression_program.h"
 #include "mongo/db/pipeline/parsed_aggregation_projection.h"
 #include "mongo/stdx/memory.h"
 #include "mongo/stdx/unordered_map.h"
@@ -59,6 +60,15 @@ public:
      */
     void optimize();
 
+    /**
+     * Compiles the computed expressions of this tree, which must already be optimized, into one
+     * ExpressionProgram, which they are then evaluated by. The caller owns the program, and must
+     * call startDocument() on it before adding the computed fields for each document. Returns
+     * nullptr, leaving the expressions to be evaluated directly, if compilation is disabled or
+     * would not save any work.
+     */
+    std::unique_ptr<ExpressionProgram> compileComputedFields();
+
     /**
      * Serialize this projection.
      */
@@ -141,6 +151,12 @@ private:
     Value applyInclusionsToValue(Value inputVal) const;
     Value addComputedFields(Value inputVal, const Document& root) const;
 
+    /**
+     * Compiles the computed expressions of this node and its children into 'program'. Passing
+     * nullptr goes back to evaluating them directly.
+     */
+    void compileComputedFields(ExpressionProgram* program);
+
     /**
      * Returns nullptr if no such child exists.
      */
@@ -171,6 +187,11 @@ private:
     StringMap<boost::intrusive_ptr<Expression>> _expressions;
     stdx::unordered_set<std::string> _inclusions;
 
+    // If the computed expressions have been compiled, the program which evaluates them, and the
+    // register holding the value of each field in '_expressions'.
+    const ExpressionProgram* _program = nullptr;
+    StringMap<size_t> _programOutputs;
+
     // TODO use StringMap once SERVER-23700 is resolved.
     stdx::unordered_map<std::string, std::unique_ptr<InclusionNode>> _children;
 };
@@ -213,6 +234,7 @@ public:
      */
     void optimize() final {
         _root->optimize();
+        _program = _root->compileComputedFields();
     }
 
     DocumentSource::GetDepsReturn addDependencies(DepsTracker* deps) const final {
@@ -277,6 +299,9 @@ private:
 
     // The InclusionNode tree does most of the execution work once constructed.
     std::unique_ptr<InclusionNode> _root;
+
+    // The program evaluating the computed fields of '_root', once they have been compiled.
+    std::unique_ptr<ExpressionProgram> _program;
 };
 }  // namespace parsed_aggregation_projection
 }  // namespace mongo
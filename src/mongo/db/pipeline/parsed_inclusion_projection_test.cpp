@@ -30,6 +30,7 @@
 
 #include "mongo/db/pipeline/parsed_inclusion_projection.h"
 
+#include <limits>
 #include <vector>
 
 #include "mongo/bson/bsonmisc.h"
@@ -40,7 +41,9 @@
 #include "mongo/db/pipeline/document_value_test_util.h"
 #include "mongo/db/pipeline/expression_context_for_test.h"
 #include "mongo/db/pipeline/value.h"
+#include "mongo/db/query/query_knobs.h"
 #include "mongo/unittest/unittest.h"
+#include "mongo/util/scopeguard.h"
 
 namespace mongo {
 namespace parsed_aggregation_projection {
@@ -643,6 +646,141 @@ TEST(InclusionProjectionExecutionTest, ShouldAlwaysKeepMetadataFromOriginalDoc)
     ASSERT_DOCUMENT_EQ(result, expectedDoc.freeze());
 }
 
+//
+// Compiled computed fields.
+//
+
+/**
+ * Applies 'spec' to each of 'inputDocs' with its computed fields compiled, and again with them
+ * evaluated directly, and asserts that the results are identical, down to the types of numbers.
+ */
+void assertCompiledProjectionMatches(const BSONObj& spec, const vector<Document>& inputDocs) {
+    const auto oldCompile = internalQueryCompileProjectionExpressions.load();
+    ON_BLOCK_EXIT([oldCompile] {
+        internalQueryCompileProjectionExpressions.store(oldCompile);
+    });
+
+    const boost::intrusive_ptr<ExpressionContextForTest> expCtx(new ExpressionContextForTest());
+    internalQueryCompileProjectionExpressions.store(true);
+    ParsedInclusionProjection compiled(expCtx);
+    compiled.parse(spec);
+    compiled.optimize();
+
+    internalQueryCompileProjectionExpressions.store(false);
+    ParsedInclusionProjection interpreted(expCtx);
+    interpreted.parse(spec);
+    interpreted.optimize();
+
+    for (auto&& inputDoc : inputDocs) {
+        BSONObj expected = interpreted.applyProjection(inputDoc).toBson();
+        BSONObj result = compiled.applyProjection(inputDoc).toBson();
+        ASSERT_TRUE(result.binaryEqual(expected)) << "expected " << expected << " but got "
+                                                  << result;
+    }
+}
+
+TEST(InclusionProjectionExecutionTest, CompiledArithmeticShouldMatchExpressionResults) {
+    auto spec = fromjson(
+        "{_id: 0, sum: {$add: ['$a', '$b', 1]}, diff: {$subtract: ['$a', '$b']},"
+        "prod: {$multiply: ['$a', '$b', 2]}, quot: {$divide: [{$add: ['$a', '$b', 1]}, '$c']},"
+        "cmp: {$cmp: ['$a', '$b']}, gt: {$gt: [{$add: ['$a', '$b', 1]}, '$c']},"
+        "big: {$cond: [{$lte: ['$a', '$b']}, {$multiply: ['$a', '$a']}, '$b']}}");
+    vector<Document> inputDocs{
+        Document{{"a", 1}, {"b", 2}, {"c", 3}},
+        Document{{"a", std::numeric_limits<int>::max()}, {"b", 1}, {"c", 0.5}},
+        Document{{"a", 3LL}, {"b", 4}, {"c", 2LL}},
+        Document{{"a", std::numeric_limits<long long>::max()}, {"b", 1LL}, {"c", 7}},
+        Document{{"a", std::numeric_limits<long long>::max()}, {"b", 0.5}, {"c", 7}},
+        Document{{"a", 0.1}, {"b", 0.2}, {"c", 0.3}},
+        Document{{"a", std::numeric_limits<double>::quiet_NaN()}, {"b", 1}, {"c", 1}},
+        Document{{"a", 1LL << 62}, {"b", 1LL << 62}, {"c", -1}},
+        Document{{"a", Decimal128("1.5")}, {"b", 2}, {"c", 3}},
+        Document{{"a", BSONNULL}, {"b", 2}, {"c", 3}},
+        Document{{"b", 2}, {"c", 3}}};
+    assertCompiledProjectionMatches(spec, inputDocs);
+}
+
+TEST(InclusionProjectionExecutionTest, CompiledComparisonsShouldMatchExpressionResults) {
+    auto spec = fromjson(
+        "{_id: 0, cmp: {$cmp: ['$a', '$b']}, lt: {$lt: ['$a', '$b']}, ne: {$ne: ['$a', '$b']},"
+        "diff: {$cond: [{$eq: ['$a', '$b']}, 'same', {$subtract: ['$a', '$b']}]}}");
+    vector<Document> inputDocs{
+        Document{{"a", true}, {"b", false}},
+        Document{{"a", 2}, {"b", 1LL}},
+        Document{{"a", 1}, {"b", 1.0}},
+        Document{{"a", (1LL << 53) + 1}, {"b", static_cast<double>(1LL << 53)}},
+        Document{{"a", std::numeric_limits<double>::quiet_NaN()}, {"b", 0LL}},
+        Document{{"a", Date_t::fromMillisSinceEpoch(1000)}, {"b", 2}},
+        Document{{"a", Date_t::fromMillisSinceEpoch(1000)},
+                 {"b", Date_t::fromMillisSinceEpoch(10)}},
+        Document{{"a", "x"_sd}, {"b", "x"_sd}}};
+    assertCompiledProjectionMatches(spec, inputDocs);
+}
+
+TEST(InclusionProjectionExecutionTest, CompiledFieldsShouldBeRecomputedForEachDocument) {
+    auto spec = fromjson("{x: {$add: ['$a', 1]}, y: {$multiply: [{$add: ['$a', 1]}, 2]}}");
+    vector<Document> inputDocs{Document{{"_id", 0}, {"a", 1}}, Document{{"_id", 1}, {"a", 5}}};
+    assertCompiledProjectionMatches(spec, inputDocs);
+}
+
+TEST(InclusionProjectionExecutionTest, CompiledFieldsShouldBeAddedToEachArrayElement) {
+    auto spec = fromjson("{'a.b': {$add: ['$c', 1]}, 'a.d': {$gt: [{$add: ['$c', 1]}, 2]}}");
+    vector<Document> inputDocs{Document{{"a", vector<Value>{Value(Document{}), Value(2)}},
+                                        {"c", 2}}};
+    assertCompiledProjectionMatches(spec, inputDocs);
+}
+
+TEST(InclusionProjectionExecutionTest, CompiledCondShouldNotEvaluateBranchNotTaken) {
+    const boost::intrusive_ptr<ExpressionContextForTest> expCtx(new ExpressionContextForTest());
+    ParsedInclusionProjection inclusion(expCtx);
+    inclusion.parse(fromjson(
+        "{_id: 0, q: {$cond: [{$eq: ['$b', 0]}, 0, {$divide: ['$a', '$b']}]},"
+        "r: {$add: ['$b', {$cond: [{$eq: ['$b', 0]}, 0, {$divide: ['$a', '$b']}]}]}}"));
+    inclusion.optimize();
+
+    auto result = inclusion.applyProjection(Document{{"a", 6}, {"b", 0}});
+    ASSERT_DOCUMENT_EQ(result, (Document{{"q", 0}, {"r", 0}}));
+
+    result = inclusion.applyProjection(Document{{"a", 6}, {"b", 3}});
+    ASSERT_DOCUMENT_EQ(result, (Document{{"q", 2.0}, {"r", 5.0}}));
+}
+
+TEST(InclusionProjectionExecutionTest, CompiledFieldsShouldThrowSameErrorsAsExpressions) {
+    const boost::intrusive_ptr<ExpressionContextForTest> expCtx(new ExpressionContextForTest());
+    ParsedInclusionProjection inclusion(expCtx);
+    inclusion.parse(fromjson("{q: {$divide: [{$add: ['$a', 1]}, '$b']}}"));
+    inclusion.optimize();
+
+    ASSERT_THROWS_CODE(inclusion.applyProjection(Document{{"a", 1}, {"b", 0}}),
+                       AssertionException,
+                       16608);
+    ASSERT_THROWS_CODE(inclusion.applyProjection(Document{{"a", "str"_sd}, {"b", 1}}),
+                       AssertionException,
+                       16554);
+    ASSERT_DOCUMENT_EQ(inclusion.applyProjection(Document{{"a", 1}, {"b", 4}}),
+                       (Document{{"q", 0.5}}));
+}
+
+TEST(InclusionProjectionExecutionTest, CompiledFallbackShouldOnlyEvaluateOperandsExpressionWould) {
+    const boost::intrusive_ptr<ExpressionContextForTest> expCtx(new ExpressionContextForTest());
+    ParsedInclusionProjection inclusion(expCtx);
+    inclusion.parse(fromjson("{_id: 0, s: {$add: ['$a', {$divide: [1, '$b']}]}}"));
+    inclusion.optimize();
+
+    // A null operand ends the $add before it reaches the $divide, which would throw.
+    ASSERT_DOCUMENT_EQ(inclusion.applyProjection(Document{{"a", BSONNULL}, {"b", 0}}),
+                       (Document{{"s", BSONNULL}}));
+
+    // A date doesn't, so the $divide is evaluated after the $add gives up on the date.
+    ASSERT_THROWS_CODE(
+        inclusion.applyProjection(Document{{"a", Date_t::fromMillisSinceEpoch(0)}, {"b", 0}}),
+        AssertionException,
+        16608);
+    ASSERT_DOCUMENT_EQ(
+        inclusion.applyProjection(Document{{"a", Date_t::fromMillisSinceEpoch(0)}, {"b", 1}}),
+        (Document{{"s", Date_t::fromMillisSinceEpoch(1)}}));
+}
+
 //
 // Detection of subset projection.
 //
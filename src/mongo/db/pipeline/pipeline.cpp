@@ -358,6 +358,33 @@ void Pipeline::unsplitFromSharded(
     stitch();
 }
 
+void Pipeline::unsplitFromShards(std::unique_ptr<Pipeline, Pipeline::Deleter> pipelineForShards) {
+    invariant(pipelineForShards);
+    invariant(pipelineForShards->_unsplitSources);
+
+    // Take the original source list before the shards part, which holds it, goes away.
+    SourceContainer unsplitSources = std::move(*pipelineForShards->_unsplitSources);
+    detachFromShards(std::move(pipelineForShards));
+
+    _sources = std::move(unsplitSources);
+    stitch();
+}
+
+void Pipeline::detachFromShards(std::unique_ptr<Pipeline, Pipeline::Deleter> pipelineForShards) {
+    invariant(isSplitForMerge());
+    invariant(pipelineForShards);
+    invariant(pipelineForShards->isSplitForShards());
+
+    // Clear the shards' source list so that destroying the pipeline object won't dispose of the
+    // stages. They may still be referenced from this pipeline, or read from a source of its own.
+    pipelineForShards->_sources.clear();
+    pipelineForShards.reset();
+
+    _splitState = SplitState::kUnsplit;
+
+    stitch();
+}
+
 void Pipeline::Optimizations::Sharded::findSplitPoint(Pipeline* shardPipe, Pipeline* mergePipe) {
     while (!mergePipe->_sources.empty()) {
         intrusive_ptr<DocumentSource> current = mergePipe->_sources.front();
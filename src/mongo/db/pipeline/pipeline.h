@@ -209,6 +209,22 @@ public:
      */
     void unsplitFromSharded(std::unique_ptr<Pipeline, Pipeline::Deleter> pipelineForMergingShard);
 
+    /**
+     * Reassemble a split merge pipeline into its original form, for callers which split a pipeline
+     * but then run it unsplit. Upon return, this pipeline will contain the original source list.
+     * Must be called on the merge part of a split pipeline, with the shards part returned by the
+     * call to splitForSharded(), which is destroyed without disposing of its stages.
+     */
+    void unsplitFromShards(std::unique_ptr<Pipeline, Pipeline::Deleter> pipelineForShards);
+
+    /**
+     * Turns the merge part of a split pipeline into an unsplit pipeline of just the merging stages,
+     * for callers which run the shards part some other way, such as on worker threads. Must be
+     * called with the shards part returned by the call to splitForSharded(), which is destroyed
+     * without disposing of its stages.
+     */
+    void detachFromShards(std::unique_ptr<Pipeline, Pipeline::Deleter> pipelineForShards);
+
     /**
      * Returns true if this pipeline has not been split.
      */
@@ -55,6 +55,7 @@
 #include "mongo/db/pipeline/document_source.h"
 #include "mongo/db/pipeline/document_source_change_stream.h"
 #include "mongo/db/pipeline/document_source_cursor.h"
+#include "mongo/db/pipeline/document_source_exchange.h"
 #include "mongo/db/pipeline/document_source_match.h"
 #include "mongo/db/pipeline/document_source_merge_cursors.h"
 #include "mongo/db/pipeline/document_source_sample.h"
@@ -65,6 +66,7 @@
 #include "mongo/db/query/collation/collator_interface.h"
 #include "mongo/db/query/get_executor.h"
 #include "mongo/db/query/plan_summary_stats.h"
+#include "mongo/db/query/query_knobs.h"
 #include "mongo/db/query/query_planner.h"
 #include "mongo/db/s/collection_metadata.h"
 #include "mongo/db/s/collection_sharding_state.h"
@@ -700,6 +702,50 @@ void PipelineD::prepareCursorSource(Collection* collection,
         collection, pipeline, expCtx, std::move(exec), deps, queryObj, sortObj, projForQuery);
 }
 
+void PipelineD::addExchangeIfParallelizable(Pipeline* pipeline) {
+    const int numWorkers = internalDocumentSourceExchangeWorkers.load();
+    const int batchSize = internalDocumentSourceExchangeBatchSize.load();
+    if (numWorkers <= 1 || batchSize <= 0) {
+        return;
+    }
+
+    auto expCtx = pipeline->getContext();
+    if (expCtx->explain || expCtx->needsMerge || expCtx->inMongos || expCtx->subPipelineDepth > 0 ||
+        expCtx->tailableMode != TailableMode::kNormal) {
+        return;
+    }
+
+    const auto& sources = pipeline->getSources();
+    if (sources.size() < 2 || !dynamic_cast<DocumentSourceCursor*>(sources.front().get())) {
+        return;
+    }
+
+    // Split the stages after the cursor as if the collection were sharded. The cursor stays on the
+    // thread serving the aggregation, which holds the collection's lock while reading from it.
+    auto cursorStage = pipeline->popFrontWithCriteria(sources.front()->getSourceName());
+    auto shardPipeline = pipeline->splitForSharded();
+
+    const auto& shardSources = shardPipeline->getSources();
+    const bool parallelizable = !shardSources.empty() &&
+        std::all_of(shardSources.begin(), shardSources.end(), [](const auto& stage) {
+            return DocumentSourceExchange::canRunOnWorkers(*stage);
+        });
+
+    if (parallelizable) {
+        // The shards' part is only needed in serialized form, to be parsed again by each worker.
+        std::vector<BSONObj> workerPipeline;
+        for (auto&& stage : shardPipeline->serialize()) {
+            workerPipeline.push_back(stage.getDocument().toBson());
+        }
+        pipeline->detachFromShards(std::move(shardPipeline));
+        pipeline->addInitialSource(
+            DocumentSourceExchange::create(expCtx, workerPipeline, numWorkers, batchSize));
+    } else {
+        pipeline->unsplitFromShards(std::move(shardPipeline));
+    }
+    pipeline->addInitialSource(cursorStage);
+}
+
 StatusWith<std::unique_ptr<PlanExecutor, PlanExecutor::Deleter>> PipelineD::prepareExecutor(
     OperationContext* opCtx,
     Collection* collection,
@@ -78,6 +78,16 @@ public:
                                     const AggregationRequest* aggRequest,
                                     Pipeline* pipeline);
 
+    /**
+     * If the pipeline reads from a DocumentSourceCursor and the part of it which would run on the
+     * shards, were the collection sharded, can run on worker threads, replaces that part with a
+     * DocumentSourceExchange running it on 'internalDocumentSourceExchangeWorkers' threads. The
+     * rest of the pipeline merges the workers' results as it would the shards'.
+     *
+     * Must be called once the pipeline has been optimized and its cursor source added.
+     */
+    static void addExchangeIfParallelizable(Pipeline* pipeline);
+
     /**
      * Injects a MongodInterface into stages which require access to mongod-specific functionality.
      */
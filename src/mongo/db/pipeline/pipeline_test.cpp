@@ -1631,6 +1631,17 @@ public:
         ASSERT_VALUE_EQ(Value(shardPipe->serialize()), beforeSplit);
 
         mergePipe = std::move(shardPipe);
+
+        // Test that the pipeline can also be reassembled from its merge part.
+        shardPipe = mergePipe->splitForSharded();
+        ASSERT(shardPipe);
+
+        mergePipe->unsplitFromShards(std::move(shardPipe));
+        ASSERT_FALSE(shardPipe);
+        ASSERT_TRUE(mergePipe->isUnsplit());
+
+        ASSERT_VALUE_EQ(Value(mergePipe->serialize()), beforeSplit);
+
         shardPipe = mergePipe->splitForSharded();
         ASSERT(shardPipe);
 
@@ -0,0 +1,349 @@
+/**
+ *    Copyright (C) 2017 MongoDB Inc.
+ *
+ *    This program is free software: you can redistribute it and/or  modify
+ *    it under the terms of the GNU Affero General Public License, version 3,
+ *    as published by the Free Software Foundation.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU Affero General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Affero General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the GNU Affero General Public License in all respects for
+ *    all of the code used other than as permitted herein. If you modify file(s)
+ *    with this exception, you may extend this exception to your version of the
+ *    file(s), but you are not obligated to do so. If you do not wish to do so,
+ *    delete this exception statement from your version. If you delete this
+ *    exception statement from all source files in the program, then also delete
+ *    it in the license file.
+ */
+
+#define MONGO_LOG_DEFAULT_COMPONENT ::mongo::logger::LogComponent::kQuery
+
+#include "mongo/platform/basic.h"
+
+#include "mongo/db/plan_cache_checkpoint.h"
+
+#include <algorithm>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "mongo/base/counter.h"
+#include "mongo/db/auth/authorization_session.h"
+#include "mongo/db/catalog/catalog_raii.h"
+#include "mongo/db/catalog/collection.h"
+#include "mongo/db/catalog/collection_info_cache.h"
+#include "mongo/db/catalog/database.h"
+#include "mongo/db/client.h"
+#include "mongo/db/commands/server_status_metric.h"
+#include "mongo/db/concurrency/write_conflict_exception.h"
+#include "mongo/db/db_raii.h"
+#include "mongo/db/matcher/extensions_callback_real.h"
+#include "mongo/db/namespace_string.h"
+#include "mongo/db/query/canonical_query.h"
+#include "mongo/db/query/get_executor.h"
+#include "mongo/db/query/internal_plans.h"
+#include "mongo/db/query/plan_cache.h"
+#include "mongo/db/query/plan_ranker.h"
+#include "mongo/db/query/query_knobs.h"
+#include "mongo/db/query/query_solution.h"
+#include "mongo/db/storage/storage_engine.h"
+#include "mongo/util/background.h"
+#include "mongo/util/concurrency/idle_thread_block.h"
+#include "mongo/util/exit.h"
+#include "mongo/util/log.h"
+
+namespace mongo {
+namespace {
+
+const NamespaceString kCheckpointNss("local.planCacheCheckpoint");
+
+// The number of entries written to the checkpoint collection per write unit.
+const size_t kCheckpointBatchSize = 100;
+
+Counter64 planCacheCheckpoints;
+Counter64 planCacheEntriesRestored;
+
+ServerStatusMetricField<Counter64> displayPlanCacheCheckpoints("query.planCache.checkpoints",
+                                                               &planCacheCheckpoints);
+ServerStatusMetricField<Counter64> displayPlanCacheEntriesRestored(
+    "query.planCache.entriesRestored", &planCacheEntriesRestored);
+
+/**
+ * Returns the checkpoint document recording 'entry', cached for the collection 'nss'. Only the
+ * winning plan is recorded.
+ */
+BSONObj entryToBSON(const NamespaceString& nss, const PlanCacheEntry& entry) {
+    BSONObjBuilder bob;
+    bob.append("_id", OID::gen());
+    bob.append("ns", nss.ns());
+    bob.append("query", entry.query);
+    bob.append("sort", entry.sort);
+    bob.append("projection", entry.projection);
+    bob.append("collation", entry.collation);
+    bob.append("works", static_cast<long long>(entry.decision->stats[0]->common.works));
+    if (entry.selectivityBucket) {
+        bob.append("selectivityBucket", *entry.selectivityBucket);
+    }
+    bob.append("timeOfCreation", entry.timeOfCreation);
+    bob.append("solution", entry.plannerData[0]->toBSON());
+    return bob.obj();
+}
+
+/**
+ * Adds the entry recorded in the checkpoint document 'doc' to the plan cache of its collection.
+ * Returns an error if the entry no longer applies, for instance because its collection or one of
+ * the indexes its plan uses has been dropped.
+ */
+Status restoreEntry(OperationContext* opCtx, const BSONObj& doc) {
+    const NamespaceString nss(doc.getStringField("ns"));
+    AutoGetCollectionForRead autoColl(opCtx, nss);
+    Collection* collection = autoColl.getCollection();
+    if (!collection) {
+        return Status(ErrorCodes::NamespaceNotFound,
+                      str::stream() << "collection " << nss.ns() << " no longer exists");
+    }
+
+    auto qr = stdx::make_unique<QueryRequest>(nss);
+    qr->setFilter(doc.getObjectField("query").getOwned());
+    qr->setSort(doc.getObjectField("sort").getOwned());
+    qr->setProj(doc.getObjectField("projection").getOwned());
+    qr->setCollation(doc.getObjectField("collation").getOwned());
+    auto statusWithCQ = CanonicalQuery::canonicalize(
+        opCtx, std::move(qr), nullptr, ExtensionsCallbackReal(opCtx, &nss));
+    if (!statusWithCQ.isOK()) {
+        return statusWithCQ.getStatus();
+    }
+    std::unique_ptr<CanonicalQuery> cq = std::move(statusWithCQ.getValue());
+    if (!PlanCache::shouldCacheQuery(*cq)) {
+        return Status(ErrorCodes::BadValue, "query is not cacheable");
+    }
+
+    // Resolve the indexes of the plan against those the collection has now.
+    QueryPlannerParams plannerParams;
+    fillOutPlannerParams(opCtx, collection, cq.get(), &plannerParams);
+    auto cacheData =
+        SolutionCacheData::fromBSON(doc.getObjectField("solution"), plannerParams.indices);
+    if (!cacheData.isOK()) {
+        return cacheData.getStatus();
+    }
+
+    // Index filters aren't persisted, so a plan chosen under one no longer applies.
+    if (cacheData.getValue()->indexFilterApplied) {
+        return Status(ErrorCodes::BadValue, "plan was chosen under an index filter");
+    }
+
+    QuerySolution soln;
+    soln.cacheData = std::move(cacheData.getValue());
+
+    // The CachedPlanStage compares the works of a cached plan with those it took to choose it in
+    // order to decide whether to replan, so those are kept as the only stats of the decision.
+    auto stats = stdx::make_unique<PlanStageStats>(CommonStats("CACHED_PLAN"), STAGE_CACHED_PLAN);
+    stats->common.works = doc["works"].numberLong();
+    auto decision = stdx::make_unique<PlanRankingDecision>();
+    decision->stats.push_back(std::move(stats));
+    decision->scores.push_back(0);
+    decision->candidateOrder.push_back(0);
+
+    auto entry = stdx::make_unique<PlanCacheEntry>(std::vector<QuerySolution*>{&soln},
+                                                   decision.release());
+    entry->query = cq->getQueryRequest().getFilter().getOwned();
+    entry->sort = cq->getQueryRequest().getSort().getOwned();
+    entry->projection = cq->getQueryRequest().getProj().getOwned();
+    entry->collation = cq->getQueryRequest().getCollation().getOwned();
+    entry->timeOfCreation = doc["timeOfCreation"].date();
+    if (doc.hasField("selectivityBucket")) {
+        entry->selectivityBucket = doc["selectivityBucket"].numberInt();
+    }
+
+    return collection->infoCache()->getPlanCache()->restore(*cq, entry.release());
+}
+
+class PlanCacheCheckpointJob : public BackgroundJob {
+public:
+    std::string name() const override {
+        return "PlanCacheCheckpoint";
+    }
+
+    void run() override {
+        Client::initThread(name().c_str());
+        AuthorizationSession::get(cc())->grantInternalAuthorization();
+
+        if (internalQueryCacheCheckpointIntervalSecs.load() > 0) {
+            try {
+                restore();
+            } catch (const DBException& ex) {
+                warning() << "Failed to restore the plan cache checkpoint: "
+                          << redact(ex.toStatus());
+            }
+        }
+
+        while (!globalInShutdownDeprecated()) {
+            const int intervalSecs = internalQueryCacheCheckpointIntervalSecs.load();
+            {
+                MONGO_IDLE_THREAD_BLOCK;
+                sleepsecs(std::max(1, intervalSecs));
+            }
+
+            if (intervalSecs <= 0 || globalInShutdownDeprecated()) {
+                continue;
+            }
+
+            try {
+                checkpoint();
+            } catch (const DBException& ex) {
+                warning() << "Failed to checkpoint the plan cache: " << redact(ex.toStatus());
+            }
+        }
+    }
+
+private:
+    void restore() {
+        const ServiceContext::UniqueOperationContext opCtx = cc().makeOperationContext();
+
+        std::vector<BSONObj> docs;
+        {
+            AutoGetCollectionForRead autoColl(opCtx.get(), kCheckpointNss);
+            Collection* collection = autoColl.getCollection();
+            if (!collection) {
+                return;
+            }
+
+            auto exec = InternalPlanner::collectionScan(
+                opCtx.get(), kCheckpointNss.ns(), collection, PlanExecutor::NO_YIELD);
+            BSONObj doc;
+            while (PlanExecutor::ADVANCED == exec->getNext(&doc, nullptr)) {
+                docs.push_back(doc.getOwned());
+            }
+        }
+
+        // Entries are revalidated against the current catalog one at a time, and those which no
+        // longer apply are skipped.
+        long long restored = 0;
+        for (const BSONObj& doc : docs) {
+            Status status = Status::OK();
+            try {
+                status = restoreEntry(opCtx.get(), doc);
+            } catch (const DBException& ex) {
+                status = ex.toStatus();
+            }
+
+            if (status.isOK()) {
+                ++restored;
+            } else {
+                LOG(2) << "Not restoring plan cache entry " << redact(doc) << ": "
+                       << redact(status);
+            }
+        }
+
+        planCacheEntriesRestored.increment(restored);
+        log() << "Restored " << restored << " of " << docs.size()
+              << " checkpointed plan cache entries";
+    }
+
+    void checkpoint() {
+        const ServiceContext::UniqueOperationContext opCtx = cc().makeOperationContext();
+
+        std::vector<BSONObj> docs;
+        std::vector<std::string> dbNames;
+        opCtx->getServiceContext()->getGlobalStorageEngine()->listDatabases(&dbNames);
+        for (const std::string& dbName : dbNames) {
+            if (dbName == kCheckpointNss.db()) {
+                continue;
+            }
+
+            AutoGetDb autoDb(opCtx.get(), dbName, MODE_IS);
+            Database* db = autoDb.getDb();
+            if (!db) {
+                continue;
+            }
+
+            for (Collection* collection : *db) {
+                for (PlanCacheEntry* rawEntry :
+                     collection->infoCache()->getPlanCache()->getAllEntries()) {
+                    std::unique_ptr<PlanCacheEntry> entry(rawEntry);
+                    docs.push_back(entryToBSON(collection->ns(), *entry));
+                }
+            }
+        }
+
+        // Create the checkpoint collection the first time. This is the only step which locks the
+        // database exclusively, and does nothing else while holding the lock.
+        bool exists;
+        {
+            AutoGetCollection autoColl(opCtx.get(), kCheckpointNss, MODE_IS);
+            exists = autoColl.getCollection() != nullptr;
+        }
+        if (!exists) {
+            writeConflictRetry(opCtx.get(), "planCacheCheckpoint", kCheckpointNss.ns(), [&] {
+                AutoGetOrCreateDb autoDb(opCtx.get(), kCheckpointNss.db(), MODE_X);
+                Database* db = autoDb.getDb();
+                if (db->getCollection(opCtx.get(), kCheckpointNss)) {
+                    return;
+                }
+                WriteUnitOfWork wunit(opCtx.get());
+                uassertStatusOK(userCreateNS(opCtx.get(), db, kCheckpointNss.ns(), BSONObj()));
+                wunit.commit();
+            });
+        }
+
+        // Replace the previous checkpoint. Only the checkpoint collection is locked exclusively,
+        // and the entries are written in batches, each in a write unit of its own, so that other
+        // users of the database aren't held up. A checkpoint cut short by a crash restores only
+        // some of the entries, which the restore tolerates like any it can no longer apply.
+        writeConflictRetry(opCtx.get(), "planCacheCheckpoint", kCheckpointNss.ns(), [&] {
+            AutoGetCollection autoColl(opCtx.get(), kCheckpointNss, MODE_IX, MODE_X);
+            Collection* collection = autoColl.getCollection();
+            uassert(ErrorCodes::NamespaceNotFound,
+                    str::stream() << kCheckpointNss.ns() << " was dropped during the checkpoint",
+                    collection);
+            WriteUnitOfWork wunit(opCtx.get());
+            uassertStatusOK(collection->truncate(opCtx.get()));
+            wunit.commit();
+        });
+
+        for (size_t begin = 0; begin < docs.size(); begin += kCheckpointBatchSize) {
+            const size_t end = std::min(docs.size(), begin + kCheckpointBatchSize);
+            writeConflictRetry(opCtx.get(), "planCacheCheckpoint", kCheckpointNss.ns(), [&] {
+                AutoGetCollection autoColl(opCtx.get(), kCheckpointNss, MODE_IX);
+                Collection* collection = autoColl.getCollection();
+                uassert(ErrorCodes::NamespaceNotFound,
+                        str::stream() << kCheckpointNss.ns()
+                                      << " was dropped during the checkpoint",
+                        collection);
+                WriteUnitOfWork wunit(opCtx.get());
+                OpDebug* const nullOpDebug = nullptr;
+                for (size_t i = begin; i < end; ++i) {
+                    uassertStatusOK(collection->insertDocument(
+                        opCtx.get(), InsertStatement(docs[i]), nullOpDebug, false));
+                }
+                wunit.commit();
+            });
+        }
+
+        planCacheCheckpoints.increment();
+        LOG(1) << "Checkpointed " << docs.size() << " plan cache entries";
+    }
+};
+
+// The job is intentionally leaked, like the TTL monitor, since it runs until shutdown.
+PlanCacheCheckpointJob* planCacheCheckpointJob = nullptr;
+
+}  // namespace
+
+void startPlanCacheCheckpointJob() {
+    invariant(!planCacheCheckpointJob);
+    planCacheCheckpointJob = new PlanCacheCheckpointJob();
+    planCacheCheckpointJob->go();
+}
+
+}  // namespace mongo
@@ -154,6 +154,10 @@ size_t getDocsExamined(StageType type, const SpecificStats* specific) {
     if (STAGE_COLLSCAN == type) {
         const CollectionScanStats* spec = static_cast<const CollectionScanStats*>(specific);
         return spec->docsTested;
+    } else if (STAGE_PARALLEL_COLLSCAN == type) {
+        const ParallelCollectionScanStats* spec =
+            static_cast<const ParallelCollectionScanStats*>(specific);
+        return spec->docsTested;
     } else if (STAGE_FETCH == type) {
         const FetchStats* spec = static_cast<const FetchStats*>(specific);
         return spec->docsExamined;
@@ -289,6 +293,9 @@ void Explain::statsToBSON(const PlanStageStats& stats,
         if (verbosity >= ExplainOptions::Verbosity::kExecStats) {
             bob->appendNumber("memUsage", spec->memUsage);
             bob->appendNumber("memLimit", spec->memLimit);
+            bob->appendNumber("hashTableBytes", spec->hashTableBytes);
+            bob->appendNumber("bloomFilterBytes", spec->bloomFilterBytes);
+            bob->appendNumber("bloomFilterRejects", spec->bloomFilterRejects);
 
             bob->appendNumber("flaggedButPassed", spec->flaggedButPassed);
             bob->appendNumber("flaggedInProgress", spec->flaggedInProgress);
@@ -315,6 +322,17 @@ void Explain::statsToBSON(const PlanStageStats& stats,
         if (verbosity >= ExplainOptions::Verbosity::kExecStats) {
             bob->appendNumber("docsExamined", spec->docsTested);
         }
+    } else if (STAGE_PARALLEL_COLLSCAN == stats.stageType) {
+        ParallelCollectionScanStats* spec =
+            static_cast<ParallelCollectionScanStats*>(stats.specific.get());
+        bob->appendNumber("numRanges", spec->numRanges);
+        bob->appendBool("preserveOrder", spec->preserveOrder);
+        bob->appendBool("hasProjection", spec->hasProjection);
+        if (verbosity >= ExplainOptions::Verbosity::kExecStats) {
+            bob->appendNumber("docsExamined", spec->docsTested);
+            bob->appendNumber("rounds", spec->rounds);
+            bob->appendNumber("writeConflicts", spec->writeConflicts);
+        }
     } else if (STAGE_COUNT == stats.stageType) {
         CountStats* spec = static_cast<CountStats*>(stats.specific.get());
 
@@ -327,6 +345,7 @@ void Explain::statsToBSON(const PlanStageStats& stats,
 
         if (verbosity >= ExplainOptions::Verbosity::kExecStats) {
             bob->appendNumber("keysExamined", spec->keysExamined);
+            bob->appendNumber("seeks", spec->seeks);
         }
 
         bob->append("keyPattern", spec->keyPattern);
@@ -343,12 +362,20 @@ void Explain::statsToBSON(const PlanStageStats& stats,
         bob->appendBool("isPartial", spec->isPartial);
         bob->append("indexVersion", spec->indexVersion);
 
-        BSONObjBuilder indexBoundsBob;
-        indexBoundsBob.append("startKey", spec->startKey);
-        indexBoundsBob.append("startKeyInclusive", spec->startKeyInclusive);
-        indexBoundsBob.append("endKey", spec->endKey);
-        indexBoundsBob.append("endKeyInclusive", spec->endKeyInclusive);
-        bob->append("indexBounds", indexBoundsBob.obj());
+        if (!spec->indexBounds.isEmpty()) {
+            if ((topLevelBob->len() + spec->indexBounds.objsize()) > kMaxStatsBSONSize) {
+                bob->append("warning", "index bounds omitted due to BSON size limit");
+            } else {
+                bob->append("indexBounds", spec->indexBounds);
+            }
+        } else {
+            BSONObjBuilder indexBoundsBob;
+            indexBoundsBob.append("startKey", spec->startKey);
+            indexBoundsBob.append("startKeyInclusive", spec->startKeyInclusive);
+            indexBoundsBob.append("endKey", spec->endKey);
+            indexBoundsBob.append("endKeyInclusive", spec->endKeyInclusive);
+            bob->append("indexBounds", indexBoundsBob.obj());
+        }
     } else if (STAGE_DELETE == stats.stageType) {
         DeleteStats* spec = static_cast<DeleteStats*>(stats.specific.get());
 
@@ -394,6 +421,12 @@ void Explain::statsToBSON(const PlanStageStats& stats,
         if (verbosity >= ExplainOptions::Verbosity::kExecStats) {
             bob->appendNumber("docsExamined", spec->docsExamined);
             bob->appendNumber("alreadyHasObj", spec->alreadyHasObj);
+            if (spec->recordsPrefetched) {
+                bob->appendNumber("recordsPrefetched", spec->recordsPrefetched);
+            }
+            if (spec->docsPartiallyMaterialized) {
+                bob->appendNumber("docsPartiallyMaterialized", spec->docsPartiallyMaterialized);
+            }
         }
     } else if (STAGE_GEO_NEAR_2D == stats.stageType || STAGE_GEO_NEAR_2DSPHERE == stats.stageType) {
         NearStats* spec = static_cast<NearStats*>(stats.specific.get());
@@ -488,6 +521,11 @@ void Explain::statsToBSON(const PlanStageStats& stats,
         if (verbosity >= ExplainOptions::Verbosity::kExecStats) {
             bob->appendNumber("memUsage", spec->memUsage);
             bob->appendNumber("memLimit", spec->memLimit);
+
+            if (spec->usedDisk) {
+                bob->appendBool("usedDisk", true);
+                bob->appendNumber("spills", spec->spills);
+            }
         }
 
         if (spec->limit > 0) {
@@ -642,6 +680,19 @@ void Explain::generatePlannerInfo(PlanExecutor* exec,
     }
     allPlansBob.doneFast();
 
+    // Report on plan enumeration if the winning plan came out of it.
+    MultiPlanStage* mps = getMultiPlanStage(exec->getRootStage());
+    const QuerySolution* solution = mps ? mps->bestSolution() : exec->getQuerySolution();
+    if (solution && solution->enumerationStats) {
+        BSONObjBuilder enumerationBob(plannerBob.subobjStart("enumeration"));
+        enumerationBob.appendNumber(
+            "timeMicros", durationCount<Microseconds>(solution->enumerationStats->time));
+        enumerationBob.appendNumber(
+            "assignmentsPruned",
+            static_cast<long long>(solution->enumerationStats->assignmentsPruned));
+        enumerationBob.doneFast();
+    }
+
     plannerBob.doneFast();
 }
 
@@ -40,6 +40,8 @@
 #include "mongo/base/parse_number.h"
 #include "mongo/client/dbclientinterface.h"
 #include "mongo/db/catalog/index_catalog.h"
+#include "mongo/db/concurrency/write_conflict_exception.h"
+#include "mongo/db/curop.h"
 #include "mongo/db/exec/cached_plan.h"
 #include "mongo/db/exec/count.h"
 #include "mongo/db/exec/delete.h"
@@ -53,6 +55,7 @@
 #include "mongo/db/exec/sort_key_generator.h"
 #include "mongo/db/exec/subplan.h"
 #include "mongo/db/exec/update.h"
+#include "mongo/db/index/index_access_method.h"
 #include "mongo/db/index/index_descriptor.h"
 #include "mongo/db/index_names.h"
 #include "mongo/db/matcher/extensions_callback_noop.h"
@@ -62,15 +65,19 @@
 #include "mongo/db/query/collation/collator_factory_interface.h"
 #include "mongo/db/query/explain.h"
 #include "mongo/db/query/index_bounds_builder.h"
+#include "mongo/db/query/index_statistics.h"
 #include "mongo/db/query/internal_plans.h"
 #include "mongo/db/query/plan_cache.h"
+#include "mongo/db/query/plan_cost_model.h"
 #include "mongo/db/query/plan_executor.h"
 #include "mongo/db/query/planner_access.h"
 #include "mongo/db/query/planner_analysis.h"
+#include "mongo/db/query/planner_ixselect.h"
 #include "mongo/db/query/query_knobs.h"
 #include "mongo/db/query/query_planner.h"
 #include "mongo/db/query/query_planner_common.h"
 #include "mongo/db/query/query_settings.h"
+#include "mongo/db/query/query_stats_store.h"
 #include "mongo/db/query/stage_builder.h"
 #include "mongo/db/repl/optime.h"
 #include "mongo/db/repl/replication_coordinator_global.h"
@@ -121,6 +128,106 @@ namespace {
 // The body is below in the "count hack" section but getExecutor calls it.
 bool turnIxscanIntoCount(QuerySolution* soln);
 
+/**
+ * Counts the distinct values of the first field of the index described by 'desc' by seeking past
+ * each of them in turn. Gives up and returns -1 once more than 'limit' values have been seen.
+ */
+long long countLeadingFieldValues(OperationContext* opCtx,
+                                  const IndexDescriptor* desc,
+                                  long long limit) {
+    const IndexAccessMethod* iam = desc->getIndexCatalog()->getIndex(desc);
+    auto cursor = iam->newCursor(opCtx, true);
+
+    IndexBounds bounds;
+    IndexBoundsBuilder::allValuesBounds(desc->keyPattern(), &bounds);
+    IndexBoundsChecker checker(&bounds, desc->keyPattern(), 1);
+    IndexSeekPoint seekPoint;
+    if (!checker.getStartSeekPoint(&seekPoint)) {
+        return 0;
+    }
+
+    long long count = 0;
+    try {
+        for (auto kv = cursor->seek(seekPoint); kv; kv = cursor->seek(seekPoint)) {
+            if (++count > limit) {
+                return -1;
+            }
+            seekPoint.keyPrefix = kv->key.getOwned();
+            seekPoint.prefixLen = 1;
+            seekPoint.prefixExclusive = true;
+        }
+    } catch (const WriteConflictException&) {
+        return -1;
+    }
+    return count;
+}
+
+/**
+ * If no index is prefixed by a field the query has predicates over, estimates the leading field
+ * cardinality of the compound btree indexes whose second field the query has predicates over, so
+ * that the planner may consider skip scans over them.
+ */
+void estimateLeadingFieldCardinalities(OperationContext* opCtx,
+                                       Collection* collection,
+                                       const CanonicalQuery& canonicalQuery,
+                                       std::vector<IndexEntry>* indexEntries) {
+    const long long maxLeadingValues = internalQueryPlannerSkipScanMaxLeadingValues.load();
+    const QueryRequest& qr = canonicalQuery.getQueryRequest();
+    if (maxLeadingValues <= 0 || !qr.getHint().isEmpty() || !qr.getMin().isEmpty() ||
+        !qr.getMax().isEmpty() || qr.isTailable()) {
+        return;
+    }
+
+    unordered_set<string> fields;
+    QueryPlannerIXSelect::getFields(canonicalQuery.root(), "", &fields);
+    std::vector<IndexEntry> relevantIndices;
+    QueryPlannerIXSelect::findRelevantIndices(fields, *indexEntries, &relevantIndices);
+    if (!relevantIndices.empty()) {
+        return;
+    }
+
+    // A count made at or after 'notBefore' may be reused rather than counted again.
+    const int cacheSecs = internalQueryPlannerSkipScanCardinalityCacheSecs.load();
+    const Date_t now = opCtx->getServiceContext()->getFastClockSource()->now();
+    const Date_t notBefore = cacheSecs > 0 ? now - Seconds(cacheSecs) : Date_t::max();
+
+    for (auto&& entry : *indexEntries) {
+        if (INDEX_BTREE != entry.type || entry.keyPattern.nFields() < 2) {
+            continue;
+        }
+        BSONObjIterator it(entry.keyPattern);
+        it.next();
+        if (fields.end() == fields.find(it.next().fieldName())) {
+            continue;
+        }
+
+        // Statistics, if we have them, save us from counting.
+        if (entry.statistics) {
+            if (entry.statistics->distinctValues <= maxLeadingValues) {
+                entry.leadingFieldCardinality =
+                    static_cast<long long>(entry.statistics->distinctValues);
+            }
+            continue;
+        }
+
+        // Counting takes up to 'maxLeadingValues' + 1 seeks, so reuse a recent count if there is
+        // one. The count only makes a skip scan eligible, and a stale one can't make its results
+        // wrong.
+        auto infoCache = collection->infoCache();
+        auto count = infoCache->getLeadingFieldCardinality(entry.name, notBefore);
+        if (!count) {
+            const IndexDescriptor* desc =
+                collection->getIndexCatalog()->findIndexByName(opCtx, entry.name);
+            invariant(desc);
+            count = countLeadingFieldValues(opCtx, desc, maxLeadingValues);
+            infoCache->setLeadingFieldCardinality(entry.name, *count, now);
+        }
+        if (*count >= 0 && *count <= maxLeadingValues) {
+            entry.leadingFieldCardinality = *count;
+        }
+    }
+}
+
 }  // namespace
 
 
@@ -143,6 +250,8 @@ void fillOutPlannerParams(OperationContext* opCtx,
                                                     ice->getFilterExpression(),
                                                     desc->infoObj(),
                                                     ice->getCollator()));
+        plannerParams->indices.back().statistics =
+            collection->infoCache()->getIndexStatistics(desc->indexName());
     }
 
     // If query supports index filters, filter params.indices by indices in query settings.
@@ -161,6 +270,9 @@ void fillOutPlannerParams(OperationContext* opCtx,
         }
     }
 
+    estimateLeadingFieldCardinalities(
+        opCtx, collection, *canonicalQuery, &plannerParams->indices);
+
     // We will not output collection scans unless there are no indexed solutions. NO_TABLE_SCAN
     // overrides this behavior by not outputting a collscan even if there are no indexed
     // solutions.
@@ -197,6 +309,10 @@ void fillOutPlannerParams(OperationContext* opCtx,
 
     plannerParams->options |= QueryPlannerParams::SPLIT_LIMITED_SORT;
 
+    if (internalQueryPlannerDeferFetchForTopKSort.load()) {
+        plannerParams->options |= QueryPlannerParams::DEFER_FETCH_FOR_TOP_K_SORT;
+    }
+
     // Doc-level locking storage engines cannot answer predicates implicitly via exact index
     // bounds for index intersection plans, as this can lead to spurious matches.
     //
@@ -231,6 +347,57 @@ struct PrepareExecutionResult {
     unique_ptr<PlanStage> root;
 };
 
+/**
+ * Looks up the plan cached for the shape of 'query' and has the planner turn it into a
+ * QuerySolution. A cached plan is only used if, with the values of 'query', its index scans are
+ * estimated to fall in the same selectivity bucket as when the plan was chosen. Otherwise the plan
+ * cached for the query's own bucket, if there is one, is tried instead.
+ *
+ * Returns the solution and populates 'csOut', or returns nullptr if there is no suitable plan.
+ */
+unique_ptr<QuerySolution> planFromCache(const CanonicalQuery& query,
+                                        const QueryPlannerParams& plannerParams,
+                                        const PlanCache& planCache,
+                                        unique_ptr<CachedSolution>* csOut) {
+    CachedSolution* rawCS;
+    if (!planCache.get(query, &rawCS).isOK()) {
+        return nullptr;
+    }
+    unique_ptr<CachedSolution> cs(rawCS);
+
+    QuerySolution* rawQs;
+    if (!QueryPlanner::planFromCache(query, plannerParams, *cs, &rawQs).isOK()) {
+        return nullptr;
+    }
+    unique_ptr<QuerySolution> qs(rawQs);
+
+    if (cs->selectivityBucket) {
+        const auto bucket = PlanCache::computeSelectivityBucket(*qs);
+        if (bucket != cs->selectivityBucket) {
+            LOG(2) << "Cached plan was chosen for selectivity bucket " << *cs->selectivityBucket
+                   << " but query " << redact(query.toStringShort()) << " falls in bucket "
+                   << (bucket ? std::to_string(*bucket) : std::string("unknown"));
+            if (!bucket || !planCache.get(query, *bucket, &rawCS).isOK()) {
+                return nullptr;
+            }
+            cs.reset(rawCS);
+            if (!QueryPlanner::planFromCache(query, plannerParams, *cs, &rawQs).isOK()) {
+                return nullptr;
+            }
+            qs.reset(rawQs);
+
+            // The other bucket's plan scans different bounds, so the query must fall in its
+            // bucket under that plan too.
+            if (PlanCache::computeSelectivityBucket(*qs) != cs->selectivityBucket) {
+                return nullptr;
+            }
+        }
+    }
+
+    *csOut = std::move(cs);
+    return qs;
+}
+
 /**
  * Build an execution tree for the query described in 'canonicalQuery'.
  *
@@ -337,17 +504,22 @@ StatusWith<PrepareExecutionResult> prepareExecution(OperationContext* opCtx,
         }
     }
 
+    // Attribute the operation's statistics to the shape of the first query it plans, if that query
+    // has a plan cache key. Queries that an operation plans later, such as those of a $lookup, are
+    // part of its cost.
+    OpDebug& opDebug = CurOp::get(opCtx)->debug();
+    const bool recordQueryShape = opDebug.queryShape.empty() && QueryStatsStore::isEnabled();
+
     // Try to look up a cached solution for the query.
-    CachedSolution* rawCS;
-    if (PlanCache::shouldCacheQuery(*canonicalQuery) &&
-        collection->infoCache()->getPlanCache()->get(*canonicalQuery, &rawCS).isOK()) {
-        // We have a CachedSolution.  Have the planner turn it into a QuerySolution.
-        unique_ptr<CachedSolution> cs(rawCS);
-        QuerySolution* qs;
-        Status status = QueryPlanner::planFromCache(*canonicalQuery, plannerParams, *cs, &qs);
-
-        if (status.isOK()) {
-            if ((plannerParams.options & QueryPlannerParams::IS_COUNT) && turnIxscanIntoCount(qs)) {
+    unique_ptr<CachedSolution> cs;
+    if (PlanCache::shouldCacheQuery(*canonicalQuery)) {
+        // Have the planner turn the CachedSolution, if we have one, into a QuerySolution.
+        unique_ptr<QuerySolution> qs = planFromCache(
+            *canonicalQuery, plannerParams, *collection->infoCache()->getPlanCache(), &cs);
+
+        if (qs) {
+            if ((plannerParams.options & QueryPlannerParams::IS_COUNT) &&
+                turnIxscanIntoCount(qs.get())) {
                 LOG(2) << "Using fast count: " << redact(canonicalQuery->toStringShort());
             }
 
@@ -364,11 +536,23 @@ StatusWith<PrepareExecutionResult> prepareExecution(OperationContext* opCtx,
                                                 canonicalQuery.get(),
                                                 plannerParams,
                                                 cs->decisionWorks,
+                                                cs->selectivityBucket,
                                                 rawRoot);
-            querySolution.reset(qs);
+            querySolution = std::move(qs);
+
+            // The cache has already computed the query's key.
+            if (recordQueryShape) {
+                opDebug.queryShape = std::move(cs->key);
+            }
             return PrepareExecutionResult(
                 std::move(canonicalQuery), std::move(querySolution), std::move(root));
         }
+
+        // Planning the query from scratch costs far more than computing its key once more.
+        if (recordQueryShape) {
+            opDebug.queryShape =
+                collection->infoCache()->getPlanCache()->computeKey(*canonicalQuery);
+        }
     }
 
     if (internalQueryPlanOrChildrenIndependently.load() &&
@@ -424,6 +608,10 @@ StatusWith<PrepareExecutionResult> prepareExecution(OperationContext* opCtx,
         }
     }
 
+    // Discard the plans which index statistics show to be far more expensive than the others,
+    // rather than spending the trial period on them.
+    PlanCostModel::pruneSolutions(&solutions);
+
     if (1 == solutions.size()) {
         // Only one possible plan.  Run it.  Build the stages from the solution.
         PlanStage* rawRoot;
@@ -440,14 +628,31 @@ StatusWith<PrepareExecutionResult> prepareExecution(OperationContext* opCtx,
             std::move(canonicalQuery), std::move(querySolution), std::move(root));
     } else {
         // Many solutions. Create a MultiPlanStage to pick the best, update the cache,
-        // and so on. The working set will be shared by all candidate plans.
+        // and so on. The working set will be shared by all candidate plans, unless their trial
+        // periods run in parallel, in which case each is built on a working set of its own.
         auto multiPlanStage = make_unique<MultiPlanStage>(opCtx, collection, canonicalQuery.get());
+        const bool parallelTrials =
+            (plannerParams.options & QueryPlannerParams::ALLOW_PARALLEL_TRIALS) &&
+            MultiPlanStage::canRunTrialsInParallel(opCtx, *canonicalQuery);
 
         for (size_t ix = 0; ix < solutions.size(); ++ix) {
             if (solutions[ix]->cacheData.get()) {
                 solutions[ix]->cacheData->indexFilterApplied = plannerParams.indexFiltersApplied;
             }
 
+            if (parallelTrials) {
+                auto candidateWs = make_unique<WorkingSet>();
+                PlanStage* nextPlanRoot;
+                verify(StageBuilder::build(opCtx,
+                                           collection,
+                                           *canonicalQuery,
+                                           *solutions[ix],
+                                           candidateWs.get(),
+                                           &nextPlanRoot));
+                multiPlanStage->addPlan(solutions[ix], nextPlanRoot, ws, std::move(candidateWs));
+                continue;
+            }
+
             // version of StageBuild::build when WorkingSet is shared
             PlanStage* nextPlanRoot;
             verify(StageBuilder::build(
@@ -670,6 +875,11 @@ StatusWith<unique_ptr<PlanExecutor, PlanExecutor::Deleter>> getExecutorFind(
     if (ShardingState::get(opCtx)->needCollectionMetadata(opCtx, nss.ns())) {
         plannerOptions |= QueryPlannerParams::INCLUDE_SHARD_FILTER;
     }
+
+    // A find is read-only, so its collection scans and plan trials may be run in parallel.
+    plannerOptions |= QueryPlannerParams::ALLOW_PARALLEL_COLLSCAN;
+    plannerOptions |= QueryPlannerParams::ALLOW_PARALLEL_TRIALS;
+
     return getExecutor(
         opCtx, collection, std::move(canonicalQuery), PlanExecutor::YIELD_AUTO, plannerOptions);
 }
@@ -1118,17 +1328,23 @@ bool turnIxscanIntoCount(QuerySolution* soln) {
     BSONObj endKey;
     bool endKeyInclusive;
 
-    if (!IndexBoundsBuilder::isSingleInterval(
-            isn->bounds, &startKey, &startKeyInclusive, &endKey, &endKeyInclusive)) {
-        return false;
-    }
-
     // Make the count node that we replace the fetch + ixscan with.
     CountScanNode* csn = new CountScanNode(isn->index);
-    csn->startKey = startKey;
-    csn->startKeyInclusive = startKeyInclusive;
-    csn->endKey = endKey;
-    csn->endKeyInclusive = endKeyInclusive;
+    if (IndexBoundsBuilder::isSingleInterval(
+            isn->bounds, &startKey, &startKeyInclusive, &endKey, &endKeyInclusive)) {
+        csn->startKey = startKey;
+        csn->startKeyInclusive = startKeyInclusive;
+        csn->endKey = endKey;
+        csn->endKeyInclusive = endKeyInclusive;
+    } else {
+        // Several intervals, as from an $in or $or over one field. The count scan skips between
+        // them with the same bounds checker as the index scan, but it only walks forwards.
+        if (1 != isn->direction) {
+            delete csn;
+            return false;
+        }
+        csn->bounds = isn->bounds;
+    }
     // Takes ownership of 'cn' and deletes the old root.
     soln->root.reset(csn);
     return true;
@@ -60,6 +60,10 @@ std::string IndexEntry::toString() const {
         sb << " io: " << infoObj;
     }
 
+    if (isSkipScan()) {
+        sb << " skip scan over: " << skipScanKeyPattern;
+    }
+
     return sb.str();
 }
 
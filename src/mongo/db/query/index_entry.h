@@ -28,6 +28,7 @@
 
 #pragma once
 
+#include <memory>
 #include <string>
 
 #include "mongo/db/index/multikey_paths.h"
@@ -38,6 +39,7 @@
 namespace mongo {
 
 class CollatorInterface;
+class IndexStatistics;
 class MatchExpression;
 
 /**
@@ -110,6 +112,14 @@ struct IndexEntry {
 
     std::string toString() const;
 
+    /**
+     * Returns true if this entry was derived by the planner to describe a skip scan, rather than
+     * coming from the catalog. See 'skipScanKeyPattern'.
+     */
+    bool isSkipScan() const {
+        return !skipScanKeyPattern.isEmpty();
+    }
+
     BSONObj keyPattern;
 
     bool multikey;
@@ -138,6 +148,21 @@ struct IndexEntry {
     // Null if this index orders strings according to the simple binary compare. If non-null,
     // represents the collator used to generate index keys for indexed strings.
     const CollatorInterface* collator = nullptr;
+
+    // An estimate of the number of distinct values of the first field of 'keyPattern', or -1 if
+    // unknown. The planner only considers skip scans over indexes for which this is known.
+    long long leadingFieldCardinality = -1;
+
+    // Non-empty if this entry describes a skip scan over the index 'name'. Such an entry is never
+    // in the catalog: its 'keyPattern' and 'multikeyPaths' omit the first field of the index,
+    // whose full key pattern and multikey paths are kept here. Access planning maps scans over
+    // the entry back onto the full index, with "all values" bounds for the first field.
+    BSONObj skipScanKeyPattern;
+    MultikeyPaths skipScanMultikeyPaths;
+
+    // Statistics about the index's keys, if they have been built with the analyzeIndexes command.
+    // Used by PlanCostModel.
+    std::shared_ptr<const IndexStatistics> statistics;
 };
 
 }  // namespace mongo
@@ -0,0 +1,197 @@
+/**
+ *    Copyright (C) 2017 MongoDB Inc.
+ *
+ *    This program is free software: you can redistribute it and/or  modify
+ *    it under the terms of the GNU Affero General Public License, version 3,
+ *    as published by the Free Software Foundation.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU Affero General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Affero General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the GNU Affero General Public License in all respects for
+ *    all of the code used other than as permitted herein. If you modify file(s)
+ *    with this exception, you may extend this exception to your version of the
+ *    file(s), but you are not obligated to do so. If you do not wish to do so,
+ *    delete this exception statement from your version. If you delete this
+ *    exception statement from all source files in the program, then also delete
+ *    it in the license file.
+ */
+
+#include "mongo/platform/basic.h"
+
+#include "mongo/db/query/index_statistics.h"
+
+#include <algorithm>
+
+#include "mongo/db/query/index_bounds.h"
+
+namespace mongo {
+
+namespace {
+
+int compareValues(const BSONObj& lhs, const BSONObj& rhs) {
+    return lhs.firstElement().woCompare(rhs.firstElement(), false);
+}
+
+}  // namespace
+
+// static
+IndexStatistics IndexStatistics::build(std::vector<BSONObj> leadingValues,
+                                       long long docsSampled,
+                                       long long numRecords) {
+    IndexStatistics stats;
+    stats.numRecords = numRecords;
+    stats.docsSampled = docsSampled;
+    stats.keysSampled = leadingValues.size();
+    stats.keysPerDocument =
+        docsSampled ? static_cast<double>(stats.keysSampled) / docsSampled : 0.0;
+
+    if (leadingValues.empty()) {
+        return stats;
+    }
+
+    std::sort(leadingValues.begin(),
+              leadingValues.end(),
+              [](const BSONObj& lhs, const BSONObj& rhs) { return compareValues(lhs, rhs) < 0; });
+    stats.lowerBound = leadingValues.front().getOwned();
+
+    // Walk the runs of equal values, closing a bucket once it holds its share of the sample. A
+    // run is never split across buckets, so each bucket knows how often its upper bound occurs.
+    const long long bucketTarget = (stats.keysSampled + kMaxBuckets - 1) / kMaxBuckets;
+    long long sampledDistinct = 0;
+    long long singletons = 0;
+    Bucket current;
+    for (size_t runStart = 0; runStart < leadingValues.size();) {
+        size_t runEnd = runStart + 1;
+        while (runEnd < leadingValues.size() &&
+               compareValues(leadingValues[runStart], leadingValues[runEnd]) == 0) {
+            ++runEnd;
+        }
+
+        const long long runLength = runEnd - runStart;
+        ++sampledDistinct;
+        if (runLength == 1) {
+            ++singletons;
+        }
+
+        current.count += runLength;
+        current.upperBoundCount = runLength;
+        ++current.distinctValues;
+        if (current.count >= bucketTarget || runEnd == leadingValues.size()) {
+            current.upperBound = leadingValues[runStart].getOwned();
+            stats.buckets.push_back(std::move(current));
+            current = Bucket();
+        }
+
+        runStart = runEnd;
+    }
+
+    // Scale the number of distinct values seen up to the whole index with the Duj1 estimator,
+    // n * d / (n - f1 + f1 * n / N), where f1 is the number of values seen exactly once.
+    const double n = stats.keysSampled;
+    const double N = std::max(n, stats.estimatedNumKeys());
+    const double denominator = n - singletons + singletons * n / N;
+    stats.distinctValues = denominator > 0 ? n * sampledDistinct / denominator : sampledDistinct;
+    stats.distinctValues =
+        std::min(N, std::max(static_cast<double>(sampledDistinct), stats.distinctValues));
+
+    return stats;
+}
+
+double IndexStatistics::estimateFraction(const OrderedIntervalList& oil) const {
+    if (buckets.empty()) {
+        // Without a sample we know nothing, so assume the whole index is scanned.
+        return 1.0;
+    }
+
+    double matched = 0;
+    for (auto&& interval : oil.intervals) {
+        BSONElement low = interval.start;
+        BSONElement high = interval.end;
+        bool lowInclusive = interval.startInclusive;
+        bool highInclusive = interval.endInclusive;
+        if (low.woCompare(high, false) > 0) {
+            std::swap(low, high);
+            std::swap(lowInclusive, highInclusive);
+        }
+        const bool isPoint = interval.isPoint();
+
+        for (size_t i = 0; i < buckets.size(); ++i) {
+            const Bucket& bucket = buckets[i];
+
+            // Every bucket but the first excludes the upper bound of the one before it.
+            const bool bucketLowInclusive = (i == 0);
+            BSONElement bucketLow = bucketLowInclusive ? lowerBound.firstElement()
+                                                       : buckets[i - 1].upperBound.firstElement();
+            BSONElement bucketHigh = bucket.upperBound.firstElement();
+
+            const int highVsLow = bucketHigh.woCompare(low, false);
+            if (highVsLow < 0 || (highVsLow == 0 && !lowInclusive)) {
+                continue;  // The bucket lies below the interval.
+            }
+            const int lowVsHigh = bucketLow.woCompare(high, false);
+            if (lowVsHigh > 0 || (lowVsHigh == 0 && (!bucketLowInclusive || !highInclusive))) {
+                continue;  // The bucket lies above the interval.
+            }
+
+            const int highVsHigh = bucketHigh.woCompare(high, false);
+            const bool containsHigh = highVsHigh < 0 || (highVsHigh == 0 && highInclusive);
+            const int lowVsLow = bucketLow.woCompare(low, false);
+            const bool containsLow =
+                lowVsLow > 0 || (lowVsLow == 0 && (!bucketLowInclusive || lowInclusive));
+            if (containsLow && containsHigh) {
+                matched += bucket.count;
+                continue;
+            }
+
+            // The interval covers part of the bucket. We know exactly how many keys equal the
+            // upper bound, and assume the rest are spread evenly over the bucket's other values.
+            const double interior = bucket.count - bucket.upperBoundCount;
+            if (containsHigh) {
+                matched += bucket.upperBoundCount;
+            } else if (isPoint) {
+                matched += interior / std::max(1LL, bucket.distinctValues - 1);
+            }
+            if (!isPoint) {
+                matched += interior / 2;
+            }
+        }
+    }
+
+    return std::min(1.0, matched / keysSampled);
+}
+
+BSONObj IndexStatistics::toBSON() const {
+    BSONObjBuilder bob;
+    bob.appendNumber("numRecords", numRecords);
+    bob.appendNumber("docsSampled", docsSampled);
+    bob.appendNumber("keysSampled", keysSampled);
+    bob.append("keysPerDocument", keysPerDocument);
+    bob.append("distinctValues", distinctValues);
+    if (!lowerBound.isEmpty()) {
+        bob.appendAs(lowerBound.firstElement(), "lowerBound");
+    }
+
+    BSONArrayBuilder histogram(bob.subarrayStart("histogram"));
+    for (auto&& bucket : buckets) {
+        BSONObjBuilder bucketBob(histogram.subobjStart());
+        bucketBob.appendAs(bucket.upperBound.firstElement(), "upperBound");
+        bucketBob.appendNumber("count", bucket.count);
+        bucketBob.appendNumber("upperBoundCount", bucket.upperBoundCount);
+        bucketBob.appendNumber("distinctValues", bucket.distinctValues);
+    }
+    histogram.doneFast();
+
+    return bob.obj();
+}
+
+}  // namespace mongo
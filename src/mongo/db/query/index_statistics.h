@@ -0,0 +1,115 @@
+/**
+ *    Copyright (C) 2017 MongoDB Inc.
+ *
+ *    This program is free software: you can redistribute it and/or  modify
+ *    it under the terms of the GNU Affero General Public License, version 3,
+ *    as published by the Free Software Foundation.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU Affero General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Affero General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the GNU Affero General Public License in all respects for
+ *    all of the code used other than as permitted herein. If you modify file(s)
+ *    with this exception, you may extend this exception to your version of the
+ *    file(s), but you are not obligated to do so. If you do not wish to do so,
+ *    delete this exception statement from your version. If you delete this
+ *    exception statement from all source files in the program, then also delete
+ *    it in the license file.
+ */
+
+#pragma once
+
+#include <vector>
+
+#include "mongo/db/jsobj.h"
+
+namespace mongo {
+
+struct OrderedIntervalList;
+
+/**
+ * Statistics about the keys of one index, estimated from a sample of the collection's documents.
+ * The analyzeIndexes command builds them and keeps them in the collection's CollectionInfoCache,
+ * from where they reach the planner's cost model through IndexEntry.
+ *
+ * Only the leading field of the key pattern is described by the histogram, since it is the field
+ * which determines how much of the index a scan has to visit.
+ */
+class IndexStatistics {
+public:
+    // The most buckets an equi-depth histogram is split into.
+    static const size_t kMaxBuckets = 64;
+
+    /**
+     * One bucket of the histogram. It covers the sampled leading values greater than the upper
+     * bound of the previous bucket, up to and including 'upperBound'.
+     */
+    struct Bucket {
+        // A single-field object holding the largest value in the bucket.
+        BSONObj upperBound;
+
+        // The number of sampled keys in the bucket, and how many of them equal 'upperBound'.
+        long long count = 0;
+        long long upperBoundCount = 0;
+
+        // The number of distinct sampled values in the bucket.
+        long long distinctValues = 0;
+    };
+
+    /**
+     * Builds the statistics from the leading field values of the keys generated for a sample of
+     * 'docsSampled' documents, out of 'numRecords' in the collection. Each element of
+     * 'leadingValues' is a single-field object, as found at the start of an index key. The values
+     * are compared without a collator, which is correct since index keys already hold collation
+     * keys.
+     */
+    static IndexStatistics build(std::vector<BSONObj> leadingValues,
+                                 long long docsSampled,
+                                 long long numRecords);
+
+    /**
+     * Returns the estimated fraction, between 0 and 1, of the index's keys whose leading field
+     * falls within 'oil'. The intervals may be in either direction.
+     */
+    double estimateFraction(const OrderedIntervalList& oil) const;
+
+    /**
+     * The estimated number of keys in the index.
+     */
+    double estimatedNumKeys() const {
+        return numRecords * keysPerDocument;
+    }
+
+    BSONObj toBSON() const;
+
+    // The number of documents in the collection when the statistics were built.
+    long long numRecords = 0;
+
+    // The number of documents sampled, and the number of keys those documents generated.
+    long long docsSampled = 0;
+    long long keysSampled = 0;
+
+    // The average number of keys a document generates. Greater than 1 for multikey indexes, and
+    // possibly less than 1 for sparse or partial ones.
+    double keysPerDocument = 0;
+
+    // The estimated number of distinct values of the leading field across the whole index.
+    double distinctValues = 0;
+
+    // The smallest sampled leading value, as a single-field object.
+    BSONObj lowerBound;
+
+    // Equi-depth histogram of the sampled leading values, in ascending order.
+    std::vector<Bucket> buckets;
+};
+
+}  // namespace mongo
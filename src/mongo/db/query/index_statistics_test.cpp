@@ -0,0 +1,132 @@
+/**
+ *    Copyright (C) 2017 MongoDB Inc.
+ *
+ *    This program is free software: you can redistribute it and/or  modify
+ *    it under the terms of the GNU Affero General Public License, version 3,
+ *    as published by the Free Software Foundation.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU Affero General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Affero General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the GNU Affero General Public License in all respects for
+ *    all of the code used other than as permitted herein. If you modify file(s)
+ *    with this exception, you may extend this exception to your version of the
+ *    file(s), but you are not obligated to do so. If you do not wish to do so,
+ *    delete this exception statement from your version. If you delete this
+ *    exception statement from all source files in the program, then also delete
+ *    it in the license file.
+ */
+
+#include "mongo/platform/basic.h"
+
+#include "mongo/db/query/index_statistics.h"
+
+#include "mongo/db/query/index_bounds.h"
+#include "mongo/unittest/unittest.h"
+
+namespace mongo {
+namespace {
+
+std::vector<BSONObj> valuesInRange(int begin, int end) {
+    std::vector<BSONObj> values;
+    for (int i = begin; i < end; ++i) {
+        values.push_back(BSON("" << i));
+    }
+    return values;
+}
+
+OrderedIntervalList makeOIL(int start, int end, bool startInclusive, bool endInclusive) {
+    OrderedIntervalList oil("a");
+    oil.intervals.push_back(Interval(BSON("" << start << "" << end), startInclusive, endInclusive));
+    return oil;
+}
+
+TEST(IndexStatisticsTest, EmptySampleAssumesFullScan) {
+    IndexStatistics stats = IndexStatistics::build({}, 0, 100);
+    ASSERT_TRUE(stats.buckets.empty());
+    ASSERT_EQ(1.0, stats.estimateFraction(makeOIL(0, 10, true, true)));
+}
+
+TEST(IndexStatisticsTest, UniformValues) {
+    IndexStatistics stats = IndexStatistics::build(valuesInRange(0, 1000), 1000, 1000);
+    ASSERT_EQ(1000, stats.keysSampled);
+    ASSERT_EQ(1.0, stats.keysPerDocument);
+    ASSERT_EQ(1000.0, stats.distinctValues);
+    ASSERT_LTE(stats.buckets.size(), IndexStatistics::kMaxBuckets);
+    ASSERT_BSONOBJ_EQ(BSON("" << 0), stats.lowerBound);
+    ASSERT_BSONOBJ_EQ(BSON("" << 999), stats.buckets.back().upperBound);
+
+    ASSERT_APPROX_EQUAL(0.1, stats.estimateFraction(makeOIL(0, 99, true, true)), 0.02);
+    ASSERT_APPROX_EQUAL(0.5, stats.estimateFraction(makeOIL(500, 2000, true, true)), 0.02);
+    ASSERT_APPROX_EQUAL(0.001, stats.estimateFraction(makeOIL(500, 500, true, true)), 0.001);
+    ASSERT_EQ(0.0, stats.estimateFraction(makeOIL(2000, 3000, true, true)));
+    ASSERT_EQ(1.0, stats.estimateFraction(makeOIL(-5, 5000, true, true)));
+}
+
+TEST(IndexStatisticsTest, DescendingIntervalsMatchAscendingOnes) {
+    IndexStatistics stats = IndexStatistics::build(valuesInRange(0, 1000), 1000, 1000);
+    ASSERT_EQ(stats.estimateFraction(makeOIL(100, 300, true, false)),
+              stats.estimateFraction(makeOIL(300, 100, false, true)));
+}
+
+TEST(IndexStatisticsTest, FrequentValueGetsItsOwnBucket) {
+    std::vector<BSONObj> values(900, BSON("" << 0));
+    for (auto&& value : valuesInRange(1, 101)) {
+        values.push_back(value);
+    }
+    IndexStatistics stats = IndexStatistics::build(values, 1000, 1000);
+
+    ASSERT_BSONOBJ_EQ(BSON("" << 0), stats.buckets[0].upperBound);
+    ASSERT_EQ(900, stats.buckets[0].upperBoundCount);
+    ASSERT_EQ(0.9, stats.estimateFraction(makeOIL(0, 0, true, true)));
+    ASSERT_LT(stats.estimateFraction(makeOIL(50, 50, true, true)), 0.01);
+    ASSERT_APPROX_EQUAL(0.1, stats.estimateFraction(makeOIL(0, 1000, false, true)), 0.01);
+}
+
+TEST(IndexStatisticsTest, MultikeyFanOut) {
+    std::vector<BSONObj> values;
+    for (int doc = 0; doc < 100; ++doc) {
+        for (int key = 0; key < 3; ++key) {
+            values.push_back(BSON("" << doc * 3 + key));
+        }
+    }
+    IndexStatistics stats = IndexStatistics::build(values, 100, 1000);
+    ASSERT_EQ(3.0, stats.keysPerDocument);
+    ASSERT_EQ(3000.0, stats.estimatedNumKeys());
+}
+
+TEST(IndexStatisticsTest, DistinctValuesScaleWithCollection) {
+    // Every sampled value is different, so the whole collection probably has many more.
+    IndexStatistics unique = IndexStatistics::build(valuesInRange(0, 100), 100, 10000);
+    ASSERT_GT(unique.distinctValues, 1000.0);
+    ASSERT_LTE(unique.distinctValues, 10000.0);
+
+    // Every value is sampled many times, so there are probably no others.
+    std::vector<BSONObj> values;
+    for (int i = 0; i < 100; ++i) {
+        values.push_back(BSON("" << i % 5));
+    }
+    IndexStatistics repeated = IndexStatistics::build(values, 100, 10000);
+    ASSERT_EQ(5.0, repeated.distinctValues);
+}
+
+TEST(IndexStatisticsTest, ToBSON) {
+    IndexStatistics stats = IndexStatistics::build(valuesInRange(0, 10), 10, 20);
+    BSONObj obj = stats.toBSON();
+    ASSERT_EQ(20, obj["numRecords"].numberLong());
+    ASSERT_EQ(10, obj["keysSampled"].numberLong());
+    ASSERT_EQ(0, obj["lowerBound"].numberInt());
+    ASSERT_EQ(static_cast<int>(stats.buckets.size()), obj["histogram"].Obj().nFields());
+}
+
+}  // namespace
+}  // namespace mongo
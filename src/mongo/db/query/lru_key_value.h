@@ -140,16 +140,25 @@ public:
             return Status(ErrorCodes::NoSuchKey, "no such key in LRU key-value store");
         }
         KVListIt found = i->second;
-        V* foundEntry = found->second;
 
         // Promote the kv-store entry to the front of the list.
-        // It is now the most recently used.
-        _kvMap.erase(i);
-        _kvList.erase(found);
-        _kvList.push_front(std::make_pair(key, foundEntry));
-        _kvMap[key] = _kvList.begin();
+        // It is now the most recently used. Splicing keeps 'found', and so the map entry
+        // pointing at it, valid without reallocating the list node.
+        _kvList.splice(_kvList.begin(), _kvList, found);
+
+        *entryOut = found->second;
+        return Status::OK();
+    }
 
-        *entryOut = foundEntry;
+    /**
+     * Like get(), but leaves the retrieved entry's position in the recency order unchanged.
+     */
+    Status peek(const K& key, V** entryOut) const {
+        KVMapConstIt i = _kvMap.find(key);
+        if (i == _kvMap.end()) {
+            return Status(ErrorCodes::NoSuchKey, "no such key in LRU key-value store");
+        }
+        *entryOut = i->second->second;
         return Status::OK();
     }
 
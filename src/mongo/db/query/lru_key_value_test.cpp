@@ -163,6 +163,26 @@ TEST(LRUKeyValueTest, PromotionTest) {
     }
 }
 
+/**
+ * Test that peek() returns an entry without promoting it.
+ */
+TEST(LRUKeyValueTest, PeekDoesNotPromote) {
+    LRUKeyValue<int, int> cache(2);
+    cache.add(1, new int(1));
+    cache.add(2, new int(2));
+
+    int* peeked = NULL;
+    ASSERT_OK(cache.peek(1, &peeked));
+    ASSERT_EQUALS(*peeked, 1);
+    ASSERT_NOT_OK(cache.peek(3, &peeked));
+
+    // The peeked entry is still the least recently used, so it is the one evicted.
+    std::unique_ptr<int> evicted = cache.add(3, new int(3));
+    ASSERT(NULL != evicted.get());
+    ASSERT_EQUALS(*evicted, 1);
+    assertNotInKVStore(cache, 1);
+}
+
 /**
  * Test that calling add() with a key that already exists
  * in the kv-store deletes the existing entry.
@@ -33,15 +33,21 @@
 #include "mongo/db/query/plan_cache.h"
 
 #include <algorithm>
+#include <cmath>
+#include <functional>
 #include <math.h>
 #include <memory>
 #include <vector>
 
+#include "mongo/base/counter.h"
 #include "mongo/base/owned_pointer_vector.h"
+#include "mongo/bson/simple_bsonobj_comparator.h"
 #include "mongo/client/dbclientinterface.h"  // For QueryOption_foobar
+#include "mongo/db/commands/server_status_metric.h"
 #include "mongo/db/matcher/expression_array.h"
 #include "mongo/db/matcher/expression_geo.h"
 #include "mongo/db/query/collation/collator_interface.h"
+#include "mongo/db/query/plan_cost_model.h"
 #include "mongo/db/query/plan_ranker.h"
 #include "mongo/db/query/query_knobs.h"
 #include "mongo/db/query/query_solution.h"
@@ -53,6 +59,20 @@
 namespace mongo {
 namespace {
 
+// Plan cache activity across all collections, reported in serverStatus.
+Counter64 planCacheHits;
+Counter64 planCacheMisses;
+Counter64 planCacheEvictions;
+Counter64 planCacheLockContention;
+
+ServerStatusMetricField<Counter64> displayPlanCacheHits("query.planCache.hits", &planCacheHits);
+ServerStatusMetricField<Counter64> displayPlanCacheMisses("query.planCache.misses",
+                                                          &planCacheMisses);
+ServerStatusMetricField<Counter64> displayPlanCacheEvictions("query.planCache.evictions",
+                                                             &planCacheEvictions);
+ServerStatusMetricField<Counter64> displayPlanCacheLockContention(
+    "query.planCache.lockContention", &planCacheLockContention);
+
 // Delimiters for cache key encoding.
 const char kEncodeDiscriminatorsBegin = '<';
 const char kEncodeDiscriminatorsEnd = '>';
@@ -67,7 +87,7 @@ const char kEncodeCollationSection = '#';
  * Encode user-provided string. Cache key delimiters seen in the
  * user string are escaped with a backslash.
  */
-void encodeUserString(StringData s, StringBuilder* keyBuilder) {
+void encodeUserString(StringData s, StackStringBuilder* keyBuilder) {
     for (size_t i = 0; i < s.size(); ++i) {
         char c = s[i];
         switch (c) {
@@ -243,7 +263,7 @@ const char* encodeMatchType(MatchExpression::MatchType mt) {
  * - geometry type
  * - CRS (flat or spherical)
  */
-void encodeGeoMatchExpression(const GeoMatchExpression* tree, StringBuilder* keyBuilder) {
+void encodeGeoMatchExpression(const GeoMatchExpression* tree, StackStringBuilder* keyBuilder) {
     const GeoExpression& geoQuery = tree->getGeoExpression();
 
     // Type of geo query.
@@ -283,7 +303,8 @@ void encodeGeoMatchExpression(const GeoMatchExpression* tree, StringBuilder* key
  * - isNearSphere
  * - CRS (flat or spherical)
  */
-void encodeGeoNearMatchExpression(const GeoNearMatchExpression* tree, StringBuilder* keyBuilder) {
+void encodeGeoNearMatchExpression(const GeoNearMatchExpression* tree,
+                                  StackStringBuilder* keyBuilder) {
     const GeoNearExpression& nearQuery = tree->getData();
 
     // isNearSphere
@@ -374,7 +395,8 @@ CachedSolution::CachedSolution(const PlanCacheKey& key, const PlanCacheEntry& en
       sort(entry.sort.getOwned()),
       projection(entry.projection.getOwned()),
       collation(entry.collation.getOwned()),
-      decisionWorks(entry.decision->stats[0]->common.works) {
+      decisionWorks(entry.decision->stats[0]->common.works),
+      selectivityBucket(entry.selectivityBucket) {
     // CachedSolution should not having any references into
     // cache entry. All relevant data should be cloned/copied.
     for (size_t i = 0; i < entry.plannerData.size(); ++i) {
@@ -437,6 +459,7 @@ PlanCacheEntry* PlanCacheEntry::clone() const {
     entry->projection = projection.getOwned();
     entry->collation = collation.getOwned();
     entry->timeOfCreation = timeOfCreation;
+    entry->selectivityBucket = selectivityBucket;
 
     // Copy performance stats.
     for (size_t i = 0; i < feedback.size(); ++i) {
@@ -521,6 +544,87 @@ std::string PlanCacheIndexTree::toString(int indents) const {
     return result.str();
 }
 
+BSONObj PlanCacheIndexTree::toBSON() const {
+    BSONObjBuilder bob;
+    if (entry) {
+        bob.append("index", entry->name);
+        bob.append("keyPattern", entry->keyPattern);
+    }
+    bob.append("position", static_cast<long long>(index_pos));
+    bob.append("canCombineBounds", canCombineBounds);
+
+    if (!orPushdowns.empty()) {
+        BSONArrayBuilder pushdownsBob(bob.subarrayStart("orPushdowns"));
+        for (const auto& orPushdown : orPushdowns) {
+            BSONObjBuilder pushdownBob(pushdownsBob.subobjStart());
+            pushdownBob.append("index", orPushdown.indexName);
+            pushdownBob.append("position", static_cast<long long>(orPushdown.position));
+            pushdownBob.append("canCombineBounds", orPushdown.canCombineBounds);
+            BSONArrayBuilder routeBob(pushdownBob.subarrayStart("route"));
+            for (auto step : orPushdown.route) {
+                routeBob.append(static_cast<long long>(step));
+            }
+            routeBob.doneFast();
+            pushdownBob.doneFast();
+        }
+        pushdownsBob.doneFast();
+    }
+
+    if (!children.empty()) {
+        BSONArrayBuilder childrenBob(bob.subarrayStart("children"));
+        for (const PlanCacheIndexTree* child : children) {
+            childrenBob.append(child->toBSON());
+        }
+        childrenBob.doneFast();
+    }
+    return bob.obj();
+}
+
+// static
+StatusWith<std::unique_ptr<PlanCacheIndexTree>> PlanCacheIndexTree::fromBSON(
+    const BSONObj& obj, const std::vector<IndexEntry>& indices) {
+    auto tree = stdx::make_unique<PlanCacheIndexTree>();
+
+    if (obj.hasField("index")) {
+        const std::string indexName = obj.getStringField("index");
+        const BSONObj keyPattern = obj.getObjectField("keyPattern");
+        auto it = std::find_if(indices.begin(), indices.end(), [&](const IndexEntry& ie) {
+            return ie.name == indexName &&
+                SimpleBSONObjComparator::kInstance.evaluate(ie.keyPattern == keyPattern);
+        });
+        if (it == indices.end()) {
+            return Status(ErrorCodes::IndexNotFound,
+                          str::stream() << "index " << indexName << " with key pattern "
+                                        << keyPattern
+                                        << " no longer exists");
+        }
+        tree->setIndexEntry(*it);
+    }
+    tree->index_pos = obj["position"].numberLong();
+    tree->canCombineBounds = obj["canCombineBounds"].trueValue();
+
+    for (auto&& pushdownElt : obj.getObjectField("orPushdowns")) {
+        const BSONObj pushdownObj = pushdownElt.Obj();
+        OrPushdown orPushdown;
+        orPushdown.indexName = pushdownObj.getStringField("index");
+        orPushdown.position = pushdownObj["position"].numberLong();
+        orPushdown.canCombineBounds = pushdownObj["canCombineBounds"].trueValue();
+        for (auto&& stepElt : pushdownObj.getObjectField("route")) {
+            orPushdown.route.push_back(stepElt.numberLong());
+        }
+        tree->orPushdowns.push_back(std::move(orPushdown));
+    }
+
+    for (auto&& childElt : obj.getObjectField("children")) {
+        auto child = fromBSON(childElt.Obj(), indices);
+        if (!child.isOK()) {
+            return child.getStatus();
+        }
+        tree->children.push_back(child.getValue().release());
+    }
+    return {std::move(tree)};
+}
+
 //
 // SolutionCacheData
 //
@@ -555,13 +659,78 @@ std::string SolutionCacheData::toString() const {
     MONGO_UNREACHABLE;
 }
 
+BSONObj SolutionCacheData::toBSON() const {
+    BSONObjBuilder bob;
+    switch (solnType) {
+        case WHOLE_IXSCAN_SOLN:
+            bob.append("type", "wholeIndexScan");
+            bob.append("direction", wholeIXSolnDir);
+            break;
+        case COLLSCAN_SOLN:
+            bob.append("type", "collectionScan");
+            break;
+        case USE_INDEX_TAGS_SOLN:
+            bob.append("type", "indexTags");
+            break;
+    }
+    if (tree) {
+        bob.append("tree", tree->toBSON());
+    }
+    bob.append("indexFilterApplied", indexFilterApplied);
+    return bob.obj();
+}
+
+// static
+StatusWith<std::unique_ptr<SolutionCacheData>> SolutionCacheData::fromBSON(
+    const BSONObj& obj, const std::vector<IndexEntry>& indices) {
+    auto cacheData = stdx::make_unique<SolutionCacheData>();
+
+    const StringData type = obj.getStringField("type");
+    if (type == "wholeIndexScan") {
+        cacheData->solnType = WHOLE_IXSCAN_SOLN;
+        cacheData->wholeIXSolnDir = obj["direction"].numberInt();
+    } else if (type == "collectionScan") {
+        cacheData->solnType = COLLSCAN_SOLN;
+    } else if (type == "indexTags") {
+        cacheData->solnType = USE_INDEX_TAGS_SOLN;
+    } else {
+        return Status(ErrorCodes::BadValue,
+                      str::stream() << "unknown cached solution type: " << type);
+    }
+
+    if (obj.hasField("tree")) {
+        auto tree = PlanCacheIndexTree::fromBSON(obj.getObjectField("tree"), indices);
+        if (!tree.isOK()) {
+            return tree.getStatus();
+        }
+        cacheData->tree = std::move(tree.getValue());
+    } else if (COLLSCAN_SOLN != cacheData->solnType) {
+        return Status(ErrorCodes::BadValue, "cached index solution has no index tree");
+    }
+    cacheData->indexFilterApplied = obj["indexFilterApplied"].trueValue();
+    return {std::move(cacheData)};
+}
+
 //
 // PlanCache
 //
 
-PlanCache::PlanCache() : _cache(internalQueryCacheSize.load()) {}
-
-PlanCache::PlanCache(const std::string& ns) : _cache(internalQueryCacheSize.load()), _ns(ns) {}
+PlanCache::PlanCache() : PlanCache("") {}
+
+PlanCache::PlanCache(const std::string& ns) : _ns(ns) {
+    // Split the capacity evenly between the shards, but never create more shards than there are
+    // entries to hold.
+    const size_t maxSize = std::max(0, internalQueryCacheSize.load());
+    const size_t maxShards = std::max(1, internalQueryCacheShards.load());
+    const size_t numShards = std::max(size_t(1), std::min(maxSize, maxShards));
+    // The first 'maxSize % numShards' shards take one extra entry each, so that the shard sizes
+    // add up to exactly 'maxSize'.
+    const size_t shardSize = maxSize / numShards;
+    const size_t remainder = maxSize % numShards;
+    for (size_t i = 0; i < numShards; ++i) {
+        _shards.push_back(stdx::make_unique<Shard>(shardSize + (i < remainder ? 1 : 0)));
+    }
+}
 
 PlanCache::~PlanCache() {}
 
@@ -570,7 +739,8 @@ PlanCache::~PlanCache() {}
  * Appends an encoding of each node's match type and path name
  * to the output stream.
  */
-void PlanCache::encodeKeyForMatch(const MatchExpression* tree, StringBuilder* keyBuilder) const {
+void PlanCache::encodeKeyForMatch(const MatchExpression* tree,
+                                  StackStringBuilder* keyBuilder) const {
     // Encode match type and path.
     *keyBuilder << encodeMatchType(tree->matchType());
 
@@ -617,7 +787,7 @@ void PlanCache::encodeKeyForMatch(const MatchExpression* tree, StringBuilder* ke
  * Sort order is normalized because it provided by
  * QueryRequest.
  */
-void PlanCache::encodeKeyForSort(const BSONObj& sortObj, StringBuilder* keyBuilder) const {
+void PlanCache::encodeKeyForSort(const BSONObj& sortObj, StackStringBuilder* keyBuilder) const {
     if (sortObj.isEmpty()) {
         return;
     }
@@ -655,7 +825,7 @@ void PlanCache::encodeKeyForSort(const BSONObj& sortObj, StringBuilder* keyBuild
  * Orders the encoded elements in the projection by field name.
  * This handles all the special projection types ($meta, $elemMatch, etc.)
  */
-void PlanCache::encodeKeyForProj(const BSONObj& projObj, StringBuilder* keyBuilder) const {
+void PlanCache::encodeKeyForProj(const BSONObj& projObj, StackStringBuilder* keyBuilder) const {
     // Sorts the BSON elements by field name using a map.
     std::map<StringData, BSONElement> elements;
 
@@ -728,6 +898,7 @@ Status PlanCache::add(const CanonicalQuery& query,
         entry->collation = query.getCollator()->getSpec().toBSON();
     }
     entry->timeOfCreation = now;
+    entry->selectivityBucket = computeSelectivityBucket(*solns[0]);
 
 
     // Strip projections on $-prefixed fields, as these are added by internal callers of the query
@@ -741,12 +912,44 @@ Status PlanCache::add(const CanonicalQuery& query,
     }
     entry->projection = projBuilder.obj();
 
-    stdx::lock_guard<stdx::mutex> cacheLock(_cacheMutex);
-    std::unique_ptr<PlanCacheEntry> evictedEntry = _cache.add(computeKey(query), entry);
+    return insert(computeKey(query), std::unique_ptr<PlanCacheEntry>(entry), false);
+}
+
+Status PlanCache::restore(const CanonicalQuery& query, PlanCacheEntry* entry) {
+    return insert(computeKey(query), std::unique_ptr<PlanCacheEntry>(entry), true);
+}
+
+Status PlanCache::insert(PlanCacheKey key,
+                         std::unique_ptr<PlanCacheEntry> entry,
+                         bool keepExisting) {
+    const size_t keyHash = std::hash<PlanCacheKey>()(key);
+    Shard& shard = shardFor(keyHash);
+
+    std::unique_ptr<KeyedEntry> evicted;
+    {
+        auto cacheLock = lockShard(shard);
+        if (KeyedEntry* keyedEntry = findInShard(shard, keyHash, key)) {
+            if (keepExisting &&
+                std::any_of(keyedEntry->entries.begin(),
+                            keyedEntry->entries.end(),
+                            [&entry](const std::unique_ptr<PlanCacheEntry>& existing) {
+                                return KeyedEntry::overlaps(*existing, *entry);
+                            })) {
+                return Status(ErrorCodes::BadValue,
+                              "a plan for this query shape and selectivity is already cached");
+            }
+            keyedEntry->add(entry.release());
+        } else {
+            auto newKeyedEntry = stdx::make_unique<KeyedEntry>(std::move(key));
+            newKeyedEntry->add(entry.release());
+            evicted = shard.cache.add(keyHash, newKeyedEntry.release());
+        }
+    }
 
-    if (NULL != evictedEntry.get()) {
+    if (evicted) {
+        planCacheEvictions.increment();
         LOG(1) << _ns << ": plan cache maximum size exceeded - "
-               << "removed least recently used entry " << redact(evictedEntry->toString());
+               << "removed least recently used entry " << redact(evicted->entries[0]->toString());
     }
 
     return Status::OK();
@@ -756,33 +959,67 @@ Status PlanCache::get(const CanonicalQuery& query, CachedSolution** crOut) const
     PlanCacheKey key = computeKey(query);
     verify(crOut);
 
-    stdx::lock_guard<stdx::mutex> cacheLock(_cacheMutex);
-    PlanCacheEntry* entry;
-    Status cacheStatus = _cache.get(key, &entry);
-    if (!cacheStatus.isOK()) {
-        return cacheStatus;
+    const size_t keyHash = std::hash<PlanCacheKey>()(key);
+    const Shard& shard = shardFor(keyHash);
+    auto cacheLock = lockShard(shard);
+    KeyedEntry* keyedEntry = findInShard(shard, keyHash, key);
+    if (!keyedEntry) {
+        planCacheMisses.increment();
+        return Status(ErrorCodes::NoSuchKey, "no such key in plan cache");
     }
-    invariant(entry);
+    planCacheHits.increment();
+
+    *crOut = new CachedSolution(key, *keyedEntry->entries[0]);
+
+    return Status::OK();
+}
+
+Status PlanCache::get(const CanonicalQuery& query,
+                      int selectivityBucket,
+                      CachedSolution** crOut) const {
+    PlanCacheKey key = computeKey(query);
+    verify(crOut);
+
+    const size_t keyHash = std::hash<PlanCacheKey>()(key);
+    const Shard& shard = shardFor(keyHash);
+    auto cacheLock = lockShard(shard);
+    KeyedEntry* keyedEntry = findInShard(shard, keyHash, key);
+    PlanCacheEntry* entry = keyedEntry ? keyedEntry->get(selectivityBucket) : NULL;
+    if (!entry) {
+        planCacheMisses.increment();
+        return Status(ErrorCodes::NoSuchKey, "no such key in plan cache");
+    }
+    planCacheHits.increment();
 
     *crOut = new CachedSolution(key, *entry);
 
     return Status::OK();
 }
 
-Status PlanCache::feedback(const CanonicalQuery& cq, PlanCacheEntryFeedback* feedback) {
+Status PlanCache::feedback(const CanonicalQuery& cq,
+                           const boost::optional<int>& selectivityBucket,
+                           PlanCacheEntryFeedback* feedback) {
     if (NULL == feedback) {
         return Status(ErrorCodes::BadValue, "feedback is NULL");
     }
     std::unique_ptr<PlanCacheEntryFeedback> autoFeedback(feedback);
     PlanCacheKey ck = computeKey(cq);
 
-    stdx::lock_guard<stdx::mutex> cacheLock(_cacheMutex);
-    PlanCacheEntry* entry;
-    Status cacheStatus = _cache.get(ck, &entry);
-    if (!cacheStatus.isOK()) {
-        return cacheStatus;
+    const size_t keyHash = std::hash<PlanCacheKey>()(ck);
+    const Shard& shard = shardFor(keyHash);
+    auto cacheLock = lockShard(shard);
+    KeyedEntry* keyedEntry = findInShard(shard, keyHash, ck);
+    if (!keyedEntry) {
+        return Status(ErrorCodes::NoSuchKey, "no such key in plan cache");
+    }
+
+    // Another query of the same shape may have made a different bucket's entry the most recently
+    // used one since the plan was looked up, so the feedback must be matched to its bucket.
+    auto it = keyedEntry->find(selectivityBucket);
+    if (it == keyedEntry->entries.end()) {
+        return Status(ErrorCodes::NoSuchKey, "no such selectivity bucket in plan cache");
     }
-    invariant(entry);
+    PlanCacheEntry* entry = it->get();
 
     // We store up to a constant number of feedback entries.
     if (entry->feedback.size() < static_cast<size_t>(internalQueryCacheFeedbacksStored.load())) {
@@ -793,17 +1030,49 @@ Status PlanCache::feedback(const CanonicalQuery& cq, PlanCacheEntryFeedback* fee
 }
 
 Status PlanCache::remove(const CanonicalQuery& canonicalQuery) {
-    stdx::lock_guard<stdx::mutex> cacheLock(_cacheMutex);
-    return _cache.remove(computeKey(canonicalQuery));
+    PlanCacheKey key = computeKey(canonicalQuery);
+    const size_t keyHash = std::hash<PlanCacheKey>()(key);
+    Shard& shard = shardFor(keyHash);
+    auto cacheLock = lockShard(shard);
+    if (!findInShard(shard, keyHash, key)) {
+        return Status(ErrorCodes::NoSuchKey, "no such key in plan cache");
+    }
+    return shard.cache.remove(keyHash);
+}
+
+Status PlanCache::remove(const CanonicalQuery& canonicalQuery,
+                         const boost::optional<int>& selectivityBucket) {
+    PlanCacheKey key = computeKey(canonicalQuery);
+    const size_t keyHash = std::hash<PlanCacheKey>()(key);
+    Shard& shard = shardFor(keyHash);
+    auto cacheLock = lockShard(shard);
+    KeyedEntry* keyedEntry = findInShard(shard, keyHash, key, false /* promote */);
+    if (!keyedEntry) {
+        return Status(ErrorCodes::NoSuchKey, "no such key in plan cache");
+    }
+    auto it = keyedEntry->find(selectivityBucket);
+    if (it == keyedEntry->entries.end()) {
+        return Status(ErrorCodes::NoSuchKey, "no such selectivity bucket in plan cache");
+    }
+
+    // A shape stays in the cache only while it has an entry for some bucket.
+    if (keyedEntry->entries.size() == 1U) {
+        return shard.cache.remove(keyHash);
+    }
+    keyedEntry->entries.erase(it);
+    return Status::OK();
 }
 
 void PlanCache::clear() {
-    stdx::lock_guard<stdx::mutex> cacheLock(_cacheMutex);
-    _cache.clear();
+    for (auto&& shard : _shards) {
+        auto cacheLock = lockShard(*shard);
+        shard->cache.clear();
+    }
 }
 
 PlanCacheKey PlanCache::computeKey(const CanonicalQuery& cq) const {
-    StringBuilder keyBuilder;
+    // Most keys fit in the builder's inline buffer, avoiding a heap allocation per lookup.
+    StackStringBuilder keyBuilder;
     encodeKeyForMatch(cq.root(), &keyBuilder);
     encodeKeyForSort(cq.getQueryRequest().getSort(), &keyBuilder);
     encodeKeyForProj(cq.getQueryRequest().getProj(), &keyBuilder);
@@ -814,39 +1083,133 @@ Status PlanCache::getEntry(const CanonicalQuery& query, PlanCacheEntry** entryOu
     PlanCacheKey key = computeKey(query);
     verify(entryOut);
 
-    stdx::lock_guard<stdx::mutex> cacheLock(_cacheMutex);
-    PlanCacheEntry* entry;
-    Status cacheStatus = _cache.get(key, &entry);
-    if (!cacheStatus.isOK()) {
-        return cacheStatus;
+    const size_t keyHash = std::hash<PlanCacheKey>()(key);
+    const Shard& shard = shardFor(keyHash);
+    auto cacheLock = lockShard(shard);
+    KeyedEntry* keyedEntry = findInShard(shard, keyHash, key);
+    if (!keyedEntry) {
+        return Status(ErrorCodes::NoSuchKey, "no such key in plan cache");
     }
-    invariant(entry);
 
-    *entryOut = entry->clone();
+    *entryOut = keyedEntry->entries[0]->clone();
 
     return Status::OK();
 }
 
 std::vector<PlanCacheEntry*> PlanCache::getAllEntries() const {
-    stdx::lock_guard<stdx::mutex> cacheLock(_cacheMutex);
     std::vector<PlanCacheEntry*> entries;
-    typedef std::list<std::pair<PlanCacheKey, PlanCacheEntry*>>::const_iterator ConstIterator;
-    for (ConstIterator i = _cache.begin(); i != _cache.end(); i++) {
-        PlanCacheEntry* entry = i->second;
-        entries.push_back(entry->clone());
+    for (auto&& shard : _shards) {
+        auto cacheLock = lockShard(*shard);
+        for (auto i = shard->cache.begin(); i != shard->cache.end(); i++) {
+            for (auto&& entry : i->second->entries) {
+                entries.push_back(entry->clone());
+            }
+        }
     }
 
     return entries;
 }
 
 bool PlanCache::contains(const CanonicalQuery& cq) const {
-    stdx::lock_guard<stdx::mutex> cacheLock(_cacheMutex);
-    return _cache.hasKey(computeKey(cq));
+    PlanCacheKey key = computeKey(cq);
+    const size_t keyHash = std::hash<PlanCacheKey>()(key);
+    const Shard& shard = shardFor(keyHash);
+    auto cacheLock = lockShard(shard);
+    // Looking an entry up without using it must not make it less likely to be evicted.
+    return findInShard(shard, keyHash, key, false /* promote */) != NULL;
 }
 
 size_t PlanCache::size() const {
-    stdx::lock_guard<stdx::mutex> cacheLock(_cacheMutex);
-    return _cache.size();
+    size_t total = 0;
+    for (auto&& shard : _shards) {
+        auto cacheLock = lockShard(*shard);
+        for (auto i = shard->cache.begin(); i != shard->cache.end(); i++) {
+            total += i->second->entries.size();
+        }
+    }
+    return total;
+}
+
+// static
+boost::optional<int> PlanCache::computeSelectivityBucket(const QuerySolution& soln) {
+    if (!soln.root) {
+        return boost::none;
+    }
+    auto keysExamined = PlanCostModel::estimateKeysExamined(soln.root.get());
+    if (!keysExamined) {
+        return boost::none;
+    }
+    return static_cast<int>(std::floor(std::log10(*keysExamined + 1)));
+}
+
+void PlanCache::KeyedEntry::add(PlanCacheEntry* entry) {
+    entries.erase(std::remove_if(entries.begin(),
+                                 entries.end(),
+                                 [entry](const std::unique_ptr<PlanCacheEntry>& existing) {
+                                     return overlaps(*existing, *entry);
+                                 }),
+                  entries.end());
+    entries.emplace(entries.begin(), entry);
+}
+
+// static
+bool PlanCache::KeyedEntry::overlaps(const PlanCacheEntry& a, const PlanCacheEntry& b) {
+    // An entry for a selectivity bucket replaces the previous entry for that bucket, as well as
+    // any entry which served every bucket. An entry which serves every bucket replaces them all.
+    return !a.selectivityBucket || !b.selectivityBucket ||
+        *a.selectivityBucket == *b.selectivityBucket;
+}
+
+PlanCacheEntry* PlanCache::KeyedEntry::get(int selectivityBucket) {
+    for (auto it = entries.begin(); it != entries.end(); ++it) {
+        if ((*it)->selectivityBucket && *(*it)->selectivityBucket == selectivityBucket) {
+            std::rotate(entries.begin(), it, it + 1);
+            return entries.front().get();
+        }
+    }
+    return NULL;
+}
+
+std::vector<std::unique_ptr<PlanCacheEntry>>::iterator PlanCache::KeyedEntry::find(
+    const boost::optional<int>& selectivityBucket) {
+    return std::find_if(entries.begin(),
+                        entries.end(),
+                        [&selectivityBucket](const std::unique_ptr<PlanCacheEntry>& entry) {
+                            return entry->selectivityBucket == selectivityBucket;
+                        });
+}
+
+PlanCache::Shard& PlanCache::shardFor(size_t keyHash) const {
+    return *_shards[keyHash % _shards.size()];
+}
+
+PlanCache::KeyedEntry* PlanCache::findInShard(const Shard& shard,
+                                              size_t keyHash,
+                                              const PlanCacheKey& key,
+                                              bool promote) {
+    KeyedEntry* keyedEntry;
+    const Status status =
+        promote ? shard.cache.get(keyHash, &keyedEntry) : shard.cache.peek(keyHash, &keyedEntry);
+    if (!status.isOK()) {
+        return NULL;
+    }
+    invariant(keyedEntry);
+
+    // Two different keys may share a hash. The later of them to be added replaces the earlier,
+    // so a mismatch here means the query's own entries are not cached.
+    if (keyedEntry->key != key) {
+        return NULL;
+    }
+    return keyedEntry;
+}
+
+stdx::unique_lock<stdx::mutex> PlanCache::lockShard(const Shard& shard) {
+    stdx::unique_lock<stdx::mutex> lock(shard.mutex, stdx::try_to_lock);
+    if (!lock.owns_lock()) {
+        planCacheLockContention.increment();
+        lock.lock();
+    }
+    return lock;
 }
 
 void PlanCache::notifyOfIndexEntries(const std::vector<IndexEntry>& indexEntries) {
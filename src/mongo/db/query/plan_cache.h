@@ -29,8 +29,11 @@
 #pragma once
 
 #include <boost/optional/optional.hpp>
+#include <memory>
 #include <set>
+#include <vector>
 
+#include "mongo/bson/util/builder.h"
 #include "mongo/db/exec/plan_stats.h"
 #include "mongo/db/query/canonical_query.h"
 #include "mongo/db/query/index_tag.h"
@@ -124,6 +127,19 @@ struct PlanCacheIndexTree {
      */
     std::string toString(int indents = 0) const;
 
+    /**
+     * Serializes the tree so that it can be persisted. Index entries are recorded by name and key
+     * pattern only.
+     */
+    BSONObj toBSON() const;
+
+    /**
+     * Parses a tree serialized by toBSON(), resolving each index it names against 'indices'.
+     * Returns an error if an index no longer exists with the key pattern it was recorded with.
+     */
+    static StatusWith<std::unique_ptr<PlanCacheIndexTree>> fromBSON(
+        const BSONObj& obj, const std::vector<IndexEntry>& indices);
+
     // Children owned here.
     std::vector<PlanCacheIndexTree*> children;
 
@@ -159,6 +175,13 @@ struct SolutionCacheData {
     // For debugging.
     std::string toString() const;
 
+    // Serializes the cache data so that it can be persisted. See PlanCacheIndexTree::toBSON().
+    BSONObj toBSON() const;
+
+    // Parses cache data serialized by toBSON(), resolving the indexes it uses against 'indices'.
+    static StatusWith<std::unique_ptr<SolutionCacheData>> fromBSON(
+        const BSONObj& obj, const std::vector<IndexEntry>& indices);
+
     // Owned here. If 'wholeIXSoln' is false, then 'tree'
     // can be used to tag an isomorphic match expression. If 'wholeIXSoln'
     // is true, then 'tree' is used to store the relevant IndexEntry.
@@ -221,6 +244,10 @@ public:
     // The number of work cycles taken to decide on a winning plan when the plan was first
     // cached.
     size_t decisionWorks;
+
+    // The selectivity bucket the plan was chosen under, or boost::none if it serves queries of
+    // any selectivity. See PlanCache::computeSelectivityBucket().
+    boost::optional<int> selectivityBucket;
 };
 
 /**
@@ -269,6 +296,12 @@ public:
     BSONObj collation;
     Date_t timeOfCreation;
 
+    // The selectivity bucket of the query whose candidate plans were ranked to create this entry.
+    // Queries of the same shape whose values put them in another bucket are planned, and cached,
+    // separately. boost::none when index statistics couldn't estimate the winning plan, in which
+    // case the entry serves queries of any selectivity.
+    boost::optional<int> selectivityBucket;
+
     //
     // Performance stats
     //
@@ -300,6 +333,17 @@ public:
      */
     static bool shouldCacheQuery(const CanonicalQuery& query);
 
+    /**
+     * Returns the selectivity bucket of 'soln': the order of magnitude of the number of index keys
+     * its index scans are estimated to examine, according to the statistics of their indexes.
+     * Returns boost::none if some leaf of the solution isn't an index scan which can be estimated.
+     *
+     * A shape's plan is only reused for queries which fall in the bucket it was chosen under, so
+     * that a plan picked for selective values isn't run with values which match most of the
+     * collection, or vice versa.
+     */
+    static boost::optional<int> computeSelectivityBucket(const QuerySolution& soln);
+
     /**
      * If omitted, namespace set to empty string.
      */
@@ -319,6 +363,9 @@ public:
      *
      * Takes ownership of 'why'.
      *
+     * The entry replaces the one cached for the same shape and selectivity bucket, if any. An
+     * entry with no selectivity bucket replaces every entry for the shape.
+     *
      * If the mapping was added successfully, returns Status::OK().
      * If the mapping already existed or some other error occurred, returns another Status.
      */
@@ -327,6 +374,15 @@ public:
                PlanRankingDecision* why,
                Date_t now);
 
+    /**
+     * Adds 'entry', which was read back from a checkpoint of the cache, for the shape of 'query'.
+     * Takes ownership of 'entry'.
+     *
+     * Plans cached since the checkpoint are more current, so if the cache already holds an entry
+     * for the same shape and selectivity bucket, 'entry' is discarded and an error is returned.
+     */
+    Status restore(const CanonicalQuery& query, PlanCacheEntry* entry);
+
     /**
      * Look up the cached data access for the provided 'query'.  Used by the query planner
      * to shortcut planning.
@@ -334,10 +390,17 @@ public:
      * If there is no entry in the cache for the 'query', returns an error Status.
      *
      * If there is an entry in the cache, populates 'crOut' and returns Status::OK().  Caller
-     * owns '*crOut'.
+     * owns '*crOut'. When the shape of 'query' has entries for several selectivity buckets, the
+     * most recently used one is returned.
      */
     Status get(const CanonicalQuery& query, CachedSolution** crOut) const;
 
+    /**
+     * As above, but only returns the entry cached for the shape of 'query' under
+     * 'selectivityBucket', which becomes the most recently used entry for the shape.
+     */
+    Status get(const CanonicalQuery& query, int selectivityBucket, CachedSolution** crOut) const;
+
     /**
      * When the CachedPlanStage runs a plan out of the cache, we want to record data about the
      * plan's performance.  The CachedPlanStage calls feedback(...) after executing the cached
@@ -349,16 +412,28 @@ public:
      * and an error Status is returned.
      *
      * If the entry corresponding to 'cq' still exists, 'feedback' is added to the run
-     * statistics about the plan.  Status::OK() is returned.
+     * statistics about the plan.  Status::OK() is returned. The feedback goes to the entry for
+     * the shape of 'cq' under 'selectivityBucket', which is the CachedSolution's bucket that the
+     * CachedPlanStage was built from.
      */
-    Status feedback(const CanonicalQuery& cq, PlanCacheEntryFeedback* feedback);
+    Status feedback(const CanonicalQuery& cq,
+                    const boost::optional<int>& selectivityBucket,
+                    PlanCacheEntryFeedback* feedback);
 
     /**
-     * Remove the entry corresponding to 'ck' from the cache.  Returns Status::OK() if the plan
-     * was present and removed and an error status otherwise.
+     * Remove the entries for the shape of 'canonicalQuery', whatever their selectivity bucket,
+     * from the cache.  Returns Status::OK() if the plan was present and removed and an error
+     * status otherwise.
      */
     Status remove(const CanonicalQuery& canonicalQuery);
 
+    /**
+     * As above, but only removes the entry for the shape of 'canonicalQuery' under
+     * 'selectivityBucket', leaving the plans cached for its other buckets in place.
+     */
+    Status remove(const CanonicalQuery& canonicalQuery,
+                  const boost::optional<int>& selectivityBucket);
+
     /**
      * Remove *all* cached plans.  Does not clear index information.
      */
@@ -382,7 +457,7 @@ public:
      * If there is no entry in the cache for the 'query', returns an error Status.
      *
      * If there is an entry in the cache, populates 'entryOut' and returns Status::OK().  Caller
-     * owns '*entryOut'.
+     * owns '*entryOut'. As with get(), this is the most recently used entry for the shape.
      */
     Status getEntry(const CanonicalQuery& cq, PlanCacheEntry** entryOut) const;
 
@@ -396,12 +471,11 @@ public:
 
     /**
      * Returns true if there is an entry in the cache for the 'query'.
-     * Internally calls hasKey() on the LRU cache.
      */
     bool contains(const CanonicalQuery& cq) const;
 
     /**
-     * Returns number of entries in cache.
+     * Returns number of entries in cache, counting each selectivity bucket of a shape separately.
      * Used for testing.
      */
     size_t size() const;
@@ -415,14 +489,90 @@ public:
     void notifyOfIndexEntries(const std::vector<IndexEntry>& indexEntries);
 
 private:
-    void encodeKeyForMatch(const MatchExpression* tree, StringBuilder* keyBuilder) const;
-    void encodeKeyForSort(const BSONObj& sortObj, StringBuilder* keyBuilder) const;
-    void encodeKeyForProj(const BSONObj& projObj, StringBuilder* keyBuilder) const;
+    /**
+     * The cache entries for one query shape, together with the full key they were added under.
+     * Shards are keyed by a hash of the PlanCacheKey, so lookups compare the stored key in order
+     * to detect hash collisions.
+     */
+    struct KeyedEntry {
+        explicit KeyedEntry(PlanCacheKey key) : key(std::move(key)) {}
+
+        /**
+         * Takes ownership of 'entry' and makes it the most recently used entry for the shape,
+         * discarding the entries it supersedes.
+         */
+        void add(PlanCacheEntry* entry);
+
+        /**
+         * Returns the entry for 'selectivityBucket', after making it the most recently used, or
+         * NULL if there is none.
+         */
+        PlanCacheEntry* get(int selectivityBucket);
+
+        /**
+         * Returns the position of the entry cached under exactly 'selectivityBucket', without
+         * changing the order of the entries, or entries.end() if there is none.
+         */
+        std::vector<std::unique_ptr<PlanCacheEntry>>::iterator find(
+            const boost::optional<int>& selectivityBucket);
+
+        /**
+         * Returns true if one of 'a' and 'b' would replace the other when added.
+         */
+        static bool overlaps(const PlanCacheEntry& a, const PlanCacheEntry& b);
+
+        PlanCacheKey key;
+
+        // One entry per selectivity bucket, most recently used first. Never empty. The number of
+        // entries is bounded by the number of orders of magnitude in the size of the indexes.
+        std::vector<std::unique_ptr<PlanCacheEntry>> entries;
+    };
+
+    /**
+     * One partition of the cache. Each shard has its own LRU list and mutex, so that operations
+     * on queries of different shapes rarely contend with each other.
+     */
+    struct Shard {
+        explicit Shard(size_t maxSize) : cache(maxSize) {}
+
+        LRUKeyValue<size_t, KeyedEntry> cache;
 
-    LRUKeyValue<PlanCacheKey, PlanCacheEntry> _cache;
+        // Protects 'cache'.
+        mutable stdx::mutex mutex;
+    };
+
+    /**
+     * Adds 'entry' under 'key'. When 'keepExisting' is true, nothing is added if an entry which
+     * 'entry' would replace is already cached.
+     */
+    Status insert(PlanCacheKey key, std::unique_ptr<PlanCacheEntry> entry, bool keepExisting);
+
+    void encodeKeyForMatch(const MatchExpression* tree, StackStringBuilder* keyBuilder) const;
+    void encodeKeyForSort(const BSONObj& sortObj, StackStringBuilder* keyBuilder) const;
+    void encodeKeyForProj(const BSONObj& projObj, StackStringBuilder* keyBuilder) const;
+
+    /**
+     * Returns the shard responsible for keys with hash 'keyHash'.
+     */
+    Shard& shardFor(size_t keyHash) const;
+
+    /**
+     * Returns the entries stored in 'shard' for 'key', or NULL if there are none. 'keyHash' must be
+     * the hash of 'key', and the caller must hold the shard's mutex. Unless 'promote' is false,
+     * the entries become the shard's most recently used.
+     */
+    static KeyedEntry* findInShard(const Shard& shard,
+                                   size_t keyHash,
+                                   const PlanCacheKey& key,
+                                   bool promote = true);
+
+    /**
+     * Locks 'shard', recording in serverStatus whether the lock was contended.
+     */
+    static stdx::unique_lock<stdx::mutex> lockShard(const Shard& shard);
 
-    // Protects _cache.
-    mutable stdx::mutex _cacheMutex;
+    // The shards of the cache. The number of shards is fixed at construction.
+    std::vector<std::unique_ptr<Shard>> _shards;
 
     // Full namespace of collection.
     std::string _ns;
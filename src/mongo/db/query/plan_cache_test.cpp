@@ -41,6 +41,7 @@
 #include "mongo/db/matcher/extensions_callback_noop.h"
 #include "mongo/db/pipeline/expression_context_for_test.h"
 #include "mongo/db/query/collation/collator_interface_mock.h"
+#include "mongo/db/query/index_statistics.h"
 #include "mongo/db/query/plan_ranker.h"
 #include "mongo/db/query/query_knobs.h"
 #include "mongo/db/query/query_planner.h"
@@ -449,6 +450,219 @@ TEST(PlanCacheTest, AddValidSolution) {
     ASSERT_EQUALS(planCache.size(), 1U);
 }
 
+TEST(PlanCacheTest, EntriesForManyShapesAreSpreadAcrossShards) {
+    PlanCache planCache;
+    QuerySolution qs;
+    qs.cacheData.reset(new SolutionCacheData());
+    qs.cacheData->tree.reset(new PlanCacheIndexTree());
+    std::vector<QuerySolution*> solns;
+    solns.push_back(&qs);
+    QueryTestServiceContext serviceContext;
+
+    // Each query has a different shape, so each gets its own entry.
+    const std::vector<std::string> queries = {
+        "{a: 1}", "{b: 1}", "{c: 1}", "{a: 1, b: 1}", "{a: {$gt: 1}}", "{b: {$lt: 1}}"};
+    for (auto&& query : queries) {
+        unique_ptr<CanonicalQuery> cq(canonicalize(query.c_str()));
+        ASSERT_OK(planCache.add(*cq, solns, createDecision(1U), Date_t{}));
+    }
+    ASSERT_EQUALS(planCache.size(), queries.size());
+
+    for (auto&& query : queries) {
+        unique_ptr<CanonicalQuery> cq(canonicalize(query.c_str()));
+        ASSERT_TRUE(planCache.contains(*cq));
+        CachedSolution* rawCachedSolution;
+        ASSERT_OK(planCache.get(*cq, &rawCachedSolution));
+        unique_ptr<CachedSolution> cachedSolution(rawCachedSolution);
+        ASSERT_EQUALS(cachedSolution->key, planCache.computeKey(*cq));
+    }
+
+    std::vector<PlanCacheEntry*> entries = planCache.getAllEntries();
+    ASSERT_EQUALS(entries.size(), queries.size());
+    for (auto entry : entries) {
+        delete entry;
+    }
+
+    unique_ptr<CanonicalQuery> removed(canonicalize(queries[0].c_str()));
+    ASSERT_OK(planCache.remove(*removed));
+    ASSERT_FALSE(planCache.contains(*removed));
+    ASSERT_NOT_OK(planCache.remove(*removed));
+    ASSERT_EQUALS(planCache.size(), queries.size() - 1);
+
+    planCache.clear();
+    ASSERT_EQUALS(planCache.size(), 0U);
+}
+
+/**
+ * Returns a solution which scans the 'a' values [start, end] of an index with statistics over
+ * 10000 documents whose 'a' values are 0 to 9999.
+ */
+unique_ptr<QuerySolution> makeIndexScanSolution(int start, int end) {
+    std::vector<BSONObj> values;
+    for (int i = 0; i < 10000; i += 10) {
+        values.push_back(BSON("" << i));
+    }
+    IndexEntry entry(BSON("a" << 1), "a_1");
+    entry.statistics = std::make_shared<const IndexStatistics>(
+        IndexStatistics::build(values, values.size(), 10000));
+
+    auto ixn = stdx::make_unique<IndexScanNode>(entry);
+    OrderedIntervalList oil("a");
+    oil.intervals.push_back(Interval(BSON("" << start << "" << end), true, true));
+    ixn->bounds.fields.push_back(oil);
+
+    auto soln = stdx::make_unique<QuerySolution>();
+    soln->root = std::move(ixn);
+    soln->cacheData.reset(new SolutionCacheData());
+    soln->cacheData->tree.reset(new PlanCacheIndexTree());
+    return soln;
+}
+
+TEST(PlanCacheTest, SelectivityBucketIsOrderOfMagnitudeOfKeysExamined) {
+    auto narrow = PlanCache::computeSelectivityBucket(*makeIndexScanSolution(0, 99));
+    auto wide = PlanCache::computeSelectivityBucket(*makeIndexScanSolution(0, 9999));
+    ASSERT_TRUE(narrow);
+    ASSERT_TRUE(wide);
+    ASSERT_EQUALS(*wide, 4);
+    ASSERT_LESS_THAN(*narrow, *wide);
+
+    // Without statistics there is no estimate.
+    QuerySolution noRoot;
+    ASSERT_FALSE(PlanCache::computeSelectivityBucket(noRoot));
+}
+
+TEST(PlanCacheTest, CachesOnePlanPerSelectivityBucket) {
+    PlanCache planCache;
+    unique_ptr<CanonicalQuery> cq(canonicalize("{a: {$gte: 0, $lte: 99}}"));
+    QueryTestServiceContext serviceContext;
+
+    auto narrow = makeIndexScanSolution(0, 99);
+    auto wide = makeIndexScanSolution(0, 9999);
+    const int narrowBucket = *PlanCache::computeSelectivityBucket(*narrow);
+    const int wideBucket = *PlanCache::computeSelectivityBucket(*wide);
+
+    std::vector<QuerySolution*> solns{narrow.get()};
+    ASSERT_OK(planCache.add(*cq, solns, createDecision(1U), Date_t{}));
+    solns = {wide.get()};
+    ASSERT_OK(planCache.add(*cq, solns, createDecision(1U), Date_t{}));
+
+    // Both plans are cached for the one shape.
+    ASSERT_EQUALS(planCache.size(), 2U);
+
+    CachedSolution* rawCachedSolution;
+    ASSERT_OK(planCache.get(*cq, &rawCachedSolution));
+    unique_ptr<CachedSolution> cachedSolution(rawCachedSolution);
+    ASSERT_EQUALS(*cachedSolution->selectivityBucket, wideBucket);
+
+    ASSERT_OK(planCache.get(*cq, narrowBucket, &rawCachedSolution));
+    cachedSolution.reset(rawCachedSolution);
+    ASSERT_EQUALS(*cachedSolution->selectivityBucket, narrowBucket);
+    ASSERT_NOT_OK(planCache.get(*cq, wideBucket + 1, &rawCachedSolution));
+
+    // Looking up a bucket makes its plan the most recently used.
+    ASSERT_OK(planCache.get(*cq, &rawCachedSolution));
+    cachedSolution.reset(rawCachedSolution);
+    ASSERT_EQUALS(*cachedSolution->selectivityBucket, narrowBucket);
+
+    // Adding a plan for an existing bucket replaces the previous one.
+    auto narrowAgain = makeIndexScanSolution(0, 99);
+    solns = {narrowAgain.get()};
+    ASSERT_OK(planCache.add(*cq, solns, createDecision(1U), Date_t{}));
+    ASSERT_EQUALS(planCache.size(), 2U);
+
+    // Feedback goes to the entry for its bucket, even when that isn't the most recently used.
+    auto makeFeedback = [] {
+        auto feedback = stdx::make_unique<PlanCacheEntryFeedback>();
+        feedback->stats =
+            stdx::make_unique<PlanStageStats>(CommonStats("IXSCAN"), STAGE_IXSCAN);
+        feedback->score = 1.0;
+        return feedback.release();
+    };
+    ASSERT_OK(planCache.feedback(*cq, wideBucket, makeFeedback()));
+    ASSERT_NOT_OK(planCache.feedback(*cq, wideBucket + 1, makeFeedback()));
+    std::vector<PlanCacheEntry*> entries = planCache.getAllEntries();
+    for (auto&& entry : entries) {
+        ASSERT_EQUALS(entry->feedback.size(), *entry->selectivityBucket == wideBucket ? 1U : 0U);
+        delete entry;
+    }
+
+    // Removing one bucket's plan leaves the others cached.
+    ASSERT_OK(planCache.remove(*cq, wideBucket));
+    ASSERT_NOT_OK(planCache.remove(*cq, wideBucket));
+    ASSERT_EQUALS(planCache.size(), 1U);
+    ASSERT_OK(planCache.get(*cq, narrowBucket, &rawCachedSolution));
+    cachedSolution.reset(rawCachedSolution);
+    solns = {wide.get()};
+    ASSERT_OK(planCache.add(*cq, solns, createDecision(1U), Date_t{}));
+    ASSERT_EQUALS(planCache.size(), 2U);
+
+    // A plan which serves every selectivity replaces them all.
+    QuerySolution anySelectivity;
+    anySelectivity.cacheData.reset(new SolutionCacheData());
+    anySelectivity.cacheData->tree.reset(new PlanCacheIndexTree());
+    solns = {&anySelectivity};
+    ASSERT_OK(planCache.add(*cq, solns, createDecision(1U), Date_t{}));
+    ASSERT_EQUALS(planCache.size(), 1U);
+
+    // Removing the shape removes every bucket's plan.
+    ASSERT_OK(planCache.remove(*cq));
+    ASSERT_EQUALS(planCache.size(), 0U);
+}
+
+TEST(PlanCacheTest, SolutionCacheDataRoundTripsThroughBSON) {
+    IndexEntry indexA(BSON("a" << 1), "a_1");
+    IndexEntry indexB(BSON("b" << 1 << "c" << 1), "b_1_c_1");
+
+    SolutionCacheData cacheData;
+    cacheData.tree.reset(new PlanCacheIndexTree());
+    auto leafA = new PlanCacheIndexTree();
+    leafA->setIndexEntry(indexA);
+    auto leafB = new PlanCacheIndexTree();
+    leafB->setIndexEntry(indexB);
+    leafB->index_pos = 1;
+    leafB->canCombineBounds = false;
+    leafB->orPushdowns.push_back({"a_1", 0, true, {1, 0}});
+    cacheData.tree->children = {leafA, leafB};
+
+    const BSONObj serialized = cacheData.toBSON();
+    auto parsed = SolutionCacheData::fromBSON(serialized, {indexA, indexB});
+    ASSERT_OK(parsed.getStatus());
+    ASSERT_EQUALS(parsed.getValue()->toString(), cacheData.toString());
+    ASSERT_BSONOBJ_EQ(parsed.getValue()->toBSON(), serialized);
+
+    // The plan no longer applies once one of its indexes is gone, or has another key pattern.
+    ASSERT_EQUALS(SolutionCacheData::fromBSON(serialized, {indexA}).getStatus(),
+                  ErrorCodes::IndexNotFound);
+    IndexEntry redefinedB(BSON("b" << -1), "b_1_c_1");
+    ASSERT_EQUALS(SolutionCacheData::fromBSON(serialized, {indexA, redefinedB}).getStatus(),
+                  ErrorCodes::IndexNotFound);
+
+    SolutionCacheData collscan;
+    collscan.solnType = SolutionCacheData::COLLSCAN_SOLN;
+    auto parsedCollscan = SolutionCacheData::fromBSON(collscan.toBSON(), {});
+    ASSERT_OK(parsedCollscan.getStatus());
+    ASSERT_EQUALS(parsedCollscan.getValue()->solnType, SolutionCacheData::COLLSCAN_SOLN);
+}
+
+TEST(PlanCacheTest, RestoreDoesNotReplaceCachedEntries) {
+    PlanCache planCache;
+    unique_ptr<CanonicalQuery> cached(canonicalize("{a: 1}"));
+    unique_ptr<CanonicalQuery> uncached(canonicalize("{b: 1}"));
+    QuerySolution qs;
+    qs.cacheData.reset(new SolutionCacheData());
+    qs.cacheData->tree.reset(new PlanCacheIndexTree());
+    std::vector<QuerySolution*> solns{&qs};
+    QueryTestServiceContext serviceContext;
+    ASSERT_OK(planCache.add(*cached, solns, createDecision(1U), Date_t{}));
+
+    ASSERT_NOT_OK(planCache.restore(*cached, new PlanCacheEntry(solns, createDecision(1U))));
+    ASSERT_EQUALS(planCache.size(), 1U);
+
+    ASSERT_OK(planCache.restore(*uncached, new PlanCacheEntry(solns, createDecision(1U))));
+    ASSERT_TRUE(planCache.contains(*uncached));
+    ASSERT_EQUALS(planCache.size(), 2U);
+}
+
 /**
  * Each test in the CachePlanSelectionTest suite goes through
  * the following flow:
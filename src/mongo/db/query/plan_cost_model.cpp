@@ -0,0 +1,248 @@
+/**
+ *    Copyright (C) 2017 MongoDB Inc.
+ *
+ *    This program is free software: you can redistribute it and/or  modify
+ *    it under the terms of the GNU Affero General Public License, version 3,
+ *    as published by the Free Software Foundation.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU Affero General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Affero General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the GNU Affero General Public License in all respects for
+ *    all of the code used other than as permitted herein. If you modify file(s)
+ *    with this exception, you may extend this exception to your version of the
+ *    file(s), but you are not obligated to do so. If you do not wish to do so,
+ *    delete this exception statement from your version. If you delete this
+ *    exception statement from all source files in the program, then also delete
+ *    it in the license file.
+ */
+
+#define MONGO_LOG_DEFAULT_COMPONENT ::mongo::logger::LogComponent::kQuery
+
+#include "mongo/platform/basic.h"
+
+#include "mongo/db/query/plan_cost_model.h"
+
+#include <algorithm>
+#include <cmath>
+
+#include "mongo/db/query/index_statistics.h"
+#include "mongo/db/query/query_knobs.h"
+#include "mongo/db/query/query_solution.h"
+#include "mongo/util/log.h"
+
+namespace mongo {
+
+const double PlanCostModel::kFetchCost = 4.0;
+const double PlanCostModel::kSortComparisonCost = 0.1;
+
+namespace {
+
+struct Estimate {
+    // The number of results the node produces, and the cost of producing all of them.
+    double results = 0;
+    double cost = 0;
+
+    // Whether the subtree consumes all of its input before producing its first result, in which
+    // case a limit above it saves nothing.
+    bool blocking = false;
+
+    // The number of index keys examined, for an index scan.
+    double keys = 0;
+};
+
+bool coversAllValues(const OrderedIntervalList& oil) {
+    if (oil.intervals.size() != 1) {
+        return false;
+    }
+    const Interval& interval = oil.intervals[0];
+    return (MinKey == interval.start.type() && MaxKey == interval.end.type()) ||
+        (MaxKey == interval.start.type() && MinKey == interval.end.type());
+}
+
+boost::optional<Estimate> estimateIndexScan(const IndexScanNode* ixn) {
+    const IndexStatistics* stats = ixn->index.statistics.get();
+    if (!stats || ixn->bounds.isSimpleRange || ixn->bounds.fields.empty()) {
+        return boost::none;
+    }
+
+    // With no bounds on the leading field, constraints on later fields make the scan skip
+    // through the index, which the leading field's histogram can't describe.
+    const OrderedIntervalList& leading = ixn->bounds.fields[0];
+    if (coversAllValues(leading)) {
+        for (size_t i = 1; i < ixn->bounds.fields.size(); ++i) {
+            if (!coversAllValues(ixn->bounds.fields[i])) {
+                return boost::none;
+            }
+        }
+    }
+
+    Estimate estimate;
+    const double keys = stats->estimatedNumKeys() * stats->estimateFraction(leading);
+    estimate.keys = keys;
+    estimate.results = keys;
+    if (ixn->index.multikey && stats->keysPerDocument > 1) {
+        // The scan deduplicates the keys of each document.
+        estimate.results = keys / stats->keysPerDocument;
+    }
+
+    // Each interval costs at least one seek.
+    estimate.cost = keys + leading.intervals.size();
+    return estimate;
+}
+
+boost::optional<Estimate> estimate(const QuerySolutionNode* node) {
+    std::vector<Estimate> children;
+    for (auto&& child : node->children) {
+        auto childEstimate = estimate(child);
+        if (!childEstimate) {
+            return boost::none;
+        }
+        children.push_back(*childEstimate);
+    }
+
+    switch (node->getType()) {
+        case STAGE_IXSCAN:
+            return estimateIndexScan(static_cast<const IndexScanNode*>(node));
+        case STAGE_FETCH: {
+            Estimate out = children[0];
+            out.cost += out.results * PlanCostModel::kFetchCost;
+            return out;
+        }
+        case STAGE_PROJECTION:
+        case STAGE_SHARDING_FILTER:
+        case STAGE_KEEP_MUTATIONS:
+        case STAGE_SORT_KEY_GENERATOR:
+        case STAGE_ENSURE_SORTED:
+        case STAGE_SKIP:
+            return children[0];
+        case STAGE_SORT: {
+            const SortNode* sn = static_cast<const SortNode*>(node);
+            Estimate out = children[0];
+            out.cost += out.results * std::log2(out.results + 1) *
+                PlanCostModel::kSortComparisonCost;
+            if (sn->limit) {
+                out.results = std::min(out.results, static_cast<double>(sn->limit));
+            }
+            out.blocking = true;
+            return out;
+        }
+        case STAGE_LIMIT: {
+            const LimitNode* ln = static_cast<const LimitNode*>(node);
+            Estimate out = children[0];
+            const double limit = ln->limit;
+            if (!out.blocking && out.results > limit) {
+                // A streaming plan stops once it has produced enough results.
+                out.cost *= limit / out.results;
+            }
+            out.results = std::min(out.results, limit);
+            return out;
+        }
+        case STAGE_AND_HASH:
+        case STAGE_AND_SORTED: {
+            Estimate out;
+            out.results = children[0].results;
+            for (auto&& child : children) {
+                out.cost += child.cost;
+                out.results = std::min(out.results, child.results);
+            }
+            out.blocking = (STAGE_AND_HASH == node->getType());
+            return out;
+        }
+        case STAGE_OR:
+        case STAGE_SORT_MERGE: {
+            Estimate out;
+            for (auto&& child : children) {
+                out.cost += child.cost;
+                out.results += child.results;
+                out.blocking = out.blocking || child.blocking;
+            }
+            return out;
+        }
+        default:
+            return boost::none;
+    }
+}
+
+}  // namespace
+
+// static
+boost::optional<double> PlanCostModel::estimateCost(const QuerySolutionNode* root) {
+    auto rootEstimate = estimate(root);
+    if (!rootEstimate) {
+        return boost::none;
+    }
+    return rootEstimate->cost;
+}
+
+// static
+boost::optional<double> PlanCostModel::estimateKeysExamined(const QuerySolutionNode* root) {
+    if (root->children.empty()) {
+        if (STAGE_IXSCAN != root->getType()) {
+            return boost::none;
+        }
+        auto scanEstimate = estimateIndexScan(static_cast<const IndexScanNode*>(root));
+        if (!scanEstimate) {
+            return boost::none;
+        }
+        return scanEstimate->keys;
+    }
+
+    double keys = 0;
+    for (auto&& child : root->children) {
+        auto childKeys = estimateKeysExamined(child);
+        if (!childKeys) {
+            return boost::none;
+        }
+        keys += *childKeys;
+    }
+    return keys;
+}
+
+// static
+size_t PlanCostModel::pruneSolutions(std::vector<QuerySolution*>* solutions) {
+    const double ratio = internalQueryPlannerCostPruningRatio.load();
+    if (ratio <= 0 || solutions->size() < 2) {
+        return 0;
+    }
+
+    std::vector<double> costs;
+    for (auto&& soln : *solutions) {
+        auto cost = estimateCost(soln->root.get());
+        if (!cost) {
+            return 0;
+        }
+        costs.push_back(*cost);
+    }
+
+    const double cheapest = *std::min_element(costs.begin(), costs.end());
+    const double threshold = ratio * std::max(cheapest, 1.0);
+
+    size_t kept = 0;
+    for (size_t i = 0; i < solutions->size(); ++i) {
+        QuerySolution* soln = (*solutions)[i];
+        if (costs[i] > threshold) {
+            LOG(2) << "Pruning plan with estimated cost " << costs[i]
+                   << ", more than " << ratio << " times the cheapest estimate of " << cheapest
+                   << ":\n" << redact(soln->toString());
+            delete soln;
+        } else {
+            (*solutions)[kept++] = soln;
+        }
+    }
+
+    const size_t pruned = solutions->size() - kept;
+    solutions->resize(kept);
+    return pruned;
+}
+
+}  // namespace mongo
@@ -0,0 +1,76 @@
+/**
+ *    Copyright (C) 2017 MongoDB Inc.
+ *
+ *    This program is free software: you can redistribute it and/or  modify
+ *    it under the terms of the GNU Affero General Public License, version 3,
+ *    as published by the Free Software Foundation.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU Affero General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Affero General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the GNU Affero General Public License in all respects for
+ *    all of the code used other than as permitted herein. If you modify file(s)
+ *    with this exception, you may extend this exception to your version of the
+ *    file(s), but you are not obligated to do so. If you do not wish to do so,
+ *    delete this exception statement from your version. If you delete this
+ *    exception statement from all source files in the program, then also delete
+ *    it in the license file.
+ */
+
+#pragma once
+
+#include <boost/optional.hpp>
+#include <vector>
+
+namespace mongo {
+
+struct QuerySolution;
+struct QuerySolutionNode;
+
+/**
+ * Estimates the cost of running a query solution from the IndexStatistics carried by the
+ * IndexEntry of each of its index scans. Costs are in abstract units, where examining one index
+ * key costs 1, and are only meaningful when compared with each other.
+ *
+ * The estimate is deliberately conservative: whenever some part of the plan can't be costed, for
+ * instance because an index has no statistics, there is no estimate at all.
+ */
+class PlanCostModel {
+public:
+    // The cost of fetching one document, relative to examining one index key.
+    static const double kFetchCost;
+
+    // The cost of one comparison made by a blocking sort, relative to examining one index key.
+    static const double kSortComparisonCost;
+
+    /**
+     * Returns the estimated cost of running the tree rooted at 'root' to completion, or boost::none
+     * if it can't be estimated.
+     */
+    static boost::optional<double> estimateCost(const QuerySolutionNode* root);
+
+    /**
+     * Returns the estimated number of index keys examined by the index scans of the tree rooted at
+     * 'root', or boost::none if some leaf of the tree isn't an index scan which can be estimated.
+     * Unlike the cost, this depends only on the index bounds, and not on limits or blocking stages.
+     */
+    static boost::optional<double> estimateKeysExamined(const QuerySolutionNode* root);
+
+    /**
+     * Removes, and deletes, the solutions whose estimated cost is more than
+     * internalQueryPlannerCostPruningRatio times that of the cheapest one. Nothing is removed
+     * unless every solution can be costed. Returns the number of solutions removed.
+     */
+    static size_t pruneSolutions(std::vector<QuerySolution*>* solutions);
+};
+
+}  // namespace mongo
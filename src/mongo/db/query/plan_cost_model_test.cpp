@@ -0,0 +1,174 @@
+/**
+ *    Copyright (C) 2017 MongoDB Inc.
+ *
+ *    This program is free software: you can redistribute it and/or  modify
+ *    it under the terms of the GNU Affero General Public License, version 3,
+ *    as published by the Free Software Foundation.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU Affero General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Affero General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the GNU Affero General Public License in all respects for
+ *    all of the code used other than as permitted herein. If you modify file(s)
+ *    with this exception, you may extend this exception to your version of the
+ *    file(s), but you are not obligated to do so. If you do not wish to do so,
+ *    delete this exception statement from your version. If you delete this
+ *    exception statement from all source files in the program, then also delete
+ *    it in the license file.
+ */
+
+#include "mongo/platform/basic.h"
+
+#include "mongo/db/query/plan_cost_model.h"
+
+#include "mongo/db/query/index_statistics.h"
+#include "mongo/db/query/query_knobs.h"
+#include "mongo/db/query/query_solution.h"
+#include "mongo/unittest/unittest.h"
+#include "mongo/util/scopeguard.h"
+
+namespace mongo {
+namespace {
+
+// Statistics for an index on {a: 1} over 10000 documents whose 'a' values are 0 to 9999.
+std::shared_ptr<const IndexStatistics> makeStatistics() {
+    std::vector<BSONObj> values;
+    for (int i = 0; i < 10000; i += 10) {
+        values.push_back(BSON("" << i));
+    }
+    return std::make_shared<const IndexStatistics>(
+        IndexStatistics::build(values, values.size(), 10000));
+}
+
+std::unique_ptr<IndexScanNode> makeIndexScan(int start,
+                                             int end,
+                                             std::shared_ptr<const IndexStatistics> stats) {
+    IndexEntry entry(BSON("a" << 1), "a_1");
+    entry.statistics = std::move(stats);
+    auto ixn = stdx::make_unique<IndexScanNode>(entry);
+    OrderedIntervalList oil("a");
+    oil.intervals.push_back(Interval(BSON("" << start << "" << end), true, true));
+    ixn->bounds.fields.push_back(oil);
+    return ixn;
+}
+
+std::unique_ptr<FetchNode> makeFetch(std::unique_ptr<QuerySolutionNode> child) {
+    auto fetch = stdx::make_unique<FetchNode>();
+    fetch->children.push_back(child.release());
+    return fetch;
+}
+
+QuerySolution* makeSolution(std::unique_ptr<QuerySolutionNode> root) {
+    QuerySolution* soln = new QuerySolution();
+    soln->root = std::move(root);
+    return soln;
+}
+
+TEST(PlanCostModelTest, NoStatisticsMeansNoEstimate) {
+    auto fetch = makeFetch(makeIndexScan(0, 100, nullptr));
+    ASSERT_FALSE(PlanCostModel::estimateCost(fetch.get()));
+}
+
+TEST(PlanCostModelTest, NarrowerScanIsCheaper) {
+    auto stats = makeStatistics();
+    auto narrow = makeFetch(makeIndexScan(0, 99, stats));
+    auto wide = makeFetch(makeIndexScan(0, 4999, stats));
+
+    auto narrowCost = PlanCostModel::estimateCost(narrow.get());
+    auto wideCost = PlanCostModel::estimateCost(wide.get());
+    ASSERT_TRUE(narrowCost);
+    ASSERT_TRUE(wideCost);
+    ASSERT_LT(*narrowCost, *wideCost);
+
+    // On the order of 100 keys examined and 100 documents fetched.
+    ASSERT_GT(*narrowCost, 50 * (1 + PlanCostModel::kFetchCost));
+    ASSERT_LT(*narrowCost, 200 * (1 + PlanCostModel::kFetchCost));
+}
+
+TEST(PlanCostModelTest, LimitOnlyDiscountsStreamingPlans) {
+    auto stats = makeStatistics();
+    auto unlimited = PlanCostModel::estimateCost(makeFetch(makeIndexScan(0, 4999, stats)).get());
+    ASSERT_TRUE(unlimited);
+
+    auto limit = stdx::make_unique<LimitNode>();
+    limit->limit = 10;
+    limit->children.push_back(makeFetch(makeIndexScan(0, 4999, stats)).release());
+    auto streaming = PlanCostModel::estimateCost(limit.get());
+    ASSERT_TRUE(streaming);
+    ASSERT_LT(*streaming, *unlimited / 100);
+
+    auto sort = stdx::make_unique<SortNode>();
+    sort->pattern = BSON("b" << 1);
+    sort->children.push_back(makeFetch(makeIndexScan(0, 4999, stats)).release());
+    auto sortLimit = stdx::make_unique<LimitNode>();
+    sortLimit->limit = 10;
+    sortLimit->children.push_back(sort.release());
+    auto blocking = PlanCostModel::estimateCost(sortLimit.get());
+    ASSERT_TRUE(blocking);
+    ASSERT_GT(*blocking, *unlimited);
+}
+
+TEST(PlanCostModelTest, PruneExpensiveSolutions) {
+    const double oldRatio = internalQueryPlannerCostPruningRatio.load();
+    ON_BLOCK_EXIT([&] { internalQueryPlannerCostPruningRatio.store(oldRatio); });
+    internalQueryPlannerCostPruningRatio.store(100);
+
+    auto stats = makeStatistics();
+    std::vector<QuerySolution*> solutions;
+    solutions.push_back(makeSolution(makeFetch(makeIndexScan(0, 9999, stats))));
+    solutions.push_back(makeSolution(makeFetch(makeIndexScan(0, 9, stats))));
+    solutions.push_back(makeSolution(makeFetch(makeIndexScan(0, 19, stats))));
+
+    ASSERT_EQ(1U, PlanCostModel::pruneSolutions(&solutions));
+    ASSERT_EQ(2U, solutions.size());
+    for (auto&& soln : solutions) {
+        delete soln;
+    }
+}
+
+TEST(PlanCostModelTest, NoPruningUnlessEverySolutionHasAnEstimate) {
+    const double oldRatio = internalQueryPlannerCostPruningRatio.load();
+    ON_BLOCK_EXIT([&] { internalQueryPlannerCostPruningRatio.store(oldRatio); });
+    internalQueryPlannerCostPruningRatio.store(100);
+
+    auto stats = makeStatistics();
+    std::vector<QuerySolution*> solutions;
+    solutions.push_back(makeSolution(makeFetch(makeIndexScan(0, 9999, stats))));
+    solutions.push_back(makeSolution(makeFetch(makeIndexScan(0, 9, stats))));
+    solutions.push_back(makeSolution(makeFetch(makeIndexScan(0, 9, nullptr))));
+
+    ASSERT_EQ(0U, PlanCostModel::pruneSolutions(&solutions));
+    ASSERT_EQ(3U, solutions.size());
+    for (auto&& soln : solutions) {
+        delete soln;
+    }
+}
+
+TEST(PlanCostModelTest, PruningCanBeDisabled) {
+    const double oldRatio = internalQueryPlannerCostPruningRatio.load();
+    ON_BLOCK_EXIT([&] { internalQueryPlannerCostPruningRatio.store(oldRatio); });
+    internalQueryPlannerCostPruningRatio.store(0);
+
+    auto stats = makeStatistics();
+    std::vector<QuerySolution*> solutions;
+    solutions.push_back(makeSolution(makeFetch(makeIndexScan(0, 9999, stats))));
+    solutions.push_back(makeSolution(makeFetch(makeIndexScan(0, 9, stats))));
+
+    ASSERT_EQ(0U, PlanCostModel::pruneSolutions(&solutions));
+    ASSERT_EQ(2U, solutions.size());
+    for (auto&& soln : solutions) {
+        delete soln;
+    }
+}
+
+}  // namespace
+}  // namespace mongo
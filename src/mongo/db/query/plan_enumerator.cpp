@@ -32,6 +32,8 @@
 
 #include <set>
 
+#include "mongo/bson/simple_bsonelement_comparator.h"
+#include "mongo/db/query/collation/collator_interface.h"
 #include "mongo/db/query/index_tag.h"
 #include "mongo/db/query/indexability.h"
 #include "mongo/util/log.h"
@@ -258,7 +260,8 @@ PlanEnumerator::PlanEnumerator(const PlanEnumeratorParams& params)
       _indices(params.indices),
       _ixisect(params.intersect),
       _orLimit(params.maxSolutionsPerOr),
-      _intersectLimit(params.maxIntersectPerAnd) {}
+      _intersectLimit(params.maxIntersectPerAnd),
+      _pruneDominated(params.pruneDominated) {}
 
 PlanEnumerator::~PlanEnumerator() {
     typedef unordered_map<MemoID, NodeAssignment*> MemoMap;
@@ -268,6 +271,8 @@ PlanEnumerator::~PlanEnumerator() {
 }
 
 Status PlanEnumerator::init() {
+    _keyPositions.resize(_indices->size());
+
     // Fill out our memo structure from the tagged _root.
     _done = !prepMemo(_root, PrepMemoContext());
 
@@ -613,7 +618,7 @@ void PlanEnumerator::assignToNonMultikeyMandatoryIndex(
     // pred over the first field of that index.
     auto compIt = idxToNotFirst.find(indexAssign->index);
     if (compIt != idxToNotFirst.end()) {
-        compound(compIt->second, index, indexAssign);
+        compound(compIt->second, indexAssign);
     }
 }
 
@@ -691,7 +696,7 @@ bool PlanEnumerator::enumerateMandatoryIndex(const IndexToPredMap& idxToFirst,
                 // 'thisIndex' and compound bounds; an index entry is produced for each combination
                 // of unique values along all of the indexed fields, even if they are in separate
                 // array elements. See SERVER-23533 for more details.
-                compound({mandatoryPred}, thisIndex, &indexAssign);
+                compound({mandatoryPred}, &indexAssign);
 
                 auto compIt = idxToNotFirst.find(indexAssign.index);
                 if (compIt != idxToNotFirst.end()) {
@@ -744,7 +749,7 @@ bool PlanEnumerator::enumerateMandatoryIndex(const IndexToPredMap& idxToFirst,
                 // position in the compound index.
                 vector<MatchExpression*> mandatoryToCompound;
                 mandatoryToCompound.push_back(mandatoryPred);
-                compound(mandatoryToCompound, thisIndex, &indexAssign);
+                compound(mandatoryToCompound, &indexAssign);
 
                 // At this point we have assigned a predicate over the leading field and
                 // we have assigned the mandatory predicate to a trailing field.
@@ -764,7 +769,7 @@ bool PlanEnumerator::enumerateMandatoryIndex(const IndexToPredMap& idxToFirst,
 
                 getMultikeyCompoundablePreds(indexAssign.preds, couldCompound, &tryCompound);
                 if (tryCompound.size()) {
-                    compound(tryCompound, thisIndex, &indexAssign);
+                    compound(tryCompound, &indexAssign);
                 }
             }
         } else {
@@ -837,6 +842,7 @@ void PlanEnumerator::enumerateOneIndex(
     // predicates that can use the key pattern to the index. However, if the index is multikey,
     // certain predicates cannot be combined/compounded. We determine which predicates can be
     // combined/compounded using path-level multikey info, if available.
+    const size_t firstChoice = andAssignment->choices.size();
 
     // First, add the state of using each subnode.
     for (size_t i = 0; i < subnodes.size(); ++i) {
@@ -936,7 +942,7 @@ void PlanEnumerator::enumerateOneIndex(
 
                     for (auto pred : toCompound) {
                         assignPredicate(
-                            outsidePreds, pred, getPosition(thisIndex, pred), &indexAssign);
+                            outsidePreds, pred, getPosition(it->first, pred), &indexAssign);
                     }
                 }
 
@@ -965,7 +971,7 @@ void PlanEnumerator::enumerateOneIndex(
             IndexToPredMap::const_iterator compIt = idxToNotFirst.find(indexAssign.index);
             if (compIt != idxToNotFirst.end()) {
                 for (auto pred : compIt->second) {
-                    assignPredicate(outsidePreds, pred, getPosition(thisIndex, pred), &indexAssign);
+                    assignPredicate(outsidePreds, pred, getPosition(it->first, pred), &indexAssign);
                 }
             }
 
@@ -976,6 +982,106 @@ void PlanEnumerator::enumerateOneIndex(
             andAssignment->choices.push_back(std::move(state));
         }
     }
+
+    if (_pruneDominated) {
+        pruneDominatedAssignments(firstChoice, andAssignment);
+    }
+}
+
+void PlanEnumerator::pruneDominatedAssignments(size_t firstChoice, AndAssignment* andAssignment) {
+    auto& choices = andAssignment->choices;
+    auto isSingleIndex = [](const AndEnumerableState& state) {
+        return state.subnodesToIndex.empty() && state.assignments.size() == 1;
+    };
+
+    vector<bool> dominated(choices.size(), false);
+    for (size_t i = firstChoice; i < choices.size(); ++i) {
+        if (!isSingleIndex(choices[i])) {
+            continue;
+        }
+        for (size_t j = firstChoice; j < choices.size(); ++j) {
+            // A dominated choice may still dominate others, since dominance is transitive.
+            if (i == j || !isSingleIndex(choices[j])) {
+                continue;
+            }
+            if (dominates(choices[j].assignments[0], choices[i].assignments[0])) {
+                LOG(5) << "Pruning assignment to index "
+                       << (*_indices)[choices[i].assignments[0].index].name
+                       << ", which the assignment to index "
+                       << (*_indices)[choices[j].assignments[0].index].name << " dominates";
+                dominated[i] = true;
+                break;
+            }
+        }
+    }
+
+    // Keep the surviving choices in the order they were generated.
+    size_t kept = firstChoice;
+    for (size_t i = firstChoice; i < choices.size(); ++i) {
+        if (dominated[i]) {
+            ++_numPrunedAssignments;
+            continue;
+        }
+        if (kept != i) {
+            choices[kept] = std::move(choices[i]);
+        }
+        ++kept;
+    }
+    choices.erase(choices.begin() + kept, choices.end());
+}
+
+bool PlanEnumerator::dominates(const OneIndexAssignment& dominant,
+                               const OneIndexAssignment& other) const {
+    // Or pushdowns and the bounds of multikey, sparse and partial indexes make the comparison
+    // depend on more than the key patterns.
+    if (!dominant.orPushdowns.empty() || !other.orPushdowns.empty() ||
+        !dominant.canCombineBounds || !other.canCombineBounds) {
+        return false;
+    }
+
+    const IndexEntry& dominantIndex = (*_indices)[dominant.index];
+    const IndexEntry& otherIndex = (*_indices)[other.index];
+    for (auto&& index : {&dominantIndex, &otherIndex}) {
+        if (index->type != INDEX_BTREE || index->multikey || index->sparse ||
+            index->filterExpr) {
+            return false;
+        }
+    }
+    if (!CollatorInterface::collatorsMatch(dominantIndex.collator, otherIndex.collator)) {
+        return false;
+    }
+
+    // The key pattern of 'other' must be a proper prefix of that of 'dominant'. The fields then
+    // sit at the same positions in both.
+    const size_t otherFields = otherIndex.keyPattern.nFields();
+    if (otherFields >= static_cast<size_t>(dominantIndex.keyPattern.nFields()) ||
+        !otherIndex.keyPattern.isPrefixOf(dominantIndex.keyPattern,
+                                          SimpleBSONElementComparator::kInstance)) {
+        return false;
+    }
+
+    // 'other' must bound every one of its fields, so that 'dominant' scans a subset of its keys
+    // rather than skipping to a later field which 'other' leaves unbounded.
+    vector<bool> otherBounded(otherFields, false);
+    for (auto position : other.positions) {
+        otherBounded[position] = true;
+    }
+    if (std::find(otherBounded.begin(), otherBounded.end(), false) != otherBounded.end()) {
+        return false;
+    }
+
+    // 'dominant' must also bound the next field, and assign every predicate 'other' does.
+    if (std::find(dominant.positions.begin(), dominant.positions.end(), otherFields) ==
+        dominant.positions.end()) {
+        return false;
+    }
+    for (auto pred : other.preds) {
+        if (std::find(dominant.preds.begin(), dominant.preds.end(), pred) ==
+            dominant.preds.end()) {
+            return false;
+        }
+    }
+    return true;
 }
 
 void PlanEnumerator::enumerateAndIntersect(const IndexToPredMap& idxToFirst,
@@ -1164,7 +1270,7 @@ void PlanEnumerator::enumerateAndIntersect(const IndexToPredMap& idxToFirst,
                     }
                 }
                 if (tryCompound.size()) {
-                    compound(tryCompound, ie1, &firstAssign);
+                    compound(tryCompound, &firstAssign);
                 }
             }
 
@@ -1196,7 +1302,7 @@ void PlanEnumerator::enumerateAndIntersect(const IndexToPredMap& idxToFirst,
                     }
                 }
                 if (tryCompound.size()) {
-                    compound(tryCompound, ie2, &secondAssign);
+                    compound(tryCompound, &secondAssign);
                 }
             }
 
@@ -1505,55 +1611,62 @@ bool PlanEnumerator::alreadyCompounded(const set<MatchExpression*>& ixisectAssig
     return false;
 }
 
-size_t PlanEnumerator::getPosition(const IndexEntry& indexEntry, MatchExpression* predicate) {
-    invariant(predicate->getTag());
-    RelevantTag* relevantTag = static_cast<RelevantTag*>(predicate->getTag());
-    size_t position = 0;
-    for (auto&& element : indexEntry.keyPattern) {
-        if (element.fieldName() == relevantTag->path) {
-            return position;
+const StringMap<PlanEnumerator::IndexPosition>& PlanEnumerator::getKeyPositions(IndexID index) {
+    invariant(index < _keyPositions.size());
+    StringMap<IndexPosition>& positions = _keyPositions[index];
+    if (positions.empty()) {
+        IndexPosition position = 0;
+        for (auto&& element : (*_indices)[index].keyPattern) {
+            // If a field name repeats, the first position wins.
+            const StringData field = element.fieldNameStringData();
+            if (positions.find(field) == positions.end()) {
+                positions[field] = position;
+            }
+            ++position;
         }
-        ++position;
     }
-    MONGO_UNREACHABLE;
+    return positions;
+}
+
+size_t PlanEnumerator::getPosition(IndexID index, MatchExpression* predicate) {
+    invariant(predicate->getTag());
+    RelevantTag* relevantTag = static_cast<RelevantTag*>(predicate->getTag());
+    const StringMap<IndexPosition>& positions = getKeyPositions(index);
+    auto it = positions.find(relevantTag->path);
+    invariant(it != positions.end());
+    return it->second;
 }
 
 void PlanEnumerator::compound(const vector<MatchExpression*>& tryCompound,
-                              const IndexEntry& thisIndex,
                               OneIndexAssignment* assign) {
-    // Let's try to match up the expressions in 'compExprs' with the
-    // fields in the index key pattern.
-    BSONObjIterator kpIt(thisIndex.keyPattern);
-
-    // Skip the first elt as it's already assigned.
-    kpIt.next();
-
-    // When we compound we store the field number that the predicate
-    // goes over in order to avoid having to iterate again and compare
+    // Let's try to match up the expressions in 'tryCompound' with the fields in the index key
+    // pattern. We do not enforce that fields are assigned contiguously from right to left, i.e.
+    // for compound index {a: 1, b: 1, c: 1} it is okay to compound predicates over "a" and "c",
+    // skipping "b".
+    const StringMap<IndexPosition>& positions = getKeyPositions(assign->index);
+
+    // Pairs of the position in the index that a predicate goes over and the predicate's offset in
+    // 'tryCompound'. We store the position in order to avoid having to iterate again and compare
     // field names.
-    size_t posInIdx = 0;
-
-    while (kpIt.more()) {
-        BSONElement keyElt = kpIt.next();
-        ++posInIdx;
-
-        // Go through 'tryCompound' to see if there is a compoundable
-        // predicate for 'keyElt'. If there is nothing to compound, then
-        // simply move on to the next field in the compound index. We
-        // do not enforce that fields are assigned contiguously from
-        // right to left, i.e. for compound index {a: 1, b: 1, c: 1}
-        // it is okay to compound predicates over "a" and "c", skipping "b".
-        for (size_t j = 0; j < tryCompound.size(); ++j) {
-            MatchExpression* maybe = tryCompound[j];
-            // Sigh we grab the full path from the relevant tag.
-            RelevantTag* rt = static_cast<RelevantTag*>(maybe->getTag());
-            if (keyElt.fieldName() == rt->path) {
-                // preds and positions are parallel arrays.
-                assign->preds.push_back(maybe);
-                assign->positions.push_back(posInIdx);
-            }
+    vector<std::pair<IndexPosition, size_t>> matches;
+    for (size_t j = 0; j < tryCompound.size(); ++j) {
+        // Sigh we grab the full path from the relevant tag.
+        RelevantTag* rt = static_cast<RelevantTag*>(tryCompound[j]->getTag());
+        auto it = positions.find(rt->path);
+
+        // The first field is already assigned.
+        if (it != positions.end() && it->second > 0) {
+            matches.push_back(std::make_pair(it->second, j));
         }
     }
+
+    // Assign in key pattern order, and in the order of 'tryCompound' within a field.
+    std::sort(matches.begin(), matches.end());
+    for (auto&& match : matches) {
+        // preds and positions are parallel arrays.
+        assign->preds.push_back(tryCompound[match.second]);
+        assign->positions.push_back(match.first);
+    }
 }
 
 //
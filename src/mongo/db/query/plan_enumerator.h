@@ -37,6 +37,7 @@
 #include "mongo/db/query/index_tag.h"
 #include "mongo/db/query/query_knobs.h"
 #include "mongo/platform/unordered_map.h"
+#include "mongo/util/string_map.h"
 
 namespace mongo {
 
@@ -44,7 +45,8 @@ struct PlanEnumeratorParams {
     PlanEnumeratorParams()
         : intersect(false),
           maxSolutionsPerOr(internalQueryEnumerationMaxOrSolutions.load()),
-          maxIntersectPerAnd(internalQueryEnumerationMaxIntersectPerAnd.load()) {}
+          maxIntersectPerAnd(internalQueryEnumerationMaxIntersectPerAnd.load()),
+          pruneDominated(internalQueryEnumerationPruneDominatedAssignments.load()) {}
 
     // Do we provide solutions that use more indices than the minimum required to provide
     // an indexed solution?
@@ -65,6 +67,10 @@ struct PlanEnumeratorParams {
     // all-pairs approach, we could wind up creating a lot of enumeration possibilities for
     // certain inputs.
     size_t maxIntersectPerAnd;
+
+    // Do we drop single index assignments which another assignment at the same AND dominates?
+    // See PlanEnumerator::pruneDominatedAssignments().
+    bool pruneDominated;
 };
 
 /**
@@ -107,6 +113,14 @@ public:
      */
     std::unique_ptr<MatchExpression> getNext();
 
+    /**
+     * Returns the number of index assignments dropped because another assignment to the same
+     * node dominated them.
+     */
+    size_t getNumPrunedAssignments() const {
+        return _numPrunedAssignments;
+    }
+
 private:
     //
     // Memoization strategy
@@ -480,18 +494,39 @@ private:
         OneIndexAssignment* indexAssign);
 
     /**
-     * Try to assign predicates in 'tryCompound' to 'thisIndex' as compound assignments.
-     * Output the assignments in 'assign'.
+     * Try to assign predicates in 'tryCompound' to the non-leading fields of the index
+     * 'assign->index' as compound assignments. Output the assignments in 'assign'.
      */
-    void compound(const std::vector<MatchExpression*>& tryCompound,
-                  const IndexEntry& thisIndex,
-                  OneIndexAssignment* assign);
+    void compound(const std::vector<MatchExpression*>& tryCompound, OneIndexAssignment* assign);
 
     /**
-     * Returns the position that 'predicate' can use in the key pattern for 'indexEntry'. It is
+     * Returns the position that 'predicate' can use in the key pattern for 'index'. It is
      * illegal to call this if 'predicate' does not have a RelevantTag, or it cannot use the index.
      */
-    size_t getPosition(const IndexEntry& indexEntry, MatchExpression* predicate);
+    size_t getPosition(IndexID index, MatchExpression* predicate);
+
+    /**
+     * Returns a map from each field of the key pattern of 'index' to its position. The map is
+     * built the first time it is asked for, since the same indices are matched against
+     * predicates at every node of the tree and by every pair considered for intersection.
+     */
+    const StringMap<IndexPosition>& getKeyPositions(IndexID index);
+
+    /**
+     * Drops the single index assignments in 'andAssignment->choices', from 'firstChoice' onwards,
+     * which another of those assignments dominates. See dominates().
+     */
+    void pruneDominatedAssignments(size_t firstChoice, AndAssignment* andAssignment);
+
+    /**
+     * Returns true if 'dominant' is at least as good as 'other' in every way the planner can
+     * tell, and strictly tighter in its index bounds. That is the case when, over plain btree
+     * indexes, the key pattern of 'other' is a proper prefix of that of 'dominant', 'other'
+     * bounds every field of its key pattern, and 'dominant' assigns all of the predicates of
+     * 'other' as well as one over the next field. 'dominant' then scans no more keys, provides
+     * every sort order and covers every projection that 'other' does.
+     */
+    bool dominates(const OneIndexAssignment& dominant, const OneIndexAssignment& other) const;
 
     /**
      * Adds 'pred' to 'indexAssignment', using 'position' as its position in the index. If 'pred' is
@@ -547,6 +582,16 @@ private:
 
     // How many things do we want from each AND?
     size_t _intersectLimit;
+
+    // Do we drop dominated single index assignments?
+    bool _pruneDominated;
+
+    // How many assignments have we dropped because another one dominated them?
+    size_t _numPrunedAssignments = 0;
+
+    // Memo of the position of each field in the key pattern of each index, indexed by IndexID.
+    // An empty map has not been built yet.
+    std::vector<StringMap<IndexPosition>> _keyPositions;
 };
 
 }  // namespace mongo
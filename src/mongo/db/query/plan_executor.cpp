@@ -48,6 +48,7 @@
 #include "mongo/db/query/find_common.h"
 #include "mongo/db/query/mock_yield_policies.h"
 #include "mongo/db/query/plan_yield_policy.h"
+#include "mongo/db/query/query_knobs.h"
 #include "mongo/db/repl/replication_coordinator.h"
 #include "mongo/db/service_context.h"
 #include "mongo/db/storage/record_fetcher.h"
@@ -298,6 +299,10 @@ PlanStage* PlanExecutor::getRootStage() const {
     return _root.get();
 }
 
+const QuerySolution* PlanExecutor::getQuerySolution() const {
+    return _qs.get();
+}
+
 CanonicalQuery* PlanExecutor::getCanonicalQuery() const {
     return _cq.get();
 }
@@ -378,6 +383,7 @@ void PlanExecutor::detachFromOperationContext() {
     invariant(_currentState == kSaved);
     _opCtx = nullptr;
     _root->detachFromOperationContext();
+    _workingSet->freeRecycledBuffers();
     _currentState = kDetached;
     _everDetachedFromOperationContext = true;
 }
@@ -395,8 +401,21 @@ void PlanExecutor::reattachToOperationContext(OperationContext* opCtx) {
 }
 
 void PlanExecutor::invalidate(OperationContext* opCtx, const RecordId& dl, InvalidationType type) {
-    if (!isMarkedAsKilled()) {
-        _root->invalidate(opCtx, dl, type);
+    if (isMarkedAsKilled()) {
+        return;
+    }
+
+    _root->invalidate(opCtx, dl, type);
+
+    // Results buffered from a batch of work are no longer tracked by any stage, so we must
+    // protect any that refer to 'dl' ourselves.
+    for (size_t i = _batchedResultsPos; i < _batchedResults.size(); ++i) {
+        WorkingSetMember* member = _workingSet->get(_batchedResults[i]);
+        if (member->hasObj() && member->hasRecordId() && member->recordId == dl) {
+            member->obj.setValue(member->obj.value().getOwned());
+            member->recordId = RecordId();
+            member->transitionToOwnedObj();
+        }
     }
 }
 
@@ -553,7 +572,7 @@ PlanExecutor::ExecState PlanExecutor::getNextImpl(Snapshotted<BSONObj>* objOut,
         fetcher.reset();
 
         WorkingSetID id = WorkingSet::INVALID_ID;
-        PlanStage::StageState code = _root->work(&id);
+        PlanStage::StageState code = workRoot(&id);
 
         if (code != PlanStage::NEED_YIELD)
             writeConflictsInARow = 0;
@@ -640,9 +659,48 @@ PlanExecutor::ExecState PlanExecutor::getNextImpl(Snapshotted<BSONObj>* objOut,
     }
 }
 
+PlanStage::StageState PlanExecutor::workRoot(WorkingSetID* out) {
+    if (_batchedResultsPos < _batchedResults.size()) {
+        *out = _batchedResults[_batchedResultsPos++];
+        return PlanStage::ADVANCED;
+    }
+
+    if (_batchEndState) {
+        PlanStage::StageState state = _batchEndState->first;
+        *out = _batchEndState->second;
+        _batchEndState = boost::none;
+        return state;
+    }
+
+    const int batchSize = internalQueryExecBatchedWorkSize.load();
+    if (batchSize <= 1 || !_root->supportsBatchedWork()) {
+        return _root->work(out);
+    }
+
+    _batchedResults.clear();
+    _batchedResultsPos = 0;
+
+    WorkingSetID stateId = WorkingSet::INVALID_ID;
+    PlanStage::StageState state =
+        _root->workBatch(_workingSet.get(), batchSize, &_batchedResults, &stateId);
+    if (_batchedResults.empty()) {
+        *out = stateId;
+        return state;
+    }
+
+    if (PlanStage::ADVANCED != state && PlanStage::NEED_TIME != state) {
+        _batchEndState = std::make_pair(state, stateId);
+    }
+
+    *out = _batchedResults[_batchedResultsPos++];
+    return PlanStage::ADVANCED;
+}
+
 bool PlanExecutor::isEOF() {
     invariant(_currentState == kUsable);
-    return isMarkedAsKilled() || (_stash.empty() && _root->isEOF());
+    return isMarkedAsKilled() ||
+        (_stash.empty() && _batchedResultsPos == _batchedResults.size() && !_batchEndState &&
+         _root->isEOF());
 }
 
 void PlanExecutor::markAsKilled(string reason) {
@@ -33,6 +33,7 @@
 
 #include "mongo/base/status.h"
 #include "mongo/db/catalog/util/partitioned.h"
+#include "mongo/db/exec/plan_stage.h"
 #include "mongo/db/invalidation_type.h"
 #include "mongo/db/query/query_solution.h"
 #include "mongo/db/storage/snapshot.h"
@@ -248,6 +249,13 @@ public:
      */
     PlanStage* getRootStage() const;
 
+    /**
+     * Get the solution that the stage tree was built from, without transferring ownership. Null if
+     * the tree was not built from a single solution, for instance if several candidate plans were
+     * ranked against each other.
+     */
+    const QuerySolution* getQuerySolution() const;
+
     /**
      * Get the query that this executor is executing, without transferring ownership.
      */
@@ -485,6 +493,15 @@ private:
 
     ExecState getNextImpl(Snapshotted<BSONObj>* objOut, RecordId* dlOut);
 
+    /**
+     * Obtains the next unit of work from the plan, with the same contract as PlanStage::work().
+     *
+     * If the plan supports it and internalQueryExecBatchedWorkSize allows it, work is requested
+     * from the plan in batches. Results are then handed out one at a time from
+     * '_batchedResults', followed by the state which ended the batch.
+     */
+    PlanStage::StageState workRoot(WorkingSetID* out);
+
     /**
      * New PlanExecutor instances are created with the static make() methods above.
      */
@@ -559,6 +576,15 @@ private:
     // stages.
     std::queue<BSONObj> _stash;
 
+    // Results produced by the last call to PlanStage::workBatch() on '_root' which have not been
+    // returned yet. They are consumed from position '_batchedResultsPos' onwards.
+    std::vector<WorkingSetID> _batchedResults;
+    size_t _batchedResultsPos = 0;
+
+    // If the last batch of work ended in a state which must be acted upon (NEED_YIELD, IS_EOF,
+    // DEAD or FAILURE), that state and its id, to be returned once '_batchedResults' is drained.
+    boost::optional<std::pair<PlanStage::StageState, WorkingSetID>> _batchEndState;
+
     enum { kUsable, kSaved, kDetached, kDisposed } _currentState = kUsable;
 
     // Set if this PlanExecutor is registered with the CursorManager.
@@ -40,6 +40,7 @@
 #include "mongo/db/exec/plan_stage.h"
 #include "mongo/db/exec/working_set.h"
 #include "mongo/db/query/explain.h"
+#include "mongo/db/query/plan_cost_model.h"
 #include "mongo/db/query/query_knobs.h"
 #include "mongo/db/query/query_solution.h"
 #include "mongo/db/server_options.h"
@@ -112,13 +113,49 @@ size_t PlanRanker::pickBestPlan(const vector<CandidatePlan>& candidates, PlanRan
         scoresAndCandidateindices.begin(), scoresAndCandidateindices.end(), scoreComparator);
 
     // Determine whether plans tied for the win.
+    const double epsilon = 1e-10;
     if (scoresAndCandidateindices.size() > 1U) {
         double bestScore = scoresAndCandidateindices[0].first;
         double runnerUpScore = scoresAndCandidateindices[1].first;
-        const double epsilon = 1e-10;
         why->tieForBest = std::abs(bestScore - runnerUpScore) < epsilon;
     }
 
+    // If the index statistics allow us to estimate the cost of every tied plan, order the tied
+    // plans by that estimate. The tie is still reported, since the trial period could not tell
+    // them apart.
+    if (why->tieForBest) {
+        const double bestScore = scoresAndCandidateindices[0].first;
+        size_t numTied = 1;
+        while (numTied < scoresAndCandidateindices.size() &&
+               std::abs(bestScore - scoresAndCandidateindices[numTied].first) < epsilon) {
+            ++numTied;
+        }
+
+        vector<std::pair<double, size_t>> costsAndPositions;
+        for (size_t i = 0; i < numTied; ++i) {
+            const QuerySolution* solution =
+                candidates[scoresAndCandidateindices[i].second].solution.get();
+            boost::optional<double> cost =
+                solution ? PlanCostModel::estimateCost(solution->root.get()) : boost::none;
+            if (!cost) {
+                costsAndPositions.clear();
+                break;
+            }
+            costsAndPositions.push_back(std::make_pair(*cost, i));
+        }
+
+        if (!costsAndPositions.empty()) {
+            std::stable_sort(costsAndPositions.begin(), costsAndPositions.end());
+            vector<std::pair<double, size_t>> tied(scoresAndCandidateindices.begin(),
+                                                   scoresAndCandidateindices.begin() + numTied);
+            for (size_t i = 0; i < numTied; ++i) {
+                scoresAndCandidateindices[i] = tied[costsAndPositions[i].second];
+            }
+            LOG(2) << "Broke a tie between " << numTied
+                   << " plans by estimated cost, the lowest being " << costsAndPositions[0].first;
+        }
+    }
+
     // Update results in 'why'
     // Stats and scores in 'why' are sorted in descending order by score.
     why->stats.clear();
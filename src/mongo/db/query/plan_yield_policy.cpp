@@ -30,33 +30,78 @@
 
 #include "mongo/db/query/plan_yield_policy.h"
 
+#include <algorithm>
+
+#include "mongo/base/counter.h"
+#include "mongo/db/commands/server_status_metric.h"
 #include "mongo/db/concurrency/write_conflict_exception.h"
 #include "mongo/db/curop.h"
 #include "mongo/db/operation_context.h"
 #include "mongo/db/query/query_knobs.h"
 #include "mongo/db/query/query_yield.h"
 #include "mongo/db/service_context.h"
+#include "mongo/db/storage/storage_engine.h"
+#include "mongo/util/clock_source.h"
 #include "mongo/util/scopeguard.h"
 #include "mongo/util/time_support.h"
 
 namespace mongo {
 
+namespace {
+
+// Adaptive yielding activity, reported in serverStatus. 'skipped' counts the yields which were due
+// but not taken because no one was waiting; the others count the yields taken because someone was.
+Counter64 adaptiveYieldsSkipped;
+Counter64 adaptiveYieldsForLockWaiters;
+Counter64 adaptiveYieldsForCachePressure;
+
+ServerStatusMetricField<Counter64> displayAdaptiveYieldsSkipped("query.yields.adaptive.skipped",
+                                                                &adaptiveYieldsSkipped);
+ServerStatusMetricField<Counter64> displayAdaptiveYieldsForLockWaiters(
+    "query.yields.adaptive.lockWaiters", &adaptiveYieldsForLockWaiters);
+ServerStatusMetricField<Counter64> displayAdaptiveYieldsForCachePressure(
+    "query.yields.adaptive.cachePressure", &adaptiveYieldsForCachePressure);
+
+// How many times as often we look for pressure as we would yield without adaptive yielding.
+const int kPressureChecksPerYieldPeriod = 4;
+
+bool shouldYieldAdaptively(PlanExecutor* exec, PlanExecutor::YieldPolicy policy) {
+    // Only YIELD_AUTO releases locks. The mock policies used in testing must yield on schedule.
+    return exec && policy == PlanExecutor::YIELD_AUTO && internalQueryExecYieldAdaptive.load();
+}
+
+}  // namespace
+
 PlanYieldPolicy::PlanYieldPolicy(PlanExecutor* exec, PlanExecutor::YieldPolicy policy)
     : _policy(exec->getOpCtx()->lockState()->isGlobalLockedRecursively() ? PlanExecutor::NO_YIELD
                                                                          : policy),
+      _adaptive(shouldYieldAdaptively(exec, _policy)),
       _forceYield(false),
       _elapsedTracker(exec->getOpCtx()->getServiceContext()->getFastClockSource(),
                       internalQueryExecYieldIterations.load(),
                       Milliseconds(internalQueryExecYieldPeriodMS.load())),
+      _pressureTracker(
+          exec->getOpCtx()->getServiceContext()->getFastClockSource(),
+          std::max(1, internalQueryExecYieldIterations.load() / kPressureChecksPerYieldPeriod),
+          Milliseconds(internalQueryExecYieldPeriodMS.load() / kPressureChecksPerYieldPeriod)),
+      _clockSource(exec->getOpCtx()->getServiceContext()->getFastClockSource()),
+      _lastYield(_clockSource->now()),
       _planYielding(exec) {}
 
 
 PlanYieldPolicy::PlanYieldPolicy(PlanExecutor::YieldPolicy policy, ClockSource* cs)
     : _policy(policy),
+      _adaptive(false),
       _forceYield(false),
       _elapsedTracker(cs,
                       internalQueryExecYieldIterations.load(),
                       Milliseconds(internalQueryExecYieldPeriodMS.load())),
+      _pressureTracker(
+          cs,
+          std::max(1, internalQueryExecYieldIterations.load() / kPressureChecksPerYieldPeriod),
+          Milliseconds(internalQueryExecYieldPeriodMS.load() / kPressureChecksPerYieldPeriod)),
+      _clockSource(cs),
+      _lastYield(cs->now()),
       _planYielding(nullptr) {}
 
 bool PlanYieldPolicy::shouldYield() {
@@ -65,11 +110,53 @@ bool PlanYieldPolicy::shouldYield() {
     invariant(!_planYielding->getOpCtx()->lockState()->inAWriteUnitOfWork());
     if (_forceYield)
         return true;
-    return _elapsedTracker.intervalHasElapsed();
+
+    if (!_adaptive) {
+        return _elapsedTracker.intervalHasElapsed();
+    }
+
+    if (_elapsedTracker.intervalHasElapsed()) {
+        if (_yieldRelievesPressure()) {
+            return true;
+        }
+
+        // Yield anyway if we haven't in a long while, or if we've been interrupted, since yield()
+        // is where YIELD_AUTO plans notice that.
+        OperationContext* opCtx = _planYielding->getOpCtx();
+        if (_clockSource->now() - _lastYield >=
+                Milliseconds(internalQueryExecYieldAdaptiveMaxPeriodMS.load()) ||
+            !opCtx->checkForInterruptNoAssert().isOK()) {
+            return true;
+        }
+
+        adaptiveYieldsSkipped.increment();
+        return false;
+    }
+
+    // Between the scheduled yields, yield early for anyone waiting on us.
+    return _pressureTracker.intervalHasElapsed() && _yieldRelievesPressure();
+}
+
+bool PlanYieldPolicy::_yieldRelievesPressure() const {
+    OperationContext* opCtx = _planYielding->getOpCtx();
+    if (opCtx->lockState()->hasWaitersOnHeldLocks()) {
+        adaptiveYieldsForLockWaiters.increment();
+        return true;
+    }
+
+    StorageEngine* storageEngine = opCtx->getServiceContext()->getGlobalStorageEngine();
+    if (storageEngine && storageEngine->isCacheUnderPressure()) {
+        adaptiveYieldsForCachePressure.increment();
+        return true;
+    }
+
+    return false;
 }
 
 void PlanYieldPolicy::resetTimer() {
     _elapsedTracker.resetLastTime();
+    _pressureTracker.resetLastTime();
+    _lastYield = _clockSource->now();
 }
 
 Status PlanYieldPolicy::yield(RecordFetcher* recordFetcher) {
@@ -54,7 +54,7 @@ public:
     /**
      * Used by YIELD_AUTO plan executors in order to check whether it is time to yield.
      * PlanExecutors give up their locks periodically in order to be fair to other
-     * threads.
+     * threads. When yielding adaptively, they only do so while another thread stands to gain.
      */
     virtual bool shouldYield();
 
@@ -137,11 +137,30 @@ public:
     }
 
 private:
+    /**
+     * Returns true if yielding now would let another operation make progress, because it waits on
+     * a lock we hold, or the storage engine wants old snapshots released to relieve its cache.
+     */
+    bool _yieldRelievesPressure() const;
+
     const PlanExecutor::YieldPolicy _policy;
 
+    // Whether yields are skipped while no other operation stands to gain from them. See
+    // internalQueryExecYieldAdaptive.
+    const bool _adaptive;
+
     bool _forceYield;
     ElapsedTracker _elapsedTracker;
 
+    // Only used when '_adaptive' is set. Decides when to look for pressure in between the yields
+    // due according to '_elapsedTracker'.
+    ElapsedTracker _pressureTracker;
+
+    ClockSource* const _clockSource;
+
+    // When we last yielded, or were created.
+    Date_t _lastYield;
+
     // The plan executor which this yield policy is responsible for yielding. Must
     // not outlive the plan executor.
     PlanExecutor* const _planYielding;
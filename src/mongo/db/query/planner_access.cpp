@@ -134,6 +134,48 @@ std::vector<bool> canProvideSortWithMergeSort(const std::vector<QuerySolutionNod
     return shouldReverseScan;
 }
 
+/**
+ * 'scan' was planned over 'skipScanEntry', so its finished (but not yet aligned) bounds cover
+ * every field of the index except the first. Prepends "all values" bounds for the first field and
+ * points the scan at the full index. The IndexBoundsChecker used by the index scan then seeks
+ * past each distinct value of the first field once the bounds of the later fields are exhausted.
+ */
+void expandSkipScan(IndexScanNode* scan, const IndexEntry& skipScanEntry) {
+    invariant(skipScanEntry.isSkipScan());
+
+    IndexEntry fullEntry(skipScanEntry);
+    fullEntry.keyPattern = skipScanEntry.skipScanKeyPattern;
+    fullEntry.multikeyPaths = skipScanEntry.skipScanMultikeyPaths;
+    fullEntry.skipScanKeyPattern = BSONObj();
+    fullEntry.skipScanMultikeyPaths.clear();
+
+    OrderedIntervalList leadingField;
+    IndexBoundsBuilder::allValuesForField(fullEntry.keyPattern.firstElement(), &leadingField);
+    scan->bounds.fields.insert(scan->bounds.fields.begin(), std::move(leadingField));
+    scan->index = std::move(fullEntry);
+}
+
+/**
+ * Returns true if a predicate over position 'pos' of 'index' whose bounds are INEXACT_COVERED can
+ * be evaluated against the index keys rather than the documents. That is the case unless the field
+ * may have multikey components: a document then has a key for each array element, and a filter
+ * applied to one key cannot tell whether the document as a whole matches. Suppose that we had the
+ * multikey index {x: 1} and a document {x: ["a", "b"]}. Now if we query for {x: /b/} the filter
+ * might only ever be applied to the index key "a", and we'd incorrectly conclude that the document
+ * does not match. Path-level multikey metadata lets us use the keys of the fields of a multikey
+ * index which are not themselves multikey.
+ */
+bool canUseCoveredFilter(const IndexEntry& index, size_t pos) {
+    if (INDEX_TEXT == index.type || !index.multikey) {
+        return true;
+    }
+    if (index.multikeyPaths.empty()) {
+        return false;
+    }
+    invariant(pos < index.multikeyPaths.size());
+    return index.multikeyPaths[pos].empty();
+}
+
 }  // namespace
 
 namespace mongo {
@@ -153,6 +195,7 @@ std::unique_ptr<QuerySolutionNode> QueryPlannerAccess::makeCollectionScan(
     csn->maxScan = query.getQueryRequest().getMaxScan();
     csn->shouldTrackLatestOplogTimestamp =
         params.options & QueryPlannerParams::TRACK_LATEST_OPLOG_TS;
+    csn->allowParallel = params.options & QueryPlannerParams::ALLOW_PARALLEL_COLLSCAN;
 
     // If the hint is {$natural: +-1} this changes the direction of the collection scan.
     if (!query.getQueryRequest().getHint().isEmpty()) {
@@ -173,6 +216,12 @@ std::unique_ptr<QuerySolutionNode> QueryPlannerAccess::makeCollectionScan(
         }
     }
 
+    // An explicit request for natural order is honoured with a single serial scan.
+    if (dps::extractElementAtPath(query.getQueryRequest().getHint(), "$natural") ||
+        dps::extractElementAtPath(sortObj, "$natural")) {
+        csn->allowParallel = false;
+    }
+
     return std::move(csn);
 }
 
@@ -538,9 +587,10 @@ bool QueryPlannerAccess::orNeedsFetch(const ScanBuildingState* scanState) {
     } else if (scanState->loosestBounds == IndexBoundsBuilder::INEXACT_FETCH) {
         return true;
     } else {
+        // handleFilterOr() only leaves the bounds INEXACT_COVERED if every predicate with such
+        // bounds can be evaluated against the index keys.
         invariant(scanState->loosestBounds == IndexBoundsBuilder::INEXACT_COVERED);
-        const IndexEntry& index = scanState->indices[scanState->currentIndexNumber];
-        return index.multikey;
+        return false;
     }
 }
 
@@ -601,6 +651,18 @@ void QueryPlannerAccess::finishLeafNode(QuerySolutionNode* node, const IndexEntr
         bounds = &scan->bounds;
     }
 
+    // A skip scan is planned over an entry which omits the first field of the index. Bounds for
+    // that field must be added before aligning the bounds with the full key pattern.
+    auto alignBounds = [&]() {
+        if (STAGE_IXSCAN == type && index.isSkipScan()) {
+            IndexScanNode* scan = static_cast<IndexScanNode*>(node);
+            expandSkipScan(scan, index);
+            IndexBoundsBuilder::alignBounds(bounds, scan->index.keyPattern);
+        } else {
+            IndexBoundsBuilder::alignBounds(bounds, index.keyPattern);
+        }
+    };
+
     // Find the first field in the scan's bounds that was not filled out.
     // TODO: could cache this.
     size_t firstEmptyField = 0;
@@ -613,7 +675,7 @@ void QueryPlannerAccess::finishLeafNode(QuerySolutionNode* node, const IndexEntr
 
     // All fields are filled out with bounds, nothing to do.
     if (firstEmptyField == bounds->fields.size()) {
-        IndexBoundsBuilder::alignBounds(bounds, index.keyPattern);
+        alignBounds();
         return;
     }
 
@@ -644,7 +706,7 @@ void QueryPlannerAccess::finishLeafNode(QuerySolutionNode* node, const IndexEntr
 
     // We create bounds assuming a forward direction but can easily reverse bounds to align
     // according to our desired direction.
-    IndexBoundsBuilder::alignBounds(bounds, index.keyPattern);
+    alignBounds();
 }
 
 // static
@@ -1220,7 +1282,7 @@ QuerySolutionNode* QueryPlannerAccess::buildIndexedDataAccess(const CanonicalQue
             if (tightness == IndexBoundsBuilder::EXACT) {
                 return soln;
             } else if (tightness == IndexBoundsBuilder::INEXACT_COVERED &&
-                       !indices[tag->index].multikey) {
+                       canUseCoveredFilter(indices[tag->index], tag->pos)) {
                 verify(NULL == soln->filter.get());
                 soln->filter.reset(autoRoot.release());
                 return soln;
@@ -1351,8 +1413,17 @@ void QueryPlannerAccess::handleFilterOr(ScanBuildingState* scanState) {
         // for affixing later.
         ++scanState->curChild;
     } else {
-        if (scanState->tightness < scanState->loosestBounds) {
-            scanState->loosestBounds = scanState->tightness;
+        // A predicate which cannot be evaluated against the index keys needs a fetch just as if
+        // its bounds were INEXACT_FETCH.
+        auto tightness = scanState->tightness;
+        if (tightness == IndexBoundsBuilder::INEXACT_COVERED &&
+            !canUseCoveredFilter(scanState->indices[scanState->currentIndexNumber],
+                                 scanState->ixtag->pos)) {
+            tightness = IndexBoundsBuilder::INEXACT_FETCH;
+        }
+
+        if (tightness < scanState->loosestBounds) {
+            scanState->loosestBounds = tightness;
         }
 
         // Detach 'child' and add it to 'curOr'.
@@ -1376,18 +1447,13 @@ void QueryPlannerAccess::handleFilterAnd(ScanBuildingState* scanState) {
         root->getChildVector()->erase(root->getChildVector()->begin() + scanState->curChild);
         delete child;
     } else if (scanState->tightness == IndexBoundsBuilder::INEXACT_COVERED &&
-               (INDEX_TEXT == index.type || !index.multikey)) {
+               canUseCoveredFilter(index, scanState->ixtag->pos)) {
         // The bounds are not exact, but the information needed to
         // evaluate the predicate is in the index key. Remove the
         // MatchExpression from its parent and attach it to the filter
-        // of the index scan we're building.
-        //
-        // We can only use this optimization if the index is NOT multikey.
-        // Suppose that we had the multikey index {x: 1} and a document
-        // {x: ["a", "b"]}. Now if we query for {x: /b/} the filter might
-        // ever only be applied to the index key "a". We'd incorrectly
-        // conclude that the document does not match the query :( so we
-        // gotta stick to non-multikey indices.
+        // of the index scan we're building. See canUseCoveredFilter()
+        // for why this is not possible for fields with multikey
+        // components.
         root->getChildVector()->erase(root->getChildVector()->begin() + scanState->curChild);
 
         addFilterToSolutionNode(scanState->currentScan.get(), child, root->matchType());
@@ -290,6 +290,41 @@ void geoSkipValidationOn(const std::set<StringData>& twoDSphereFields,
     }
 }
 
+/**
+ * Returns true if a blocking sort over 'solnRoot' can take its sort keys from the index keys,
+ * without fetching documents.
+ */
+bool canSortOnIndexKeys(const CanonicalQuery& query,
+                        const BSONObj& sortObj,
+                        QuerySolutionNode* solnRoot) {
+    if (solnRoot->fetched()) {
+        return false;
+    }
+
+    for (auto&& elt : sortObj) {
+        // $meta sorts need metadata which is not carried alongside index keys.
+        if (!elt.isNumber() || !solnRoot->hasField(elt.fieldName())) {
+            return false;
+        }
+    }
+
+    // Index keys for strings are collation keys, which only stand in for the sort keys if the
+    // query sorts with the same collator.
+    vector<QuerySolutionNode*> leafNodes;
+    getLeafNodes(solnRoot, &leafNodes);
+    for (auto&& leaf : leafNodes) {
+        if (STAGE_IXSCAN != leaf->getType()) {
+            return false;
+        }
+        const IndexScanNode* ixn = static_cast<const IndexScanNode*>(leaf);
+        if (!CollatorInterface::collatorsMatch(ixn->index.collator, query.getCollator())) {
+            return false;
+        }
+    }
+
+    return true;
+}
+
 }  // namespace
 
 // static
@@ -525,10 +560,14 @@ QuerySolutionNode* QueryPlannerAnalysis::analyzeSort(const CanonicalQuery& query
         return NULL;
     }
 
-    // Add a fetch stage so we have the full object when we hit the sort stage.  TODO: Can we
-    // pull the values that we sort by out of the key and if so in what cases?  Perhaps we can
-    // avoid a fetch.
-    if (!solnRoot->fetched()) {
+    // Add a fetch stage so we have the full object when we hit the sort stage. A sort with a
+    // limit may instead take its keys from the index and leave the fetch to the caller, so that
+    // only the documents which make it into the top K are fetched.
+    const bool hasLimit = qr.getLimit() || qr.getNToReturn();
+    const bool deferFetch = hasLimit &&
+        (params.options & QueryPlannerParams::DEFER_FETCH_FOR_TOP_K_SORT) &&
+        !qr.shouldAllowDiskUse() && canSortOnIndexKeys(query, sortObj, solnRoot);
+    if (!solnRoot->fetched() && !deferFetch) {
         FetchNode* fetch = new FetchNode();
         fetch->children.push_back(solnRoot);
         solnRoot = fetch;
@@ -812,6 +851,12 @@ QuerySolution* QueryPlannerAnalysis::analyzeDataAccess(
             solnRoot.reset(keyGenNode);
         }
 
+        // A FETCH directly below a SIMPLE_DOC projection can drop the other fields of the
+        // documents it returns, rather than copying them whole when they must be made owned.
+        if (ProjectionNode::SIMPLE_DOC == projType && STAGE_FETCH == solnRoot->getType()) {
+            static_cast<FetchNode*>(solnRoot.get())->simpleProjection = qr.getProj();
+        }
+
         // We now know we have whatever data is required for the projection.
         ProjectionNode* projNode = new ProjectionNode(*query.getProj());
         projNode->children.push_back(solnRoot.release());
@@ -185,6 +185,38 @@ void QueryPlannerIXSelect::findRelevantIndices(const unordered_set<string>& fiel
     }
 }
 
+// static
+void QueryPlannerIXSelect::findRelevantSkipScanIndices(const unordered_set<string>& fields,
+                                                       const vector<IndexEntry>& allIndices,
+                                                       vector<IndexEntry>* out) {
+    for (const auto& index : allIndices) {
+        if (INDEX_BTREE != index.type || index.leadingFieldCardinality < 0 ||
+            index.keyPattern.nFields() < 2) {
+            continue;
+        }
+
+        BSONObjIterator it(index.keyPattern);
+        it.next();
+        BSONObjBuilder suffixBuilder;
+        while (it.more()) {
+            suffixBuilder.append(it.next());
+        }
+        BSONObj suffix = suffixBuilder.obj();
+        if (fields.end() == fields.find(suffix.firstElementFieldName())) {
+            continue;
+        }
+
+        IndexEntry skipScanEntry(index);
+        skipScanEntry.keyPattern = suffix;
+        if (!index.multikeyPaths.empty()) {
+            skipScanEntry.multikeyPaths.erase(skipScanEntry.multikeyPaths.begin());
+        }
+        skipScanEntry.skipScanKeyPattern = index.keyPattern;
+        skipScanEntry.skipScanMultikeyPaths = index.multikeyPaths;
+        out->push_back(std::move(skipScanEntry));
+    }
+}
+
 // static
 bool QueryPlannerIXSelect::compatible(const BSONElement& elt,
                                       const IndexEntry& index,
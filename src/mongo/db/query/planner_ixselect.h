@@ -61,6 +61,15 @@ public:
                                     const std::vector<IndexEntry>& indices,
                                     std::vector<IndexEntry>* out);
 
+    /**
+     * Find all btree indices with an estimated leading field cardinality whose second field we
+     * have predicates over, and output an entry describing a skip scan over each of them. See
+     * IndexEntry::skipScanKeyPattern.
+     */
+    static void findRelevantSkipScanIndices(const unordered_set<std::string>& fields,
+                                            const std::vector<IndexEntry>& indices,
+                                            std::vector<IndexEntry>* out);
+
     /**
      * Return true if the index key pattern field 'elt' (which belongs to 'index') can be used
      * to answer the predicate 'node'.
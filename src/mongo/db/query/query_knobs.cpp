@@ -38,18 +38,26 @@ MONGO_EXPORT_SERVER_PARAMETER(internalQueryPlanEvaluationCollFraction, double, 0
 
 MONGO_EXPORT_SERVER_PARAMETER(internalQueryPlanEvaluationMaxResults, int, 101);
 
+MONGO_EXPORT_SERVER_PARAMETER(internalQueryPlanEvaluationParallelTrials, bool, false);
+
 MONGO_EXPORT_SERVER_PARAMETER(internalQueryCacheSize, int, 5000);
 
+MONGO_EXPORT_SERVER_PARAMETER(internalQueryCacheShards, int, 16);
+
 MONGO_EXPORT_SERVER_PARAMETER(internalQueryCacheFeedbacksStored, int, 20);
 
 MONGO_EXPORT_SERVER_PARAMETER(internalQueryCacheEvictionRatio, double, 10.0);
 
+MONGO_EXPORT_SERVER_PARAMETER(internalQueryCacheCheckpointIntervalSecs, int, 0);
+
 MONGO_EXPORT_SERVER_PARAMETER(internalQueryPlannerMaxIndexedSolutions, int, 64);
 
 MONGO_EXPORT_SERVER_PARAMETER(internalQueryEnumerationMaxOrSolutions, int, 10);
 
 MONGO_EXPORT_SERVER_PARAMETER(internalQueryEnumerationMaxIntersectPerAnd, int, 3);
 
+MONGO_EXPORT_SERVER_PARAMETER(internalQueryEnumerationPruneDominatedAssignments, bool, false);
+
 MONGO_EXPORT_SERVER_PARAMETER(internalQueryForceIntersectionPlans, bool, false);
 
 MONGO_EXPORT_SERVER_PARAMETER(internalQueryPlannerEnableIndexIntersection, bool, true);
@@ -60,11 +68,34 @@ MONGO_EXPORT_SERVER_PARAMETER(internalQueryPlanOrChildrenIndependently, bool, tr
 
 MONGO_EXPORT_SERVER_PARAMETER(internalQueryMaxScansToExplode, int, 200);
 
+MONGO_EXPORT_SERVER_PARAMETER(internalQueryPlannerDeferFetchForTopKSort, bool, true);
+
+MONGO_EXPORT_SERVER_PARAMETER(internalQueryPlannerSkipScanMaxLeadingValues, int, 32);
+
+MONGO_EXPORT_SERVER_PARAMETER(internalQueryPlannerSkipScanCardinalityCacheSecs, int, 60);
+
+MONGO_EXPORT_SERVER_PARAMETER(internalQueryPlannerCostPruningRatio, double, 0.0);
+
 MONGO_EXPORT_SERVER_PARAMETER(internalQueryExecMaxBlockingSortBytes, int, 32 * 1024 * 1024);
 
 // Yield every 128 cycles or 10ms.
 MONGO_EXPORT_SERVER_PARAMETER(internalQueryExecYieldIterations, int, 128);
 MONGO_EXPORT_SERVER_PARAMETER(internalQueryExecYieldPeriodMS, int, 10);
+MONGO_EXPORT_SERVER_PARAMETER(internalQueryExecYieldAdaptive, bool, false);
+MONGO_EXPORT_SERVER_PARAMETER(internalQueryExecYieldAdaptiveMaxPeriodMS, int, 100);
+
+MONGO_EXPORT_SERVER_PARAMETER(internalQueryExecBatchedWorkSize, int, 0);
+
+MONGO_EXPORT_SERVER_PARAMETER(internalQueryExecFetchPrefetchBatchSize, int, 0);
+
+MONGO_EXPORT_SERVER_PARAMETER(internalQueryParallelCollectionScanWorkers, int, 0);
+MONGO_EXPORT_SERVER_PARAMETER(internalQueryParallelCollectionScanBatchSize, int, 1000);
+MONGO_EXPORT_SERVER_PARAMETER(internalQueryParallelCollectionScanMaxBufferBytes,
+                              int,
+                              4 * 1024 * 1024);
+MONGO_EXPORT_SERVER_PARAMETER(internalQueryParallelCollectionScanPreserveOrder, bool, true);
+
+MONGO_EXPORT_SERVER_PARAMETER(internalQueryStatsStoreSize, int, 5000);
 
 MONGO_EXPORT_SERVER_PARAMETER(internalQueryFacetBufferSizeBytes, int, 100 * 1024 * 1024);
 
@@ -76,6 +107,17 @@ MONGO_EXPORT_SERVER_PARAMETER(internalDocumentSourceCursorBatchSizeBytes, int, 4
 
 MONGO_EXPORT_SERVER_PARAMETER(internalDocumentSourceLookupCacheSizeBytes, int, 100 * 1024 * 1024);
 
+MONGO_EXPORT_SERVER_PARAMETER(internalDocumentSourceLookupHashJoinMaxBytes, int, 32 * 1024 * 1024);
+MONGO_EXPORT_SERVER_PARAMETER(internalDocumentSourceLookupHashJoinBatchSize, int, 100);
+
+MONGO_EXPORT_SERVER_PARAMETER(internalDocumentSourceGroupHashPartitions, int, 16);
+MONGO_EXPORT_SERVER_PARAMETER(internalDocumentSourceGroupBatchSize, int, 1024);
+
+MONGO_EXPORT_SERVER_PARAMETER(internalDocumentSourceExchangeWorkers, int, 0);
+MONGO_EXPORT_SERVER_PARAMETER(internalDocumentSourceExchangeBatchSize, int, 1000);
+
+MONGO_EXPORT_SERVER_PARAMETER(internalQueryCompileProjectionExpressions, bool, true);
+
 MONGO_EXPORT_SERVER_PARAMETER(internalQueryPlannerGenerateCoveredWholeIndexScans, bool, false);
 
 MONGO_EXPORT_SERVER_PARAMETER(internalQueryIgnoreUnknownJSONSchemaKeywords, bool, false);
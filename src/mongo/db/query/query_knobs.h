@@ -48,6 +48,10 @@ extern AtomicDouble internalQueryPlanEvaluationCollFraction;
 // Stop working plans once a plan returns this many results.
 extern AtomicInt32 internalQueryPlanEvaluationMaxResults;
 
+// Work the candidate plans of a read at the same time, each on a worker thread with a snapshot of
+// its own, rather than in turn on the thread running the query.
+extern AtomicBool internalQueryPlanEvaluationParallelTrials;
+
 // Do we give a big ranking bonus to intersection plans?
 extern AtomicBool internalQueryForceIntersectionPlans;
 
@@ -64,6 +68,10 @@ extern AtomicBool internalQueryPlannerEnableHashIntersection;
 // How many entries in the cache?
 extern AtomicInt32 internalQueryCacheSize;
 
+// How many independently locked shards is each collection's cache split into? The cache size is
+// divided evenly between them.
+extern AtomicInt32 internalQueryCacheShards;
+
 // How many feedback entries do we collect before possibly evicting from the cache based on bad
 // performance?
 extern AtomicInt32 internalQueryCacheFeedbacksStored;
@@ -72,6 +80,10 @@ extern AtomicInt32 internalQueryCacheFeedbacksStored;
 // and replanning?
 extern AtomicDouble internalQueryCacheEvictionRatio;
 
+// How many seconds between checkpoints of every collection's plan cache to local storage? The
+// checkpoint is restored at startup. A value of 0 disables checkpointing, and restoring at startup.
+extern AtomicInt32 internalQueryCacheCheckpointIntervalSecs;
+
 //
 // Planning and enumeration.
 //
@@ -85,6 +97,12 @@ extern AtomicInt32 internalQueryEnumerationMaxOrSolutions;
 // How many intersections will the enumerator consider at each AND?
 extern AtomicInt32 internalQueryEnumerationMaxIntersectPerAnd;
 
+// Do we drop an index assignment when another assignment to the same AND uses an index whose key
+// pattern extends the first's with a bounded field? The other assignment scans no more keys and
+// provides every sort the first does. Off by default: pruning can leave a single solution where
+// there used to be several, which changes what the plan cache holds and what explain reports.
+extern AtomicBool internalQueryEnumerationPruneDominatedAssignments;
+
 // Do we want to plan each child of the OR independently?
 extern AtomicBool internalQueryPlanOrChildrenIndependently;
 
@@ -92,6 +110,23 @@ extern AtomicBool internalQueryPlanOrChildrenIndependently;
 // during explodeForSort?
 extern AtomicInt32 internalQueryMaxScansToExplode;
 
+// Allow a SORT with a limit to buffer index keys rather than documents when the index provides
+// every sort field, fetching only the documents which make it into the top K.
+extern AtomicBool internalQueryPlannerDeferFetchForTopKSort;
+
+// Queries with no index prefixed by a predicated field may skip scan a compound index whose first
+// field has at most this many distinct values. A value of 0 disables skip scans.
+extern AtomicInt32 internalQueryPlannerSkipScanMaxLeadingValues;
+
+// How long the leading field cardinality counted for a skip scan candidate is reused by later
+// planning passes over the same collection. A value of 0 counts on every planning pass.
+extern AtomicInt32 internalQueryPlannerSkipScanCardinalityCacheSecs;
+
+// Before trial execution, discard candidate plans whose cost, estimated from index statistics,
+// exceeds this multiple of the cheapest estimate. A value of 0, the default, disables pruning, as
+// index statistics are only refreshed by analyzeIndexes and may be arbitrarily stale.
+extern AtomicDouble internalQueryPlannerCostPruningRatio;
+
 // Allow the planner to generate covered whole index scans, rather than falling back to a COLLSCAN.
 extern AtomicBool internalQueryPlannerGenerateCoveredWholeIndexScans;
 
@@ -110,6 +145,40 @@ extern AtomicInt32 internalQueryExecYieldIterations;
 // Yield if it's been at least this many milliseconds since we last yielded.
 extern AtomicInt32 internalQueryExecYieldPeriodMS;
 
+// Skip the yields called for by the two knobs above unless another operation is waiting on a lock
+// we hold or the storage engine's cache is under pressure. Either is checked for at four times the
+// usual rate, so that we yield sooner when it is found.
+extern AtomicBool internalQueryExecYieldAdaptive;
+
+// When yielding adaptively, yield if it's been at least this many milliseconds since we last
+// yielded, whether or not anyone is waiting.
+extern AtomicInt32 internalQueryExecYieldAdaptiveMaxPeriodMS;
+
+// The number of units of work PlanExecutor asks for at once from plans which support batched
+// work. Values of 0 or 1 disable batched execution.
+extern AtomicInt32 internalQueryExecBatchedWorkSize;
+
+// FETCH stages buffer up to this many results from their child and ask the storage engine to
+// prefetch their records together, before fetching them one at a time. Values of 0 or 1 disable
+// prefetching.
+extern AtomicInt32 internalQueryExecFetchPrefetchBatchSize;
+
+// The number of RecordId ranges a forward collection scan for a read may be split into, each
+// scanned by a worker thread. Values of 0 or 1 disable parallel collection scans.
+extern AtomicInt32 internalQueryParallelCollectionScanWorkers;
+
+// The number of documents each parallel collection scan worker examines per round.
+extern AtomicInt32 internalQueryParallelCollectionScanBatchSize;
+
+// The number of bytes of results a parallel collection scan may buffer for each range.
+extern AtomicInt32 internalQueryParallelCollectionScanMaxBufferBytes;
+
+// Whether a parallel collection scan returns results in the same order as a serial scan.
+extern AtomicBool internalQueryParallelCollectionScanPreserveOrder;
+
+// How many query shapes do we keep execution statistics for? A value of 0 disables the statistics.
+extern AtomicInt32 internalQueryStatsStoreSize;
+
 // Limit the size that we write without yielding to 16MB / 64 (max expected number of indexes)
 const int64_t insertVectorMaxBytes = 256 * 1024;
 
@@ -122,5 +191,38 @@ extern AtomicInt32 internalDocumentSourceCursorBatchSizeBytes;
 
 extern AtomicInt32 internalDocumentSourceLookupCacheSizeBytes;
 
+// The number of bytes of foreign documents a $lookup with localField/foreignField syntax may hold
+// in a hash table, so that local documents find their matches without a query each. The table
+// holds the whole foreign collection if it fits, or else the matches of a batch of local documents.
+// A value of 0 disables hash joins.
+extern AtomicInt32 internalDocumentSourceLookupHashJoinMaxBytes;
+
+// The number of local documents whose matches a hash joining $lookup finds with a single query,
+// when the foreign documents do not all fit in its hash table.
+extern AtomicInt32 internalDocumentSourceLookupHashJoinBatchSize;
+
+// The number of partitions, by the hash of the group _id, a $group which runs out of memory spills
+// its groups into. Each partition is then aggregated on its own, and split again if it does not
+// fit. Values of 0 or 1 spill sorted runs of groups instead, which are merged as they are read.
+extern AtomicInt32 internalDocumentSourceGroupHashPartitions;
+
+// The number of documents whose accumulator inputs a $group gathers before processing them, so
+// that the accumulators of each group can process all of that group's inputs at once, with tight
+// loops over runs of numbers. Values of 0 or 1 process each document as it arrives.
+extern AtomicInt32 internalDocumentSourceGroupBatchSize;
+
+// The number of worker threads an aggregation may run the shards' part of its pipeline on, as if
+// the collection were sharded, when that part has only $match, $project, $addFields, $unwind and
+// $group stages. Values of 0 or 1 run the whole pipeline on the thread serving the aggregation.
+extern AtomicInt32 internalDocumentSourceExchangeWorkers;
+
+// The number of documents each exchange worker is given per round.
+extern AtomicInt32 internalDocumentSourceExchangeBatchSize;
+
+// Compile the computed fields of a $project or $addFields stage, when it is optimized, into a
+// single program which computes each distinct subexpression once per document and does arithmetic
+// on unboxed numbers.
+extern AtomicBool internalQueryCompileProjectionExpressions;
+
 extern AtomicBool internalQueryProhibitBlockingMergeOnMongoS;
 }  // namespace mongo
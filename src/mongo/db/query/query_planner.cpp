@@ -53,6 +53,7 @@
 #include "mongo/db/query/query_planner_common.h"
 #include "mongo/db/query/query_solution.h"
 #include "mongo/util/log.h"
+#include "mongo/util/timer.h"
 
 namespace mongo {
 
@@ -135,6 +136,16 @@ string optionString(size_t options) {
                 break;
             case QueryPlannerParams::TRACK_LATEST_OPLOG_TS:
                 ss << "TRACK_LATEST_OPLOG_TS ";
+                break;
+            case QueryPlannerParams::ALLOW_PARALLEL_COLLSCAN:
+                ss << "ALLOW_PARALLEL_COLLSCAN ";
+                break;
+            case QueryPlannerParams::DEFER_FETCH_FOR_TOP_K_SORT:
+                ss << "DEFER_FETCH_FOR_TOP_K_SORT ";
+                break;
+            case QueryPlannerParams::ALLOW_PARALLEL_TRIALS:
+                ss << "ALLOW_PARALLEL_TRIALS ";
+                break;
             case QueryPlannerParams::DEFAULT:
                 MONGO_UNREACHABLE;
                 break;
@@ -314,6 +325,12 @@ Status QueryPlanner::cacheDataFromTaggedTree(const MatchExpression* const tagged
             return Status(ErrorCodes::BadValue, ss);
         }
 
+        // Skip scans are described by entries which are not in the catalog, so they can't be
+        // looked up again when planning from the cache.
+        if (relevantIndices[itag->index].isSkipScan()) {
+            return Status(ErrorCodes::BadValue, "can't cache skip scan");
+        }
+
         // Make sure not to cache solutions which use '2d' indices.
         // A 2d index that doesn't wrap on one query may wrap on another, so we have to
         // check that the index is OK with the predicate. The only thing we have to do
@@ -335,6 +352,10 @@ Status QueryPlanner::cacheDataFromTaggedTree(const MatchExpression* const tagged
         if (orPushdownTag->getIndexTag()) {
             const IndexTag* itag = static_cast<const IndexTag*>(orPushdownTag->getIndexTag());
 
+            if (relevantIndices[itag->index].isSkipScan()) {
+                return Status(ErrorCodes::BadValue, "can't cache skip scan");
+            }
+
             if (is2DIndex(relevantIndices[itag->index].keyPattern)) {
                 return Status(ErrorCodes::BadValue, "can't cache '2d' index");
             }
@@ -350,6 +371,9 @@ Status QueryPlanner::cacheDataFromTaggedTree(const MatchExpression* const tagged
             PlanCacheIndexTree::OrPushdown orPushdown;
             orPushdown.route = dest.route;
             IndexTag* indexTag = static_cast<IndexTag*>(dest.tagData.get());
+            if (relevantIndices[indexTag->index].isSkipScan()) {
+                return Status(ErrorCodes::BadValue, "can't cache skip scan");
+            }
             orPushdown.indexName = relevantIndices[indexTag->index].name;
             orPushdown.position = indexTag->pos;
             orPushdown.canCombineBounds = indexTag->canCombineBounds;
@@ -648,6 +672,15 @@ Status QueryPlanner::plan(const CanonicalQuery& query,
 
     if (hintIndex.isEmpty()) {
         QueryPlannerIXSelect::findRelevantIndices(fields, params.indices, &relevantIndices);
+
+        // If no index is prefixed by a predicated field, we would otherwise collection scan.
+        // Consider skipping over the values of the first field of indexes whose first field is
+        // known to have few distinct values, using any predicates over their second field.
+        if (relevantIndices.empty() && query.getQueryRequest().getMin().isEmpty() &&
+            query.getQueryRequest().getMax().isEmpty()) {
+            QueryPlannerIXSelect::findRelevantSkipScanIndices(
+                fields, params.indices, &relevantIndices);
+        }
     } else {
         // Sigh.  If the hint is specified it might be using the index name.
         BSONElement firstHintElt = hintIndex.firstElement();
@@ -860,6 +893,17 @@ Status QueryPlanner::plan(const CanonicalQuery& query,
         LOG(5) << "Rated tree after text processing:" << redact(query.root()->toString());
     }
 
+    // Filled out if we enumerate indexed plans, and attached to every solution we output.
+    boost::optional<QuerySolution::EnumerationStats> enumerationStats;
+    auto attachEnumerationStats = [&] {
+        if (!enumerationStats) {
+            return;
+        }
+        for (auto soln : *out) {
+            soln->enumerationStats = enumerationStats;
+        }
+    };
+
     // If we have any relevant indices, we try to create indexed plans.
     if (0 < relevantIndices.size()) {
         // The enumerator spits out trees tagged with IndexTag(s).
@@ -868,11 +912,20 @@ Status QueryPlanner::plan(const CanonicalQuery& query,
         enumParams.root = query.root();
         enumParams.indices = &relevantIndices;
 
+        // Only time spent in the enumerator is counted, not that spent building solutions.
+        Timer enumerationTimer;
         PlanEnumerator isp(enumParams);
         isp.init().transitional_ignore();
+        Microseconds enumerationTime(enumerationTimer.micros());
+        auto nextTaggedTree = [&] {
+            enumerationTimer.reset();
+            auto taggedTree = isp.getNext();
+            enumerationTime += Microseconds(enumerationTimer.micros());
+            return taggedTree;
+        };
 
         unique_ptr<MatchExpression> rawTree;
-        while ((rawTree = isp.getNext()) && (out->size() < params.maxIndexedSolutions)) {
+        while ((out->size() < params.maxIndexedSolutions) && (rawTree = nextTaggedTree())) {
             LOG(5) << "About to build solntree from tagged tree:" << endl
                    << redact(rawTree.get()->toString());
 
@@ -912,6 +965,10 @@ Status QueryPlanner::plan(const CanonicalQuery& query,
                 out->push_back(soln);
             }
         }
+
+        enumerationStats = QuerySolution::EnumerationStats();
+        enumerationStats->time = enumerationTime;
+        enumerationStats->assignmentsPruned = isp.getNumPrunedAssignments();
     }
 
     // Don't leave tags on query tree.
@@ -945,6 +1002,7 @@ Status QueryPlanner::plan(const CanonicalQuery& query,
                 out->push_back(soln);
             }
         }
+        attachEnumerationStats();
         return Status::OK();
     }
 
@@ -1096,6 +1154,7 @@ Status QueryPlanner::plan(const CanonicalQuery& query,
         }
     }
 
+    attachEnumerationStats();
     return Status::OK();
 }
 
@@ -101,6 +101,20 @@ struct QueryPlannerParams {
 
         // Set this to track the most recent timestamp seen by this cursor while scanning the oplog.
         TRACK_LATEST_OPLOG_TS = 1 << 12,
+
+        // Set this to allow a collection scan to be split into RecordId ranges which are scanned
+        // by worker threads. Only read-only operations may set this, since the results carry no
+        // guarantee of coming from a single snapshot.
+        ALLOW_PARALLEL_COLLSCAN = 1 << 13,
+
+        // Set this to allow a SORT with a limit to sit below the FETCH when the index keys provide
+        // every field of the sort pattern, so only the documents in the top K are fetched.
+        DEFER_FETCH_FOR_TOP_K_SORT = 1 << 14,
+
+        // Set this to allow the trial periods of candidate plans to run at the same time on worker
+        // threads. Only read-only operations may set this, since each candidate reads from
+        // snapshots of its own.
+        ALLOW_PARALLEL_TRIALS = 1 << 15,
     };
 
     // See Options enum above.
@@ -1583,6 +1583,166 @@ TEST_F(QueryPlannerTest, SortSkipSoftLimit) {
         "{node: {cscan: {dir: 1}}}}}}}}");
 }
 
+//
+// Deferring the fetch past a top-K sort
+//
+
+TEST_F(QueryPlannerTest, TopKSortOnIndexKeysDefersFetch) {
+    params.options = QueryPlannerParams::NO_TABLE_SCAN;
+    params.options |= QueryPlannerParams::DEFER_FETCH_FOR_TOP_K_SORT;
+    addIndex(BSON("a" << 1 << "b" << 1));
+
+    runQueryAsCommand(
+        fromjson("{find: 'testns', filter: {a: {$gt: 1}}, sort: {b: -1}, limit: 20}"));
+
+    assertNumSolutions(1U);
+    assertSolutionExists(
+        "{fetch: {filter: null, node: {sort: {pattern: {b: -1}, limit: 20, node: {sortKeyGen: "
+        "{node: {ixscan: {pattern: {a: 1, b: 1}}}}}}}}}");
+}
+
+TEST_F(QueryPlannerTest, TopKSortOnIndexKeysWithCoveredProjectionNeedsNoFetch) {
+    params.options = QueryPlannerParams::NO_TABLE_SCAN;
+    params.options |= QueryPlannerParams::DEFER_FETCH_FOR_TOP_K_SORT;
+    addIndex(BSON("a" << 1 << "b" << 1));
+
+    runQueryAsCommand(fromjson(
+        "{find: 'testns', filter: {a: {$gt: 1}}, sort: {b: 1}, projection: {_id: 0, b: 1}, "
+        "limit: 5}"));
+
+    assertNumSolutions(1U);
+    assertSolutionExists(
+        "{proj: {spec: {_id: 0, b: 1}, type: 'coveredIndex', node: {sort: {pattern: {b: 1}, "
+        "limit: 5, node: {sortKeyGen: {node: {ixscan: {pattern: {a: 1, b: 1}}}}}}}}}");
+}
+
+TEST_F(QueryPlannerTest, SortWithoutLimitDoesNotDeferFetch) {
+    params.options = QueryPlannerParams::NO_TABLE_SCAN;
+    params.options |= QueryPlannerParams::DEFER_FETCH_FOR_TOP_K_SORT;
+    addIndex(BSON("a" << 1 << "b" << 1));
+
+    runQueryAsCommand(fromjson("{find: 'testns', filter: {a: {$gt: 1}}, sort: {b: -1}}"));
+
+    assertNumSolutions(1U);
+    assertSolutionExists(
+        "{sort: {pattern: {b: -1}, limit: 0, node: {sortKeyGen: {node: "
+        "{fetch: {filter: null, node: {ixscan: {pattern: {a: 1, b: 1}}}}}}}}}");
+}
+
+TEST_F(QueryPlannerTest, TopKSortOnFieldMissingFromIndexDoesNotDeferFetch) {
+    params.options = QueryPlannerParams::NO_TABLE_SCAN;
+    params.options |= QueryPlannerParams::DEFER_FETCH_FOR_TOP_K_SORT;
+    addIndex(BSON("a" << 1));
+
+    runQueryAsCommand(
+        fromjson("{find: 'testns', filter: {a: {$gt: 1}}, sort: {b: -1}, limit: 20}"));
+
+    assertNumSolutions(1U);
+    assertSolutionExists(
+        "{sort: {pattern: {b: -1}, limit: 20, node: {sortKeyGen: {node: "
+        "{fetch: {filter: null, node: {ixscan: {pattern: {a: 1}}}}}}}}}");
+}
+
+TEST_F(QueryPlannerTest, TopKSortOnMultikeyFieldDoesNotDeferFetch) {
+    params.options = QueryPlannerParams::NO_TABLE_SCAN;
+    params.options |= QueryPlannerParams::DEFER_FETCH_FOR_TOP_K_SORT;
+    MultikeyPaths multikeyPaths{std::set<size_t>{}, {0U}};
+    addIndex(BSON("a" << 1 << "b" << 1), multikeyPaths);
+
+    runQueryAsCommand(
+        fromjson("{find: 'testns', filter: {a: {$gt: 1}}, sort: {b: -1}, limit: 20}"));
+
+    assertNumSolutions(1U);
+    assertSolutionExists(
+        "{sort: {pattern: {b: -1}, limit: 20, node: {sortKeyGen: {node: "
+        "{fetch: {filter: null, node: {ixscan: {pattern: {a: 1, b: 1}}}}}}}}}");
+}
+
+TEST_F(QueryPlannerTest, TopKSortAllowedToSpillDoesNotDeferFetch) {
+    params.options = QueryPlannerParams::NO_TABLE_SCAN;
+    params.options |= QueryPlannerParams::DEFER_FETCH_FOR_TOP_K_SORT;
+    addIndex(BSON("a" << 1 << "b" << 1));
+
+    runQueryAsCommand(fromjson(
+        "{find: 'testns', filter: {a: {$gt: 1}}, sort: {b: -1}, limit: 20, allowDiskUse: true}"));
+
+    assertNumSolutions(1U);
+    assertSolutionExists(
+        "{sort: {pattern: {b: -1}, limit: 20, node: {sortKeyGen: {node: "
+        "{fetch: {filter: null, node: {ixscan: {pattern: {a: 1, b: 1}}}}}}}}}");
+}
+
+//
+// Skip scans
+//
+
+TEST_F(QueryPlannerTest, SkipScanUsesIndexWithLowCardinalityLeadingField) {
+    addIndex(BSON("a" << 1 << "b" << 1));
+    params.indices.back().leadingFieldCardinality = 3;
+
+    runQuery(fromjson("{b: 5}"));
+
+    assertNumSolutions(1U);
+    assertSolutionExists(
+        "{fetch: {filter: null, node: {ixscan: {pattern: {a: 1, b: 1}, bounds: "
+        "{a: [['MinKey','MaxKey',true,true]], b: [[5,5,true,true]]}}}}}");
+}
+
+TEST_F(QueryPlannerTest, SkipScanNotUsedWithoutLeadingFieldCardinality) {
+    addIndex(BSON("a" << 1 << "b" << 1));
+
+    runQuery(fromjson("{b: 5}"));
+
+    assertNumSolutions(1U);
+    assertSolutionExists("{cscan: {dir: 1}}");
+}
+
+TEST_F(QueryPlannerTest, SkipScanNotUsedWhenAnIndexIsPrefixedByPredicatedField) {
+    addIndex(BSON("a" << 1 << "b" << 1));
+    params.indices.back().leadingFieldCardinality = 3;
+    addIndex(BSON("c" << 1));
+
+    runQuery(fromjson("{b: 5, c: 6}"));
+
+    assertNumSolutions(1U);
+    assertSolutionExists("{fetch: {filter: {b: 5}, node: {ixscan: {pattern: {c: 1}}}}}");
+}
+
+TEST_F(QueryPlannerTest, SkipScanBoundsOnDescendingIndex) {
+    addIndex(BSON("a" << -1 << "b" << -1 << "c" << 1));
+    params.indices.back().leadingFieldCardinality = 3;
+
+    runQuery(fromjson("{b: {$gt: 5}, c: 1}"));
+
+    assertNumSolutions(1U);
+    assertSolutionExists(
+        "{fetch: {filter: null, node: {ixscan: {pattern: {a: -1, b: -1, c: 1}, bounds: "
+        "{a: [['MaxKey','MinKey',true,true]], b: [[Infinity,5,true,false]], "
+        "c: [[1,1,true,true]]}}}}}");
+}
+
+TEST_F(QueryPlannerTest, SkipScanCanBeCovered) {
+    addIndex(BSON("a" << 1 << "b" << 1));
+    params.indices.back().leadingFieldCardinality = 3;
+
+    runQuerySortProj(fromjson("{b: {$in: [1, 2]}}"), BSONObj(), fromjson("{_id: 0, a: 1, b: 1}"));
+
+    assertNumSolutions(1U);
+    assertSolutionExists(
+        "{proj: {spec: {_id: 0, a: 1, b: 1}, node: {ixscan: {pattern: {a: 1, b: 1}, bounds: "
+        "{a: [['MinKey','MaxKey',true,true]], b: [[1,1,true,true], [2,2,true,true]]}}}}}");
+}
+
+TEST_F(QueryPlannerTest, SkipScanSolutionIsNotCached) {
+    addIndex(BSON("a" << 1 << "b" << 1));
+    params.indices.back().leadingFieldCardinality = 3;
+
+    runQuery(fromjson("{b: 5}"));
+
+    assertNumSolutions(1U);
+    ASSERT_FALSE(solns[0]->cacheData);
+}
+
 //
 // Sort elimination
 //
@@ -3591,6 +3751,102 @@ TEST_F(QueryPlannerTest, IntersectCompoundInsteadUnusedField2) {
         "{ixscan: {filter: null, pattern: {a:1,b:1,c:1}}}}}");
 }
 
+//
+// Pruning of dominated index assignments.
+//
+
+TEST_F(QueryPlannerTest, PruneDominatedAssignmentToIndexPrefix) {
+    bool oldPruneDominated = internalQueryEnumerationPruneDominatedAssignments.load();
+    internalQueryEnumerationPruneDominatedAssignments.store(true);
+
+    addIndex(BSON("a" << 1));
+    addIndex(BSON("a" << 1 << "b" << 1));
+
+    runQuery(fromjson("{a:1, b:{$gt:2,$lt:2}}"));
+
+    // The scan of {a: 1} examines every key that the scan of {a: 1, b: 1} does, and more.
+    assertNumSolutions(2U);
+    assertSolutionExists("{cscan: {dir: 1, filter: {$and:[{b:{$lt:2}},{a:1},{b:{$gt:2}}]}}}");
+    assertSolutionExists(
+        "{fetch: {filter: null, node: {ixscan: "
+        "{filter: null, pattern: {a: 1, b: 1}}}}}");
+
+    internalQueryEnumerationPruneDominatedAssignments.store(oldPruneDominated);
+}
+
+TEST_F(QueryPlannerTest, PruneDominatedAssignmentsTransitively) {
+    bool oldPruneDominated = internalQueryEnumerationPruneDominatedAssignments.load();
+    internalQueryEnumerationPruneDominatedAssignments.store(true);
+
+    addIndex(BSON("a" << 1));
+    addIndex(BSON("a" << 1 << "b" << 1));
+    addIndex(BSON("a" << 1 << "b" << 1 << "c" << 1));
+
+    runQuery(fromjson("{a: 1, b: 1, c: 1}"));
+
+    assertNumSolutions(2U);
+    assertSolutionExists("{cscan: {dir: 1}}");
+    assertSolutionExists(
+        "{fetch: {filter: null, node: {ixscan: "
+        "{filter: null, pattern: {a: 1, b: 1, c: 1}}}}}");
+
+    internalQueryEnumerationPruneDominatedAssignments.store(oldPruneDominated);
+}
+
+TEST_F(QueryPlannerTest, DoNotPruneAssignmentWhenLongerIndexDoesNotBoundNextField) {
+    bool oldPruneDominated = internalQueryEnumerationPruneDominatedAssignments.load();
+    internalQueryEnumerationPruneDominatedAssignments.store(true);
+
+    addIndex(BSON("a" << 1));
+    addIndex(BSON("a" << 1 << "b" << 1));
+
+    runQuery(fromjson("{a: 1}"));
+
+    // Neither scan is tighter than the other.
+    assertNumSolutions(3U);
+    assertSolutionExists("{cscan: {dir: 1, filter: {a: 1}}}");
+    assertSolutionExists("{fetch: {filter: null, node: {ixscan: {pattern: {a: 1}}}}}");
+    assertSolutionExists("{fetch: {filter: null, node: {ixscan: {pattern: {a: 1, b: 1}}}}}");
+
+    internalQueryEnumerationPruneDominatedAssignments.store(oldPruneDominated);
+}
+
+TEST_F(QueryPlannerTest, DoNotPruneAssignmentToMultikeyIndex) {
+    bool oldPruneDominated = internalQueryEnumerationPruneDominatedAssignments.load();
+    internalQueryEnumerationPruneDominatedAssignments.store(true);
+
+    addIndex(BSON("a" << 1));
+    addIndex(BSON("a" << 1 << "b" << 1), true);
+
+    runQuery(fromjson("{a: 1, b: 1}"));
+
+    assertNumSolutions(3U);
+    assertSolutionExists("{cscan: {dir: 1}}");
+    assertSolutionExists("{fetch: {filter: {b: 1}, node: {ixscan: {pattern: {a: 1}}}}}");
+    assertSolutionExists("{fetch: {node: {ixscan: {pattern: {a: 1, b: 1}}}}}");
+
+    internalQueryEnumerationPruneDominatedAssignments.store(oldPruneDominated);
+}
+
+TEST_F(QueryPlannerTest, DoNotPruneAssignmentWhenShorterIndexLeavesFieldUnbounded) {
+    bool oldPruneDominated = internalQueryEnumerationPruneDominatedAssignments.load();
+    internalQueryEnumerationPruneDominatedAssignments.store(true);
+
+    addIndex(BSON("a" << 1 << "c" << 1));
+    addIndex(BSON("a" << 1 << "c" << 1 << "b" << 1));
+
+    runQuery(fromjson("{a: 1, b: 1}"));
+
+    // The scan of {a: 1, c: 1, b: 1} checks 'b' in the index keys, but examines as many keys as
+    // the scan of {a: 1, c: 1}.
+    assertNumSolutions(3U);
+    assertSolutionExists("{cscan: {dir: 1}}");
+    assertSolutionExists("{fetch: {filter: {b: 1}, node: {ixscan: {pattern: {a: 1, c: 1}}}}}");
+    assertSolutionExists("{fetch: {node: {ixscan: {pattern: {a: 1, c: 1, b: 1}}}}}");
+
+    internalQueryEnumerationPruneDominatedAssignments.store(oldPruneDominated);
+}
+
 //
 // Test that we add a KeepMutations when we should and and we don't add one when we shouldn't.
 //
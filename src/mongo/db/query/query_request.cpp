@@ -99,6 +99,7 @@ const char kOplogReplayField[] = "oplogReplay";
 const char kNoCursorTimeoutField[] = "noCursorTimeout";
 const char kAwaitDataField[] = "awaitData";
 const char kPartialResultsField[] = "allowPartialResults";
+const char kAllowDiskUseField[] = "allowDiskUse";
 const char kTermField[] = "term";
 const char kOptionsField[] = "options";
 
@@ -351,6 +352,13 @@ StatusWith<unique_ptr<QueryRequest>> QueryRequest::parseFromFindCommand(unique_p
             }
 
             qr->_allowPartialResults = el.boolean();
+        } else if (fieldName == kAllowDiskUseField) {
+            Status status = checkFieldType(el, Bool);
+            if (!status.isOK()) {
+                return status;
+            }
+
+            qr->_allowDiskUse = el.boolean();
         } else if (fieldName == kOptionsField) {
             // 3.0.x versions of the shell may generate an explain of a find command with an
             // 'options' field. We accept this only if the 'options' field is empty so that
@@ -532,6 +540,10 @@ void QueryRequest::asFindCommand(BSONObjBuilder* cmdBuilder) const {
         cmdBuilder->append(kPartialResultsField, true);
     }
 
+    if (_allowDiskUse) {
+        cmdBuilder->append(kAllowDiskUseField, true);
+    }
+
     if (_replicationTerm) {
         cmdBuilder->append(kTermField, *_replicationTerm);
     }
@@ -1112,6 +1124,9 @@ StatusWith<BSONObj> QueryRequest::asAggregationCommand() const {
     if (!_comment.empty()) {
         aggregationBuilder.append("comment", _comment);
     }
+    if (_allowDiskUse) {
+        aggregationBuilder.append(kAllowDiskUseField, true);
+    }
     if (!_readConcern.isEmpty()) {
         aggregationBuilder.append("readConcern", _readConcern);
     }
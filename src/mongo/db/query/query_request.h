@@ -389,6 +389,14 @@ public:
         _allowPartialResults = allowPartialResults;
     }
 
+    bool shouldAllowDiskUse() const {
+        return _allowDiskUse;
+    }
+
+    void setAllowDiskUse(bool allowDiskUse) {
+        _allowDiskUse = allowDiskUse;
+    }
+
     boost::optional<long long> getReplicationTerm() const {
         return _replicationTerm;
     }
@@ -520,6 +528,9 @@ private:
     bool _exhaust = false;
     bool _allowPartialResults = false;
 
+    // Allows blocking sorts which exceed the in-memory limit to spill to disk.
+    bool _allowDiskUse = false;
+
     boost::optional<long long> _replicationTerm;
 };
 
@@ -451,6 +451,20 @@ TEST(QueryRequestTest, ParseFromCommandAllFlagsTrue) {
     ASSERT(qr->isAllowPartialResults());
 }
 
+TEST(QueryRequestTest, ParseFromCommandAllowDiskUse) {
+    BSONObj cmdObj = fromjson("{find: 'testns', sort: {a: 1}, allowDiskUse: true}");
+    const NamespaceString nss("test.testns");
+    bool isExplain = false;
+    unique_ptr<QueryRequest> qr(
+        assertGet(QueryRequest::makeFromFindCommand(nss, cmdObj, isExplain)));
+
+    ASSERT(qr->shouldAllowDiskUse());
+
+    BSONObjBuilder bob;
+    qr->asFindCommand(&bob);
+    ASSERT_TRUE(bob.obj()["allowDiskUse"].trueValue());
+}
+
 TEST(QueryRequestTest, ParseFromCommandCommentWithValidMinMax) {
     BSONObj cmdObj = fromjson(
         "{find: 'testns',"
@@ -801,6 +815,17 @@ TEST(QueryRequestTest, ParseFromCommandPartialWrongType) {
     ASSERT_NOT_OK(result.getStatus());
 }
 
+TEST(QueryRequestTest, ParseFromCommandAllowDiskUseWrongType) {
+    BSONObj cmdObj = fromjson(
+        "{find: 'testns',"
+        "sort: {a: 1},"
+        "allowDiskUse: 3}");
+    const NamespaceString nss("test.testns");
+    bool isExplain = false;
+    auto result = QueryRequest::makeFromFindCommand(nss, cmdObj, isExplain);
+    ASSERT_NOT_OK(result.getStatus());
+}
+
 TEST(QueryRequestTest, ParseFromCommandReadConcernWrongType) {
     BSONObj cmdObj = fromjson(
         "{find: 'testns',"
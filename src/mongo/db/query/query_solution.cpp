@@ -248,6 +248,7 @@ QuerySolutionNode* CollectionScanNode::clone() const {
     copy->direction = this->direction;
     copy->maxScan = this->maxScan;
     copy->shouldTrackLatestOplogTimestamp = this->shouldTrackLatestOplogTimestamp;
+    copy->allowParallel = this->allowParallel;
 
     return copy;
 }
@@ -494,6 +495,10 @@ void FetchNode::appendToString(mongoutils::str::stream* ss, int indent) const {
         filter->debugString(sb, indent + 2);
         *ss << sb.str();
     }
+    if (!simpleProjection.isEmpty()) {
+        addIndent(ss, indent + 1);
+        *ss << "simpleProjection = " << simpleProjection.toString() << '\n';
+    }
     addCommon(ss, indent);
     addIndent(ss, indent + 1);
     *ss << "Child:" << '\n';
@@ -505,6 +510,7 @@ QuerySolutionNode* FetchNode::clone() const {
     cloneBaseData(copy);
 
     copy->_sorts = this->_sorts;
+    copy->simpleProjection = this->simpleProjection;
 
     return copy;
 }
@@ -1135,10 +1141,15 @@ void CountScanNode::appendToString(mongoutils::str::stream* ss, int indent) cons
     *ss << "name = " << index.name << '\n';
     addIndent(ss, indent + 1);
     *ss << "keyPattern = " << index.keyPattern << '\n';
-    addIndent(ss, indent + 1);
-    *ss << "startKey = " << startKey << '\n';
-    addIndent(ss, indent + 1);
-    *ss << "endKey = " << endKey << '\n';
+    if (bounds.size() > 0) {
+        addIndent(ss, indent + 1);
+        *ss << "bounds = " << bounds.toString() << '\n';
+    } else {
+        addIndent(ss, indent + 1);
+        *ss << "startKey = " << startKey << '\n';
+        addIndent(ss, indent + 1);
+        *ss << "endKey = " << endKey << '\n';
+    }
 }
 
 QuerySolutionNode* CountScanNode::clone() const {
@@ -1150,6 +1161,7 @@ QuerySolutionNode* CountScanNode::clone() const {
     copy->startKeyInclusive = this->startKeyInclusive;
     copy->endKey = this->endKey;
     copy->endKeyInclusive = this->endKeyInclusive;
+    copy->bounds = this->bounds;
 
     return copy;
 }
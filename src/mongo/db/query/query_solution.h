@@ -28,6 +28,7 @@
 
 #pragma once
 
+#include <boost/optional.hpp>
 #include <memory>
 
 #include "mongo/bson/bsonobj_comparator_interface.h"
@@ -37,6 +38,7 @@
 #include "mongo/db/query/index_bounds.h"
 #include "mongo/db/query/plan_cache.h"
 #include "mongo/db/query/stage_types.h"
+#include "mongo/util/duration.h"
 
 namespace mongo {
 
@@ -200,6 +202,17 @@ struct QuerySolution {
     // Owned here. Used by the plan cache.
     std::unique_ptr<SolutionCacheData> cacheData;
 
+    // How the plan enumerator fared for the query this solution answers. Reported by explain.
+    // Not set for solutions which did not come from enumeration, such as those from the cache.
+    struct EnumerationStats {
+        // Time spent preparing the enumerator and producing every indexed assignment.
+        Microseconds time{0};
+
+        // How many index assignments were dropped because another assignment dominated them.
+        size_t assignmentsPruned = 0;
+    };
+    boost::optional<EnumerationStats> enumerationStats;
+
     /**
      * Output a human-readable std::string representing the plan.
      */
@@ -301,6 +314,9 @@ struct CollectionScanNode : public QuerySolutionNode {
     // across a sharded cluster.
     bool shouldTrackLatestOplogTimestamp = false;
 
+    // May the scan be split across worker threads? See QueryPlannerParams::ALLOW_PARALLEL_COLLSCAN.
+    bool allowParallel = false;
+
     int direction;
 
     // maxScan option to .find() limits how many docs we look at.
@@ -445,6 +461,10 @@ struct FetchNode : public QuerySolutionNode {
     QuerySolutionNode* clone() const;
 
     BSONObjSet _sorts;
+
+    // Set when a SIMPLE_DOC projection sits directly above this node. Documents only need to keep
+    // the fields it includes once they have passed the filter.
+    BSONObj simpleProjection;
 };
 
 struct IndexScanNode : public QuerySolutionNode {
@@ -952,6 +972,9 @@ struct CountScanNode : public QuerySolutionNode {
 
     BSONObj endKey;
     bool endKeyInclusive;
+
+    // If non-empty, the multi-interval bounds to count over in place of the start and end keys.
+    IndexBounds bounds;
 };
 
 /**
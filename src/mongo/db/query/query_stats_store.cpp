@@ -0,0 +1,184 @@
+/**
+ *    Copyright (C) 2017 MongoDB Inc.
+ *
+ *    This program is free software: you can redistribute it and/or  modify
+ *    it under the terms of the GNU Affero General Public License, version 3,
+ *    as published by the Free Software Foundation.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU Affero General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Affero General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the GNU Affero General Public License in all respects for
+ *    all of the code used other than as permitted herein. If you modify file(s)
+ *    with this exception, you may extend this exception to your version of the
+ *    file(s), but you are not obligated to do so. If you do not wish to do so,
+ *    delete this exception statement from your version. If you delete this
+ *    exception statement from all source files in the program, then also delete
+ *    it in the license file.
+ */
+
+#include "mongo/platform/basic.h"
+
+#include "mongo/db/query/query_stats_store.h"
+
+#include <algorithm>
+
+#include "mongo/base/simple_string_data_comparator.h"
+#include "mongo/bson/bsonobjbuilder.h"
+#include "mongo/db/query/query_knobs.h"
+#include "mongo/db/service_context.h"
+
+namespace mongo {
+
+namespace {
+
+const auto getQueryStatsStore = ServiceContext::declareDecoration<QueryStatsStore>();
+
+}  // namespace
+
+const size_t QueryStatsStore::kNumShards;
+
+void QueryStatsEntry::appendTo(bool includeHistograms, BSONObjBuilder* builder) const {
+    builder->append("ns", ns);
+    builder->append("shape", shape);
+    builder->append("planSummary", planSummary);
+    builder->append("execCount", execCount);
+    builder->append("keysExamined", keysExamined);
+    builder->append("docsExamined", docsExamined);
+    builder->append("nReturned", nReturned);
+    builder->append("totalExecMicros", totalExecMicros);
+
+    BSONObjBuilder latencyBuilder(builder->subobjStart("latency"));
+    latency.append(includeHistograms, &latencyBuilder);
+    latencyBuilder.doneFast();
+
+    builder->append("firstSeen", firstSeen);
+    builder->append("lastSeen", lastSeen);
+}
+
+// static
+QueryStatsStore& QueryStatsStore::get(ServiceContext* service) {
+    return getQueryStatsStore(service);
+}
+
+// static
+bool QueryStatsStore::isEnabled() {
+    return internalQueryStatsStoreSize.load() > 0;
+}
+
+// static
+size_t QueryStatsStore::hashKey(StringData ns, StringData shape) {
+    size_t hash = 0;
+    SimpleStringDataComparator::kInstance.hash_combine(hash, ns);
+    SimpleStringDataComparator::kInstance.hash_combine(hash, shape);
+    return hash;
+}
+
+void QueryStatsStore::record(StringData ns,
+                             StringData shape,
+                             long long keysExamined,
+                             long long docsExamined,
+                             long long nReturned,
+                             long long execMicros,
+                             Command::ReadWriteType readWriteType,
+                             StringData planSummary) {
+    const int maxSize = internalQueryStatsStoreSize.load();
+    if (maxSize <= 0) {
+        return;
+    }
+    const size_t maxShardSize =
+        std::max(static_cast<size_t>(1), static_cast<size_t>(maxSize) / kNumShards);
+
+    _totalExecCount.fetchAndAdd(1);
+    _totalKeysExamined.fetchAndAdd(std::max(0LL, keysExamined));
+    _totalDocsExamined.fetchAndAdd(std::max(0LL, docsExamined));
+    _totalNReturned.fetchAndAdd(std::max(0LL, nReturned));
+    _totalExecMicros.fetchAndAdd(execMicros);
+
+    const size_t keyHash = hashKey(ns, shape);
+    const Date_t now = Date_t::now();
+    Shard& shard = _shards[keyHash % kNumShards];
+    stdx::lock_guard<stdx::mutex> lock(shard.mutex);
+
+    auto indexIt = shard.index.find(keyHash);
+    if (indexIt != shard.index.end() &&
+        (indexIt->second->ns != ns || indexIt->second->shape != shape)) {
+        shard.entries.erase(indexIt->second);
+        shard.index.erase(indexIt);
+        indexIt = shard.index.end();
+    }
+
+    if (indexIt == shard.index.end()) {
+        shard.entries.emplace_front(ns.toString(), shape.toString(), now);
+        indexIt = shard.index.emplace(keyHash, shard.entries.begin()).first;
+
+        // The knob may have shrunk since the shard last grew, so evict until we are within it.
+        while (shard.entries.size() > maxShardSize) {
+            shard.index.erase(hashKey(shard.entries.back().ns, shard.entries.back().shape));
+            shard.entries.pop_back();
+            _evictions.fetchAndAdd(1);
+        }
+    } else {
+        shard.entries.splice(shard.entries.begin(), shard.entries, indexIt->second);
+    }
+
+    QueryStatsEntry& entry = *indexIt->second;
+    entry.lastSeen = now;
+    ++entry.execCount;
+    entry.keysExamined += std::max(0LL, keysExamined);
+    entry.docsExamined += std::max(0LL, docsExamined);
+    entry.nReturned += std::max(0LL, nReturned);
+    entry.totalExecMicros += execMicros;
+    entry.latency.increment(execMicros, readWriteType);
+    if (entry.planSummary != planSummary) {
+        entry.planSummary = planSummary.toString();
+    }
+}
+
+std::vector<QueryStatsEntry> QueryStatsStore::getEntries(StringData ns) const {
+    std::vector<QueryStatsEntry> entries;
+    for (auto&& shard : _shards) {
+        stdx::lock_guard<stdx::mutex> lock(shard.mutex);
+        for (auto&& entry : shard.entries) {
+            if (ns.empty() || entry.ns == ns) {
+                entries.push_back(entry);
+            }
+        }
+    }
+    return entries;
+}
+
+void QueryStatsStore::appendSummary(BSONObjBuilder* builder) const {
+    long long numShapes = 0;
+    for (auto&& shard : _shards) {
+        stdx::lock_guard<stdx::mutex> lock(shard.mutex);
+        numShapes += shard.entries.size();
+    }
+
+    builder->appendNumber("shapes", numShapes);
+    builder->appendNumber("evictions", static_cast<long long>(_evictions.load()));
+    builder->appendNumber("execCount", _totalExecCount.load());
+    builder->appendNumber("keysExamined", _totalKeysExamined.load());
+    builder->appendNumber("docsExamined", _totalDocsExamined.load());
+    builder->appendNumber("nReturned", _totalNReturned.load());
+    builder->appendNumber("totalExecMicros", _totalExecMicros.load());
+}
+
+void QueryStatsStore::clear() {
+    for (auto&& shard : _shards) {
+        stdx::lock_guard<stdx::mutex> lock(shard.mutex);
+        shard.index.clear();
+        shard.entries.clear();
+    }
+}
+
+}  // namespace mongo
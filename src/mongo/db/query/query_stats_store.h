@@ -0,0 +1,166 @@
+/**
+ *    Copyright (C) 2017 MongoDB Inc.
+ *
+ *    This program is free software: you can redistribute it and/or  modify
+ *    it under the terms of the GNU Affero General Public License, version 3,
+ *    as published by the Free Software Foundation.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU Affero General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Affero General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the GNU Affero General Public License in all respects for
+ *    all of the code used other than as permitted herein. If you modify file(s)
+ *    with this exception, you may extend this exception to your version of the
+ *    file(s), but you are not obligated to do so. If you do not wish to do so,
+ *    delete this exception statement from your version. If you delete this
+ *    exception statement from all source files in the program, then also delete
+ *    it in the license file.
+ */
+
+#pragma once
+
+#include <list>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "mongo/base/disallow_copying.h"
+#include "mongo/base/string_data.h"
+#include "mongo/db/commands.h"
+#include "mongo/db/stats/operation_latency_histogram.h"
+#include "mongo/platform/atomic_word.h"
+#include "mongo/stdx/mutex.h"
+#include "mongo/stdx/unordered_map.h"
+#include "mongo/util/time_support.h"
+
+namespace mongo {
+
+class BSONObjBuilder;
+class ServiceContext;
+
+/**
+ * Execution statistics accumulated for one query shape of one collection.
+ */
+struct QueryStatsEntry {
+    QueryStatsEntry(std::string ns, std::string shape, Date_t now)
+        : ns(std::move(ns)), shape(std::move(shape)), firstSeen(now), lastSeen(now) {}
+
+    /**
+     * Appends the statistics to 'builder'. The latency histograms are only included if
+     * 'includeHistograms' is true.
+     */
+    void appendTo(bool includeHistograms, BSONObjBuilder* builder) const;
+
+    const std::string ns;
+
+    // The plan cache key of the shape, as computed by PlanCache::computeKey().
+    const std::string shape;
+
+    const Date_t firstSeen;
+    Date_t lastSeen;
+
+    long long execCount = 0;
+    long long keysExamined = 0;
+    long long docsExamined = 0;
+    long long nReturned = 0;
+    long long totalExecMicros = 0;
+    OperationLatencyHistogram latency;
+
+    // The plan summary of the latest execution.
+    std::string planSummary;
+};
+
+/**
+ * A bounded in-memory store of execution statistics per query shape, keyed by namespace and plan
+ * cache key. Operations which planned a query record their statistics here when they complete, so
+ * the shapes which cost the most can be found without turning on the profiler.
+ *
+ * The store is split into independently locked shards by key hash. Each shard evicts its least
+ * recently executed shape once it holds its share of internalQueryStatsStoreSize entries.
+ *
+ * This class is thread-safe.
+ */
+class QueryStatsStore {
+    MONGO_DISALLOW_COPYING(QueryStatsStore);
+
+public:
+    static const size_t kNumShards = 16;
+
+    static QueryStatsStore& get(ServiceContext* service);
+
+    QueryStatsStore() = default;
+
+    /**
+     * Returns true if statistics are being recorded, that is if internalQueryStatsStoreSize is
+     * positive. Callers may skip computing a query's shape otherwise.
+     */
+    static bool isEnabled();
+
+    /**
+     * Adds one execution of the shape 'shape' over 'ns' to the store.
+     */
+    void record(StringData ns,
+                StringData shape,
+                long long keysExamined,
+                long long docsExamined,
+                long long nReturned,
+                long long execMicros,
+                Command::ReadWriteType readWriteType,
+                StringData planSummary);
+
+    /**
+     * Returns copies of the entries for every shape over 'ns', or of every entry if 'ns' is empty.
+     */
+    std::vector<QueryStatsEntry> getEntries(StringData ns) const;
+
+    /**
+     * Appends the number of shapes tracked and evicted, and totals over every execution recorded
+     * since startup. The output has the same fields whatever the workload, since it is meant for
+     * periodic sampling.
+     */
+    void appendSummary(BSONObjBuilder* builder) const;
+
+    /**
+     * Drops every entry.
+     */
+    void clear();
+
+private:
+    // The least recently executed entry of a shard is at the back of its list.
+    typedef std::list<QueryStatsEntry> EntryList;
+
+    struct Shard {
+        EntryList entries;
+
+        // Indexes 'entries' by the hash of each entry's namespace and shape. Two keys may share a
+        // hash, in which case the later of them to be recorded replaces the earlier.
+        stdx::unordered_map<size_t, EntryList::iterator> index;
+
+        // Protects 'entries' and 'index'.
+        mutable stdx::mutex mutex;
+    };
+
+    static size_t hashKey(StringData ns, StringData shape);
+
+    Shard _shards[kNumShards];
+
+    AtomicUInt64 _evictions;
+
+    // Totals over every execution recorded, which clear() leaves alone.
+    AtomicInt64 _totalExecCount;
+    AtomicInt64 _totalKeysExamined;
+    AtomicInt64 _totalDocsExamined;
+    AtomicInt64 _totalNReturned;
+    AtomicInt64 _totalExecMicros;
+};
+
+}  // namespace mongo
@@ -0,0 +1,154 @@
+/**
+ *    Copyright (C) 2017 MongoDB Inc.
+ *
+ *    This program is free software: you can redistribute it and/or  modify
+ *    it under the terms of the GNU Affero General Public License, version 3,
+ *    as published by the Free Software Foundation.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU Affero General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Affero General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the GNU Affero General Public License in all respects for
+ *    all of the code used other than as permitted herein. If you modify file(s)
+ *    with this exception, you may extend this exception to your version of the
+ *    file(s), but you are not obligated to do so. If you do not wish to do so,
+ *    delete this exception statement from your version. If you delete this
+ *    exception statement from all source files in the program, then also delete
+ *    it in the license file.
+ */
+
+#include "mongo/platform/basic.h"
+
+#include "mongo/db/query/query_stats_store.h"
+
+#include "mongo/bson/bsonobjbuilder.h"
+#include "mongo/db/query/query_knobs.h"
+#include "mongo/unittest/unittest.h"
+
+namespace mongo {
+namespace {
+
+class QueryStatsStoreTest : public unittest::Test {
+public:
+    void setUp() final {
+        _oldStoreSize = internalQueryStatsStoreSize.load();
+        internalQueryStatsStoreSize.store(5000);
+    }
+
+    void tearDown() final {
+        internalQueryStatsStoreSize.store(_oldStoreSize);
+    }
+
+protected:
+    void recordRead(StringData ns, StringData shape, long long keys, long long micros) {
+        store.record(ns, shape, keys, keys, 1, micros, Command::ReadWriteType::kRead, "IXSCAN");
+    }
+
+    QueryStatsStore store;
+
+private:
+    int _oldStoreSize;
+};
+
+TEST_F(QueryStatsStoreTest, ExecutionsOfAShapeAccumulate) {
+    recordRead("test.coll", "eqa", 10, 100);
+    recordRead("test.coll", "eqa", 20, 300);
+
+    auto entries = store.getEntries("test.coll");
+    ASSERT_EQ(1U, entries.size());
+    ASSERT_EQ("eqa", entries[0].shape);
+    ASSERT_EQ(2, entries[0].execCount);
+    ASSERT_EQ(30, entries[0].keysExamined);
+    ASSERT_EQ(30, entries[0].docsExamined);
+    ASSERT_EQ(2, entries[0].nReturned);
+    ASSERT_EQ(400, entries[0].totalExecMicros);
+    ASSERT_EQ("IXSCAN", entries[0].planSummary);
+
+    BSONObjBuilder builder;
+    entries[0].appendTo(false, &builder);
+    BSONObj stats = builder.obj();
+    ASSERT_EQ(2, stats["latency"]["reads"]["ops"].numberLong());
+    ASSERT_EQ(400, stats["latency"]["reads"]["latency"].numberLong());
+}
+
+TEST_F(QueryStatsStoreTest, UnsetMetricsCountAsZero) {
+    store.record("test.coll", "eqa", -1, -1, -1, 5, Command::ReadWriteType::kWrite, "COLLSCAN");
+
+    auto entries = store.getEntries("test.coll");
+    ASSERT_EQ(1U, entries.size());
+    ASSERT_EQ(1, entries[0].execCount);
+    ASSERT_EQ(0, entries[0].keysExamined);
+    ASSERT_EQ(0, entries[0].docsExamined);
+    ASSERT_EQ(0, entries[0].nReturned);
+}
+
+TEST_F(QueryStatsStoreTest, ShapesAreKeptPerNamespace) {
+    recordRead("test.a", "eqa", 1, 1);
+    recordRead("test.b", "eqa", 1, 1);
+    recordRead("test.b", "eqb", 1, 1);
+
+    ASSERT_EQ(1U, store.getEntries("test.a").size());
+    ASSERT_EQ(2U, store.getEntries("test.b").size());
+    ASSERT_EQ(3U, store.getEntries("").size());
+}
+
+TEST_F(QueryStatsStoreTest, StoreIsBounded) {
+    internalQueryStatsStoreSize.store(QueryStatsStore::kNumShards);
+    for (int i = 0; i < 100; ++i) {
+        recordRead("test.coll", "shape" + std::to_string(i), 1, 1);
+    }
+
+    const size_t numEntries = store.getEntries("").size();
+    ASSERT_LTE(numEntries, QueryStatsStore::kNumShards);
+
+    BSONObjBuilder builder;
+    store.appendSummary(&builder);
+    BSONObj summary = builder.obj();
+    ASSERT_EQ(static_cast<long long>(numEntries), summary["shapes"].numberLong());
+    ASSERT_EQ(static_cast<long long>(100 - numEntries), summary["evictions"].numberLong());
+}
+
+TEST_F(QueryStatsStoreTest, NothingIsRecordedWhenDisabled) {
+    internalQueryStatsStoreSize.store(0);
+    ASSERT_FALSE(QueryStatsStore::isEnabled());
+
+    recordRead("test.coll", "eqa", 1, 1);
+    ASSERT_TRUE(store.getEntries("").empty());
+}
+
+TEST_F(QueryStatsStoreTest, SummaryReportsTotalsOverEveryExecution) {
+    recordRead("test.coll", "cheap", 1, 10);
+    recordRead("test.coll", "expensive", 2, 1000);
+    recordRead("test.coll", "middling", 3, 100);
+    store.clear();
+    recordRead("test.coll", "cheap", 4, 10);
+
+    BSONObjBuilder builder;
+    store.appendSummary(&builder);
+    BSONObj summary = builder.obj();
+    ASSERT_EQ(1, summary["shapes"].numberLong());
+
+    // The totals include executions of shapes which are no longer in the store.
+    ASSERT_EQ(4, summary["execCount"].numberLong());
+    ASSERT_EQ(10, summary["keysExamined"].numberLong());
+    ASSERT_EQ(4, summary["nReturned"].numberLong());
+    ASSERT_EQ(1120, summary["totalExecMicros"].numberLong());
+}
+
+TEST_F(QueryStatsStoreTest, ClearDropsEveryShape) {
+    recordRead("test.coll", "eqa", 1, 1);
+    store.clear();
+    ASSERT_TRUE(store.getEntries("").empty());
+}
+
+}  // namespace
+}  // namespace mongo
@@ -0,0 +1,88 @@
+/**
+ *    Copyright (C) 2017 MongoDB Inc.
+ *
+ *    This program is free software: you can redistribute it and/or  modify
+ *    it under the terms of the GNU Affero General Public License, version 3,
+ *    as published by the Free Software Foundation.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU Affero General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Affero General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the GNU Affero General Public License in all respects for
+ *    all of the code used other than as permitted herein. If you modify file(s)
+ *    with this exception, you may extend this exception to your version of the
+ *    file(s), but you are not obligated to do so. If you do not wish to do so,
+ *    delete this exception statement from your version. If you delete this
+ *    exception statement from all source files in the program, then also delete
+ *    it in the license file.
+ */
+
+#include "mongo/platform/basic.h"
+
+#include "mongo/db/query/query_worker_pool.h"
+
+#include <algorithm>
+
+#include "mongo/db/client.h"
+#include "mongo/db/service_context.h"
+#include "mongo/stdx/memory.h"
+#include "mongo/util/processinfo.h"
+
+namespace mongo {
+
+namespace {
+
+const auto getQueryWorkerPool = ServiceContext::declareDecoration<QueryWorkerPool>();
+
+}  // namespace
+
+QueryWorkerPool::QueryWorkerPool() {
+    ThreadPool::Options options;
+    options.poolName = "QueryWorkerPool";
+    options.threadNamePrefix = "queryWorker-";
+    options.minThreads = 0;
+    options.maxThreads = std::max(2U, ProcessInfo().getNumCores());
+    options.onCreateThread = [](const std::string& threadName) {
+        Client::initThread(threadName.c_str());
+    };
+    _pool = stdx::make_unique<ThreadPool>(options);
+}
+
+// static
+QueryWorkerPool& QueryWorkerPool::get(ServiceContext* serviceContext) {
+    return getQueryWorkerPool(serviceContext);
+}
+
+Status QueryWorkerPool::schedule(ThreadPool::Task task) {
+    {
+        stdx::lock_guard<stdx::mutex> lk(_mutex);
+        if (!_started && !_shutdown) {
+            _pool->startup();
+            _started = true;
+        }
+    }
+    return _pool->schedule(std::move(task));
+}
+
+void QueryWorkerPool::shutdown() {
+    {
+        stdx::lock_guard<stdx::mutex> lk(_mutex);
+        if (_shutdown) {
+            return;
+        }
+        _shutdown = true;
+    }
+    _pool->shutdown();
+    _pool->join();
+}
+
+}  // namespace mongo
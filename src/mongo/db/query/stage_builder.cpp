@@ -49,6 +49,7 @@
 #include "mongo/db/exec/limit.h"
 #include "mongo/db/exec/merge_sort.h"
 #include "mongo/db/exec/or.h"
+#include "mongo/db/exec/parallel_collection_scan.h"
 #include "mongo/db/exec/projection.h"
 #include "mongo/db/exec/shard_filter.h"
 #include "mongo/db/exec/skip.h"
@@ -57,7 +58,9 @@
 #include "mongo/db/exec/text.h"
 #include "mongo/db/index/fts_access_method.h"
 #include "mongo/db/matcher/extensions_callback_real.h"
+#include "mongo/db/query/query_knobs.h"
 #include "mongo/db/s/collection_sharding_state.h"
+#include "mongo/db/storage/storage_options.h"
 #include "mongo/stdx/memory.h"
 #include "mongo/util/log.h"
 
@@ -66,6 +69,32 @@ namespace mongo {
 using std::unique_ptr;
 using stdx::make_unique;
 
+namespace {
+
+CollectionScanParams makeCollectionScanParams(Collection* collection,
+                                              const CollectionScanNode* csn) {
+    CollectionScanParams params;
+    params.collection = collection;
+    params.tailable = csn->tailable;
+    params.shouldTrackLatestOplogTimestamp = csn->shouldTrackLatestOplogTimestamp;
+    params.direction =
+        (csn->direction == 1) ? CollectionScanParams::FORWARD : CollectionScanParams::BACKWARD;
+    params.maxScan = csn->maxScan;
+    return params;
+}
+
+ParallelCollectionScanParams makeParallelCollectionScanParams(Collection* collection) {
+    ParallelCollectionScanParams params;
+    params.collection = collection;
+    params.numRanges = internalQueryParallelCollectionScanWorkers.load();
+    params.batchSize = internalQueryParallelCollectionScanBatchSize.load();
+    params.maxBufferBytesPerRange = internalQueryParallelCollectionScanMaxBufferBytes.load();
+    params.preserveOrder = internalQueryParallelCollectionScanPreserveOrder.load();
+    return params;
+}
+
+}  // namespace
+
 PlanStage* buildStages(OperationContext* opCtx,
                        Collection* collection,
                        const CanonicalQuery& cq,
@@ -75,13 +104,13 @@ PlanStage* buildStages(OperationContext* opCtx,
     switch (root->getType()) {
         case STAGE_COLLSCAN: {
             const CollectionScanNode* csn = static_cast<const CollectionScanNode*>(root);
-            CollectionScanParams params;
-            params.collection = collection;
-            params.tailable = csn->tailable;
-            params.shouldTrackLatestOplogTimestamp = csn->shouldTrackLatestOplogTimestamp;
-            params.direction = (csn->direction == 1) ? CollectionScanParams::FORWARD
-                                                     : CollectionScanParams::BACKWARD;
-            params.maxScan = csn->maxScan;
+            CollectionScanParams params = makeCollectionScanParams(collection, csn);
+            if (csn->allowParallel &&
+                ParallelCollectionScan::canRunInParallel(
+                    opCtx, collection, params, csn->filter.get())) {
+                return new ParallelCollectionScan(
+                    opCtx, makeParallelCollectionScanParams(collection), ws, csn->filter.get());
+            }
             return new CollectionScan(opCtx, params, ws, csn->filter.get());
         }
         case STAGE_IXSCAN: {
@@ -110,7 +139,8 @@ PlanStage* buildStages(OperationContext* opCtx,
             if (nullptr == childStage) {
                 return nullptr;
             }
-            return new FetchStage(opCtx, ws, childStage, fn->filter.get(), collection);
+            return new FetchStage(
+                opCtx, ws, childStage, fn->filter.get(), collection, fn->simpleProjection);
         }
         case STAGE_SORT: {
             const SortNode* sn = static_cast<const SortNode*>(root);
@@ -122,6 +152,10 @@ PlanStage* buildStages(OperationContext* opCtx,
             params.collection = collection;
             params.pattern = sn->pattern;
             params.limit = sn->limit;
+            if (cq.getQueryRequest().shouldAllowDiskUse()) {
+                params.allowDiskUse = true;
+                params.tempDir = storageGlobalParams.dbpath + "/_tmp";
+            }
             return new SortStage(opCtx, params, ws, childStage);
         }
         case STAGE_SORT_KEY_GENERATOR: {
@@ -136,6 +170,27 @@ PlanStage* buildStages(OperationContext* opCtx,
         }
         case STAGE_PROJECTION: {
             const ProjectionNode* pn = static_cast<const ProjectionNode*>(root);
+
+            // A projection directly over a parallel collection scan is run by the scan's workers,
+            // which also evaluate the full expression for positional and $elemMatch projections.
+            if (ProjectionNode::DEFAULT == pn->projType &&
+                STAGE_COLLSCAN == pn->children[0]->getType()) {
+                const CollectionScanNode* csn =
+                    static_cast<const CollectionScanNode*>(pn->children[0]);
+                CollectionScanParams csParams = makeCollectionScanParams(collection, csn);
+                if (csn->allowParallel &&
+                    ParallelCollectionScan::canEvaluateOnWorkers(pn->fullExpression) &&
+                    ParallelCollectionScan::canRunInParallel(
+                        opCtx, collection, csParams, csn->filter.get())) {
+                    ParallelCollectionScanParams params =
+                        makeParallelCollectionScanParams(collection);
+                    params.projObj = pn->projection;
+                    params.fullExpression = pn->fullExpression;
+                    params.collator = cq.getCollator();
+                    return new ParallelCollectionScan(opCtx, params, ws, csn->filter.get());
+                }
+            }
+
             PlanStage* childStage = buildStages(opCtx, collection, cq, qsol, pn->children[0], ws);
             if (nullptr == childStage) {
                 return nullptr;
@@ -343,6 +398,7 @@ PlanStage* buildStages(OperationContext* opCtx,
             params.startKeyInclusive = csn->startKeyInclusive;
             params.endKey = csn->endKey;
             params.endKeyInclusive = csn->endKeyInclusive;
+            params.bounds = csn->bounds;
 
             return new CountScan(opCtx, params, ws);
         }
@@ -87,6 +87,10 @@ enum StageType {
     STAGE_MULTI_PLAN,
     STAGE_OPLOG_START,
     STAGE_OR,
+
+    // A collection scan split into RecordId ranges which are scanned by worker threads.
+    STAGE_PARALLEL_COLLSCAN,
+
     STAGE_PROJECTION,
 
     // Stage for running aggregation pipelines.
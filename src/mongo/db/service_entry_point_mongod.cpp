@@ -55,6 +55,7 @@
 #include "mongo/db/ops/write_ops.h"
 #include "mongo/db/ops/write_ops_exec.h"
 #include "mongo/db/query/find.h"
+#include "mongo/db/query/query_stats_store.h"
 #include "mongo/db/read_concern.h"
 #include "mongo/db/repl/optime.h"
 #include "mongo/db/repl/read_concern_args.h"
@@ -1195,6 +1196,18 @@ DbResponse ServiceEntryPointMongod::handleRequest(OperationContext* opCtx, const
             durationCount<Microseconds>(currentOp.elapsedTimeExcludingPauses()),
             currentOp.getReadWriteType());
 
+    if (!debug.queryShape.empty()) {
+        QueryStatsStore::get(opCtx->getServiceContext())
+            .record(currentOp.getNS(),
+                    debug.queryShape,
+                    debug.keysExamined,
+                    debug.docsExamined,
+                    debug.nreturned,
+                    debug.executionTimeMicros,
+                    currentOp.getReadWriteType(),
+                    currentOp.getPlanSummary());
+    }
+
     const bool shouldSample = serverGlobalParams.sampleRate == 1.0
         ? true
         : c.getPrng().nextCanonicalDouble() < serverGlobalParams.sampleRate;
@@ -151,6 +151,15 @@ public:
         return {{_it->first, _it->second.toRecordData()}};
     }
 
+    boost::optional<Record> seekAtOrAfter(const RecordId& start) final {
+        _lastMoveWasRestore = false;
+        _needFirstSeek = false;
+        _it = _records.lower_bound(start);
+        if (_it == _records.end())
+            return {};
+        return {{_it->first, _it->second.toRecordData()}};
+    }
+
     void save() final {
         if (!_needFirstSeek && !_lastMoveWasRestore)
             _savedId = _it == _records.end() ? RecordId() : _it->first;
@@ -224,6 +233,17 @@ public:
         return {{_it->first, _it->second.toRecordData()}};
     }
 
+    boost::optional<Record> seekAtOrAfter(const RecordId& start) final {
+        _lastMoveWasRestore = false;
+        _needFirstSeek = false;
+
+        // See restore() for why this lands on the first entry <= 'start'.
+        _it = Records::const_reverse_iterator(_records.upper_bound(start));
+        if (_it == _records.rend())
+            return {};
+        return {{_it->first, _it->second.toRecordData()}};
+    }
+
     void save() final {
         if (!_needFirstSeek && !_lastMoveWasRestore)
             _savedId = _it == _records.rend() ? RecordId() : _it->first;
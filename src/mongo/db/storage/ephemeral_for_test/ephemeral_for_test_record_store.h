@@ -89,6 +89,10 @@ public:
     std::unique_ptr<SeekableRecordCursor> getCursor(OperationContext* opCtx,
                                                     bool forward) const final;
 
+    bool supportsSeekAtOrAfter() const final {
+        return true;
+    }
+
     virtual Status truncate(OperationContext* opCtx);
 
     virtual void cappedTruncateAfter(OperationContext* opCtx, RecordId end, bool inclusive);
@@ -273,6 +273,13 @@ public:
      */
     virtual void replicationBatchIsComplete() const {};
 
+    /**
+     * See `StorageEngine::isCacheUnderPressure()`
+     */
+    virtual bool isCacheUnderPressure() const {
+        return false;
+    }
+
     /**
      * The destructor will never be called from mongod, but may be called from tests.
      * Engines may assume that this will only be called in the case of clean shutdown, even if
@@ -383,4 +383,8 @@ bool KVStorageEngine::supportsRecoverToStableTimestamp() const {
 void KVStorageEngine::replicationBatchIsComplete() const {
     return _engine->replicationBatchIsComplete();
 }
+
+bool KVStorageEngine::isCacheUnderPressure() const {
+    return _engine->isCacheUnderPressure();
+}
 }  // namespace mongo
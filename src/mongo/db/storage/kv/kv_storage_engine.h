@@ -123,6 +123,8 @@ public:
 
     virtual void replicationBatchIsComplete() const override;
 
+    bool isCacheUnderPressure() const override;
+
     SnapshotManager* getSnapshotManager() const final;
 
     void setJournalListener(JournalListener* jl) final;
@@ -131,6 +131,13 @@ public:
      */
     virtual std::unique_ptr<RecordFetcher> recordNeedsFetch(const DiskLoc& loc) const = 0;
 
+    /**
+     * Hints that the records at 'locs', which are in ascending order, will be read soon.
+     * Implementations may start paging them in, so that reading them is less likely to page
+     * fault. The default implementation does nothing.
+     */
+    virtual void prefetchRecords(const std::vector<DiskLoc>& locs) const {}
+
     /**
      * @param loc - has to be for a specific MmapV1RecordHeader (not an Extent)
      * Note(erh) see comment on recordFor
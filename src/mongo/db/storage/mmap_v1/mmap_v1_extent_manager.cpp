@@ -32,6 +32,10 @@
 
 #include <boost/filesystem/operations.hpp>
 
+#ifndef _WIN32
+#include <sys/mman.h>
+#endif
+
 #include "mongo/db/storage/mmap_v1/mmap_v1_extent_manager.h"
 
 #include "mongo/base/counter.h"
@@ -53,6 +57,7 @@
 #include "mongo/util/fail_point_service.h"
 #include "mongo/util/file.h"
 #include "mongo/util/log.h"
+#include "mongo/util/processinfo.h"
 
 namespace mongo {
 
@@ -331,6 +336,31 @@ std::unique_ptr<RecordFetcher> MmapV1ExtentManager::recordNeedsFetch(const DiskL
     return {};
 }
 
+void MmapV1ExtentManager::prefetchRecords(const std::vector<DiskLoc>& locs) const {
+#ifndef _WIN32
+    // Advise the kernel to start reading in the first page of each record. We must not dereference
+    // the records here, as that would take the page faults we are trying to get ahead of, so their
+    // lengths aren't known; read-ahead normally covers the rest of each record. Records which are
+    // already resident make this a cheap no-op. The access tracker is left alone, so that the
+    // reads which follow still yield for a fetch if they would page fault.
+    const uintptr_t pageSize = ProcessInfo::getPageSize();
+    uintptr_t lastPage = 0;
+    for (auto&& loc : locs) {
+        if (loc.isNull()) {
+            continue;
+        }
+
+        const uintptr_t page =
+            reinterpret_cast<uintptr_t>(_recordForV1(loc)) & ~(pageSize - 1);
+        if (page == lastPage) {
+            continue;
+        }
+        posix_madvise(reinterpret_cast<void*>(page), pageSize, POSIX_MADV_WILLNEED);
+        lastPage = page;
+    }
+#endif
+}
+
 DiskLoc MmapV1ExtentManager::extentLocForV1(const DiskLoc& loc) const {
     MmapV1RecordHeader* record = recordForV1(loc);
     return DiskLoc(loc.a(), record->extentOfs());
@@ -126,4 +126,13 @@ std::unique_ptr<RecordFetcher> SimpleRecordStoreV1Iterator::fetcherForNext() con
 std::unique_ptr<RecordFetcher> SimpleRecordStoreV1Iterator::fetcherForId(const RecordId& id) const {
     return _recordStore->_extentManager->recordNeedsFetch(DiskLoc::fromRecordId(id));
 }
+
+void SimpleRecordStoreV1Iterator::prefetch(const std::vector<RecordId>& ids) {
+    std::vector<DiskLoc> locs;
+    locs.reserve(ids.size());
+    for (auto&& id : ids) {
+        locs.push_back(DiskLoc::fromRecordId(id));
+    }
+    _recordStore->_extentManager->prefetchRecords(locs);
+}
 }
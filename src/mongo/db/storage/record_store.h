@@ -38,6 +38,7 @@
 #include "mongo/db/record_id.h"
 #include "mongo/db/storage/record_data.h"
 #include "mongo/db/storage/record_fetcher.h"
+#include "mongo/util/assert_util.h"
 
 namespace mongo {
 
@@ -248,6 +249,16 @@ public:
      */
     virtual boost::optional<Record> seekExact(const RecordId& id) = 0;
 
+    /**
+     * Seeks to the first Record whose id is at or after 'start' in the direction of this cursor.
+     * Returns boost::none and positions the cursor at EOF if there is no such Record.
+     *
+     * Only supported if RecordStore::supportsSeekAtOrAfter() returns true.
+     */
+    virtual boost::optional<Record> seekAtOrAfter(const RecordId& start) {
+        MONGO_UNREACHABLE;
+    }
+
     /**
      * Prepares for state changes in underlying data without necessarily saving the current
      * state.
@@ -268,6 +279,19 @@ public:
     virtual std::unique_ptr<RecordFetcher> fetcherForId(const RecordId& id) const {
         return {};
     }
+
+    /**
+     * Hints that the Records with the provided ids are about to be read with seekExact(), so
+     * that the implementation may start bringing them into memory together rather than one
+     * seekExact() at a time. 'ids' must be in ascending order. Records which no longer exist are
+     * ignored.
+     *
+     * Leaves the position of the cursor unspecified, as seekExact() does. May throw a
+     * WriteConflictException, in which case the hint may be dropped.
+     *
+     * The default implementation does nothing.
+     */
+    virtual void prefetch(const std::vector<RecordId>& ids) {}
 };
 
 /**
@@ -501,6 +525,14 @@ public:
         return {};
     }
 
+    /**
+     * Returns true if cursors over this RecordStore implement seekAtOrAfter(), allowing it to be
+     * scanned as several independent RecordId ranges.
+     */
+    virtual bool supportsSeekAtOrAfter() const {
+        return false;
+    }
+
     /**
      * Returns many RecordCursors that partition the RecordStore into many disjoint sets.
      * Iterating all returned RecordCursors is equivalent to iterating the full store.
@@ -443,5 +443,104 @@ TEST(RecordStoreTestHarness, SeekAfterEofAndContinue) {
     ASSERT(!cursor->next());
 }
 
+// Insert multiple records and seek to RecordIds at, between and beyond them in both directions.
+TEST(RecordStoreTestHarness, SeekAtOrAfter) {
+    const auto harnessHelper(newRecordStoreHarnessHelper());
+    unique_ptr<RecordStore> rs(harnessHelper->newNonCappedRecordStore());
+    if (!rs->supportsSeekAtOrAfter()) {
+        return;
+    }
+
+    const int nToInsert = 10;
+    RecordId locs[nToInsert];
+    for (int i = 0; i < nToInsert; i++) {
+        ServiceContext::UniqueOperationContext opCtx(harnessHelper->newOperationContext());
+        stringstream ss;
+        ss << "record " << i;
+        string data = ss.str();
+
+        WriteUnitOfWork uow(opCtx.get());
+        StatusWith<RecordId> res =
+            rs->insertRecord(opCtx.get(), data.c_str(), data.size() + 1, Timestamp(), false);
+        ASSERT_OK(res.getStatus());
+        locs[i] = res.getValue();
+        uow.commit();
+    }
+    std::sort(locs, locs + nToInsert);
+
+    ServiceContext::UniqueOperationContext opCtx(harnessHelper->newOperationContext());
+    auto forward = rs->getCursor(opCtx.get(), true);
+    auto reverse = rs->getCursor(opCtx.get(), false);
+    for (int i = 0; i < nToInsert; i++) {
+        // Exact hits.
+        auto record = forward->seekAtOrAfter(locs[i]);
+        ASSERT(record);
+        ASSERT_EQUALS(locs[i], record->id);
+        record = reverse->seekAtOrAfter(locs[i]);
+        ASSERT(record);
+        ASSERT_EQUALS(locs[i], record->id);
+
+        // Just past the record, which lands on the neighbour in the direction of the cursor.
+        record = forward->seekAtOrAfter(RecordId(locs[i].repr() + 1));
+        if (i + 1 < nToInsert) {
+            ASSERT(record);
+            ASSERT_EQUALS(locs[i + 1], record->id);
+
+            // Iteration continues from the new position.
+            if (i + 2 < nToInsert) {
+                record = forward->next();
+                ASSERT(record);
+                ASSERT_EQUALS(locs[i + 2], record->id);
+            }
+        } else {
+            ASSERT(!record);
+        }
+
+        record = reverse->seekAtOrAfter(RecordId(locs[i].repr() - 1));
+        if (i > 0) {
+            ASSERT(record);
+            ASSERT_EQUALS(locs[i - 1], record->id);
+        } else {
+            ASSERT(!record);
+        }
+    }
+}
+
+// A prefetch hint must not change what seekExact() returns afterwards.
+TEST(RecordStoreTestHarness, SeekExactAfterPrefetch) {
+    const auto harnessHelper(newRecordStoreHarnessHelper());
+    unique_ptr<RecordStore> rs(harnessHelper->newNonCappedRecordStore());
+
+    const int nToInsert = 10;
+    RecordId locs[nToInsert];
+    string datas[nToInsert];
+    for (int i = 0; i < nToInsert; i++) {
+        ServiceContext::UniqueOperationContext opCtx(harnessHelper->newOperationContext());
+        stringstream ss;
+        ss << "record " << i;
+        datas[i] = ss.str();
+
+        WriteUnitOfWork uow(opCtx.get());
+        StatusWith<RecordId> res = rs->insertRecord(
+            opCtx.get(), datas[i].c_str(), datas[i].size() + 1, Timestamp(), false);
+        ASSERT_OK(res.getStatus());
+        locs[i] = res.getValue();
+        uow.commit();
+    }
+
+    std::vector<RecordId> ids(locs, locs + nToInsert);
+    std::sort(ids.begin(), ids.end());
+
+    ServiceContext::UniqueOperationContext opCtx(harnessHelper->newOperationContext());
+    auto cursor = rs->getCursor(opCtx.get());
+    cursor->prefetch(ids);
+    for (int i = nToInsert - 1; i >= 0; i--) {
+        auto record = cursor->seekExact(locs[i]);
+        ASSERT(record);
+        ASSERT_EQUALS(locs[i], record->id);
+        ASSERT_EQUALS(datas[i], record->data.data());
+    }
+}
+
 }  // namespace
 }  // namespace mongo
@@ -343,6 +343,15 @@ public:
      */
     virtual void replicationBatchIsComplete() const {};
 
+    /**
+     * Returns true if the storage engine's cache is full enough that it is evicting on behalf of
+     * application threads, so that operations holding old snapshots open should release them.
+     * Must be cheap enough to call from query execution, and may report a slightly stale answer.
+     */
+    virtual bool isCacheUnderPressure() const {
+        return false;
+    }
+
     // (CollectionName, IndexName)
     typedef std::pair<std::string, std::string> CollectionIndexNamePair;
 
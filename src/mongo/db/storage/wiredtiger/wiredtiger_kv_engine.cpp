@@ -870,6 +870,36 @@ bool WiredTigerKVEngine::haveDropsQueued() const {
     return lk.try_lock() && !_identToDrop.empty();
 }
 
+bool WiredTigerKVEngine::isCacheUnderPressure() const {
+    // Reading the statistics opens a cursor, so only one caller refreshes the answer, at most every
+    // 100ms. Everyone else gets the last answer.
+    const long long now = _clockSource->now().toMillisSinceEpoch();
+    const long long previous = _previousCheckedCachePressureMillis.load();
+    if (now - previous < 100 ||
+        _previousCheckedCachePressureMillis.compareAndSwap(previous, now) != previous) {
+        return _cacheUnderPressure.load();
+    }
+
+    UniqueWiredTigerSession session = _sessionCache->getSession();
+    WT_SESSION* s = session->getSession();
+    auto readStatistic = [s](int key) -> uint64_t {
+        StatusWith<uint64_t> result =
+            WiredTigerUtil::getStatisticsValue(s, "statistics:", "statistics=(fast)", key);
+        return result.isOK() ? result.getValue() : 0;
+    };
+
+    const uint64_t maxBytes = readStatistic(WT_STAT_CONN_CACHE_BYTES_MAX);
+    const uint64_t inUseBytes = readStatistic(WT_STAT_CONN_CACHE_BYTES_INUSE);
+    const uint64_t dirtyBytes = readStatistic(WT_STAT_CONN_CACHE_BYTES_DIRTY);
+
+    // Past WiredTiger's default eviction_trigger (95%) and eviction_dirty_trigger (20%),
+    // application threads are made to evict pages themselves.
+    const bool underPressure =
+        maxBytes > 0 && (inUseBytes > maxBytes / 100 * 95 || dirtyBytes > maxBytes / 100 * 20);
+    _cacheUnderPressure.store(underPressure);
+    return underPressure;
+}
+
 void WiredTigerKVEngine::dropSomeQueuedIdents() {
     int numInQueue;
 
@@ -42,6 +42,7 @@
 #include "mongo/db/storage/kv/kv_engine.h"
 #include "mongo/db/storage/wiredtiger/wiredtiger_oplog_manager.h"
 #include "mongo/db/storage/wiredtiger/wiredtiger_session_cache.h"
+#include "mongo/platform/atomic_word.h"
 #include "mongo/stdx/functional.h"
 #include "mongo/stdx/mutex.h"
 #include "mongo/util/elapsed_tracker.h"
@@ -187,6 +188,8 @@ public:
         std::list<WiredTigerCachedCursor>* cache);
     bool haveDropsQueued() const;
 
+    bool isCacheUnderPressure() const override;
+
     void syncSizeInfo(bool sync) const;
 
     /*
@@ -307,6 +310,10 @@ private:
 
     mutable Date_t _previousCheckedDropsQueued;
 
+    // The answer isCacheUnderPressure() last computed from the connection statistics, and when.
+    mutable AtomicBool _cacheUnderPressure{false};
+    mutable AtomicInt64 _previousCheckedCachePressureMillis{0};
+
     std::unique_ptr<WiredTigerSession> _backupSession;
 };
 }
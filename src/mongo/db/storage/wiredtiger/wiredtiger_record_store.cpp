@@ -1741,6 +1741,57 @@ boost::optional<Record> WiredTigerRecordStoreCursorBase::seekExact(const RecordI
     return {{id, {static_cast<const char*>(value.data), static_cast<int>(value.size)}}};
 }
 
+void WiredTigerRecordStoreCursorBase::prefetch(const std::vector<RecordId>& ids) {
+    // WiredTiger has no interface for asynchronous reads. Searching for the records in RecordId
+    // order reads the pages holding them into the cache in key order, visiting each page once, so
+    // that the seekExact() calls which follow in the caller's order find them in the cache.
+    _skipNextAdvance = false;
+    WT_CURSOR* c = _cursor->get();
+    for (auto&& id : ids) {
+        setKey(c, id);
+        int ret = WT_READ_CHECK(c->search(c));
+        if (ret != WT_NOTFOUND) {
+            invariantWTOK(ret);
+        }
+    }
+    invariantWTOK(c->reset(c));
+    _eof = true;
+}
+
+boost::optional<Record> WiredTigerRecordStoreCursorBase::seekAtOrAfter(const RecordId& start) {
+    invariant(!_rs._isCapped);
+    _skipNextAdvance = false;
+    WT_CURSOR* c = _cursor->get();
+    setKey(c, start);
+
+    int cmp;
+    int ret = WT_READ_CHECK(c->search_near(c, &cmp));
+    if (ret == 0 && (_forward ? cmp < 0 : cmp > 0)) {
+        // Landed on the wrong side of 'start', so step over it in the direction of the cursor.
+        ret = WT_READ_CHECK(_forward ? c->next(c) : c->prev(c));
+    }
+
+    RecordId id;
+    if (ret == WT_NOTFOUND) {
+        _eof = true;
+        return {};
+    }
+    invariantWTOK(ret);
+    if (hasWrongPrefix(c, &id)) {
+        _eof = true;
+        return {};
+    }
+    if (!id.isNormal()) {
+        id = getKey(c);
+    }
+
+    WT_ITEM value;
+    invariantWTOK(c->get_value(c, &value));
+
+    _lastReturnedId = id;
+    _eof = false;
+    return {{id, {static_cast<const char*>(value.data), static_cast<int>(value.size)}}};
+}
 
 void WiredTigerRecordStoreCursorBase::save() {
     try {
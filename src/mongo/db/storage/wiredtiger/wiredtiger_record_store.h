@@ -173,6 +173,11 @@ public:
 
     std::unique_ptr<RecordCursor> getRandomCursor(OperationContext* opCtx) const final;
 
+    bool supportsSeekAtOrAfter() const final {
+        // Capped collections have visibility rules which only forward iteration enforces.
+        return !_isCapped;
+    }
+
     virtual std::unique_ptr<RecordCursor> getRandomCursorWithOptions(
         OperationContext* opCtx, StringData extraConfig) const = 0;
 
@@ -388,6 +393,10 @@ public:
 
     boost::optional<Record> seekExact(const RecordId& id);
 
+    boost::optional<Record> seekAtOrAfter(const RecordId& start);
+
+    void prefetch(const std::vector<RecordId>& ids);
+
     void save();
 
     void saveUnpositioned();
@@ -142,8 +142,14 @@ public:
 
         // High enough so that we shouldn't trigger a replan based on works.
         const size_t decisionWorks = 50;
-        CachedPlanStage cachedPlanStage(
-            &_opCtx, collection, &_ws, cq.get(), plannerParams, decisionWorks, mockChild.release());
+        CachedPlanStage cachedPlanStage(&_opCtx,
+                                        collection,
+                                        &_ws,
+                                        cq.get(),
+                                        plannerParams,
+                                        decisionWorks,
+                                        boost::none,
+                                        mockChild.release());
 
         // This should succeed after triggering a replan.
         PlanYieldPolicy yieldPolicy(PlanExecutor::NO_YIELD,
@@ -213,8 +219,14 @@ public:
             mockChild->pushBack(PlanStage::NEED_TIME);
         }
 
-        CachedPlanStage cachedPlanStage(
-            &_opCtx, collection, &_ws, cq.get(), plannerParams, decisionWorks, mockChild.release());
+        CachedPlanStage cachedPlanStage(&_opCtx,
+                                        collection,
+                                        &_ws,
+                                        cq.get(),
+                                        plannerParams,
+                                        decisionWorks,
+                                        boost::none,
+                                        mockChild.release());
 
         // This should succeed after triggering a replan.
         PlanYieldPolicy yieldPolicy(PlanExecutor::NO_YIELD,
@@ -39,15 +39,18 @@
 #include "mongo/db/db_raii.h"
 #include "mongo/db/dbdirectclient.h"
 #include "mongo/db/exec/collection_scan.h"
+#include "mongo/db/exec/parallel_collection_scan.h"
 #include "mongo/db/exec/plan_stage.h"
 #include "mongo/db/json.h"
 #include "mongo/db/matcher/expression_parser.h"
 #include "mongo/db/namespace_string.h"
 #include "mongo/db/query/plan_executor.h"
+#include "mongo/db/query/query_knobs.h"
 #include "mongo/db/storage/record_store.h"
 #include "mongo/dbtests/dbtests.h"
 #include "mongo/stdx/memory.h"
 #include "mongo/util/fail_point_service.h"
+#include "mongo/util/scopeguard.h"
 
 namespace QueryStageCollectionScan {
 
@@ -400,6 +403,177 @@ public:
     }
 };
 
+//
+// Batched work returns the same documents in the same order as work(), applying the filter before
+// any WorkingSetMember is allocated.
+//
+
+class QueryStageCollscanBatchedWorkWithMatch : public QueryStageCollectionScanBase {
+public:
+    void run() {
+        AutoGetCollectionForReadCommand ctx(&_opCtx, nss);
+
+        CollectionScanParams params;
+        params.collection = ctx.getCollection();
+        params.direction = CollectionScanParams::FORWARD;
+        params.tailable = false;
+
+        const CollatorInterface* collator = nullptr;
+        const boost::intrusive_ptr<ExpressionContext> expCtx(
+            new ExpressionContext(&_opCtx, collator));
+        StatusWithMatchExpression statusWithMatcher =
+            MatchExpressionParser::parse(BSON("foo" << BSON("$gte" << 10)), expCtx);
+        ASSERT_OK(statusWithMatcher.getStatus());
+        unique_ptr<MatchExpression> filterExpr = std::move(statusWithMatcher.getValue());
+
+        WorkingSet ws;
+        unique_ptr<CollectionScan> scan =
+            make_unique<CollectionScan>(&_opCtx, params, &ws, filterExpr.get());
+
+        int count = 0;
+        PlanStage::StageState state = PlanStage::NEED_TIME;
+        while (PlanStage::IS_EOF != state) {
+            vector<WorkingSetID> batch;
+            WorkingSetID stateId = WorkingSet::INVALID_ID;
+            state = scan->workBatch(&ws, 7, &batch, &stateId);
+            ASSERT_NOT_EQUALS(PlanStage::FAILURE, state);
+            ASSERT_NOT_EQUALS(PlanStage::DEAD, state);
+            ASSERT_LTE(batch.size(), 7U);
+
+            for (auto id : batch) {
+                WorkingSetMember* member = ws.get(id);
+                ASSERT_EQUALS(WorkingSetMember::RID_AND_OBJ, member->getState());
+                ASSERT_EQUALS(10 + count, member->obj.value()["foo"].numberInt());
+                ++count;
+                ws.free(id);
+            }
+        }
+
+        ASSERT_EQUALS(numObj() - 10, count);
+        ASSERT_TRUE(scan->isEOF());
+        auto stats = static_cast<const CollectionScanStats*>(scan->getSpecificStats());
+        ASSERT_EQUALS(static_cast<size_t>(numObj()), stats->docsTested);
+        ASSERT_EQUALS(static_cast<size_t>(count), scan->getCommonStats()->advanced);
+    }
+};
+
+//
+// PlanExecutor drives a plan which supports it through workBatch() when asked to.
+//
+
+class QueryStageCollscanExecutorBatchedWork : public QueryStageCollectionScanBase {
+public:
+    void run() {
+        const int oldBatchSize = internalQueryExecBatchedWorkSize.load();
+        internalQueryExecBatchedWorkSize.store(16);
+        ON_BLOCK_EXIT([oldBatchSize] { internalQueryExecBatchedWorkSize.store(oldBatchSize); });
+
+        ASSERT_EQUALS(numObj(), countResults(CollectionScanParams::FORWARD, BSONObj()));
+        ASSERT_EQUALS(25,
+                      countResults(CollectionScanParams::BACKWARD,
+                                   BSON("foo" << BSON("$lt" << 25))));
+    }
+};
+
+//
+// A parallel scan with order preserved returns the same documents as a forward CollectionScan,
+// however the collection is split between the workers.
+//
+
+class QueryStageParallelCollscanPreservesOrder : public QueryStageCollectionScanBase {
+public:
+    void run() {
+        AutoGetCollectionForReadCommand ctx(&_opCtx, nss);
+        if (!ctx.getCollection()->getRecordStore()->supportsSeekAtOrAfter()) {
+            return;
+        }
+
+        const CollatorInterface* collator = nullptr;
+        const boost::intrusive_ptr<ExpressionContext> expCtx(
+            new ExpressionContext(&_opCtx, collator));
+        StatusWithMatchExpression statusWithMatcher =
+            MatchExpressionParser::parse(BSON("foo" << BSON("$gte" << 10)), expCtx);
+        ASSERT_OK(statusWithMatcher.getStatus());
+        unique_ptr<MatchExpression> filterExpr = std::move(statusWithMatcher.getValue());
+
+        for (size_t numRanges : {1, 3, 4, 64}) {
+            ParallelCollectionScanParams params;
+            params.collection = ctx.getCollection();
+            params.numRanges = numRanges;
+            params.batchSize = 7;
+            params.preserveOrder = true;
+
+            WorkingSet ws;
+            ParallelCollectionScan scan(&_opCtx, params, &ws, filterExpr.get());
+
+            int count = 0;
+            while (!scan.isEOF()) {
+                WorkingSetID id = WorkingSet::INVALID_ID;
+                PlanStage::StageState state = scan.work(&id);
+                ASSERT_NOT_EQUALS(PlanStage::FAILURE, state);
+                if (PlanStage::ADVANCED == state) {
+                    WorkingSetMember* member = ws.get(id);
+                    ASSERT_EQUALS(WorkingSetMember::RID_AND_OBJ, member->getState());
+                    ASSERT_EQUALS(10 + count, member->obj.value()["foo"].numberInt());
+                    ++count;
+                    ws.free(id);
+                }
+            }
+
+            ASSERT_EQUALS(numObj() - 10, count);
+            auto stats =
+                static_cast<const ParallelCollectionScanStats*>(scan.getSpecificStats());
+            ASSERT_EQUALS(static_cast<size_t>(numObj()), stats->docsTested);
+        }
+    }
+};
+
+//
+// Without order preserved, every document is still returned exactly once, and the workers apply
+// the projection.
+//
+
+class QueryStageParallelCollscanUnorderedWithProjection : public QueryStageCollectionScanBase {
+public:
+    void run() {
+        AutoGetCollectionForReadCommand ctx(&_opCtx, nss);
+        if (!ctx.getCollection()->getRecordStore()->supportsSeekAtOrAfter()) {
+            return;
+        }
+
+        ParallelCollectionScanParams params;
+        params.collection = ctx.getCollection();
+        params.numRanges = 4;
+        params.batchSize = 5;
+        params.preserveOrder = false;
+        params.projObj = BSON("_id" << 0 << "foo" << 1);
+
+        WorkingSet ws;
+        ParallelCollectionScan scan(&_opCtx, params, &ws, nullptr);
+
+        vector<bool> seen(numObj(), false);
+        while (!scan.isEOF()) {
+            WorkingSetID id = WorkingSet::INVALID_ID;
+            PlanStage::StageState state = scan.work(&id);
+            ASSERT_NOT_EQUALS(PlanStage::FAILURE, state);
+            if (PlanStage::ADVANCED == state) {
+                WorkingSetMember* member = ws.get(id);
+                ASSERT_EQUALS(WorkingSetMember::OWNED_OBJ, member->getState());
+                BSONObj obj = member->obj.value();
+                ASSERT_EQUALS(1, obj.nFields());
+                int foo = obj["foo"].numberInt();
+                ASSERT_FALSE(seen[foo]);
+                seen[foo] = true;
+                ws.free(id);
+            }
+        }
+
+        for (int i = 0; i < numObj(); ++i) {
+            ASSERT_TRUE(seen[i]);
+        }
+    }
+};
+
 class All : public Suite {
 public:
     All() : Suite("QueryStageCollectionScan") {}
@@ -414,6 +588,10 @@ public:
         add<QueryStageCollscanObjectsInOrderBackward>();
         add<QueryStageCollscanInvalidateUpcomingObject>();
         add<QueryStageCollscanInvalidateUpcomingObjectBackward>();
+        add<QueryStageCollscanBatchedWorkWithMatch>();
+        add<QueryStageCollscanExecutorBatchedWork>();
+        add<QueryStageParallelCollscanPreservesOrder>();
+        add<QueryStageParallelCollscanUnorderedWithProjection>();
     }
 };
 
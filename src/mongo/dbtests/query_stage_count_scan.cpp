@@ -641,6 +641,82 @@ public:
     }
 };
 
+//
+// Check that multi-interval bounds count the keys within each interval, skipping the gaps
+//
+class QueryStageCountScanMultiInterval : public CountBase {
+public:
+    void run() {
+        OldClientWriteContext ctx(&_opCtx, ns());
+
+        for (int i = 0; i < 20; ++i) {
+            insert(BSON("a" << i));
+        }
+        addIndex(BSON("a" << 1));
+
+        // {a: {$in: [2, 5, 6, 7, 15]}} plus a gap which holds no keys.
+        OrderedIntervalList oil("a");
+        oil.intervals.push_back(Interval(BSON("" << 2 << "" << 2), true, true));
+        oil.intervals.push_back(Interval(BSON("" << 5 << "" << 8), true, false));
+        oil.intervals.push_back(Interval(BSON("" << 12.5 << "" << 12.75), true, true));
+        oil.intervals.push_back(Interval(BSON("" << 15 << "" << 15), true, true));
+
+        CountScanParams params;
+        params.descriptor = getIndex(ctx.db(), BSON("a" << 1));
+        params.bounds.fields.push_back(oil);
+
+        WorkingSet ws;
+        CountScan count(&_opCtx, params, &ws);
+
+        // No working set members are allocated for the counted keys.
+        int numCounted = 0;
+        WorkingSetID wsid;
+        PlanStage::StageState countState;
+        while (PlanStage::IS_EOF != (countState = count.work(&wsid))) {
+            if (PlanStage::ADVANCED == countState) {
+                ASSERT_EQUALS(WorkingSet::INVALID_ID, wsid);
+                ++numCounted;
+            }
+        }
+        ASSERT_EQUALS(5, numCounted);
+
+        // Only the keys in each interval, and the first key past each, were looked at.
+        auto stats = static_cast<const CountScanStats*>(count.getSpecificStats());
+        ASSERT_EQUALS(9U, stats->keysExamined);
+        ASSERT_EQUALS(4U, stats->seeks);
+    }
+};
+
+//
+// Check that a document whose keys fall in several intervals is counted once
+//
+class QueryStageCountScanMultiIntervalDups : public CountBase {
+public:
+    void run() {
+        OldClientWriteContext ctx(&_opCtx, ns());
+
+        insert(BSON("a" << BSON_ARRAY(1 << 3)));
+        insert(BSON("a" << BSON_ARRAY(3 << 5)));
+        insert(BSON("a" << 4));
+        addIndex(BSON("a" << 1));
+
+        OrderedIntervalList oil("a");
+        oil.intervals.push_back(Interval(BSON("" << 1 << "" << 1), true, true));
+        oil.intervals.push_back(Interval(BSON("" << 3 << "" << 3), true, true));
+        oil.intervals.push_back(Interval(BSON("" << 5 << "" << 5), true, true));
+
+        CountScanParams params;
+        params.descriptor = getIndex(ctx.db(), BSON("a" << 1));
+        params.bounds.fields.push_back(oil);
+
+        WorkingSet ws;
+        CountScan count(&_opCtx, params, &ws);
+
+        int numCounted = runCount(&count);
+        ASSERT_EQUALS(2, numCounted);
+    }
+};
+
 class All : public Suite {
 public:
     All() : Suite("query_stage_count_scan") {}
@@ -657,6 +733,8 @@ public:
         add<QueryStageCountScanInsertNewDocsDuringYield>();
         add<QueryStageCountScanBecomesMultiKeyDuringYield>();
         add<QueryStageCountScanUnusedKeys>();
+        add<QueryStageCountScanMultiInterval>();
+        add<QueryStageCountScanMultiIntervalDups>();
     }
 };
 
@@ -43,8 +43,10 @@
 #include "mongo/db/exec/queued_data_stage.h"
 #include "mongo/db/json.h"
 #include "mongo/db/matcher/expression_parser.h"
+#include "mongo/db/query/query_knobs.h"
 #include "mongo/dbtests/dbtests.h"
 #include "mongo/stdx/memory.h"
+#include "mongo/util/scopeguard.h"
 
 namespace QueryStageFetch {
 
@@ -219,6 +221,138 @@ public:
     }
 };
 
+//
+// Test that prefetching in batches returns documents in the order the child produced them.
+//
+class FetchStagePrefetchPreservesOrder : public QueryStageFetchBase {
+public:
+    void run() {
+        OldClientWriteContext ctx(&_opCtx, ns());
+        Database* db = ctx.db();
+        Collection* coll = db->getCollection(&_opCtx, ns());
+        if (!coll) {
+            WriteUnitOfWork wuow(&_opCtx);
+            coll = db->createCollection(&_opCtx, ns());
+            wuow.commit();
+        }
+
+        const int kNumDocs = 10;
+        for (int i = 0; i < kNumDocs; ++i) {
+            insert(BSON("foo" << i));
+        }
+        set<RecordId> recordIds;
+        getRecordIds(&recordIds, coll);
+        ASSERT_EQUALS(size_t(kNumDocs), recordIds.size());
+
+        const int oldBatchSize = internalQueryExecFetchPrefetchBatchSize.load();
+        ON_BLOCK_EXIT([&] { internalQueryExecFetchPrefetchBatchSize.store(oldBatchSize); });
+        internalQueryExecFetchPrefetchBatchSize.store(4);
+
+        // Hand the RecordIds to the fetch stage in descending order.
+        WorkingSet ws;
+        auto mockStage = make_unique<QueuedDataStage>(&_opCtx, &ws);
+        std::vector<BSONObj> expected;
+        for (auto it = recordIds.rbegin(); it != recordIds.rend(); ++it) {
+            WorkingSetID id = ws.allocate();
+            WorkingSetMember* mockMember = ws.get(id);
+            mockMember->recordId = *it;
+            ws.transitionToRecordIdAndIdx(id);
+            mockStage->pushBack(id);
+            expected.push_back(coll->docFor(&_opCtx, *it).value().getOwned());
+        }
+
+        unique_ptr<FetchStage> fetchStage(
+            new FetchStage(&_opCtx, &ws, mockStage.release(), NULL, coll));
+
+        std::vector<BSONObj> results;
+        PlanStage::StageState state = PlanStage::NEED_TIME;
+        while (PlanStage::IS_EOF != state) {
+            WorkingSetID id = WorkingSet::INVALID_ID;
+            state = fetchStage->work(&id);
+            if (PlanStage::ADVANCED == state) {
+                results.push_back(ws.get(id)->obj.value().getOwned());
+            }
+        }
+
+        ASSERT_EQUALS(expected.size(), results.size());
+        for (size_t i = 0; i < expected.size(); ++i) {
+            ASSERT_BSONOBJ_EQ(expected[i], results[i]);
+        }
+
+        auto stats = static_cast<const FetchStats*>(fetchStage->getSpecificStats());
+        ASSERT_EQUALS(size_t(kNumDocs), stats->recordsPrefetched);
+    }
+};
+
+//
+// Test that batched results only keep the fields of the projection above the fetch, and that the
+// filter still sees the whole document.
+//
+class FetchStageProjectsBatchedResults : public QueryStageFetchBase {
+public:
+    void run() {
+        OldClientWriteContext ctx(&_opCtx, ns());
+        Database* db = ctx.db();
+        Collection* coll = db->getCollection(&_opCtx, ns());
+        if (!coll) {
+            WriteUnitOfWork wuow(&_opCtx);
+            coll = db->createCollection(&_opCtx, ns());
+            wuow.commit();
+        }
+
+        const int kNumDocs = 6;
+        for (int i = 0; i < kNumDocs; ++i) {
+            insert(BSON("_id" << i << "a" << i << "b" << std::string(1024, 'x') << "c" << i % 2));
+        }
+        set<RecordId> recordIds;
+        getRecordIds(&recordIds, coll);
+        ASSERT_EQUALS(size_t(kNumDocs), recordIds.size());
+
+        WorkingSet ws;
+        auto mockStage = make_unique<QueuedDataStage>(&_opCtx, &ws);
+        for (auto&& recordId : recordIds) {
+            WorkingSetID id = ws.allocate();
+            WorkingSetMember* mockMember = ws.get(id);
+            mockMember->recordId = recordId;
+            ws.transitionToRecordIdAndIdx(id);
+            mockStage->pushBack(id);
+        }
+
+        // The filter is on a field which the projection drops.
+        BSONObj filterObj = BSON("c" << 1);
+        const CollatorInterface* collator = nullptr;
+        const boost::intrusive_ptr<ExpressionContext> expCtx(
+            new ExpressionContext(&_opCtx, collator));
+        StatusWithMatchExpression statusWithMatcher =
+            MatchExpressionParser::parse(filterObj, expCtx);
+        verify(statusWithMatcher.isOK());
+        unique_ptr<MatchExpression> filterExpr = std::move(statusWithMatcher.getValue());
+
+        unique_ptr<FetchStage> fetchStage(new FetchStage(
+            &_opCtx, &ws, mockStage.release(), filterExpr.get(), coll, BSON("a" << 1)));
+
+        std::vector<WorkingSetID> out;
+        WorkingSetID stateId = WorkingSet::INVALID_ID;
+        PlanStage::StageState state = PlanStage::NEED_TIME;
+        while (PlanStage::IS_EOF != state) {
+            state = fetchStage->workBatch(&ws, 4, &out, &stateId);
+            ASSERT_NOT_EQUALS(PlanStage::FAILURE, state);
+        }
+
+        ASSERT_EQUALS(size_t(kNumDocs / 2), out.size());
+        for (size_t i = 0; i < out.size(); ++i) {
+            WorkingSetMember* member = ws.get(out[i]);
+            ASSERT_TRUE(member->obj.value().isOwned());
+            const int expectedId = 2 * i + 1;
+            ASSERT_BSONOBJ_EQ(BSON("_id" << expectedId << "a" << expectedId),
+                              member->obj.value());
+        }
+
+        auto stats = static_cast<const FetchStats*>(fetchStage->getSpecificStats());
+        ASSERT_EQUALS(size_t(kNumDocs / 2), stats->docsPartiallyMaterialized);
+    }
+};
+
 class All : public Suite {
 public:
     All() : Suite("query_stage_fetch") {}
@@ -226,6 +360,8 @@ public:
     void setupTests() {
         add<FetchStageAlreadyFetched>();
         add<FetchStageFilter>();
+        add<FetchStagePrefetchPreservesOrder>();
+        add<FetchStageProjectsBatchedResults>();
     }
 };
 
@@ -314,6 +314,50 @@ public:
     }
 };
 
+// Batched work must produce the same keys as work(), and leave the scan able to yield between
+// batches.
+class QueryStageIxscanWorkBatch : public IndexScanTest {
+public:
+    void run() {
+        setup();
+
+        for (int i = 0; i < 20; ++i) {
+            insert(BSON("_id" << i << "x" << i));
+        }
+
+        std::unique_ptr<IndexScan> ixscan(
+            createIndexScan(BSON("x" << 5), BSON("x" << 15), true, true));
+        ASSERT_TRUE(ixscan->supportsBatchedWork());
+
+        int expected = 5;
+        std::vector<WorkingSetID> batch;
+        WorkingSetID stateId = WorkingSet::INVALID_ID;
+        PlanStage::StageState state = PlanStage::NEED_TIME;
+        while (PlanStage::IS_EOF != state) {
+            batch.clear();
+            state = ixscan->workBatch(&_ws, 3, &batch, &stateId);
+            ASSERT_NE(PlanStage::DEAD, state);
+            ASSERT_NE(PlanStage::FAILURE, state);
+            ASSERT_LTE(batch.size(), 3U);
+
+            for (auto id : batch) {
+                WorkingSetMember* member = _ws.get(id);
+                ASSERT_EQ(WorkingSetMember::RID_AND_IDX, member->getState());
+                ASSERT_BSONOBJ_EQ(member->keyData[0].keyData, BSON("" << expected));
+                ++expected;
+                _ws.free(id);
+            }
+
+            ixscan->saveState();
+            ixscan->restoreState();
+        }
+
+        ASSERT_EQ(16, expected);
+        ASSERT(ixscan->isEOF());
+        ASSERT_EQ(11U, ixscan->getCommonStats()->advanced);
+    }
+};
+
 class All : public Suite {
 public:
     All() : Suite("query_stage_ixscan") {}
@@ -324,6 +368,7 @@ public:
         add<QueryStageIxscanInsertDuringSaveExclusive>();
         add<QueryStageIxscanInsertDuringSaveExclusive2>();
         add<QueryStageIxscanInsertDuringSaveReverse>();
+        add<QueryStageIxscanWorkBatch>();
     }
 } QueryStageIxscanAll;
 
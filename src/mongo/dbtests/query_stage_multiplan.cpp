@@ -214,6 +214,97 @@ TEST_F(QueryStageMultiPlanTest, MPSCollectionScanVsHighlySelectiveIXScan) {
     ASSERT_EQUALS(results, N / 10);
 }
 
+// Same as above, but with each candidate built on a WorkingSet of its own so that their trial
+// periods run at the same time on worker threads.
+TEST_F(QueryStageMultiPlanTest, MPSParallelTrialsPickHighlySelectiveIXScan) {
+    if (!supportsDocLocking()) {
+        return;
+    }
+
+    const int N = 5000;
+    for (int i = 0; i < N; ++i) {
+        insert(BSON("foo" << (i % 10)));
+    }
+
+    addIndex(BSON("foo" << 1));
+
+    AutoGetCollectionForReadCommand ctx(_opCtx.get(), nss);
+    const Collection* coll = ctx.getCollection();
+
+    std::vector<IndexDescriptor*> indexes;
+    coll->getIndexCatalog()->findIndexesByKeyPattern(
+        _opCtx.get(), BSON("foo" << 1), false, &indexes);
+    ASSERT_EQ(indexes.size(), 1U);
+
+    IndexScanParams ixparams;
+    ixparams.descriptor = indexes[0];
+    ixparams.bounds.isSimpleRange = true;
+    ixparams.bounds.startKey = BSON("" << 7);
+    ixparams.bounds.endKey = BSON("" << 7);
+    ixparams.bounds.boundInclusion = BoundInclusion::kIncludeBothStartAndEndKeys;
+    ixparams.direction = 1;
+
+    // Plan 0: IXScan over foo == 7.
+    auto firstWs = make_unique<WorkingSet>();
+    IndexScan* ix = new IndexScan(_opCtx.get(), ixparams, firstWs.get(), NULL);
+    unique_ptr<PlanStage> firstRoot(new FetchStage(_opCtx.get(), firstWs.get(), ix, NULL, coll));
+
+    // Plan 1: CollScan with matcher.
+    CollectionScanParams csparams;
+    csparams.collection = coll;
+    csparams.direction = CollectionScanParams::FORWARD;
+
+    BSONObj filterObj = BSON("foo" << 7);
+    const CollatorInterface* collator = nullptr;
+    const boost::intrusive_ptr<ExpressionContext> expCtx(
+        new ExpressionContext(_opCtx.get(), collator));
+    StatusWithMatchExpression statusWithMatcher = MatchExpressionParser::parse(filterObj, expCtx);
+    verify(statusWithMatcher.isOK());
+    unique_ptr<MatchExpression> filter = std::move(statusWithMatcher.getValue());
+    auto secondWs = make_unique<WorkingSet>();
+    unique_ptr<PlanStage> secondRoot(
+        new CollectionScan(_opCtx.get(), csparams, secondWs.get(), filter.get()));
+
+    auto qr = stdx::make_unique<QueryRequest>(nss);
+    qr->setFilter(BSON("foo" << 7));
+    auto statusWithCQ = CanonicalQuery::canonicalize(opCtx(), std::move(qr));
+    verify(statusWithCQ.isOK());
+    unique_ptr<CanonicalQuery> cq = std::move(statusWithCQ.getValue());
+    verify(NULL != cq.get());
+
+    unique_ptr<WorkingSet> sharedWs(new WorkingSet());
+    unique_ptr<MultiPlanStage> mps =
+        make_unique<MultiPlanStage>(_opCtx.get(), ctx.getCollection(), cq.get());
+    mps->addPlan(createQuerySolution(), firstRoot.release(), sharedWs.get(), std::move(firstWs));
+    mps->addPlan(createQuerySolution(), secondRoot.release(), sharedWs.get(), std::move(secondWs));
+
+    PlanYieldPolicy yieldPolicy(PlanExecutor::NO_YIELD, _clock);
+    ASSERT_OK(mps->pickBestPlan(&yieldPolicy));
+    ASSERT(mps->bestPlanChosen());
+    ASSERT_EQUALS(0, mps->bestPlanIdx());
+
+    auto statusWithPlanExecutor = PlanExecutor::make(_opCtx.get(),
+                                                     std::move(sharedWs),
+                                                     std::move(mps),
+                                                     std::move(cq),
+                                                     coll,
+                                                     PlanExecutor::NO_YIELD);
+    ASSERT_OK(statusWithPlanExecutor.getStatus());
+    auto exec = std::move(statusWithPlanExecutor.getValue());
+
+    // The results buffered during the trial period and those produced afterwards all come back
+    // through the shared WorkingSet.
+    int results = 0;
+    BSONObj obj;
+    PlanExecutor::ExecState state;
+    while (PlanExecutor::ADVANCED == (state = exec->getNext(&obj, NULL))) {
+        ASSERT_EQUALS(obj["foo"].numberInt(), 7);
+        ++results;
+    }
+    ASSERT_EQUALS(PlanExecutor::IS_EOF, state);
+    ASSERT_EQUALS(results, N / 10);
+}
+
 // Case in which we select a blocking plan as the winner, and a non-blocking plan
 // is available as a backup.
 TEST_F(QueryStageMultiPlanTest, MPSBackupPlan) {
@@ -41,8 +41,11 @@
 #include "mongo/db/exec/sort.h"
 #include "mongo/db/json.h"
 #include "mongo/db/query/plan_executor.h"
+#include "mongo/db/query/query_knobs.h"
+#include "mongo/db/storage/storage_options.h"
 #include "mongo/dbtests/dbtests.h"
 #include "mongo/stdx/memory.h"
+#include "mongo/util/scopeguard.h"
 
 /**
  * This file tests db/exec/sort.cpp
@@ -578,6 +581,155 @@ public:
     }
 };
 
+// Sort more data than fits under the in-memory limit, spilling sorted runs to disk.
+template <int LIMIT>
+class QueryStageSortSpill : public QueryStageSortTestBase {
+public:
+    virtual int numObj() {
+        return 2000;
+    }
+
+    virtual int limit() const {
+        return LIMIT;
+    }
+
+    void run() {
+        OldClientWriteContext ctx(&_opCtx, ns());
+        Database* db = ctx.db();
+        Collection* coll = db->getCollection(&_opCtx, ns());
+        if (!coll) {
+            WriteUnitOfWork wuow(&_opCtx);
+            coll = db->createCollection(&_opCtx, ns());
+            wuow.commit();
+        }
+
+        // Only a handful of documents fit in memory at once.
+        const int oldMaxBytes = internalQueryExecMaxBlockingSortBytes.load();
+        internalQueryExecMaxBlockingSortBytes.store(4 * 1024);
+        ON_BLOCK_EXIT([&] { internalQueryExecMaxBlockingSortBytes.store(oldMaxBytes); });
+
+        // Insert in an order which differs from the sort order.
+        for (int i = 0; i < numObj(); ++i) {
+            insert(BSON("foo" << (i * 7) % numObj() << "bar" << i));
+        }
+
+        auto ws = make_unique<WorkingSet>();
+        auto queuedDataStage = make_unique<QueuedDataStage>(&_opCtx, ws.get());
+        insertVarietyOfObjects(ws.get(), queuedDataStage.get(), coll);
+
+        SortStageParams params;
+        params.collection = coll;
+        params.pattern = BSON("foo" << 1);
+        params.limit = limit();
+        params.allowDiskUse = true;
+        params.tempDir = storageGlobalParams.dbpath + "/_tmp";
+
+        auto keyGenStage = make_unique<SortKeyGeneratorStage>(
+            &_opCtx, queuedDataStage.release(), ws.get(), params.pattern, nullptr);
+
+        auto sortStage = make_unique<SortStage>(&_opCtx, params, ws.get(), keyGenStage.release());
+        SortStage* sort = sortStage.get();
+
+        auto statusWithPlanExecutor = PlanExecutor::make(
+            &_opCtx, std::move(ws), std::move(sortStage), coll, PlanExecutor::NO_YIELD);
+        ASSERT_OK(statusWithPlanExecutor.getStatus());
+        auto exec = std::move(statusWithPlanExecutor.getValue());
+
+        int count = 0;
+        BSONObj obj;
+        PlanExecutor::ExecState state;
+        while (PlanExecutor::ADVANCED == (state = exec->getNext(&obj, NULL))) {
+            ASSERT_EQUALS(count, obj["foo"].numberInt());
+            ++count;
+        }
+        ASSERT_EQUALS(PlanExecutor::IS_EOF, state);
+        checkCount(count);
+
+        const SortStats* stats = static_cast<const SortStats*>(sort->getSpecificStats());
+        ASSERT_GREATER_THAN(stats->spills, 1U);
+    }
+};
+
+// A limited sort over index keys keeps only the winning keys, and the documents are fetched after
+// the sort.
+class QueryStageSortTopKOnIndexKeys : public QueryStageSortTestBase {
+public:
+    virtual int numObj() {
+        return 500;
+    }
+
+    virtual int limit() const {
+        return 20;
+    }
+
+    void run() {
+        OldClientWriteContext ctx(&_opCtx, ns());
+        Database* db = ctx.db();
+        Collection* coll = db->getCollection(&_opCtx, ns());
+        if (!coll) {
+            WriteUnitOfWork wuow(&_opCtx);
+            coll = db->createCollection(&_opCtx, ns());
+            wuow.commit();
+        }
+
+        // Insert in an order which differs from the sort order.
+        for (int i = 0; i < numObj(); ++i) {
+            insert(BSON("foo" << (i * 7) % numObj() << "bar" << i));
+        }
+
+        // Feed the sort index keys, as an index scan over {foo: 1} would.
+        auto ws = make_unique<WorkingSet>();
+        auto queuedDataStage = make_unique<QueuedDataStage>(&_opCtx, ws.get());
+        const BSONObj keyPattern = BSON("foo" << 1);
+        auto cursor = coll->getCursor(&_opCtx);
+        while (auto record = cursor->next()) {
+            BSONObj doc = record->data.toBson();
+            WorkingSetID id = ws->allocate();
+            WorkingSetMember* member = ws->get(id);
+            member->recordId = record->id;
+            member->keyData.push_back(
+                IndexKeyDatum(keyPattern, BSON("" << doc["foo"].numberInt()), nullptr));
+            ws->transitionToRecordIdAndIdx(id);
+            queuedDataStage->pushBack(id);
+        }
+
+        SortStageParams params;
+        params.collection = coll;
+        params.pattern = BSON("foo" << -1);
+        params.limit = limit();
+
+        auto keyGenStage = make_unique<SortKeyGeneratorStage>(
+            &_opCtx, queuedDataStage.release(), ws.get(), params.pattern, nullptr);
+
+        auto sortStage = make_unique<SortStage>(&_opCtx, params, ws.get(), keyGenStage.release());
+        SortStage* sort = sortStage.get();
+
+        auto fetchStage =
+            make_unique<FetchStage>(&_opCtx, ws.get(), sortStage.release(), nullptr, coll);
+
+        auto statusWithPlanExecutor = PlanExecutor::make(
+            &_opCtx, std::move(ws), std::move(fetchStage), coll, PlanExecutor::NO_YIELD);
+        ASSERT_OK(statusWithPlanExecutor.getStatus());
+        auto exec = std::move(statusWithPlanExecutor.getValue());
+
+        int count = 0;
+        BSONObj obj;
+        PlanExecutor::ExecState state;
+        while (PlanExecutor::ADVANCED == (state = exec->getNext(&obj, NULL))) {
+            ASSERT_EQUALS(numObj() - 1 - count, obj["foo"].numberInt());
+            ASSERT_TRUE(obj.hasField("bar"));
+            ++count;
+        }
+        ASSERT_EQUALS(PlanExecutor::IS_EOF, state);
+        checkCount(count);
+
+        // Only the index keys of the top K were ever buffered.
+        auto stats = sort->getStats();
+        auto sortStats = static_cast<const SortStats*>(stats->specific.get());
+        ASSERT_LT(sortStats->memUsage, static_cast<size_t>(limit()) * 1024U);
+    }
+};
+
 class All : public Suite {
 public:
     All() : Suite("query_stage_sort") {}
@@ -595,6 +747,9 @@ public:
         add<QueryStageSortDeletionInvalidationWithLimit<10>>();
         add<QueryStageSortDeletionInvalidationWithLimit<1>>();
         add<QueryStageSortParallelArrays>();
+        add<QueryStageSortSpill<0>>();
+        add<QueryStageSortSpill<500>>();
+        add<QueryStageSortTopKOnIndexKeys>();
     }
 };
 
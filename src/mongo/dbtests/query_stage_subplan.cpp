@@ -607,6 +607,118 @@ TEST_F(QueryStageSubplanTest, QueryStageSubplanPlanRootedOrNE) {
     ASSERT_EQ(numResults, 4U);
 }
 
+/**
+ * Test that when every branch of a sorted rooted $or has an index which provides the sort as
+ * selectively as any other, the multiplanner picks it for each branch, and the composite solution
+ * merges the branches rather than sorting their union in memory.
+ */
+TEST_F(QueryStageSubplanTest, QueryStageSubplanPrefersMergeSortWhenBranchesProvideSort) {
+    OldClientWriteContext ctx(opCtx(), nss.ns());
+    addIndex(BSON("a" << 1));
+    addIndex(BSON("a" << 1 << "c" << 1));
+    addIndex(BSON("b" << 1));
+    addIndex(BSON("b" << 1 << "c" << 1));
+
+    for (int i = 0; i < 10; ++i) {
+        insert(BSON("_id" << i << "a" << 1 << "b" << (i % 2) << "c" << (10 - i)));
+    }
+
+    auto qr = stdx::make_unique<QueryRequest>(nss);
+    qr->setFilter(fromjson("{$or: [{a: 1}, {b: 1}]}"));
+    qr->setSort(BSON("c" << 1));
+    auto cq = unittest::assertGet(CanonicalQuery::canonicalize(opCtx(), std::move(qr)));
+
+    Collection* collection = ctx.getCollection();
+
+    QueryPlannerParams plannerParams;
+    fillOutPlannerParams(opCtx(), collection, cq.get(), &plannerParams);
+
+    WorkingSet ws;
+    std::unique_ptr<SubplanStage> subplan(
+        new SubplanStage(opCtx(), collection, &ws, plannerParams, cq.get()));
+
+    PlanYieldPolicy yieldPolicy(PlanExecutor::NO_YIELD, _clock);
+    ASSERT_OK(subplan->pickBestPlan(&yieldPolicy));
+
+    QuerySolution* soln = subplan->compositeSolution();
+    ASSERT(soln);
+    ASSERT_FALSE(soln->hasBlockingStage);
+
+    // Every document matches the first branch, and half of them the second. The merge must return
+    // each of them once, in order.
+    int numResults = 0;
+    int lastC = 0;
+    PlanStage::StageState stageState = PlanStage::NEED_TIME;
+    while (stageState != PlanStage::IS_EOF) {
+        WorkingSetID id = WorkingSet::INVALID_ID;
+        stageState = subplan->work(&id);
+        ASSERT_NE(stageState, PlanStage::DEAD);
+        ASSERT_NE(stageState, PlanStage::FAILURE);
+        if (stageState == PlanStage::ADVANCED) {
+            ++numResults;
+            WorkingSetMember* member = ws.get(id);
+            ASSERT(member->hasObj());
+            const int c = member->obj.value()["c"].numberInt();
+            ASSERT_GT(c, lastC);
+            lastC = c;
+        }
+    }
+
+    ASSERT_EQ(numResults, 10);
+}
+
+/**
+ * Test that a selective index which doesn't provide the sort still competes with a scan of the
+ * whole index on the sort field for each branch of a sorted rooted $or, and wins.
+ */
+TEST_F(QueryStageSubplanTest, QueryStageSubplanRanksBlockingSortBranchSolutions) {
+    OldClientWriteContext ctx(opCtx(), nss.ns());
+    addIndex(BSON("a" << 1));
+    addIndex(BSON("b" << 1));
+    addIndex(BSON("c" << 1));
+
+    for (int i = 0; i < 200; ++i) {
+        insert(BSON("_id" << i << "a" << i << "b" << i << "c" << (200 - i)));
+    }
+
+    auto qr = stdx::make_unique<QueryRequest>(nss);
+    qr->setFilter(fromjson("{$or: [{a: 1}, {b: 2}]}"));
+    qr->setSort(BSON("c" << 1));
+    auto cq = unittest::assertGet(CanonicalQuery::canonicalize(opCtx(), std::move(qr)));
+
+    Collection* collection = ctx.getCollection();
+
+    QueryPlannerParams plannerParams;
+    fillOutPlannerParams(opCtx(), collection, cq.get(), &plannerParams);
+
+    WorkingSet ws;
+    std::unique_ptr<SubplanStage> subplan(
+        new SubplanStage(opCtx(), collection, &ws, plannerParams, cq.get()));
+
+    PlanYieldPolicy yieldPolicy(PlanExecutor::NO_YIELD, _clock);
+    ASSERT_OK(subplan->pickBestPlan(&yieldPolicy));
+
+    // Each branch should use its own index and leave the sort to a blocking SORT, rather than scan
+    // the whole {c: 1} index.
+    QuerySolution* soln = subplan->compositeSolution();
+    ASSERT(soln);
+    ASSERT_TRUE(soln->hasBlockingStage);
+
+    int numResults = 0;
+    PlanStage::StageState stageState = PlanStage::NEED_TIME;
+    while (stageState != PlanStage::IS_EOF) {
+        WorkingSetID id = WorkingSet::INVALID_ID;
+        stageState = subplan->work(&id);
+        ASSERT_NE(stageState, PlanStage::DEAD);
+        ASSERT_NE(stageState, PlanStage::FAILURE);
+        if (stageState == PlanStage::ADVANCED) {
+            ++numResults;
+        }
+    }
+
+    ASSERT_EQ(numResults, 2);
+}
+
 TEST_F(QueryStageSubplanTest, ShouldReportErrorIfExceedsTimeLimitDuringPlanning) {
     OldClientWriteContext ctx(opCtx(), nss.ns());
     // Build a query with a rooted $or.
@@ -44,6 +44,12 @@ void DoubleDoubleSummation::addLong(long long x) {
     addDouble(high);
 }
 
+void DoubleDoubleSummation::addLongs(const long long* values, size_t count) {
+    for (size_t i = 0; i < count; ++i) {
+        addLong(values[i]);
+    }
+}
+
 /**
  * Returns whether the sum is in range of the 64-bit signed integer long long type.
  */
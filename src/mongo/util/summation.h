@@ -29,6 +29,7 @@
 #pragma once
 
 #include <cmath>
+#include <cstddef>
 #include <tuple>
 #include <utility>
 
@@ -57,12 +58,38 @@ public:
         _addend += x;                                  // Store away lowest part of sum
     }
 
+    /**
+     * Adds the 'count' doubles at 'values' in order, with the same result as calling addDouble() on
+     * each of them. The running sum is kept in locals for the length of the loop.
+     */
+    void addDoubles(const double* values, size_t count) {
+        double special = _special;
+        double sum = _sum;
+        double addend = _addend;
+        for (size_t i = 0; i < count; ++i) {
+            double x = values[i];
+            special += x;
+            std::tie(x, addend) = _fast2Sum(x, addend);
+            std::tie(sum, x) = _2Sum(sum, x);
+            addend += x;
+        }
+        _special = special;
+        _sum = sum;
+        _addend = addend;
+    }
+
     /**
      * Adds x to internal sum. Extra precision guarantees that sum is exact, unless intermediate
      * sums exceed a magnitude of 2**106.
      */
     void addLong(long long x);
 
+    /**
+     * Adds the 'count' longs at 'values' in order, with the same result as calling addLong() on
+     * each of them.
+     */
+    void addLongs(const long long* values, size_t count);
+
     /**
      * Adds x to internal sum. Adds as double as that is more efficient.
      */
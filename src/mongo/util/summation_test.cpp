@@ -203,4 +203,24 @@ TEST(Summation, AddDoubles) {
     ASSERT_EQUALS(sum.getDouble(), doubleValuesSum);
     ASSERT(straightSum != sum.getDouble());
 }
+
+TEST(Summation, AddInBulkMatchesAddingOneAtATime) {
+    DoubleDoubleSummation oneAtATime;
+    for (auto x : doubleValues) {
+        oneAtATime.addDouble(x);
+    }
+    for (auto x : longValues) {
+        oneAtATime.addLong(x);
+    }
+
+    DoubleDoubleSummation bulk;
+    bulk.addDoubles(doubleValues.data(), doubleValues.size());
+    bulk.addLongs(longValues.data(), longValues.size());
+
+    ASSERT_EQUALS(bulk.getDoubleDouble().first, oneAtATime.getDoubleDouble().first);
+    ASSERT_EQUALS(bulk.getDoubleDouble().second, oneAtATime.getDoubleDouble().second);
+
+    bulk.addDoubles(specialValues.data(), specialValues.size());
+    ASSERT(std::isnan(bulk.getDouble()));
+}
 }  // namespace mongo